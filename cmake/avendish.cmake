@@ -26,6 +26,10 @@ option(AVND_ENABLE_STANDALONE    "Enable standalone executable"  ON)
 option(AVND_ENABLE_GSTREAMER     "Enable GStreamer backend"      ON)
 option(AVND_ENABLE_WASM          "Enable WebAssembly backend"    ON)
 option(AVND_ENABLE_FUZZ          "Enable libFuzzer harness (Clang only)" OFF)
+# ON by default when this repo is built with BUILD_TESTING (see CMakeLists.txt).
+# The examples which allocate in process() on purpose are listed in
+# AVND_RTCHECK_EXPECTED_FAILURES.
+option(AVND_ENABLE_RTCHECK       "Enable realtime-safety harness (allocations / locks in process())" OFF)
 
 # Opt-in for add-ons that wrap a library whose API requires exceptions/RTTI (e.g.
 # onnxruntime). When ON, the DisableExceptions target becomes a no-op so the
@@ -128,6 +132,7 @@ set(AVENDISH_SOURCES
 
 
     "${AVND_SOURCE_DIR}/include/avnd/wrappers/process/base.hpp"
+    "${AVND_SOURCE_DIR}/include/avnd/wrappers/process/lane_packed.hpp"
     "${AVND_SOURCE_DIR}/include/avnd/wrappers/process/per_channel_arg.hpp"
     "${AVND_SOURCE_DIR}/include/avnd/wrappers/process/per_channel_port.hpp"
     "${AVND_SOURCE_DIR}/include/avnd/wrappers/process/per_frame_port.hpp"
@@ -144,8 +149,10 @@ set(AVENDISH_SOURCES
     "${AVND_SOURCE_DIR}/include/avnd/wrappers/process_bus/poly_arg.hpp"
     "${AVND_SOURCE_DIR}/include/avnd/wrappers/process_bus/poly_port.hpp"
 
+    "${AVND_SOURCE_DIR}/include/avnd/wrappers/audio_buffer.hpp"
     "${AVND_SOURCE_DIR}/include/avnd/wrappers/audio_channel_manager.hpp"
     "${AVND_SOURCE_DIR}/include/avnd/wrappers/avnd.hpp"
+    "${AVND_SOURCE_DIR}/include/avnd/wrappers/batched_voices.hpp"
     "${AVND_SOURCE_DIR}/include/avnd/wrappers/bus_host_process_adapter.hpp"
     "${AVND_SOURCE_DIR}/include/avnd/wrappers/callbacks_adapter.hpp"
     "${AVND_SOURCE_DIR}/include/avnd/wrappers/colors.hpp"
@@ -163,10 +170,15 @@ set(AVENDISH_SOURCES
     "${AVND_SOURCE_DIR}/include/avnd/wrappers/process_bus_adapter.hpp"
     "${AVND_SOURCE_DIR}/include/avnd/wrappers/process_execution.hpp"
     "${AVND_SOURCE_DIR}/include/avnd/wrappers/ranges.hpp"
+    "${AVND_SOURCE_DIR}/include/avnd/wrappers/simd_lanes.hpp"
     "${AVND_SOURCE_DIR}/include/avnd/wrappers/smooth.hpp"
     "${AVND_SOURCE_DIR}/include/avnd/wrappers/soundfile_storage.hpp"
+    "${AVND_SOURCE_DIR}/include/avnd/wrappers/stft.hpp"
     "${AVND_SOURCE_DIR}/include/avnd/wrappers/tensor_shim.hpp"
+    "${AVND_SOURCE_DIR}/include/avnd/wrappers/value_mailbox.hpp"
+    "${AVND_SOURCE_DIR}/include/avnd/wrappers/voice_pool.hpp"
     "${AVND_SOURCE_DIR}/include/avnd/wrappers/widgets.hpp"
+    "${AVND_SOURCE_DIR}/include/avnd/wrappers/window.hpp"
 
     "${AVND_SOURCE_DIR}/include/avnd/common/arithmetic.hpp"
     "${AVND_SOURCE_DIR}/include/avnd/common/aggregates.hpp"
@@ -176,6 +188,7 @@ set(AVENDISH_SOURCES
     "${AVND_SOURCE_DIR}/include/avnd/common/aggregates.recursive.hpp"
     "${AVND_SOURCE_DIR}/include/avnd/common/aggregates.simple.hpp"
     "${AVND_SOURCE_DIR}/include/avnd/common/aggregates.structured.hpp"
+    "${AVND_SOURCE_DIR}/include/avnd/common/aligned_allocator.hpp"
     "${AVND_SOURCE_DIR}/include/avnd/common/array.hpp"
     "${AVND_SOURCE_DIR}/include/avnd/common/concepts_polyfill.hpp"
     "${AVND_SOURCE_DIR}/include/avnd/common/coroutines.hpp"
@@ -223,6 +236,7 @@ set(AVENDISH_SOURCES
     "${AVND_SOURCE_DIR}/include/halp/controls_fmt.hpp"
     "${AVND_SOURCE_DIR}/include/halp/curve.hpp"
     "${AVND_SOURCE_DIR}/include/halp/custom_widgets.hpp"
+    "${AVND_SOURCE_DIR}/include/halp/deferred_log.hpp"
     "${AVND_SOURCE_DIR}/include/halp/device.hpp"
     "${AVND_SOURCE_DIR}/include/halp/device_compute.hpp"
     "${AVND_SOURCE_DIR}/include/halp/dynamic_port.hpp"
@@ -237,6 +251,7 @@ set(AVENDISH_SOURCES
     "${AVND_SOURCE_DIR}/include/halp/messages.hpp"
     "${AVND_SOURCE_DIR}/include/halp/meta.hpp"
     "${AVND_SOURCE_DIR}/include/halp/midi.hpp"
+    "${AVND_SOURCE_DIR}/include/halp/midi_event.hpp"
     "${AVND_SOURCE_DIR}/include/halp/midifile_port.hpp"
     "${AVND_SOURCE_DIR}/include/halp/modules.hpp"
     "${AVND_SOURCE_DIR}/include/halp/polyfill.hpp"
@@ -244,6 +259,7 @@ set(AVENDISH_SOURCES
     "${AVND_SOURCE_DIR}/include/halp/sample_accurate_controls.hpp"
     "${AVND_SOURCE_DIR}/include/halp/schedule.hpp"
     "${AVND_SOURCE_DIR}/include/halp/shared_instance.hpp"
+    "${AVND_SOURCE_DIR}/include/halp/simd.hpp"
     "${AVND_SOURCE_DIR}/include/halp/smooth_controls.hpp"
     "${AVND_SOURCE_DIR}/include/halp/smoothers.hpp"
     "${AVND_SOURCE_DIR}/include/halp/soundfile_port.hpp"
@@ -285,6 +301,7 @@ include(avendish.godot)
 include(avendish.packaging)
 include(avendish.wasm)
 include(avendish.fuzz)
+include(avendish.rtcheck)
 include(avendish.example)
 
 # Used for getting completion in IDEs...
@@ -314,6 +331,7 @@ function(avnd_make_object)
   avnd_make_dump(${ARGV})
   avnd_make_golden(${ARGV})
   _avnd_dispatch_backend(fuzz ${ARGV})
+  _avnd_dispatch_backend(rtcheck ${ARGV})
   avnd_make_ossia(${ARGV})
   _avnd_dispatch_backend(python ${ARGV})
   _avnd_dispatch_backend(pd ${ARGV})
@@ -332,6 +350,7 @@ function(avnd_make_audioplug)
   avnd_make_dump(${ARGV})
   avnd_make_golden(${ARGV})
   _avnd_dispatch_backend(fuzz ${ARGV})
+  _avnd_dispatch_backend(rtcheck ${ARGV})
   avnd_make_ossia(${ARGV})
   _avnd_dispatch_backend(vintage ${ARGV})
   _avnd_dispatch_backend(clap ${ARGV})
@@ -1,3 +1,19 @@
+# Examples which allocate or print in process() or in their messages on
+# purpose: their realtime-safety check is expected to fail.
+set(AVND_RTCHECK_EXPECTED_FAILURES
+  # printf / std::cout / std::cerr in message handlers
+  Messages
+  Init
+  HelpersMessages
+  CompleteMessageExample
+  # std::map of timed values, std::cout in operator()
+  SampleAccurateControls
+  # Resizes its output vector to the requested length
+  Poles
+  # Resizes its temporary buffer to the block size
+  Tutorial_Distortion
+)
+
 avnd_make_object(
   TARGET Aggregate
   MAIN_FILE examples/Raw/Aggregate.hpp
@@ -220,6 +236,20 @@ avnd_make_all(
   C_NAME avnd_helpers_per_sample_as_ports
   )
 
+avnd_make_all(
+  TARGET HelpersLaneLowpass
+  MAIN_FILE examples/Helpers/LaneLowpass.hpp
+  MAIN_CLASS examples::helpers::LaneLowpass
+  C_NAME avnd_helpers_lane_lowpass
+)
+
+avnd_make_all(
+  TARGET HelpersLaneSynth
+  MAIN_FILE examples/Helpers/LaneSynth.hpp
+  MAIN_CLASS examples::helpers::LaneSynth
+  C_NAME avnd_helpers_lane_synth
+)
+
 avnd_make_all(
   TARGET HelpersLowpass
   MAIN_FILE examples/Helpers/Lowpass.hpp
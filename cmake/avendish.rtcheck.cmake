@@ -0,0 +1,73 @@
+# SPDX-License-Identifier: GPL-3.0-or-later
+#
+# Realtime-safety harness: builds one executable per processor which runs a
+# few blocks through the process adapter, at both float and double precision,
+# for each channel layout and way of calling it, with control changes, MIDI
+# and messages in between, and fails if process() allocates, frees or takes a
+# blocking lock.
+#
+# Targets listed in AVND_RTCHECK_EXPECTED_FAILURES are expected to fail the
+# check: their test passes only if the harness does report a violation.
+#
+# The C allocator and pthread locks are only interposed on Linux / glibc;
+# elsewhere only operator new / delete are checked.
+
+function(avnd_make_rtcheck)
+  cmake_parse_arguments(AVND "" "TARGET;MAIN_FILE;MAIN_CLASS;C_NAME" "" ${ARGN})
+
+  set(AVND_FX_TARGET "${AVND_TARGET}_rtcheck")
+  if(TARGET "${AVND_FX_TARGET}")
+    return()
+  endif()
+
+  string(MAKE_C_IDENTIFIER "${AVND_MAIN_CLASS}" MAIN_OUT_FILE)
+
+  configure_file(
+    "${AVND_SOURCE_DIR}/include/avnd/binding/rtcheck/prototype.cpp.in"
+    "${CMAKE_BINARY_DIR}/${MAIN_OUT_FILE}_rtcheck.cpp"
+    @ONLY
+    NEWLINE_STYLE LF
+  )
+
+  add_executable(${AVND_FX_TARGET})
+
+  set_target_properties(
+    ${AVND_FX_TARGET}
+    PROPERTIES
+      RUNTIME_OUTPUT_DIRECTORY rtcheck
+  )
+
+  target_sources(
+    ${AVND_FX_TARGET}
+    PRIVATE
+      "${AVND_MAIN_FILE}"
+      "${CMAKE_BINARY_DIR}/${MAIN_OUT_FILE}_rtcheck.cpp"
+  )
+
+  target_link_libraries(
+    ${AVND_FX_TARGET}
+    PRIVATE
+      Avendish::Avendish_rtcheck
+      ${CMAKE_DL_LIBS}
+  )
+
+  avnd_common_setup("${AVND_TARGET}" "${AVND_FX_TARGET}")
+
+  # Every registered object becomes a `ctest` test.
+  # Run with AVND_RTCHECK_ABORT=1 to stop in a debugger on the first violation.
+  if(BUILD_TESTING)
+    add_test(
+      NAME "rtcheck_${AVND_TARGET}"
+      COMMAND ${AVND_FX_TARGET})
+    set_tests_properties("rtcheck_${AVND_TARGET}" PROPERTIES
+      LABELS "rtcheck"
+      TIMEOUT 60)
+    if("${AVND_TARGET}" IN_LIST AVND_RTCHECK_EXPECTED_FAILURES)
+      set_tests_properties("rtcheck_${AVND_TARGET}" PROPERTIES WILL_FAIL TRUE)
+    endif()
+  endif()
+endfunction()
+
+add_library(Avendish_rtcheck INTERFACE)
+target_link_libraries(Avendish_rtcheck INTERFACE Avendish)
+add_library(Avendish::Avendish_rtcheck ALIAS Avendish_rtcheck)
@@ -15,6 +15,7 @@ avnd_make_texture(TARGET TestTexR32F    MAIN_FILE examples/Tests/TestTexR32FPass
 avnd_make_texture(TARGET TestTexRGBA32F MAIN_FILE examples/Tests/TestTexRGBA32FPassthrough.hpp MAIN_CLASS examples::tests::TestTexRGBA32FPassthrough C_NAME avnd_test_tex_rgba32f)
 avnd_make_texture(TARGET TestTexGen     MAIN_FILE examples/Tests/TestTexGenerator.hpp          MAIN_CLASS examples::tests::TestTexGenerator          C_NAME avnd_test_tex_generator)
 avnd_make_texture(TARGET TestTexVar     MAIN_FILE examples/Tests/TestTexVariableInput.hpp      MAIN_CLASS examples::tests::TestTexVariableInput      C_NAME avnd_test_tex_variable)
+avnd_make_texture(TARGET TestTexInPlace MAIN_FILE examples/Tests/TestTexInPlaceInvert.hpp      MAIN_CLASS examples::tests::TestTexInPlaceInvert      C_NAME avnd_test_tex_in_place)
 
 ### Controls / value I/O (§1, §2) ###
 avnd_make_all(TARGET TestFloatSlider      MAIN_FILE examples/Tests/TestFloatSlider.hpp      MAIN_CLASS examples::tests::TestFloatSlider       C_NAME avnd_test_float_slider)
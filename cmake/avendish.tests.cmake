@@ -47,6 +47,17 @@ if(BUILD_TESTING)
   avnd_add_executable_test(test_reflection tests/test_reflection.cpp)
 
   avnd_add_catch_test(test_quantification tests/quantification.cpp)
+  avnd_add_catch_test(test_fft tests/test_fft.cpp)
+  avnd_add_catch_test(test_smooth tests/test_smooth.cpp)
+  avnd_add_catch_test(test_stft tests/test_stft.cpp)
+  avnd_add_catch_test(test_curve_evaluator tests/test_curve_evaluator.cpp)
+  avnd_add_catch_test(test_midi_event tests/test_midi_event.cpp)
+  avnd_add_catch_test(test_deferred_logger tests/test_deferred_logger.cpp)
+  avnd_add_catch_test(test_voice_pool tests/test_voice_pool.cpp)
+  avnd_add_catch_test(test_batched_voices tests/test_batched_voices.cpp)
+  avnd_add_catch_test(test_interleave tests/test_interleave.cpp)
+  avnd_add_catch_test(test_value_mailbox tests/test_value_mailbox.cpp)
+  avnd_add_catch_test(test_for_nth tests/test_for_nth.cpp)
   avnd_add_catch_test(test_gain tests/objects/gain.cpp)
   avnd_add_catch_test(test_patternal tests/objects/patternal.cpp)
 
@@ -55,6 +66,11 @@ if(BUILD_TESTING)
   # channel 1 a copy of channel 0).
   avnd_add_catch_test(test_polyphony_channels tests/objects/polyphony_channels.cpp)
 
+  # Nothing on the audio path may allocate: process() and reading back the
+  # outputs of every per-channel instance, receiving MIDI, under a counting
+  # operator new.
+  avnd_add_catch_test(test_allocation_free tests/objects/allocation_free.cpp)
+
   # Report parsing / stall detection of the Max golden harness. Pure Python, no
   # Max needed -- these cover the bugs that once made the harness blame slow
   # objects for crashing Max.
@@ -71,6 +87,24 @@ if(BUILD_TESTING)
   if(AVND_ENABLE_CLAP AND CLAP_HEADER)
     avnd_add_catch_test(test_params_flush tests/objects/params_flush.cpp)
     target_include_directories(test_params_flush PRIVATE "${CLAP_HEADER}")
+    avnd_add_catch_test(test_clap_block_split tests/objects/clap_block_split.cpp)
+    target_include_directories(test_clap_block_split PRIVATE "${CLAP_HEADER}")
+  endif()
+
+  # VST3 parameter queues: block splitting and sample-accurate controls.
+  if(AVND_ENABLE_VST3 AND TARGET sdk_common)
+    avnd_add_catch_test(test_vst3_block_split tests/objects/vst3_block_split.cpp)
+    target_link_libraries(test_vst3_block_split PRIVATE sdk_common pluginterfaces)
+  endif()
+
+  # Python binding, end to end: imports the python modules of the test objects
+  # (ports, audio streams and their numpy buffers). Skipped without numpy.
+  if(Python3_Interpreter_FOUND AND TARGET pybind11::headers)
+    add_test(
+      NAME test_avnd_python
+      COMMAND "${Python3_EXECUTABLE}" "${AVND_SOURCE_DIR}/tooling/test_avnd_python.py"
+              "${CMAKE_BINARY_DIR}/python")
+    set_tests_properties(test_avnd_python PROPERTIES SKIP_RETURN_CODE 77)
   endif()
 endif()
 
@@ -190,6 +190,7 @@ target_sources(Avendish PRIVATE
   "${AVND_SOURCE_DIR}/include/avnd/binding/vst3/controller_base.hpp"
   "${AVND_SOURCE_DIR}/include/avnd/binding/vst3/factory.hpp"
   "${AVND_SOURCE_DIR}/include/avnd/binding/vst3/helpers.hpp"
+  "${AVND_SOURCE_DIR}/include/avnd/binding/vst3/interface_ids.hpp"
   "${AVND_SOURCE_DIR}/include/avnd/binding/vst3/metadata.hpp"
   "${AVND_SOURCE_DIR}/include/avnd/binding/vst3/programs.hpp"
   "${AVND_SOURCE_DIR}/include/avnd/binding/vst3/refcount.hpp"
@@ -23,6 +23,7 @@ public:
   halp_meta(description, "Basic echo audio effect")
   halp_meta(manual_url, "https://ossia.io/score-docs/processes/audio-effects.html#echo")
   halp_meta(uuid, "d7b7d998-e9d2-4575-9cf4-be5fec20195f")
+  halp_flag(channel_major);
 
   struct inputs
   {
@@ -24,6 +24,7 @@ public:
   halp_meta(
       manual_url, "https://ossia.io/score-docs/processes/audio-effects.html#flanger")
   halp_meta(uuid, "538165be-18f0-4bbf-bcf0-ef9b97d6a1b1")
+  halp_flag(channel_major);
 
   struct inputs
   {
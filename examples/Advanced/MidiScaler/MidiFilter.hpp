@@ -2,6 +2,7 @@
 
 /* SPDX-License-Identifier: GPL-3.0-or-later */
 
+#include <array>
 #include <cmath>
 #include <halp/audio.hpp>
 #include <halp/callback.hpp>
@@ -9,6 +10,7 @@
 #include <halp/file_port.hpp>
 #include <halp/meta.hpp>
 #include <halp/midi.hpp>
+#include <halp/midi_event.hpp>
 #include <halp/midifile_port.hpp>
 #include <libremidi/message.hpp>
 #include <ossia/detail/flat_set.hpp>
@@ -89,10 +91,45 @@ struct MidiFilter
         poly_raw;
   } outputs;
 
+  //! Maximum number of MIDI messages output per block,
+  //! as many as the bindings reserve at least for the input
+  static constexpr int max_output = 512;
+
   ossia::small_flat_map<int, int, 128> running;
   ossia::small_vector<uint8_t, 128> out_no_vel;
   ossia::small_vector<note_int, 128> out_vel;
 
+  //! The messages let through, in input order, until they are written to the
+  //! MIDI output
+  std::array<halp::midi_event, max_output> filtered;
+  int filtered_count{};
+
+  //! Only channel messages are let through: they are one event each
+  void pass(const libremidi::message& m) noexcept
+  {
+    if(filtered_count < max_output)
+      halp::midi1_to_events(
+          m.bytes.data(), m.bytes.size(), int32_t(m.timestamp),
+          [this](const halp::midi_event& e) { filtered[filtered_count++] = e; });
+  }
+
+  //! Every message let through is written: bindings which do not reserve
+  //! room in the output, as ossia does, get it grown here
+  void write_output()
+  {
+    auto& out = outputs.midi.midi_messages;
+    out.reserve(out.size() + filtered_count);
+    for(int i = 0; i < filtered_count; i++)
+    {
+      const halp::midi_event& e = filtered[i];
+      uint8_t bytes[8];
+      const int n = halp::midi1_from_event(e, bytes);
+      auto& msg = out.emplace_back();
+      msg.bytes.assign(bytes, bytes + n);
+      msg.timestamp = e.timestamp;
+    }
+  }
+
   using tick = halp::tick_musical;
   void push_poly(int ts)
   {
@@ -157,7 +194,7 @@ struct MidiFilter
     const int vel = (int)m.bytes[2];
     if(inputs.index == 0 || inputs.index == pitch)
     {
-      outputs.midi.push_back(m);
+      pass(m);
       switch(inputs.mode)
       {
         case Both: {
@@ -181,6 +218,7 @@ struct MidiFilter
 
   void operator()()
   {
+    filtered_count = 0;
     for(auto& m : inputs.midi)
     {
       if(inputs.channel != 0 && m.get_channel() == inputs.channel)
@@ -209,7 +247,7 @@ struct MidiFilter
 
         if(inputs.index == 0 || inputs.index == m.bytes[1])
         {
-          outputs.midi.push_back(m);
+          pass(m);
           if(inputs.note_off_to_zero)
           {
             switch(inputs.mode)
@@ -293,35 +331,23 @@ struct MidiFilter
         case Type::AfterTouch:
           if(t == libremidi::message_type::AFTERTOUCH)
           {
-            outputs.midi.push_back(m);
+            pass(m);
             outputs.raw(m.timestamp, m.bytes[1]);
             outputs.normalized(m.timestamp, m.bytes[1] / 127.);
           }
           break;
         case Type::CC:
           if(t == libremidi::message_type::CONTROL_CHANGE)
-          {
-            if(inputs.index == 0 || inputs.index == m.bytes[1])
-            {
-              outputs.midi.push_back(m);
-              output_2_bytes(m);
-            }
-          }
+            output_2_bytes(m);
           break;
         case Type::PolyPressure:
           if(t == libremidi::message_type::POLY_PRESSURE)
-          {
-            if(inputs.index == 0 || inputs.index == m.bytes[1])
-            {
-              outputs.midi.push_back(m);
-              output_2_bytes(m);
-            }
-          }
+            output_2_bytes(m);
           break;
         case Type::PitchBend:
           if(t == libremidi::message_type::PITCH_BEND)
           {
-            outputs.midi.push_back(m);
+            pass(m);
             const int pb = m.bytes[2] * 128 + m.bytes[1];
             outputs.raw(m.timestamp, pb);
             outputs.normalized(m.timestamp, pb / (128. * 128.) - 0.5);
@@ -329,6 +355,8 @@ struct MidiFilter
           break;
       }
     }
+
+    write_output();
   }
 };
 }
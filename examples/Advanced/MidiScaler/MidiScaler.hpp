@@ -12,8 +12,8 @@
 #include <halp/file_port.hpp>
 #include <halp/meta.hpp>
 #include <halp/midi.hpp>
+#include <halp/midi_event.hpp>
 #include <halp/midifile_port.hpp>
-#include <libremidi/message.hpp>
 
 #include <QDebug>
 
@@ -165,20 +165,13 @@ struct MidiScaler
     // Update the active notes
     for(auto& msg : this->inputs.midi)
     {
-      libremidi::message m;
-      m.bytes.assign(msg.bytes.begin(), msg.bytes.end());
-
-      switch(m.get_message_type())
-      {
-        case libremidi::message_type::NOTE_ON:
-          this->active[m.bytes[1]] = m.bytes[2];
-          break;
-        case libremidi::message_type::NOTE_OFF:
-          this->active[m.bytes[1]] = 0;
-          break;
-        default:
-          break;
-      }
+      halp::midi1_to_events(
+          msg.bytes.data(), msg.bytes.size(), 0, [this](const halp::midi_event& m) {
+        if(m.is_note_on())
+          this->active[m.data1()] = m.data2();
+        else if(m.is_note_off())
+          this->active[m.data1()] = 0;
+      });
     }
 
     for(std::size_t note = 0; note < this->active.size(); note++)
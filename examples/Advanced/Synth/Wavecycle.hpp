@@ -36,6 +36,7 @@ public:
   } outputs;
 
   int rate{};
+  halp::curve_evaluator<halp::custom_curve> curve;
   void prepare(halp::setup info) noexcept { this->rate = info.rate; }
 
   using tick = halp::tick_musical;
@@ -51,7 +52,8 @@ public:
     for(int i = 0; i < frames.frames; i++, current_sample++)
     {
       outputs.audio.channel[i]
-          = inputs.curve.value.value_at((current_sample % isamples) / double(samples))
+          = curve.value_at(
+                inputs.curve.value, (current_sample % isamples) / double(samples))
             - 0.5;
     }
   }
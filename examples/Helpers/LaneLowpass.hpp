@@ -0,0 +1,48 @@
+#pragma once
+
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+#include <halp/controls.hpp>
+#include <halp/meta.hpp>
+#include <halp/simd.hpp>
+
+namespace examples::helpers
+{
+
+/**
+ * A one-pole lowpass written once for any sample type.
+ *
+ * The host sees the double version. As it declares a lane-generic version of
+ * itself, the per-sample adapter runs it with halp::simd packs instead:
+ * a single instance then filters 4 or 8 channels at once.
+ */
+// Shared by all the lane versions, so that they all read the same controls
+struct LaneLowpassInputs
+{
+  halp::hslider_f32<"Weight", halp::range{.min = 0., .max = 1., .init = 0.5}> weight;
+};
+
+template <typename V>
+struct BasicLaneLowpass
+{
+  halp_meta(name, "Lowpass (lanes)")
+  halp_meta(c_name, "avnd_helpers_lane_lowpass")
+  halp_meta(uuid, "0b7c7d8e-4f0b-4a4e-9a84-61f1c5d1f6a2")
+
+  template <typename U>
+  using lanes = BasicLaneLowpass<U>;
+
+  using inputs = LaneLowpassInputs;
+
+  V operator()(V in, const inputs& ins)
+  {
+    const V w = ins.weight.value;
+    previous = w * in + (1. - w) * previous;
+    return previous;
+  }
+
+  V previous{};
+};
+
+using LaneLowpass = BasicLaneLowpass<double>;
+}
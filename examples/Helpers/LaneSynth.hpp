@@ -0,0 +1,152 @@
+#pragma once
+
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+#include <avnd/wrappers/batched_voices.hpp>
+#include <halp/audio.hpp>
+#include <halp/controls.hpp>
+#include <halp/meta.hpp>
+#include <halp/midi.hpp>
+#include <halp/simd.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+namespace examples::helpers
+{
+
+/**
+ * The voices of LaneSynth: decaying sines, written once for a pack of samples.
+ *
+ * voice_lanes<V> holds the state of as many voices as V has lanes, one voice
+ * per lane, as structures of arrays: avnd::batched_voices then renders all
+ * the voices of a pack at once.
+ */
+struct LaneSynthVoices
+{
+  template <typename V>
+  struct voice_lanes
+  {
+    using FP = typename V::value_type;
+
+    V frequency{};
+    V phase{};
+    V gain{};
+    V released{};
+
+    void start(int lane, int note, float velocity)
+    {
+      frequency[lane] = FP(440. * std::exp2((note - 69) / 12.));
+      phase[lane] = 0;
+      gain[lane] = velocity / 127.f;
+      released[lane] = 0;
+    }
+
+    void release(int lane) { released[lane] = 1; }
+
+    bool finished(int lane) const { return released[lane] > 0 && gain[lane] < 1e-4f; }
+
+    void operator()(LaneSynthVoices& synth, V** out, int frames)
+    {
+      using std::floor;
+      using std::sin;
+      constexpr FP two_pi = 2 * std::numbers::pi_v<FP>;
+
+      const V increment = frequency * V(two_pi / synth.rate);
+      const V decay = V(1) - released * V(1 - synth.release);
+      const V volume = V(synth.volume);
+      for(int i = 0; i < frames; i++)
+      {
+        const V s = sin(phase) * gain * volume;
+        out[0][i] += s;
+        out[1][i] += s;
+        phase += increment;
+        gain *= decay;
+      }
+      phase -= floor(phase / V(two_pi)) * V(two_pi);
+    }
+  };
+
+  double rate{48000.};
+  float volume{0.5f};
+
+  // Gain multiplier per sample once a voice is released
+  float release{0.9999f};
+};
+
+/**
+ * A polyphonic synth whose voices are rendered 4 or 8 at a time in SIMD
+ * lanes by avnd::batched_voices. Notes start and stop at their timestamp.
+ */
+struct LaneSynth
+{
+  halp_meta(name, "Synth (lanes)")
+  halp_meta(c_name, "avnd_helpers_lane_synth")
+  halp_meta(uuid, "6e1d4c2a-8b3f-4a57-9c0e-2f7b5d9a1e43")
+
+  struct
+  {
+    halp::midi_bus<"MIDI"> midi;
+    halp::hslider_f32<"Volume", halp::range{.min = 0., .max = 1., .init = 0.5}> volume;
+    halp::hslider_f32<"Release", halp::range{.min = 0.01, .max = 2., .init = 0.3}>
+        release;
+  } inputs;
+
+  struct
+  {
+    halp::fixed_audio_bus<"Out", float, 2> audio;
+  } outputs;
+
+  void prepare(halp::setup info)
+  {
+    synth.rate = info.rate;
+    voices.reserve(2, info.frames);
+  }
+
+  void operator()(int frames)
+  {
+    // The release time is the time the gain takes to decay by e
+    synth.volume = inputs.volume.value;
+    synth.release = std::exp(-1. / (inputs.release.value * synth.rate));
+
+    for(int c = 0; c < 2; c++)
+      std::fill_n(outputs.audio[c], frames, 0.f);
+
+    int start = 0;
+    for(auto& m : inputs.midi)
+    {
+      const int t = std::clamp(int(m.timestamp), start, frames);
+      render(start, t);
+      start = t;
+
+      if(m.bytes.size() < 3)
+        continue;
+      switch(m.bytes[0] & 0xF0)
+      {
+        case 0x90:
+          if(m.bytes[2] > 0)
+            voices.note_on(m.bytes[1], m.bytes[2]);
+          else
+            voices.note_off(m.bytes[1]);
+          break;
+        case 0x80:
+          voices.note_off(m.bytes[1]);
+          break;
+      }
+    }
+    render(start, frames);
+  }
+
+  void render(int begin, int end)
+  {
+    if(end <= begin)
+      return;
+    float* out[2] = {outputs.audio[0] + begin, outputs.audio[1] + begin};
+    voices.render(synth, out, 2, end - begin);
+  }
+
+  LaneSynthVoices synth;
+  avnd::batched_voices<LaneSynthVoices, float, 32> voices;
+};
+}
@@ -5,6 +5,7 @@
 #include <halp/audio.hpp>
 #include <halp/controls.hpp>
 #include <halp/meta.hpp>
+#include <halp/smooth_controls.hpp>
 #include <halp/smoothers.hpp>
 
 #include <vector>
@@ -87,4 +88,54 @@ public:
     outputs.audio.sample = inputs.audio.sample * inputs.gain;
   }
 };
+
+/**
+ * Smooth gain, with a per-sample ramp over the whole buffer:
+ * the smoothing does not depend on the buffer size.
+ */
+class SmoothGainRamp
+{
+public:
+  halp_meta(name, "Smooth Gain")
+  halp_meta(c_name, "avnd_helpers_smooth_gain")
+  halp_meta(uuid, "032e1734-f84a-4eb2-9d14-01fc3dea4c14")
+
+  using setup = halp::setup;
+  using tick = halp::tick;
+
+  struct
+  {
+    halp::dynamic_audio_bus<"Input", double> audio;
+    halp::smooth_ramp_control<
+        halp::hslider_f32<"Gain", halp::range{.min = 0., .max = 1., .init = 0.5}>>
+        gain;
+  } inputs;
+
+  struct
+  {
+    halp::dynamic_audio_bus<"Output", double> audio;
+  } outputs;
+
+  void operator()(halp::tick t)
+  {
+    const auto& ramp = inputs.gain.ramp;
+    for(int i = 0; i < inputs.audio.channels; i++)
+    {
+      auto* in = inputs.audio[i];
+      auto* out = outputs.audio[i];
+
+      if(ramp.empty())
+      {
+        // The gain did not move during this buffer
+        for(int j = 0; j < t.frames; j++)
+          out[j] = inputs.gain * in[j];
+      }
+      else
+      {
+        for(int j = 0; j < t.frames; j++)
+          out[j] = ramp[j] * in[j];
+      }
+    }
+  }
+};
 }
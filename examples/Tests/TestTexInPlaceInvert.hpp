@@ -0,0 +1,59 @@
+#pragma once
+
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+#include <halp/meta.hpp>
+#include <halp/texture.hpp>
+
+#include <cstddef>
+
+namespace examples::tests
+{
+/**
+ * Inverts the colours of an 8-bit RGBA texture, in place where the binding
+ * supports it (e.g. GStreamer, through transform_ip): the output texture then
+ * already points to the input texture when the processor runs.
+ */
+struct TestTexInPlaceInvert
+{
+  halp_meta(name, "Test Texture in-place invert")
+  halp_meta(c_name, "avnd_test_tex_in_place")
+  halp_meta(category, "Tests/Texture")
+  halp_meta(description, "Inverts an 8-bit RGBA texture over itself")
+  halp_meta(uuid, "5b0f6e2d-93c4-4d1a-8e27-c4a9f1d30b66")
+  halp_flag(texture_in_place);
+
+  struct
+  {
+    halp::texture_input<"In", halp::rgba_texture> image;
+  } inputs;
+  struct
+  {
+    halp::texture_output<"Out", halp::rgba_texture> image;
+  } outputs;
+
+  void operator()()
+  {
+    auto& in = inputs.image.texture;
+    auto& out = outputs.image.texture;
+    if(in.bytes == nullptr || in.width <= 0 || in.height <= 0)
+      return;
+
+    // Bindings without in-place support leave the output to the processor
+    if(out.bytes != in.bytes && (out.width != in.width || out.height != in.height))
+      outputs.image.create(in.width, in.height);
+    if(out.bytes == nullptr)
+      return;
+
+    const std::size_t n = std::size_t(in.width) * in.height * 4;
+    for(std::size_t i = 0; i < n; i += 4)
+    {
+      out.bytes[i + 0] = 255 - in.bytes[i + 0];
+      out.bytes[i + 1] = 255 - in.bytes[i + 1];
+      out.bytes[i + 2] = 255 - in.bytes[i + 2];
+      out.bytes[i + 3] = in.bytes[i + 3];
+    }
+    outputs.image.upload();
+  }
+};
+}
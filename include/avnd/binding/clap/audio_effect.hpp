@@ -14,6 +14,7 @@
 #include <avnd/wrappers/metadatas.hpp>
 #include <avnd/wrappers/prepare.hpp>
 #include <avnd/wrappers/process_adapter.hpp>
+#include <avnd/wrappers/stft.hpp>
 #include <avnd/wrappers/widgets.hpp>
 #include <clap/all.h>
 
@@ -24,91 +25,51 @@ namespace avnd_clap
 template <typename T>
 struct midi_processor : public avnd::midi_storage<T>
 {
-  void
-  init_midi_message(avnd::dynamic_midi_message auto& in, const clap_event_note_t& ev)
+  // Nothing here may allocate: the message storage and the sysex arena
+  // are reserved by midi_storage::reserve_space.
+  bool init_midi_message(avnd::midi_message auto& in, const clap_event_note_t& ev)
   {
     using mb = unsigned char;
+    mb status{};
     switch(ev.header.type)
     {
       case CLAP_EVENT_NOTE_ON:
-        in.bytes = {mb(0x90 | ev.channel), mb(ev.key), mb(ev.velocity * 127)};
+        status = 0x90;
         break;
       case CLAP_EVENT_NOTE_OFF:
-        in.bytes = {mb(0x80 | ev.channel), mb(ev.key), mb(ev.velocity * 127)};
+        status = 0x80;
         break;
       default:
         // TODO
-        break;
-    }
-    if_possible(in.timestamp = ev.header.time);
-  }
-  void init_midi_message(
-      avnd::dynamic_midi_message auto& in, const clap_event_midi_sysex_t& ev)
-  {
-    using mb = unsigned char;
-    in.bytes.assign(ev.buffer, ev.buffer + ev.size);
-    if_possible(in.timestamp = ev.header.time);
-  }
-
-  void
-  init_midi_message(avnd::dynamic_midi_message auto& in, const clap_event_midi_t& ev)
-  {
-    using mb = unsigned char;
-    in.bytes.assign(ev.data, ev.data + 3);
-    if_possible(in.timestamp = ev.header.time);
-  }
-
-  void init_midi_message(avnd::raw_midi_message auto& in, const clap_event_note_t& ev)
-  {
-    using bytes_type = decltype(in.bytes);
-    switch(ev.header.type)
-    {
-      case CLAP_EVENT_NOTE_ON:
-        in.bytes[0] = 0x90 | ev.channel;
-        in.bytes[1] = ev.key;
-        in.bytes[2] = ev.velocity * 127;
-        break;
-      case CLAP_EVENT_NOTE_OFF:
-        in.bytes[0] = 0x80 | ev.channel;
-        in.bytes[1] = ev.key;
-        in.bytes[2] = ev.velocity * 127;
-        break;
-      default:
-        // TODO
-        break;
+        return false;
     }
+    const mb bytes[3]{mb(status | ev.channel), mb(ev.key), mb(ev.velocity * 127)};
     if_possible(in.timestamp = ev.header.time);
+    return this->assign_bytes(in, bytes, 3);
   }
 
-  void
-  init_midi_message(avnd::raw_midi_message auto& in, const clap_event_midi_sysex_t& ev)
+  bool
+  init_midi_message(avnd::midi_message auto& in, const clap_event_midi_sysex_t& ev)
   {
-    using bytes_type = decltype(in.bytes);
-    // FIXME unsuppported
     if_possible(in.timestamp = ev.header.time);
+    return this->assign_bytes(in, ev.buffer, ev.size);
   }
 
-  void init_midi_message(avnd::raw_midi_message auto& in, const clap_event_midi_t& ev)
+  bool init_midi_message(avnd::midi_message auto& in, const clap_event_midi_t& ev)
   {
-    using bytes_type = decltype(in.bytes);
     static_assert(sizeof(in.bytes[0]) == sizeof(ev.data[0]));
-    memcpy(std::begin(in.bytes), ev.data, 3);
     if_possible(in.timestamp = ev.header.time);
+    return this->assign_bytes(in, ev.data, 3);
   }
 
-  void add_message(avnd::dynamic_container_midi_port auto& port, const auto& msg)
-  {
-    port.midi_messages.push_back({});
-    auto& elt = port.midi_messages.back();
-    init_midi_message(elt, msg);
-  }
-
-  void add_message(avnd::raw_container_midi_port auto& port, const auto& msg)
+  // Events beyond the reserved capacity are dropped
+  void add_message(avnd::midi_port auto& port, const auto& msg)
   {
-    auto& elt = port.midi_messages[port.size];
-    init_midi_message(elt, msg);
-
-    port.size++;
+    auto elt = this->push_message(port);
+    if(!elt)
+      return;
+    if(!init_midi_message(*elt, msg))
+      this->pop_message(port);
   }
 };
 
@@ -121,6 +82,8 @@ struct SimpleAudioEffect : clap_plugin
   using midi_in_info = avnd::midi_input_introspection<T>;
   using midi_out_info = avnd::midi_output_introspection<T>;
   static const constexpr int32_t parameter_count = param_in_info::size;
+  static constexpr bool split_on_parameter_changes
+      = avnd::tag_split_on_parameter_changes<T> && param_in_info::size > 0;
 
   avnd::effect_container<T> effect;
 
@@ -133,6 +96,9 @@ struct SimpleAudioEffect : clap_plugin
   AVND_NO_UNIQUE_ADDRESS avnd::control_storage<T> control_buffers;
   AVND_NO_UNIQUE_ADDRESS midi_processor<T> midi;
 
+  // Analysis feeding the spectrum input ports
+  AVND_NO_UNIQUE_ADDRESS avnd::stft_storage<T> spectrums;
+
   float sample_rate{44100.};
   int buffer_size{512};
 
@@ -185,6 +151,9 @@ struct SimpleAudioEffect : clap_plugin
         return &p.audio_ports;
       if(id_sv == "clap.note-ports")
         return &p.note_ports;
+      if constexpr(avnd::stft_storage<T>::resynthesis)
+        if(id_sv == "clap.latency")
+          return p.get_latency();
 
       return nullptr;
     };
@@ -235,6 +204,9 @@ struct SimpleAudioEffect : clap_plugin
       midi.reserve_space(this->effect, buffer_size);
     }
 
+    if constexpr(sizeof(spectrums) > 1)
+      spectrums.reserve_space(effect, setup_info.input_channels, buffer_size);
+
     // Effect-specific preparation
     avnd::prepare(effect, setup_info);
   }
@@ -288,9 +260,58 @@ struct SimpleAudioEffect : clap_plugin
       if(!outputs[i])
         outputs[i] = trash_buffer<samples_t>();
 
+    const uint32_t frames = process.frames_count;
+    if constexpr(split_on_parameter_changes)
+    {
+      // Run the processor on each span of frames between two changes
+      // of a plain control.
+      uint32_t event = 0;
+      uint32_t start = 0;
+      do
+      {
+        const uint32_t end = process_in_events(process, event, start);
+        run_block(inputs, in_N, outputs, out_N, end - start);
+
+        for(int i = 0; i < in_N; i++)
+          inputs[i] += end - start;
+        for(int i = 0; i < out_N; i++)
+          outputs[i] += end - start;
+        start = end;
+
+        if(start < frames)
+          clear_inputs();
+      } while(start < frames);
+    }
+    else
+    {
+      uint32_t event = 0;
+      process_in_events(process, event, 0);
+      run_block(inputs, in_N, outputs, out_N, frames);
+    }
+  }
+
+  template <typename samples_t>
+  void run_block(
+      samples_t** inputs, int in_N, samples_t** outputs, int out_N, uint32_t frames)
+  {
+    avnd::span<samples_t*> in{inputs, std::size_t(in_N)};
+
+    // Resynthesized spectrum ports replace their input channels
+    if constexpr(sizeof(spectrums) > 1)
+      in = spectrums.analyze(effect, in, frames);
+
     processor.process(
-        effect, avnd::span<samples_t*>{inputs, std::size_t(in_N)},
-        avnd::span<samples_t*>{outputs, std::size_t(out_N)}, process.frames_count);
+        effect, in, avnd::span<samples_t*>{outputs, std::size_t(out_N)}, frames);
+  }
+
+  void clear_inputs()
+  {
+    // Clear the sample-accurate control in ports
+    if constexpr(sizeof(control_buffers) > 1)
+      control_buffers.clear_inputs(this->effect);
+
+    // Clear the midi in ports
+    midi.clear_inputs(this->effect);
   }
 
   // Scratch rows substituted for null host channel pointers. Sized in
@@ -326,10 +347,7 @@ struct SimpleAudioEffect : clap_plugin
     // Clear the midi out ports
     midi.clear_outputs(this->effect);
 
-    // Process the input events
-    process_in_events(process);
-
-    // Process the audio
+    // Process the input events and the audio
     {
       int in_N = avnd::input_channels<T>(2);
       int out_N = avnd::output_channels<T>(2);
@@ -377,16 +395,11 @@ struct SimpleAudioEffect : clap_plugin
     // Process the output events
     process_out_events(process);
 
-    // Clear the sample-accurate control in ports
-    if constexpr(sizeof(control_buffers) > 1)
-      control_buffers.clear_inputs(this->effect);
-
-    // Clear the midi in ports
-    midi.clear_inputs(this->effect);
+    clear_inputs();
   }
 
   // Representative shared-controls inputs for reads / MIDI dispatch. inputs() is
-  // a per-instance member_iterator for polyphonic effects, which the field
+  // a per-instance member_range for polyphonic effects, which the field
   // introspection helpers can't take; use the first instance.
   decltype(auto) controls_inputs() noexcept
   {
@@ -403,7 +416,7 @@ struct SimpleAudioEffect : clap_plugin
     }
   }
 
-  void process_param(const clap_event_param_value& p)
+  void process_param(const clap_event_param_value& p, int frame = -1)
   {
     // Parameter ids are the RAW field indices (as advertised by
     // get_param_info) and values are PLAIN, in the [min_value, max_value]
@@ -417,8 +430,43 @@ struct SimpleAudioEffect : clap_plugin
             if constexpr(requires {
                            field.value = avnd::map_control_from_double<C>(p.value);
                          })
+            {
               field.value = avnd::map_control_from_double<C>(p.value);
+            }
           });
+
+    // Sample-accurate controls additionally get the change at frame of the
+    // current (sub-)block, if any: this is recorded once for all the instances.
+    param_in_info::for_nth_raw(
+        controls_inputs(), p.param_id, [&]<typename C>(C& field) {
+          if constexpr(requires {
+                         field.value = avnd::map_control_from_double<C>(p.value);
+                       })
+          {
+            control_buffers.add_timed_value(
+                this->effect, field, field.value, frame, buffer_size);
+          }
+        });
+  }
+
+  // Whether a change of this parameter must start a new sub-block
+  static bool splits_block(clap_id param_id) noexcept
+  {
+    bool res = false;
+    param_in_info::for_nth_raw(
+        param_id, [&]<std::size_t Index, typename C>(avnd::field_reflection<Index, C>) {
+          res = !avnd::sample_accurate_parameter_port<C>;
+        });
+    return res;
+  }
+
+  // Event timestamps are relative to the sub-block being processed
+  template <typename Event>
+  static Event rebase(const clap_event_header_t* ev, uint32_t start) noexcept
+  {
+    Event e = *reinterpret_cast<const Event*>(ev);
+    e.header.time = e.header.time > start ? e.header.time - start : 0;
+    return e;
   }
 
   void process_transport(const clap_event_transport& transport)
@@ -426,15 +474,21 @@ struct SimpleAudioEffect : clap_plugin
     // TODO
   }
 
-  void process_in_events(const clap_process& p)
+  /**
+   * Applies the input events from index onwards, to the sub-block starting at
+   * frame start. When splitting blocks, stops at the first later change of a
+   * plain control and returns its frame, otherwise returns the block size.
+   */
+  uint32_t process_in_events(const clap_process& p, uint32_t& index, uint32_t start)
   {
     // Parameter and transport events apply to every plug-in; only the MIDI
     // cases depend on having MIDI inputs.
-    auto N = p.in_events->size(p.in_events);
+    const uint32_t frames = p.frames_count;
+    const auto N = p.in_events->size(p.in_events);
 
-    for(uint32_t i = 0; i < N; i++)
+    for(; index < N; index++)
     {
-      const clap_event_header_t* ev = p.in_events->get(p.in_events, i);
+      const clap_event_header_t* ev = p.in_events->get(p.in_events, index);
 
       switch(ev->type)
       {
@@ -442,41 +496,46 @@ struct SimpleAudioEffect : clap_plugin
         case CLAP_EVENT_NOTE_OFF: {
           if constexpr(midi_in_info::size > 0)
           {
+            const auto note = rebase<clap_event_note_t>(ev, start);
             midi_in_info::for_nth_mapped(
-                controls_inputs(), ((clap_event_note_t*)ev)->port_index,
-                [&]<typename C>(C& in_port) {
-              midi.add_message(in_port, *(clap_event_note_t*)ev);
-            });
+                controls_inputs(), note.port_index,
+                [&]<typename C>(C& in_port) { midi.add_message(in_port, note); });
           }
           break;
         }
         case CLAP_EVENT_MIDI: {
           if constexpr(midi_in_info::size > 0)
           {
+            const auto msg = rebase<clap_event_midi_t>(ev, start);
             midi_in_info::for_nth_mapped(
-                controls_inputs(), ((clap_event_midi_t*)ev)->port_index,
-                [&]<typename C>(C& in_port) {
-              midi.add_message(in_port, *(clap_event_midi_t*)ev);
-            });
+                controls_inputs(), msg.port_index,
+                [&]<typename C>(C& in_port) { midi.add_message(in_port, msg); });
           }
           break;
         }
         case CLAP_EVENT_MIDI_SYSEX: {
           if constexpr(midi_in_info::size > 0)
           {
+            const auto msg = rebase<clap_event_midi_sysex_t>(ev, start);
             midi_in_info::for_nth_mapped(
-                controls_inputs(), ((clap_event_midi_sysex_t*)ev)->port_index,
-                [&]<typename C>(C& in_port) {
-              midi.add_message(in_port, *(clap_event_midi_sysex_t*)ev);
-            });
+                controls_inputs(), msg.port_index,
+                [&]<typename C>(C& in_port) { midi.add_message(in_port, msg); });
           }
           break;
         }
 
         case CLAP_EVENT_PARAM_VALUE: {
           // Event type ids are only meaningful within the core namespace.
-          if(ev->space_id == CLAP_CORE_EVENT_SPACE_ID)
-            process_param(*((clap_event_param_value_t*)ev));
+          if(ev->space_id != CLAP_CORE_EVENT_SPACE_ID)
+            break;
+
+          const auto& param = *((const clap_event_param_value_t*)ev);
+          if constexpr(split_on_parameter_changes)
+          {
+            if(ev->time > start && ev->time < frames && splits_block(param.param_id))
+              return ev->time;
+          }
+          process_param(param, int(ev->time > start ? ev->time - start : 0));
           break;
         }
         case CLAP_EVENT_PARAM_MOD:
@@ -493,6 +552,7 @@ struct SimpleAudioEffect : clap_plugin
           break;
       }
     }
+    return frames;
   }
 
   void process_out_events(const clap_process& p)
@@ -678,6 +738,16 @@ struct SimpleAudioEffect : clap_plugin
     return &params;
   }
 
+  // Known once activated: the spectrum ports are sized from the buffer size
+  static const clap_plugin_latency* get_latency() noexcept
+  {
+    static constexpr clap_plugin_latency latency{
+        .get = [](const clap_plugin* plugin) -> uint32_t {
+      return self(plugin)->spectrums.latency();
+    }};
+    return &latency;
+  }
+
   static constexpr clap_plugin_audio_ports audio_ports{
       .count = [](const clap_plugin* plugin, bool input) -> uint32_t {
     if(input)
@@ -2,13 +2,21 @@
 
 /* SPDX-License-Identifier: GPL-3.0-or-later */
 
+#include <avnd/binding/godot/configure.hpp>
 #include <avnd/binding/godot/node.hpp>
+#include <avnd/concepts/logger.hpp>
+#include <avnd/wrappers/audio_buffer.hpp>
 #include <avnd/wrappers/audio_channel_manager.hpp>
 #include <avnd/wrappers/process_adapter.hpp>
+#include <avnd/wrappers/value_mailbox.hpp>
 
 #include <godot_cpp/classes/audio_effect.hpp>
 #include <godot_cpp/classes/audio_effect_instance.hpp>
+#include <godot_cpp/classes/audio_server.hpp>
 
+#include <algorithm>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 namespace godot_binding
@@ -26,17 +34,25 @@ struct audio_process_adapter
   avnd::process_adapter<T> processor;
   AVND_NO_UNIQUE_ADDRESS avnd::audio_channel_manager<T> channels{effect};
 
-  std::vector<float> in_buf_l, in_buf_r;
-  std::vector<float> out_buf_l, out_buf_r;
+  // Sized in prepare(): larger blocks are processed in several parts
+  avnd::audio_scratch<float> inputs;
+  avnd::audio_scratch<float> outputs;
+  float* in_ptrs[godot_channels]{};
+  float* out_ptrs[godot_channels]{};
+  int max_frames{};
 
   bool prepared{false};
 
   void prepare(int frames, double rate)
   {
-    in_buf_l.resize(frames);
-    in_buf_r.resize(frames);
-    out_buf_l.resize(frames);
-    out_buf_r.resize(frames);
+    max_frames = frames;
+    inputs.reserve(godot_channels, frames);
+    outputs.reserve(godot_channels, frames);
+    for(int c = 0; c < godot_channels; c++)
+    {
+      in_ptrs[c] = inputs.channel(c);
+      out_ptrs[c] = outputs.channel(c);
+    }
 
     channels.set_input_channels(effect, 0, godot_channels);
     channels.set_output_channels(effect, 0, godot_channels);
@@ -65,45 +81,135 @@ struct audio_process_adapter
     if(!prepared || frame_count <= 0)
       return;
 
-    // Resize scratch buffers if needed
-    if(std::ssize(in_buf_l) < frame_count)
-    {
-      in_buf_l.resize(frame_count);
-      in_buf_r.resize(frame_count);
-      out_buf_l.resize(frame_count);
-      out_buf_r.resize(frame_count);
-    }
+    // Processors may log from here: register the audio thread with the logger.
+    // The audio API does not tell on which thread it will call us beforehand:
+    // only the first callback on a thread sets it up, the others are a
+    // thread_local read.
+    if constexpr(avnd::audio_thread_logger<config::logger_type>)
+      config::logger_type::attach();
 
-    // Deinterleave stereo AudioFrame input → separate channel buffers
     const float* src = static_cast<const float*>(p_src_buffer);
-    for(int32_t i = 0; i < frame_count; ++i)
+    float* dst = static_cast<float*>(p_dst_buffer);
+    for(int32_t start = 0; start < frame_count; start += max_frames)
     {
-      in_buf_l[i] = src[i * 2 + 0];
-      in_buf_r[i] = src[i * 2 + 1];
+      const int32_t n = std::min(max_frames, frame_count - start);
+
+      // Deinterleave stereo AudioFrame input → separate channel buffers
+      avnd::deinterleave_samples(src + start * 2, in_ptrs, godot_channels, n);
+
+      // Clear output
+      std::fill_n(out_ptrs[0], n, 0.f);
+      std::fill_n(out_ptrs[1], n, 0.f);
+
+      // Run Avendish processor with separate channel buffers
+      processor.process(
+          effect, std::span<float*>(in_ptrs, godot_channels),
+          std::span<float*>(out_ptrs, godot_channels), n);
+
+      // Interleave separate channel buffers → stereo AudioFrame output
+      avnd::interleave_samples(out_ptrs, dst + start * 2, godot_channels, n);
     }
+  }
+};
+
+/// One mailbox per parameter input of each processor instance of an effect
+/// instance: the AudioEffect resource writes a parameter in them when it is
+/// set, and the audio thread applies the changed ones at the start of each
+/// block without locking. Every processor instance reads its own mailbox, so
+/// that values which are not trivially copyable are swapped in, never copied.
+template <typename T>
+struct parameter_mailboxes
+{
+  using inputs = avnd::parameter_input_introspection<T>;
 
-    // Clear output
-    std::fill_n(out_buf_l.data(), frame_count, 0.f);
-    std::fill_n(out_buf_r.data(), frame_count, 0.f);
+  template <typename Field>
+  using mailbox_type = avnd::value_mailbox<std::remove_cvref_t<decltype(Field::value)>>;
 
-    // Run Avendish processor with separate channel buffers
-    float* in_ptrs[2] = {in_buf_l.data(), in_buf_r.data()};
-    float* out_ptrs[2] = {out_buf_l.data(), out_buf_r.data()};
+  // std::tuple< value_mailbox<field1 value>, value_mailbox<field3 value>, ... >
+  using tuple = avnd::filter_and_apply<mailbox_type, avnd::parameter_input_introspection, T>;
 
-    processor.process(
-        effect, std::span<float*>(in_ptrs, godot_channels),
-        std::span<float*>(out_ptrs, godot_channels), frame_count);
+  // One tuple per processor instance, e.g. per channel
+  std::unique_ptr<tuple[]> mailboxes;
+  std::size_t count{};
 
-    // Interleave separate channel buffers → stereo AudioFrame output
-    float* dst = static_cast<float*>(p_dst_buffer);
-    for(int32_t i = 0; i < frame_count; ++i)
+  // Main thread, once the effect is prepared and before the mailboxes are
+  // written
+  void allocate(avnd::effect_container<T>& effect)
+  {
+    count = 0;
+    for([[maybe_unused]] auto state : effect.full_state())
+      count++;
+    mailboxes = std::make_unique<tuple[]>(count);
+  }
+
+  // Main thread
+  template <std::size_t Idx>
+  void write(avnd::effect_container<T>& params, avnd::field_index<Idx>)
+  {
+    for(auto state : params.full_state())
     {
-      dst[i * 2 + 0] = out_buf_l[i];
-      dst[i * 2 + 1] = out_buf_r[i];
+      // representative source params
+      const auto& value = avnd::pfr::get<Idx>(state.inputs).value;
+      for(std::size_t i = 0; i < count; i++)
+        tpl::get<inputs::template unmap<Idx>()>(mailboxes[i]).write(value);
+      break;
+    }
+  }
+
+  // Audio thread
+  void apply(avnd::effect_container<T>& effect) noexcept
+  {
+    if constexpr(inputs::size > 0)
+    {
+      // inputs() is a member_range for polyphonic effects, so reach the
+      // concrete inputs through full_state().
+      std::size_t i = 0;
+      for(auto state : effect.full_state())
+      {
+        if(i == count)
+          break;
+        auto& instance_mailboxes = mailboxes[i++];
+        inputs::for_all([&]<auto Idx, typename C>(avnd::field_reflection<Idx, C>) {
+          auto& mailbox = tpl::get<inputs::template unmap<Idx>()>(instance_mailboxes);
+          auto& field = avnd::pfr::get<Idx>(state.inputs);
+          if(mailbox.read(field.value))
+            if_possible(field.update(state.effect));
+        });
+      }
     }
   }
 };
 
+/// The mailboxes of the live instances of an AudioEffect resource.
+/// Only the main thread locks the mutex, which also ensures that each
+/// mailbox has a single writer.
+template <typename T>
+struct parameter_fanout
+{
+  std::mutex mutex;
+  std::vector<parameter_mailboxes<T>*> instances;
+
+  void add(parameter_mailboxes<T>& mb)
+  {
+    std::lock_guard lock{mutex};
+    instances.push_back(&mb);
+  }
+
+  void remove(parameter_mailboxes<T>& mb)
+  {
+    std::lock_guard lock{mutex};
+    std::erase(instances, &mb);
+  }
+
+  template <std::size_t Idx>
+  void write(avnd::effect_container<T>& params, avnd::field_index<Idx> idx)
+  {
+    std::lock_guard lock{mutex};
+    for(auto* mb : instances)
+      mb->write(params, idx);
+  }
+};
+
 /**
  * Godot AudioEffectInstance wrapping an Avendish audio processor.
  *
@@ -114,18 +220,33 @@ template <typename T>
 struct godot_audio_effect_instance : public godot::AudioEffectInstance
 {
   audio_process_adapter<T> adapter;
+  parameter_mailboxes<T> parameters;
 
-  // Points to the parent AudioEffect's params; kept alive by base_ref.
-  avnd::effect_container<T>* params_src{nullptr};
+  // Owned by the parent AudioEffect; kept alive by base_ref.
+  parameter_fanout<T>* fanout{nullptr};
   godot::Ref<godot::AudioEffect> base_ref;
 
   godot_audio_effect_instance() = default;
+  ~godot_audio_effect_instance()
+  {
+    if(fanout)
+      fanout->remove(parameters);
+  }
 
-  void init(avnd::effect_container<T>& params, const godot::Ref<godot::AudioEffect>& ref)
+  void init(
+      avnd::effect_container<T>& params, parameter_fanout<T>& f,
+      const godot::Ref<godot::AudioEffect>& ref)
   {
-    params_src = &params;
     base_ref = ref;
-    adapter.prepare(1024, 44100.0); // FIXME get proper samplerate / buffer size
+
+    const double rate = mix_rate();
+    adapter.prepare(block_size(rate), rate);
+
+    // Start from the current values: later changes come through the mailboxes
+    parameters.allocate(adapter.effect);
+    copy_parameters(params);
+    fanout = &f;
+    fanout->add(parameters);
   }
 
   void do_process(
@@ -135,29 +256,48 @@ struct godot_audio_effect_instance : public godot::AudioEffectInstance
     if(p_frame_count <= 0)
       return;
 
-    sync_parameters();
+    parameters.apply(adapter.effect);
     adapter.process(p_src_buffer, p_dst_buffer, p_frame_count);
   }
 
 private:
-  void sync_parameters()
+  static double mix_rate()
   {
-    if(!params_src)
-      return;
+    auto* server = godot::AudioServer::get_singleton();
+    return server ? server->get_mix_rate() : 44100.0;
+  }
 
+  // Godot mixes the effects in steps of its internal buffer size, 512 frames,
+  // which is not exposed. A device buffer is the largest block expected;
+  // anything larger would be processed in several parts.
+  static int block_size(double rate)
+  {
+    int frames = 512;
+    if(auto* server = godot::AudioServer::get_singleton())
+    {
+      const double latency = server->get_output_latency() * rate;
+      while(frames < latency && frames < 16384)
+        frames *= 2;
+    }
+    return frames;
+  }
+
+  void copy_parameters(avnd::effect_container<T>& params)
+  {
     if constexpr(avnd::has_inputs<T>)
     {
       // Copy the canonical parameter values into every instance of the
-      // processing container. inputs() is a member_iterator for polyphonic
+      // processing container. inputs() is a member_range for polyphonic
       // effects, so reach the concrete inputs through full_state().
-      for(auto src_state : params_src->full_state())
+      for(auto src_state : params.full_state())
       {
         for(auto dst_state : adapter.effect.full_state())
         {
           avnd::parameter_input_introspection<T>::for_all(
               [&]<auto Idx, typename C>(avnd::field_reflection<Idx, C>) {
-            avnd::pfr::get<Idx>(dst_state.inputs).value
-                = avnd::pfr::get<Idx>(src_state.inputs).value;
+            auto& field = avnd::pfr::get<Idx>(dst_state.inputs);
+            field.value = avnd::pfr::get<Idx>(src_state.inputs).value;
+            if_possible(field.update(dst_state.effect));
           });
         }
         break; // representative source params
@@ -176,6 +316,7 @@ template <typename T, typename InstanceClass>
 struct godot_audio_effect : public godot::AudioEffect
 {
   mutable avnd::effect_container<T> params;
+  parameter_fanout<T> fanout;
 
   godot_audio_effect()
   {
@@ -189,7 +330,7 @@ struct godot_audio_effect : public godot::AudioEffect
   {
     godot::Ref<InstanceClass> inst;
     inst.instantiate();
-    inst->init(params, godot::Ref<godot::AudioEffect>(this));
+    inst->init(params, fanout, godot::Ref<godot::AudioEffect>(this));
     return inst;
   }
 
@@ -200,7 +341,9 @@ struct godot_audio_effect : public godot::AudioEffect
 
   bool do_set(const godot::StringName& p_name, const godot::Variant& p_value)
   {
-    return godot_binding::set_property<T>(params, p_name, p_value);
+    // Only the parameter which was set is sent to the instances
+    return godot_binding::set_property<T>(
+        params, p_name, p_value, [this](auto idx) { fanout.write(params, idx); });
   }
 
   bool do_get(const godot::StringName& p_name, godot::Variant& r_ret) const
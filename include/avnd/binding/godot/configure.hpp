@@ -3,12 +3,14 @@
 /* SPDX-License-Identifier: GPL-3.0-or-later */
 
 #include <avnd/wrappers/configure.hpp>
-#include <halp/log.hpp>
+#include <halp/deferred_log.hpp>
 
 namespace godot_binding
 {
 struct config
 {
-  using logger_type = halp::basic_logger;
+  // Processors log from the audio callback, which is deferred, and from the
+  // main thread, which is not
+  using logger_type = halp::audio_deferred_logger;
 };
 }
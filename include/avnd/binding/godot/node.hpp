@@ -339,11 +339,12 @@ void get_property_list(godot::List<godot::PropertyInfo>* p_list)
   }
 }
 
-/// Set a property on the effect by name
+/// Set a property on the effect by name, then call on_set with the
+/// avnd::field_index of the input which was set
 template <typename T>
 bool set_property(
     avnd::effect_container<T>& effect, const godot::StringName& p_name,
-    const godot::Variant& p_value)
+    const godot::Variant& p_value, auto&& on_set)
 {
   if constexpr(!avnd::has_inputs<T>)
     return false;
@@ -357,7 +358,7 @@ bool set_property(
       static const godot::StringName fname{field_name<Idx, C, inputs_t>().data()};
       if(fname == p_name)
       {
-        // Write to every (per-channel) instance; inputs() is a member_iterator
+        // Write to every (per-channel) instance; inputs() is a member_range
         // for polyphonic effects, so go through full_state().
         for(auto state : effect.full_state())
         {
@@ -368,12 +369,22 @@ bool set_property(
             found = true;
           }
         }
+        if(found)
+          on_set(avnd::field_index<Idx>{});
       }
     }
   });
   return found;
 }
 
+template <typename T>
+bool set_property(
+    avnd::effect_container<T>& effect, const godot::StringName& p_name,
+    const godot::Variant& p_value)
+{
+  return set_property<T>(effect, p_name, p_value, [](auto) {});
+}
+
 /// Get a property from the effect by name
 template <typename T>
 bool get_property(
@@ -392,7 +403,7 @@ bool get_property(
         static const godot::StringName fname{field_name<Idx, C, inputs_t>().data()};
         if(fname == p_name)
         {
-          // Read a representative instance (inputs() is a member_iterator for
+          // Read a representative instance (inputs() is a member_range for
           // polyphonic effects; controls are shared across instances).
           for(auto state : effect.full_state())
           {
@@ -1,8 +1,11 @@
 #pragma once
 
 #include <avnd/binding/gstreamer/utils.hpp>
+#include <avnd/wrappers/audio_buffer.hpp>
 #include <avnd/wrappers/process_adapter.hpp>
 
+#include <cstdint>
+#include <type_traits>
 #include <vector>
 
 namespace gst
@@ -16,10 +19,48 @@ struct element<T> : property_handler
   avnd::effect_container<T> impl;
   avnd::process_adapter<T> processor;
 
+  // Planar memory for one block, in the precision given to the processor
+  template <typename FP>
+  struct planar_buffers
+  {
+    avnd::audio_scratch<FP> inputs;
+    avnd::audio_scratch<FP> outputs;
+    std::vector<FP*> input_ptrs;
+    std::vector<FP*> output_ptrs;
+
+    // Point to the planes of non-interleaved buffers for the caps channels
+    std::vector<FP*> input_planes;
+    std::vector<FP*> output_planes;
+
+    void reserve(int in_ch, int out_ch, int frames)
+    {
+      inputs.reserve(in_ch, frames);
+      outputs.reserve(out_ch, frames);
+      input_ptrs.resize(in_ch);
+      output_ptrs.resize(out_ch);
+      for(int ch = 0; ch < in_ch; ch++)
+        input_ptrs[ch] = inputs.channel(ch);
+      for(int ch = 0; ch < out_ch; ch++)
+        output_ptrs[ch] = outputs.channel(ch);
+      input_planes = input_ptrs;
+      output_planes = output_ptrs;
+    }
+  };
+
+  // Cached from the caps in set_caps
+  static constexpr int frames_per_buffer = 1024;
+  GstAudioInfo m_info{};
+  int m_channels{};
+  int m_input_channels{};
+  int m_output_channels{};
+  bool m_double{};
+  planar_buffers<float> m_float_buffers;
+  planar_buffers<double> m_double_buffers;
+
   // Using deducing this for property handling
   using effect_type = T;
 
-  void init() { }
+  void init() { gst_base_transform_set_in_place(&the_object, TRUE); }
 
   void set_property(guint property_id, const GValue* value, GParamSpec* pspec)
   {
@@ -33,112 +74,159 @@ struct element<T> : property_handler
 
   GstFlowReturn transform(GstBuffer* inbuf, GstBuffer* outbuf)
   {
-    GST_DEBUG_OBJECT(this, "transform");
+    if(m_channels == 0)
+      return GST_FLOW_NOT_NEGOTIATED;
 
-    // Get audio format info from caps
-    GstCaps* caps = gst_pad_get_current_caps(GST_BASE_TRANSFORM_SINK_PAD(this));
-    if(!caps)
-    {
-      GST_ERROR_OBJECT(this, "No caps available");
-      return GST_FLOW_ERROR;
-    }
-
-    GstAudioInfo audio_info;
-    if(!gst_audio_info_from_caps(&audio_info, caps))
-    {
-      GST_ERROR_OBJECT(this, "Failed to get audio info from caps");
-      gst_caps_unref(caps);
-      return GST_FLOW_ERROR;
-    }
-    gst_caps_unref(caps);
-
-    GstMapInfo in_info, out_info;
-    if(!gst_buffer_map(inbuf, &in_info, GST_MAP_READ))
+    // Also maps the planes of non-interleaved buffers, with or without GstAudioMeta
+    GstAudioBuffer in, out;
+    if(!gst_audio_buffer_map(&in, &m_info, inbuf, GST_MAP_READ))
     {
       GST_ERROR_OBJECT(this, "Failed to map input buffer");
       return GST_FLOW_ERROR;
     }
 
-    if(!gst_buffer_map(outbuf, &out_info, GST_MAP_WRITE))
+    if(!gst_audio_buffer_map(&out, &m_info, outbuf, GST_MAP_WRITE))
     {
       GST_ERROR_OBJECT(this, "Failed to map output buffer");
-      gst_buffer_unmap(inbuf, &in_info);
+      gst_audio_buffer_unmap(&in);
       return GST_FLOW_ERROR;
     }
 
     // Ensure buffer sizes match
-    if(in_info.size != out_info.size)
+    if(in.n_samples != out.n_samples)
     {
       GST_ERROR_OBJECT(this, "Input and output buffer sizes don't match");
-      gst_buffer_unmap(inbuf, &in_info);
-      gst_buffer_unmap(outbuf, &out_info);
+      gst_audio_buffer_unmap(&in);
+      gst_audio_buffer_unmap(&out);
       return GST_FLOW_ERROR;
     }
 
-    // Get audio parameters
-    int channels = GST_AUDIO_INFO_CHANNELS(&audio_info);
-    int sample_rate = GST_AUDIO_INFO_RATE(&audio_info);
-    GstAudioFormat format = GST_AUDIO_INFO_FORMAT(&audio_info);
-    int bps = GST_AUDIO_INFO_BPF(&audio_info); // bytes per frame
-    gsize n_frames = in_info.size / bps;
+    process_audio(in, out);
 
-    GST_DEBUG_OBJECT(
-        this, "Processing %lu frames: %d channels, %d Hz, format=%s, bps=%d", n_frames,
-        channels, sample_rate, gst_audio_format_to_string(format), bps);
+    gst_audio_buffer_unmap(&in);
+    gst_audio_buffer_unmap(&out);
+    return GST_FLOW_OK;
+  }
 
-    // The object may read/write more channels than the caps advertise -- e.g. a
-    // fixed_audio_bus<..., 2> output unconditionally writes channel 1 even when
-    // fed a mono stream. Size the planar buffers to what the object needs, not
-    // just to `channels`, so process() can never write past the end.
-    const int in_ch = std::max<int>(channels, avnd::input_channels<T>(channels));
-    const int out_ch = std::max<int>(channels, avnd::output_channels<T>(channels));
-    const int buf_ch = std::max(in_ch, out_ch);
+  // Used by GstBaseTransform whenever the buffer is writable, which avoids
+  // allocating an output buffer and copying to it.
+  GstFlowReturn transform_ip(GstBuffer* buf)
+  {
+    if(m_channels == 0)
+      return GST_FLOW_NOT_NEGOTIATED;
+
+    GstAudioBuffer abuf;
+    if(!gst_audio_buffer_map(&abuf, &m_info, buf, GST_MAP_READWRITE))
+    {
+      GST_ERROR_OBJECT(this, "Failed to map buffer");
+      return GST_FLOW_ERROR;
+    }
 
-    // Convert interleaved GStreamer audio to planar format for process_adapter
-    std::vector<float*> input_ptrs(buf_ch);
-    std::vector<float*> output_ptrs(buf_ch);
-    std::vector<std::vector<float>> input_channels(buf_ch);
-    std::vector<std::vector<float>> output_channels(buf_ch);
+    process_audio(abuf, abuf);
 
-    // Allocate and prepare channel arrays (extra channels stay zero-filled)
-    for(int ch = 0; ch < buf_ch; ch++)
+    gst_audio_buffer_unmap(&abuf);
+    return GST_FLOW_OK;
+  }
+
+  void process_audio(GstAudioBuffer& in, GstAudioBuffer& out) noexcept
+  {
+    switch(GST_AUDIO_INFO_FORMAT(&m_info))
     {
-      input_channels[ch].resize(n_frames);
-      output_channels[ch].resize(n_frames);
-      input_ptrs[ch] = input_channels[ch].data();
-      output_ptrs[ch] = output_channels[ch].data();
+      case GST_AUDIO_FORMAT_F32LE:
+        return process_format<float>(in, out);
+      case GST_AUDIO_FORMAT_F64LE:
+        return process_format<double>(in, out);
+      case GST_AUDIO_FORMAT_S16LE:
+        return process_format<int16_t>(in, out);
+      case GST_AUDIO_FORMAT_S32LE:
+        return process_format<int32_t>(in, out);
+      default:
+        break;
     }
+  }
 
-    // Convert from interleaved to planar format (only the caps channels exist)
-    float* samples = (float*)in_info.data;
-    for(int ch = 0; ch < channels; ch++)
+  template <typename Sample>
+  void process_format(GstAudioBuffer& in, GstAudioBuffer& out) noexcept
+  {
+    if constexpr(avnd::double_processor<T>)
     {
-      for(gsize i = 0; i < n_frames; i++)
-      {
-        input_channels[ch][i] = samples[i * channels + ch];
-      }
+      if(m_double)
+        return process_blocks<double, Sample>(in, out);
     }
+    process_blocks<float, Sample>(in, out);
+  }
 
-    // Process through process_adapter (handles all Avendish audio APIs)
-    processor.process(
-        impl, avnd::span<float*>{input_ptrs.data(), (size_t)in_ch},
-        avnd::span<float*>{output_ptrs.data(), (size_t)out_ch}, n_frames);
+  // Processes in blocks of at most frames_per_buffer frames: each block is
+  // entirely read before being written, so in and out may be the same buffer,
+  // except for the zero-copy path for which set_caps disables in-place processing.
+  template <typename FP, typename Sample>
+  void process_blocks(GstAudioBuffer& in, GstAudioBuffer& out) noexcept
+  {
+    const gsize n_frames = in.n_samples;
+    GST_LOG_OBJECT(this, "Processing %lu frames", n_frames);
 
-    // Convert back from planar to interleaved format
-    float* out_samples = (float*)out_info.data;
-    for(int ch = 0; ch < channels; ch++)
+    auto& b = buffers<FP>();
+    const bool interleaved
+        = GST_AUDIO_INFO_LAYOUT(&m_info) == GST_AUDIO_LAYOUT_INTERLEAVED;
+
+    for(gsize start = 0; start < n_frames; start += frames_per_buffer)
     {
-      for(gsize i = 0; i < n_frames; i++)
+      const gsize n = std::min<gsize>(frames_per_buffer, n_frames - start);
+
+      if(interleaved)
+      {
+        // Only the caps channels exist: extra input channels stay zero-filled
+        avnd::deinterleave_samples(
+            (const Sample*)in.planes[0] + start * m_channels, b.input_ptrs.data(),
+            m_channels, n);
+
+        process_block(b.input_ptrs, b.output_ptrs, n);
+
+        avnd::interleave_samples(
+            b.output_ptrs.data(), (Sample*)out.planes[0] + start * m_channels,
+            m_channels, n);
+      }
+      else if constexpr(std::is_same_v<Sample, FP>)
       {
-        out_samples[i * channels + ch] = output_channels[ch][i];
+        // The processor reads and writes the planes of the buffers directly
+        for(int ch = 0; ch < m_channels; ch++)
+        {
+          b.input_planes[ch] = (FP*)in.planes[ch] + start;
+          b.output_planes[ch] = (FP*)out.planes[ch] + start;
+        }
+
+        process_block(b.input_planes, b.output_planes, n);
+      }
+      else
+      {
+        for(int ch = 0; ch < m_channels; ch++)
+          avnd::convert_samples(
+              (const Sample*)in.planes[ch] + start, b.input_ptrs[ch], n);
+
+        process_block(b.input_ptrs, b.output_ptrs, n);
+
+        for(int ch = 0; ch < m_channels; ch++)
+          avnd::convert_samples(
+              b.output_ptrs[ch], (Sample*)out.planes[ch] + start, n);
       }
     }
+  }
 
-    GST_DEBUG_OBJECT(this, "Audio processing completed via process_adapter");
+  template <typename FP>
+  void process_block(std::vector<FP*>& inputs, std::vector<FP*>& outputs, gsize n)
+  {
+    processor.process(
+        impl, avnd::span<FP*>{inputs.data(), (size_t)m_input_channels},
+        avnd::span<FP*>{outputs.data(), (size_t)m_output_channels}, n);
+  }
 
-    gst_buffer_unmap(inbuf, &in_info);
-    gst_buffer_unmap(outbuf, &out_info);
-    return GST_FLOW_OK;
+  template <typename FP>
+  planar_buffers<FP>& buffers() noexcept
+  {
+    if constexpr(std::is_same_v<FP, double>)
+      return m_double_buffers;
+    else
+      return m_float_buffers;
   }
 
   // Initialize processor buffers when caps are set
@@ -148,22 +236,66 @@ struct element<T> : property_handler
     if(!gst_audio_info_from_caps(&audio_info, incaps))
       return FALSE;
 
-    int channels = GST_AUDIO_INFO_CHANNELS(&audio_info);
+    const auto format = GST_AUDIO_INFO_FORMAT(&audio_info);
+    const auto layout = GST_AUDIO_INFO_LAYOUT(&audio_info);
+    switch(format)
+    {
+      case GST_AUDIO_FORMAT_F32LE:
+      case GST_AUDIO_FORMAT_F64LE:
+      case GST_AUDIO_FORMAT_S16LE:
+      case GST_AUDIO_FORMAT_S32LE:
+        break;
+      default:
+        GST_ERROR_OBJECT(this, "Unsupported audio format");
+        return FALSE;
+    }
+
+    m_info = audio_info;
+    m_channels = GST_AUDIO_INFO_CHANNELS(&audio_info);
+    const int channels = m_channels;
     int sample_rate = GST_AUDIO_INFO_RATE(&audio_info);
-    int frames_per_buffer = 1024; // Default, will be updated in transform()
 
-    // Size to what the object needs, not just the caps: a fixed output bus keeps
-    // its channel count regardless of the input's.
+    GST_DEBUG_OBJECT(
+        this, "set_caps: %d channels, %d Hz, format=%s", channels, sample_rate,
+        gst_audio_format_to_string(format));
+
+    // Run the processor in the precision of the stream when it supports it,
+    // otherwise in the one it has
+    const bool wide = format == GST_AUDIO_FORMAT_F64LE || format == GST_AUDIO_FORMAT_S32LE;
+    m_double = avnd::double_processor<T> && (wide || !avnd::float_processor<T>);
+
+    // Planar F32 for float processing or F64 for double processing need no
+    // copy, but the processor may not support reading and writing the same memory
+    const bool zero_copy = layout == GST_AUDIO_LAYOUT_NON_INTERLEAVED
+                           && (m_double ? format == GST_AUDIO_FORMAT_F64LE
+                                        : format == GST_AUDIO_FORMAT_F32LE);
+    gst_base_transform_set_in_place(&the_object, !zero_copy);
+
+    // The object may read/write more channels than the caps advertise -- e.g. a
+    // fixed_audio_bus<..., 2> output unconditionally writes channel 1 even when
+    // fed a mono stream. Size the planar buffers to what the object needs, not
+    // just to the caps, so process() can never write past the end.
     const int in_ch = std::max<int>(channels, avnd::input_channels<T>(channels));
     const int out_ch = std::max<int>(channels, avnd::output_channels<T>(channels));
+    m_input_channels = in_ch;
+    m_output_channels = out_ch;
 
-    // Initialize process adapter buffers
     avnd::process_setup setup_info{
         .input_channels = in_ch,
         .output_channels = out_ch,
         .frames_per_buffer = frames_per_buffer,
         .rate = (double)sample_rate};
-    processor.allocate_buffers(setup_info, float{});
+    // Planar scratch for a whole block, reused for every buffer
+    if(m_double)
+    {
+      m_double_buffers.reserve(in_ch, out_ch, frames_per_buffer);
+      processor.allocate_buffers(setup_info, double{});
+    }
+    else
+    {
+      m_float_buffers.reserve(in_ch, out_ch, frames_per_buffer);
+      processor.allocate_buffers(setup_info, float{});
+    }
 
     // Set up the effect duplicator's per-channel state and output bus channel
     // count -- without this the object writes to unallocated output channels.
@@ -194,13 +326,22 @@ struct metaclass<T>
   using type = T;
   static inline GstDebugCategory* debug_category = nullptr;
 
+  // The first format is the one preferred when fixating: the native precision
+  // of the processor. Integer formats are converted while (de)interleaving.
+  static constexpr const char* caps
+      = avnd::double_processor<T> && !avnd::float_processor<T>
+            ? "audio/x-raw,format={F64LE,F32LE,S32LE,S16LE},"
+              "layout={interleaved,non-interleaved},"
+              "channels=[1,64],rate=[8000,192000]"
+            : "audio/x-raw,format={F32LE,F64LE,S16LE,S32LE},"
+              "layout={interleaved,non-interleaved},"
+              "channels=[1,64],rate=[8000,192000]";
+
   static inline GstStaticPadTemplate sink_pad_template = GST_STATIC_PAD_TEMPLATE(
-      "sink", GST_PAD_SINK, GST_PAD_ALWAYS,
-      GST_STATIC_CAPS("audio/x-raw,format=F32LE,channels=[1,8],rate=[8000,192000]"));
+      "sink", GST_PAD_SINK, GST_PAD_ALWAYS, GST_STATIC_CAPS(caps));
 
   static inline GstStaticPadTemplate src_pad_template = GST_STATIC_PAD_TEMPLATE(
-      "src", GST_PAD_SRC, GST_PAD_ALWAYS,
-      GST_STATIC_CAPS("audio/x-raw,format=F32LE,channels=[1,8],rate=[8000,192000]"));
+      "src", GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS(caps));
 
   GstBaseTransformClass the_class;
 
@@ -224,6 +365,11 @@ struct metaclass<T>
       return ((element<T>*)gobject)->transform(inbuf, outbuf);
     });
 
+    base_transform_class->transform_ip = GST_DEBUG_FUNCPTR(
+        +[](GstBaseTransform* gobject, GstBuffer* buf) -> GstFlowReturn {
+      return ((element<T>*)gobject)->transform_ip(buf);
+    });
+
     // Caps negotiation for texture processing
     base_transform_class->transform_caps = GST_DEBUG_FUNCPTR(
         +[](GstBaseTransform* gobject, GstPadDirection direction, GstCaps* caps,
@@ -13,11 +13,39 @@ struct element<T> : property_handler
   GstBaseTransform the_object; // MUST be first for GObject
   avnd::effect_container<T> impl;
 
-  // Buffer for handling stride conversion when input has padding
+  // The processor writes over its input: see avnd::tag_texture_in_place
+  static constexpr bool in_place = avnd::tag_texture_in_place<T>;
+
+  // The input textures can only point into the read-only input frame, which
+  // may be shared with other elements, when the processor cannot write
+  // through them: their bytes have to be pointers to const.
+  static constexpr bool inputs_read_only = [] {
+    bool read_only = true;
+    avnd::texture_input_introspection<T>::for_all(
+        [&]<std::size_t Index, typename Field>(avnd::field_reflection<Index, Field>) {
+      using texture_type = decltype(Field::texture);
+      using px_t = std::remove_pointer_t<decltype(texture_type::bytes)>;
+      read_only = read_only && std::is_const_v<px_t>;
+    });
+    return read_only;
+  }();
+
+  // Cached from the input caps in set_caps
+  GstVideoInfo m_info{};
+  bool m_negotiated{};
+
+  // Copy of the input, when it has padding or the processor may write to it
   std::unique_ptr<uint8_t[]> stride_conversion_buffer;
   size_t stride_conversion_buffer_size = 0;
 
-  void init() { }
+  // Output buffers, sized for the last output texture
+  GstBufferPool* m_pool{};
+  gsize m_pool_buffer_size{};
+  gsize m_output_size{};
+
+  void init() { gst_base_transform_set_in_place(&the_object, in_place); }
+  ~element() { release_pool(); }
+
   // Using deducing this for property handling
   using effect_type = T;
 
@@ -34,281 +62,240 @@ struct element<T> : property_handler
   GstFlowReturn transform(GstBuffer* inbuf, GstBuffer* outbuf)
   {
     GST_DEBUG_OBJECT(this, "transform");
+    if(!m_negotiated)
+      return GST_FLOW_NOT_NEGOTIATED;
 
-    // Get video format info from caps
-    GstCaps* caps = gst_pad_get_current_caps(GST_BASE_TRANSFORM_SINK_PAD(this));
-    if(!caps)
+    GstVideoFrame in_frame;
+    if(!gst_video_frame_map(&in_frame, &m_info, inbuf, GST_MAP_READ))
     {
-      GST_ERROR_OBJECT(this, "No caps available");
+      GST_ERROR_OBJECT(this, "Failed to map input buffer");
       return GST_FLOW_ERROR;
     }
 
-    GstVideoInfo video_info;
-    if(!gst_video_info_from_caps(&video_info, caps))
-    {
-      GST_ERROR_OBJECT(this, "Failed to get video info from caps");
-      gst_caps_unref(caps);
-      return GST_FLOW_ERROR;
-    }
-    gst_caps_unref(caps);
+    const int width = GST_VIDEO_FRAME_WIDTH(&in_frame);
+    const int height = GST_VIDEO_FRAME_HEIGHT(&in_frame);
+    const int stride = GST_VIDEO_FRAME_PLANE_STRIDE(&in_frame, 0);
+    auto* pixels = (uint8_t*)GST_VIDEO_FRAME_PLANE_DATA(&in_frame, 0);
 
-    GstMapInfo in_info, out_info;
-    if(!gst_buffer_map(inbuf, &in_info, GST_MAP_READ))
-    {
-      GST_ERROR_OBJECT(this, "Failed to map input buffer");
-      return GST_FLOW_ERROR;
-    }
+    GST_DEBUG_OBJECT(
+        this, "Processing %dx%d texture, stride=%d", width, height, stride);
+
+    // A processor which may write its inputs works on a copy of the frame
+    uint8_t* data = inputs_read_only ? packed_pixels(pixels, stride, width, height)
+                                     : copied_pixels(pixels, stride, width, height);
+    set_input_textures(data, width, height);
+    run_effect();
+
+    // The outputs may still point to the inputs, thus into the frame
+    const GstFlowReturn ret = copy_output_textures(outbuf, width, height);
+    gst_video_frame_unmap(&in_frame);
+    return ret;
+  }
+
+  // Used instead of transform for in-place processors: the output textures
+  // are the input buffer itself, made writable by GstBaseTransform if needed.
+  GstFlowReturn transform_ip(GstBuffer* buf)
+  {
+    GST_DEBUG_OBJECT(this, "transform_ip");
+    if(!m_negotiated)
+      return GST_FLOW_NOT_NEGOTIATED;
 
-    if(!gst_buffer_map(outbuf, &out_info, GST_MAP_WRITE))
+    GstVideoFrame frame;
+    if(!gst_video_frame_map(&frame, &m_info, buf, GST_MAP_READWRITE))
     {
-      GST_ERROR_OBJECT(this, "Failed to map output buffer");
-      gst_buffer_unmap(inbuf, &in_info);
+      GST_ERROR_OBJECT(this, "Failed to map buffer");
       return GST_FLOW_ERROR;
     }
 
-    // Get video dimensions and format info
-    int width = GST_VIDEO_INFO_WIDTH(&video_info);
-    int height = GST_VIDEO_INFO_HEIGHT(&video_info);
-    GstVideoFormat format = GST_VIDEO_INFO_FORMAT(&video_info);
-    int stride = GST_VIDEO_INFO_PLANE_STRIDE(&video_info, 0);
+    const int width = GST_VIDEO_FRAME_WIDTH(&frame);
+    const int height = GST_VIDEO_FRAME_HEIGHT(&frame);
+    const int stride = GST_VIDEO_FRAME_PLANE_STRIDE(&frame, 0);
+    auto* pixels = (uint8_t*)GST_VIDEO_FRAME_PLANE_DATA(&frame, 0);
+    uint8_t* data = packed_pixels(pixels, stride, width, height);
+
+    set_input_textures(data, width, height);
+    avnd::texture_output_introspection<T>::for_all(
+        avnd::get_outputs(impl), [&]<typename Field>(Field& field) {
+      using px_t = std::remove_pointer_t<decltype(field.texture.bytes)>;
+      if constexpr(std::is_same_v<px_t, unsigned char>)
+      {
+        field.texture.bytes = data;
+        field.texture.width = width;
+        field.texture.height = height;
+        field.texture.changed = false;
+      }
+    });
 
-    GST_DEBUG_OBJECT(
-        this, "Processing %dx%d texture, format=%s, stride=%d, buffer_size=%lu", width,
-        height, gst_video_format_to_string(format), stride, in_info.size);
+    run_effect();
 
-    // Set up input texture data for Avendish
-    auto& inputs = avnd::get_inputs(impl);
-    auto& outputs = avnd::get_outputs(impl);
+    // An effect which still allocated its own output gets it copied back
+    avnd::texture_output_introspection<T>::for_all(
+        avnd::get_outputs(impl), [&]<typename Field>(Field& field) {
+      using px_t = std::remove_pointer_t<decltype(field.texture.bytes)>;
+      if constexpr(std::is_same_v<px_t, unsigned char>)
+      {
+        if(field.texture.bytes && field.texture.bytes != data
+           && field.texture.width == width && field.texture.height == height)
+          memcpy(data, field.texture.bytes, size_t(width) * height * 4);
+      }
+    });
 
-    // Validate format and buffer size
-    if(format != GST_VIDEO_FORMAT_RGBA)
+    // Copy row by row to restore the padding
+    if(data != pixels)
     {
-      GST_ERROR_OBJECT(
-          this, "Unexpected format: %s (expected RGBA)",
-          gst_video_format_to_string(format));
-      gst_buffer_unmap(inbuf, &in_info);
-      gst_buffer_unmap(outbuf, &out_info);
-      return GST_FLOW_ERROR;
+      for(int y = 0; y < height; y++)
+        memcpy(pixels + y * stride, data + y * width * 4, width * 4);
     }
 
-    size_t expected_min_size = stride * height;
-    if(in_info.size < expected_min_size)
+    gst_video_frame_unmap(&frame);
+    return GST_FLOW_OK;
+  }
+
+  // Textures are tightly packed: frames whose rows have padding are copied
+  uint8_t* packed_pixels(uint8_t* pixels, int stride, int width, int height)
+  {
+    if(stride == width * 4)
+      return pixels;
+    return copied_pixels(pixels, stride, width, height);
+  }
+
+  // Copies the frame into the scratch buffer, without the padding of the rows
+  uint8_t* copied_pixels(uint8_t* pixels, int stride, int width, int height)
+  {
+    if(!stride_conversion_buffer
+       || stride_conversion_buffer_size < size_t(width) * height * 4)
     {
-      GST_ERROR_OBJECT(
-          this, "Input buffer too small: %lu < %lu", in_info.size, expected_min_size);
-      gst_buffer_unmap(inbuf, &in_info);
-      gst_buffer_unmap(outbuf, &out_info);
-      return GST_FLOW_ERROR;
+      stride_conversion_buffer = std::make_unique<uint8_t[]>(width * height * 4);
+      stride_conversion_buffer_size = width * height * 4;
     }
 
-    // Set up input texture - ensure proper data flow to Avendish get() method
-    if constexpr(avnd::texture_input_introspection<T>::size > 0)
-    {
-      avnd::texture_input_introspection<T>::for_all(
-          inputs, [&]<typename Field>(Field& field) {
-        // This element advertises 8-bit RGBA caps (4 bytes/pixel). A float
-        // texture (float* bytes, 16 bytes/pixel) would read four times past the
-        // GStreamer buffer -> out-of-bounds. Until the caps become format-aware,
-        // skip such textures (leave bytes null so the effect early-outs) instead
-        // of crashing.
-        using px_t = std::remove_pointer_t<decltype(field.texture.bytes)>;
-        if constexpr(!std::is_same_v<px_t, unsigned char>)
-        {
-          field.texture.bytes = nullptr;
-          return;
-        }
-        // CRITICAL: Ensure texture buffer is valid and accessible
-        if(!in_info.data || in_info.size < expected_min_size)
-        {
-          GST_ERROR_OBJECT(
-              this, "Invalid input buffer: ptr=%p, size=%lu, expected=%lu", in_info.data,
-              in_info.size, expected_min_size);
-          return;
-        }
+    // Copy row by row to remove padding
+    uint8_t* dst = stride_conversion_buffer.get();
+    for(int y = 0; y < height; y++)
+      memcpy(dst + y * width * 4, pixels + y * stride, width * 4);
 
-        // Handle stride: if buffer has padding, we need to create a tightly packed copy
-        if(stride == width * 4)
-        {
-          // No padding, can use buffer directly. Cast to the field's own pixel
-          // pointer type: byte textures use `unsigned char*`, float textures
-          // (e.g. RGBA32F) use `float*`.
-          field.texture.bytes
-              = reinterpret_cast<decltype(field.texture.bytes)>(in_info.data);
-        }
-        else
-        {
-          // Has padding, need to create tightly packed buffer
-          if(!stride_conversion_buffer
-             || stride_conversion_buffer_size < width * height * 4)
-          {
-            stride_conversion_buffer = std::make_unique<uint8_t[]>(width * height * 4);
-            stride_conversion_buffer_size = width * height * 4;
-          }
-
-          // Copy row by row to remove padding
-          uint8_t* src = (uint8_t*)in_info.data;
-          uint8_t* dst = stride_conversion_buffer.get();
-          for(int y = 0; y < height; y++)
-          {
-            memcpy(dst + y * width * 4, src + y * stride, width * 4);
-          }
-
-          field.texture.bytes = reinterpret_cast<decltype(field.texture.bytes)>(
-              stride_conversion_buffer.get());
-          GST_DEBUG_OBJECT(
-              this, "Converted strided input (%d) to tightly packed buffer", stride);
-        }
+    GST_DEBUG_OBJECT(this, "Copied input (stride %d) to tightly packed buffer", stride);
+    return dst;
+  }
 
+  void set_input_textures(uint8_t* data, int width, int height)
+  {
+    avnd::texture_input_introspection<T>::for_all(
+        avnd::get_inputs(impl), [&]<typename Field>(Field& field) {
+      // This element advertises 8-bit RGBA caps (4 bytes/pixel). A float
+      // texture (float* bytes, 16 bytes/pixel) would read four times past the
+      // GStreamer buffer -> out-of-bounds. Until the caps become format-aware,
+      // skip such textures (leave bytes null so the effect early-outs) instead
+      // of crashing.
+      using px_t = std::remove_pointer_t<decltype(field.texture.bytes)>;
+      if constexpr(!std::is_same_v<std::remove_const_t<px_t>, unsigned char>)
+      {
+        field.texture.bytes = nullptr;
+      }
+      else
+      {
+        field.texture.bytes = data;
         field.texture.width = width;
         field.texture.height = height;
         field.texture.changed = true;
 
         GST_DEBUG_OBJECT(
-            this, "Input texture setup: %dx%d, %lu bytes, ptr=%p", width, height,
-            in_info.size, in_info.data);
-
-        // ENSURE: Input buffer contains actual data (not all zeros)
-        uint8_t* pixels = (uint8_t*)in_info.data;
-        int non_zero_count = 0;
-        for(size_t i = 0; i < std::min(in_info.size, size_t(100)); i++)
-        {
-          if(pixels[i] != 0)
-            non_zero_count++;
-        }
-        GST_DEBUG_OBJECT(
-            this, "Input validation: %d non-zero bytes in first 100", non_zero_count);
-
-        if(non_zero_count == 0)
-        {
-          GST_WARNING_OBJECT(
-              this,
-              "Input buffer appears to be all zeros - this will cause black output");
-        }
-
-        // Debug: Sample pixels to verify format
-        if(in_info.size >= 16)
-        {
-          GST_DEBUG_OBJECT(
-              this, "Sample pixels - [0]: R=%d G=%d B=%d A=%d, [1]: R=%d G=%d B=%d A=%d",
-              pixels[0], pixels[1], pixels[2], pixels[3], pixels[4], pixels[5],
-              pixels[6], pixels[7]);
-        }
-      });
-    }
-
-    // Let the Avendish effect create its own output texture
-    if constexpr(avnd::texture_output_introspection<T>::size > 0)
-    {
-      avnd::texture_output_introspection<T>::for_all(
-          outputs, [&]<typename Field>(Field& field) {
-        // Let the effect create its own output buffer initially
-        // We'll copy back to GStreamer buffer after processing
-      });
-    }
-
-    // ENSURE: Before calling effect, verify input texture is accessible
-    if constexpr(avnd::texture_input_introspection<T>::size > 0)
-    {
-      avnd::texture_input_introspection<T>::for_all(
-          inputs, [&]<typename Field>(Field& field) {
-        if(field.texture.bytes == nullptr)
-        {
-          GST_ERROR_OBJECT(
-              this,
-              "CRITICAL: Input texture bytes is NULL - Avendish effect will return "
-              "early!");
-        }
-        else
-        {
-          GST_DEBUG_OBJECT(
-              this, "Input texture ready: ptr=%p, %dx%d, changed=%d",
-              field.texture.bytes, field.texture.width, field.texture.height,
-              field.texture.changed);
-        }
-      });
-    }
+            this, "Input texture setup: %dx%d, ptr=%p", width, height, data);
+      }
+    });
+  }
 
+  void run_effect()
+  {
     // Call the Avendish effect (texture processing doesn't need a tick)
     if constexpr(avnd::tag_single_exec<T>)
       impl.effect();
     else
       impl.effect.operator()();
+  }
 
-    // Copy output texture back to GStreamer buffer (handle dynamic size changes)
-    if constexpr(avnd::texture_output_introspection<T>::size > 0)
-    {
-      avnd::texture_output_introspection<T>::for_all(
-          outputs, [&]<typename Field>(Field& field) {
-        if(field.texture.bytes)
+  // Copy output texture back to GStreamer buffer (handle dynamic size changes)
+  GstFlowReturn copy_output_textures(GstBuffer* outbuf, int width, int height)
+  {
+    GstFlowReturn ret = GST_FLOW_OK;
+    avnd::texture_output_introspection<T>::for_all(
+        avnd::get_outputs(impl), [&]<typename Field>(Field& field) {
+      if(!field.texture.bytes)
+      {
+        GST_ERROR_OBJECT(
+            this, "Output texture bytes is NULL - no output will be generated");
+        return;
+      }
+
+      // Get actual output texture dimensions after effect
+      int out_width = field.texture.width;
+      int out_height = field.texture.height;
+
+      GST_DEBUG_OBJECT(
+          this, "Effect output size: %dx%d (input was %dx%d)", out_width, out_height,
+          width, height);
+
+      // Calculate actual output buffer requirements
+      gsize required_output_size = gsize(out_width) * out_height * 4;
+
+      // For dynamic resolution changes, we need to create new caps and update the buffer
+      if(out_width != width || out_height != height)
+      {
+        GST_DEBUG_OBJECT(
+            this, "Dynamic resolution change detected: %dx%d -> %dx%d", width, height,
+            out_width, out_height);
+
+        // Create new caps for the actual output size
+        GstCaps* new_caps = gst_caps_new_simple(
+            "video/x-raw", "format", G_TYPE_STRING, "RGBA", "width", G_TYPE_INT,
+            out_width, "height", G_TYPE_INT, out_height, "framerate", GST_TYPE_FRACTION,
+            30, 1, NULL);
+
+        // Update the source pad caps
+        if(!gst_pad_set_caps(GST_BASE_TRANSFORM_SRC_PAD(this), new_caps))
         {
-          // Get actual output texture dimensions after effect
-          int out_width = field.texture.width;
-          int out_height = field.texture.height;
-
-          GST_DEBUG_OBJECT(
-              this, "Effect output size: %dx%d (input was %dx%d)", out_width, out_height,
-              width, height);
-
-          // Calculate actual output buffer requirements
-          size_t required_output_size = out_width * out_height * 4;
-
-          if(required_output_size > out_info.size)
-          {
-            GST_ERROR_OBJECT(
-                this, "Output texture too large for buffer: %lu > %lu",
-                required_output_size, out_info.size);
-            return;
-          }
-
-          // For dynamic resolution changes, we need to create new caps and update the buffer
-          if(out_width != width || out_height != height)
-          {
-            GST_DEBUG_OBJECT(
-                this, "Dynamic resolution change detected: %dx%d -> %dx%d", width,
-                height, out_width, out_height);
-
-            // Create new caps for the actual output size
-            GstCaps* new_caps = gst_caps_new_simple(
-                "video/x-raw", "format", G_TYPE_STRING, "RGBA", "width", G_TYPE_INT,
-                out_width, "height", G_TYPE_INT, out_height, "framerate",
-                GST_TYPE_FRACTION, 30, 1, NULL);
-
-            // Update the source pad caps
-            if(!gst_pad_set_caps(GST_BASE_TRANSFORM_SRC_PAD(this), new_caps))
-            {
-              GST_WARNING_OBJECT(this, "Failed to update source pad caps for new size");
-            }
-            gst_caps_unref(new_caps);
-
-            // Resize the output buffer to match actual output
-            gst_buffer_set_size(outbuf, required_output_size);
-
-            // Re-map the buffer with the new size
-            gst_buffer_unmap(outbuf, &out_info);
-            if(!gst_buffer_map(outbuf, &out_info, GST_MAP_WRITE))
-            {
-              GST_ERROR_OBJECT(this, "Failed to re-map resized output buffer");
-              return;
-            }
-          }
-
-          // Copy output texture data (no stride needed for tightly packed Avendish output)
-          memcpy(out_info.data, field.texture.bytes, required_output_size);
-          GST_DEBUG_OBJECT(
-              this, "Copied %lu bytes from %dx%d output texture", required_output_size,
-              out_width, out_height);
+          GST_WARNING_OBJECT(this, "Failed to update source pad caps for new size");
         }
-        else
+        gst_caps_unref(new_caps);
+      }
+
+      // Pooled buffers have the size of the previous output: when it grows the
+      // memory is replaced, which also makes the pool discard the buffer.
+      gsize max_size = 0;
+      gst_buffer_get_sizes(outbuf, nullptr, &max_size);
+      if(required_output_size > max_size)
+      {
+        GstMemory* mem = gst_allocator_alloc(nullptr, required_output_size, nullptr);
+        if(!mem)
         {
           GST_ERROR_OBJECT(
-              this, "Output texture bytes is NULL - no output will be generated");
+              this, "Failed to allocate output memory of size %lu",
+              required_output_size);
+          ret = GST_FLOW_ERROR;
+          return;
         }
-      });
-    }
+        gst_buffer_replace_all_memory(outbuf, mem);
+      }
+      gst_buffer_set_size(outbuf, required_output_size);
+      m_output_size = required_output_size;
 
-    gst_buffer_unmap(inbuf, &in_info);
-    gst_buffer_unmap(outbuf, &out_info);
-    return GST_FLOW_OK;
+      GstMapInfo out_info;
+      if(!gst_buffer_map(outbuf, &out_info, GST_MAP_WRITE))
+      {
+        GST_ERROR_OBJECT(this, "Failed to map output buffer");
+        ret = GST_FLOW_ERROR;
+        return;
+      }
+
+      // Copy output texture data (no stride needed for tightly packed Avendish output)
+      memcpy(out_info.data, field.texture.bytes, required_output_size);
+      GST_DEBUG_OBJECT(
+          this, "Copied %lu bytes from %dx%d output texture", required_output_size,
+          out_width, out_height);
+
+      gst_buffer_unmap(outbuf, &out_info);
+    });
+    return ret;
   }
 
   // Caps negotiation methods for handling resolution changes
@@ -316,6 +303,12 @@ struct element<T> : property_handler
   {
     GST_DEBUG_OBJECT(this, "transform_caps");
 
+    // In-place processing keeps the resolution
+    if constexpr(in_place)
+    {
+      return filter ? gst_caps_intersect(caps, filter) : gst_caps_ref(caps);
+    }
+
     // For now, allow any resolution transformation - let the effect determine the output size
     // This avoids hardcoding scaling factors and allows dynamic resolution changes
     GstCaps* result = gst_caps_copy(caps);
@@ -383,53 +376,79 @@ struct element<T> : property_handler
   gboolean set_caps(GstCaps* incaps, GstCaps* outcaps)
   {
     GST_DEBUG_OBJECT(this, "set_caps");
-    // Store the caps for use in transform
+
+    m_negotiated = false;
+    if(!gst_video_info_from_caps(&m_info, incaps))
+    {
+      GST_ERROR_OBJECT(this, "Failed to get video info from caps");
+      return FALSE;
+    }
+
+    if(GST_VIDEO_INFO_FORMAT(&m_info) != GST_VIDEO_FORMAT_RGBA)
+    {
+      GST_ERROR_OBJECT(
+          this, "Unexpected format: %s (expected RGBA)",
+          gst_video_format_to_string(GST_VIDEO_INFO_FORMAT(&m_info)));
+      return FALSE;
+    }
+
+    // Until the effect has run, its output is assumed to have the input size
+    m_output_size = 0;
+    m_negotiated = true;
     return TRUE;
   }
 
   GstFlowReturn prepare_output_buffer(GstBuffer* inbuf, GstBuffer** outbuf)
   {
     GST_DEBUG_OBJECT(this, "prepare_output_buffer");
+    if(!m_negotiated)
+      return GST_FLOW_NOT_NEGOTIATED;
 
-    // For dynamic resolution effects, allocate based on input size as maximum
-    GstCaps* incaps = gst_pad_get_current_caps(GST_BASE_TRANSFORM_SINK_PAD(this));
-    if(!incaps)
+    const gsize size = m_output_size > 0 ? m_output_size : GST_VIDEO_INFO_SIZE(&m_info);
+    if(!m_pool || m_pool_buffer_size != size)
     {
-      GST_ERROR_OBJECT(this, "No input caps available");
-      return GST_FLOW_ERROR;
+      if(!configure_pool(size))
+        return GST_FLOW_ERROR;
     }
 
-    GstVideoInfo in_info;
-    if(!gst_video_info_from_caps(&in_info, incaps))
+    if(gst_buffer_pool_acquire_buffer(m_pool, outbuf, nullptr) != GST_FLOW_OK)
     {
-      GST_ERROR_OBJECT(this, "Failed to get video info from input caps");
-      gst_caps_unref(incaps);
+      GST_ERROR_OBJECT(this, "Failed to acquire output buffer of size %lu", size);
       return GST_FLOW_ERROR;
     }
-    gst_caps_unref(incaps);
 
-    int in_width = GST_VIDEO_INFO_WIDTH(&in_info);
-    int in_height = GST_VIDEO_INFO_HEIGHT(&in_info);
-
-    // For effects that might increase resolution, allocate a larger buffer
-    // We'll use 2x the input dimensions as a reasonable upper bound
-    int max_width = std::min(in_width * 2, 8192);       // Cap at 8K width
-    int max_height = std::min(in_height * 2, 8192);     // Cap at 8K height
-    gsize max_buffer_size = max_width * max_height * 4; // RGBA
+    gst_buffer_copy_into(*outbuf, inbuf, GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
+    return GST_FLOW_OK;
+  }
 
-    *outbuf = gst_buffer_new_allocate(nullptr, max_buffer_size, nullptr);
+  bool configure_pool(gsize size)
+  {
+    release_pool();
 
-    if(!*outbuf)
+    m_pool = gst_buffer_pool_new();
+    GstStructure* config = gst_buffer_pool_get_config(m_pool);
+    gst_buffer_pool_config_set_params(config, nullptr, size, 2, 0);
+    if(!gst_buffer_pool_set_config(m_pool, config)
+       || !gst_buffer_pool_set_active(m_pool, TRUE))
     {
-      GST_ERROR_OBJECT(
-          this, "Failed to allocate output buffer of size %lu", max_buffer_size);
-      return GST_FLOW_ERROR;
+      GST_ERROR_OBJECT(this, "Failed to configure output buffer pool of size %lu", size);
+      release_pool();
+      return false;
     }
 
-    GST_DEBUG_OBJECT(
-        this, "Allocated max output buffer: %dx%d (input: %dx%d), size=%lu", max_width,
-        max_height, in_width, in_height, max_buffer_size);
-    return GST_FLOW_OK;
+    GST_DEBUG_OBJECT(this, "Configured output buffer pool of size %lu", size);
+    m_pool_buffer_size = size;
+    return true;
+  }
+
+  void release_pool()
+  {
+    if(m_pool)
+    {
+      gst_buffer_pool_set_active(m_pool, FALSE);
+      gst_object_unref(m_pool);
+      m_pool = nullptr;
+    }
   }
 };
 
@@ -470,12 +489,30 @@ struct metaclass<T>
 
     // Transform API - disable passthrough to ensure transform is always called
     base_transform_class->passthrough_on_same_caps = FALSE;
-    base_transform_class->transform_ip = nullptr; // Force out-of-place transformation
-    base_transform_class->transform = GST_DEBUG_FUNCPTR(
-        +[](GstBaseTransform* gobject, GstBuffer* inbuf,
-            GstBuffer* outbuf) -> GstFlowReturn {
-      return ((element<T>*)gobject)->transform(inbuf, outbuf);
-    });
+    if constexpr(element<T>::in_place)
+    {
+      // The default prepare_output_buffer gives the input buffer, made writable
+      base_transform_class->transform_ip = GST_DEBUG_FUNCPTR(
+          +[](GstBaseTransform* gobject, GstBuffer* buf) -> GstFlowReturn {
+        return ((element<T>*)gobject)->transform_ip(buf);
+      });
+    }
+    else
+    {
+      base_transform_class->transform_ip = nullptr; // Force out-of-place transformation
+      base_transform_class->transform = GST_DEBUG_FUNCPTR(
+          +[](GstBaseTransform* gobject, GstBuffer* inbuf,
+              GstBuffer* outbuf) -> GstFlowReturn {
+        return ((element<T>*)gobject)->transform(inbuf, outbuf);
+      });
+
+      // Output buffers come from a pool sized for the output texture
+      base_transform_class->prepare_output_buffer = GST_DEBUG_FUNCPTR(
+          +[](GstBaseTransform* gobject, GstBuffer* inbuf,
+              GstBuffer** outbuf) -> GstFlowReturn {
+        return ((element<T>*)gobject)->prepare_output_buffer(inbuf, outbuf);
+      });
+    }
 
     // Caps negotiation for texture processing
     base_transform_class->transform_caps = GST_DEBUG_FUNCPTR(
@@ -494,13 +531,6 @@ struct metaclass<T>
         +[](GstBaseTransform* gobject, GstCaps* incaps, GstCaps* outcaps) -> gboolean {
       return ((element<T>*)gobject)->set_caps(incaps, outcaps);
     });
-
-    // Handle dynamic output buffer allocation
-    base_transform_class->prepare_output_buffer = GST_DEBUG_FUNCPTR(
-        +[](GstBaseTransform* gobject, GstBuffer* inbuf,
-            GstBuffer** outbuf) -> GstFlowReturn {
-      return ((element<T>*)gobject)->prepare_output_buffer(inbuf, outbuf);
-    });
   }
 
   static GType get_type()
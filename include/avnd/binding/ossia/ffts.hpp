@@ -7,6 +7,7 @@
 #include <avnd/introspection/input.hpp>
 #include <avnd/introspection/output.hpp>
 #include <avnd/introspection/port.hpp>
+#include <avnd/wrappers/window.hpp>
 #include <boost/mp11.hpp>
 #include <ossia/audio/fft.hpp>
 #include <ossia/dataflow/nodes/media.hpp>
@@ -214,12 +215,36 @@ struct spectrum_storage
   AVND_NO_UNIQUE_ADDRESS spectrum_split_bus_input_storage<T> split_bus;
   AVND_NO_UNIQUE_ADDRESS spectrum_complex_bus_input_storage<T> complex_bus;
 
+  // Window tables of the spectrum ports, for the current buffer size
+  avnd::window_cache windows;
+
   void reserve_space(avnd::effect_container<T>& t, int buffer_size)
   {
     split_channel.init(t, buffer_size);
     complex_channel.init(t, buffer_size);
     split_bus.init(t, buffer_size);
     complex_bus.init(t, buffer_size);
+
+    if constexpr(
+        avnd::spectrum_split_channel_input_introspection<T>::size
+            + avnd::spectrum_complex_channel_input_introspection<T>::size
+            + avnd::spectrum_split_bus_input_introspection<T>::size
+            + avnd::spectrum_complex_bus_input_introspection<T>::size
+        > 0)
+    {
+      windows.clear();
+      auto prepare_window = [&]<typename Field>(Field& port) {
+        static constexpr auto kind = avnd::window_kind_for<Field>();
+        if constexpr(kind != avnd::window_kind::rectangular)
+          windows.prepare<ossia::fft_real>(kind, buffer_size, true);
+      };
+      auto&& inputs = avnd::get_inputs(t);
+      avnd::spectrum_split_channel_input_introspection<T>::for_all(inputs, prepare_window);
+      avnd::spectrum_complex_channel_input_introspection<T>::for_all(
+          inputs, prepare_window);
+      avnd::spectrum_split_bus_input_introspection<T>::for_all(inputs, prepare_window);
+      avnd::spectrum_complex_bus_input_introspection<T>::for_all(inputs, prepare_window);
+    }
   }
 };
 
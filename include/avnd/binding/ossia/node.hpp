@@ -209,6 +209,7 @@ public:
       // FIXME buffer_size can be variable: to be precise, we have to compute the ratio on each frame
       this->smooth.init(this->impl, sample_rate / buffer_size);
     }
+    this->smooth.reserve_ramps(this->impl, sample_rate, buffer_size);
 
     // constexpr const int total_input_channels = avnd::input_channels<T>(-1);
     // constexpr const int total_output_channels = avnd::output_channels<T>(-1);
@@ -556,7 +557,10 @@ public:
     return true;
   }
 
-  void process_smooth() { this->smooth.smooth_all(this->impl); }
+  void process_smooth()
+  {
+    this->smooth.smooth_all(this->impl, this->frame_count_for_this_tick);
+  }
 
   typename controls_input_queue<T>::i_tuple make_controls_in_tuple()
   {
@@ -230,7 +230,7 @@ struct process_before_run
       const int N = samples.size();
       if(N > 0)
       {
-        apply_window{}(ctrl, samples.data(), fft.input(), N);
+        apply_window{self.spectrums.windows}(ctrl, samples.data(), fft.input(), N);
 
         auto fftOut = reinterpret_cast<ossia::fft_real*>(fft.execute());
         deinterleave(fftOut, N);
@@ -256,7 +256,7 @@ struct process_before_run
       const int N = samples.size();
       if(N > 0)
       {
-        apply_window{}(ctrl, samples.data(), fft.input(), N);
+        apply_window{self.spectrums.windows}(ctrl, samples.data(), fft.input(), N);
 
         ctrl.spectrum.bin = reinterpret_cast<decltype(ctrl.spectrum.bin)>(fft.execute());
       }
@@ -281,7 +281,7 @@ struct process_before_run
         const int N = samples.size();
         if(N > 0)
         {
-          apply_window{}(ctrl, samples.data(), fft.input(), N);
+          apply_window{self.spectrums.windows}(ctrl, samples.data(), fft.input(), N);
 
           auto fftOut = reinterpret_cast<ossia::fft_real*>(fft.execute());
           deinterleave(fftOut, N);
@@ -311,7 +311,7 @@ struct process_before_run
         const int N = samples.size();
         if(N > 0)
         {
-          apply_window{}(ctrl, samples.data(), fft.input(), N);
+          apply_window{self.spectrums.windows}(ctrl, samples.data(), fft.input(), N);
 
           ctrl.spectrum.bin[c]
               = reinterpret_cast<decltype(ctrl.spectrum.bin[c])>(fft.execute());
@@ -1,60 +1,39 @@
 #pragma once
-#include <cmath>
+#include <avnd/wrappers/window.hpp>
 
 namespace oscr
 {
-
-struct hanning_window
-{
-  template <typename T>
-  void operator()(const T* in, T* out, int size)
-  {
-    const T norm = 0.5 / size;
-    const auto factor = ossia::two_pi / (size - 1);
-    for(int i = 0; i < size; ++i)
-    {
-      out[i] = in[i] * norm * (1. - std::cos(factor * i));
-    }
-  }
-};
-
-struct hamming_window
-{
-  template <typename T>
-  void operator()(const T* in, T* out, int size)
-  {
-    constexpr T a0 = 25. / 46.;
-    constexpr T a1 = 21. / 46.;
-
-    const T norm = 1. / size;
-    const auto factor = ossia::two_pi / (size - 1);
-    for(int i = 0; i < size; ++i)
-    {
-      out[i] = in[i] * norm * (a0 - a1 * std::cos(factor * i));
-    }
-  }
-};
-
+/**
+ * Windows the `frames` input samples of a spectrum port before its FFT.
+ *
+ * The windows are symmetric and scaled by 1 / frames. Their tables are
+ * computed once, in spectrum_storage::reserve_space: a block size which was
+ * not prepared there (e.g. a shorter last block) computes the window in place
+ * instead of allocating.
+ */
 struct apply_window
 {
+  const avnd::window_cache& cache;
+
   template <typename Field, typename T>
   void operator()(Field& f, const T* in, T* out, int frames) noexcept
   {
-    if constexpr(requires { Field::window::hanning; })
+    static constexpr auto kind = avnd::window_kind_for<Field>();
+    const T norm = T(1) / frames;
+    if constexpr(kind == avnd::window_kind::rectangular)
     {
-      hanning_window{}(in, out, frames);
+      for(int i = 0; i < frames; ++i)
+        out[i] = norm * in[i];
     }
-    else if constexpr(requires { Field::window::hamming; })
+    else if(const T* window = cache.find<T>(kind, frames, true))
     {
-      hamming_window{}(in, out, frames);
+      avnd::multiply_window(in, window, out, frames, norm);
     }
     else
     {
-      const T mult = 1. / frames;
+      avnd::fill_window(kind, out, frames, true);
       for(int i = 0; i < frames; ++i)
-      {
-        out[i] = mult * in[i];
-      }
+        out[i] *= norm * in[i];
     }
   }
 };
@@ -13,6 +13,7 @@
 #include <avnd/introspection/channels.hpp>
 #include <avnd/wrappers/controls.hpp>
 #include <avnd/wrappers/process_adapter.hpp>
+#include <avnd/wrappers/stft.hpp>
 #include <cmath>
 #include <m_pd.h>
 
@@ -63,6 +64,9 @@ struct audio_processor
   avnd::effect_container<T> implementation;
   avnd::process_adapter<T> processor;
 
+  // Analysis feeding the spectrum input ports
+  AVND_NO_UNIQUE_ADDRESS avnd::stft_storage<T> spectrums;
+
   std::array<t_int, dsp_input_count> dsp_inputs;
   inputs<T> input_setup;
 
@@ -174,6 +178,9 @@ struct audio_processor
         .rate = rate};
     processor.allocate_buffers(setup_info, float{});
 
+    if constexpr(sizeof(spectrums) > 1)
+      spectrums.reserve_space(implementation, input_channels, N);
+
     // Allocate buffers if supported
     avnd::prepare(implementation, setup_info);
 
@@ -217,9 +224,14 @@ struct audio_processor
       }
     }
 
+    avnd::span<t_sample*> in{input, std::size_t(input_channels)};
+
+    // Resynthesized spectrum ports replace their input channels
+    if constexpr(sizeof(spectrums) > 1)
+      in = spectrums.analyze(implementation, in, n);
+
     processor.process(
-        implementation, avnd::span<t_sample*>{input, input_channels},
-        avnd::span<t_sample*>{output, output_channels}, n);
+        implementation, in, avnd::span<t_sample*>{output, output_channels}, n);
 
     // Impulse-like (optional) inputs are one-shot: consumed by this block,
     // else a single [Bang< message would fire on every subsequent block.
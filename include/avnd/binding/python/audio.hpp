@@ -13,138 +13,286 @@
 #include <avnd/wrappers/effect_container.hpp>
 #include <avnd/wrappers/prepare.hpp>
 #include <avnd/wrappers/process_adapter.hpp>
+#include <avnd/wrappers/stft.hpp>
 
 #include <pybind11/numpy.h>
+#include <pybind11/stl.h>
 
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
 #include <vector>
 
 namespace python
 {
 namespace py = pybind11;
 
-// Drive an audio processor over one block. `ins` is (channels, frames) float32
-// (1-D is treated as mono); returns (out_channels, frames). Current control
-// values on `self` are copied into the processing instances first.
-template <typename T>
-py::array_t<float> run_audio(
-    T& self, py::array_t<float, py::array::c_style | py::array::forcecast> ins,
-    double rate)
+// Shape of a (channels, frames) float32 block; 1-D is treated as mono.
+inline std::pair<int, int> block_shape(const py::buffer_info& info, const char* func)
 {
-  const auto info = ins.request();
-  int n_in = 0, frames = 0;
   if(info.ndim == 1)
+    return {1, static_cast<int>(info.shape[0])};
+  if(info.ndim == 2)
+    return {static_cast<int>(info.shape[0]), static_cast<int>(info.shape[1])};
+
+  throw std::runtime_error(
+      std::string{func} + " expects a 1-D or 2-D float array (channels, frames)");
+}
+
+// An audio processor which keeps its state (filters, delays...) across blocks:
+// it is prepared once for a rate, a maximum block size and a channel count,
+// then fed successive blocks. Control values on `self` are copied into the
+// processing instances before each block, output controls back after it.
+template <typename T>
+class audio_stream
+{
+public:
+  audio_stream(T& self, double rate, int block_size, int channels)
+      : m_self{&self}
+      , m_rate{rate}
+      , m_block_size{block_size}
+      , m_inputs{channels}
   {
-    n_in = 1;
-    frames = static_cast<int>(info.shape[0]);
+    if(block_size <= 0 || channels <= 0)
+      throw std::runtime_error("stream expects a positive block size and channel count");
+
+    // Monophonic adapters process in.size() channels and write as many out, so
+    // the output must match the input count; sizing it by output_channels<T>()
+    // (e.g. 1 for a sample-port object) underflows out_ptrs -> heap corruption.
+    m_outputs = avnd::monophonic_audio_processor<T>
+                    ? std::max(1, m_inputs)
+                    : std::max(1, avnd::output_channels<T>(m_inputs));
+
+    auto& c = m_container;
+    c.init_channels(m_inputs, m_outputs);
+
+    // Default the container's control storage before copying instance values:
+    // nested inputs/outputs-TYPE ports live in the container, not on `T`, so the
+    // copy below can't reach them and they'd otherwise be read uninitialised.
+    avnd::init_controls(c);
+
+    for(auto&& st : c.full_state())
+    {
+      if constexpr(std::is_copy_assignable_v<T>)
+        st.effect = self;
+      else if constexpr(requires { st.inputs = avnd::get_inputs(self); })
+        st.inputs = avnd::get_inputs(self);
+    }
+
+    // Install no-op/inline handlers so host callables aren't empty when
+    // prepare()/process() runs them.
+    if constexpr(avnd::audio_bus_input_introspection<T>::size > 0)
+      avnd::audio_bus_input_introspection<T>::for_all(
+          avnd::get_inputs(c), [](auto& p) {
+            if constexpr(requires { p.request_channels; })
+              if(!p.request_channels)
+                p.request_channels = [](int) {};
+          });
+    if constexpr(avnd::audio_bus_output_introspection<T>::size > 0)
+      avnd::audio_bus_output_introspection<T>::for_all(
+          avnd::get_outputs(c), [](auto& p) {
+            if constexpr(requires { p.request_channels; })
+              if(!p.request_channels)
+                p.request_channels = [](int) {};
+          });
+    auto wire_buffer = [](auto& p) {
+      if constexpr(requires { p.buffer.upload; })
+        if(!p.buffer.upload)
+          p.buffer.upload = [](const char*, std::int64_t, std::int64_t) {};
+    };
+    if constexpr(avnd::buffer_output_introspection<T>::size > 0)
+      avnd::buffer_output_introspection<T>::for_all(avnd::get_outputs(c), wire_buffer);
+    if constexpr(avnd::buffer_input_introspection<T>::size > 0)
+      avnd::buffer_input_introspection<T>::for_all(avnd::get_inputs(c), wire_buffer);
+    if constexpr(avnd::has_worker<T>)
+      for(auto& impl : c.effects())
+      {
+        using worker_t = std::decay_t<decltype(impl.worker)>;
+        impl.worker.request = [](auto&&... args) {
+          worker_t::work(std::forward<decltype(args)>(args)...);
+        };
+      }
+
+    avnd::process_setup su{
+        .input_channels = m_inputs,
+        .output_channels = m_outputs,
+        .frames_per_buffer = block_size,
+        .rate = rate};
+    m_processor.allocate_buffers(su, float{});
+    m_processor.allocate_buffers(su, double{});
+    avnd::prepare(c, su);
+
+    // Sample-accurate control ports need their per-buffer storage reserved
+    // before process() (else the object writes into unallocated storage).
+    if constexpr(sizeof(m_control_buffers) > 1)
+      m_control_buffers.reserve_space(c, block_size);
+
+    if constexpr(sizeof(m_spectrums) > 1)
+      m_spectrums.reserve_space(c, m_inputs, block_size);
+
+    m_in_ptrs.resize(m_inputs);
+    m_out_ptrs.resize(m_outputs);
   }
-  else if(info.ndim == 2)
+
+  // Processes a (channels, frames) block with any number of frames, in parts
+  // of at most block_size frames. The result is written in `out` if given,
+  // which must be a writable C-contiguous float32 (output_channels, frames)
+  // array, otherwise in a new array.
+  py::array process(
+      py::array_t<float, py::array::c_style | py::array::forcecast> ins,
+      std::optional<py::array> out)
   {
-    n_in = static_cast<int>(info.shape[0]);
-    frames = static_cast<int>(info.shape[1]);
+    const auto info = ins.request();
+    const auto [n_in, frames] = block_shape(info, "process");
+    if(n_in != m_inputs)
+      throw std::runtime_error(
+          "process expects " + std::to_string(m_inputs) + " input channels, got "
+          + std::to_string(n_in));
+
+    float* out_base{};
+    if(out)
+    {
+      const bool shape_ok
+          = out->ndim() == 2 ? out->shape(0) == m_outputs && out->shape(1) == frames
+                             : out->ndim() == 1 && m_outputs == 1 && out->shape(0) == frames;
+      if(!shape_ok || !out->dtype().is(py::dtype::of<float>())
+         || !(out->flags() & py::array::c_style) || !out->writeable())
+        throw std::runtime_error(
+            "out must be a writable C-contiguous float32 array of shape ("
+            + std::to_string(m_outputs) + ", " + std::to_string(frames) + ")");
+      out_base = static_cast<float*>(out->mutable_data());
+    }
+    else
+    {
+      out = py::array_t<float>(std::vector<py::ssize_t>{m_outputs, frames});
+      out_base = static_cast<float*>(out->mutable_data());
+    }
+
+    copy_inputs();
+
+    auto* in_base = static_cast<float*>(info.ptr);
+    for(int start = 0; start < frames; start += m_block_size)
+    {
+      const int n = std::min(m_block_size, frames - start);
+      for(int ch = 0; ch < m_inputs; ch++)
+        m_in_ptrs[ch] = in_base + static_cast<std::size_t>(ch) * frames + start;
+      for(int ch = 0; ch < m_outputs; ch++)
+        m_out_ptrs[ch] = out_base + static_cast<std::size_t>(ch) * frames + start;
+
+      process_block(n);
+    }
+
+    copy_outputs();
+    return *std::move(out);
   }
-  else
+
+  avnd::effect_container<T>& container() noexcept { return m_container; }
+  double rate() const noexcept { return m_rate; }
+  int block_size() const noexcept { return m_block_size; }
+  int input_channels() const noexcept { return m_inputs; }
+  int output_channels() const noexcept { return m_outputs; }
+
+  // Delay of the resynthesized spectrum ports, in samples
+  int latency() const noexcept { return m_spectrums.latency(); }
+
+private:
+  void process_block(int frames)
   {
-    throw std::runtime_error(
-        "process_audio expects a 1-D or 2-D float array (channels, frames)");
-  }
+    struct tick
+    {
+      int frames;
+    } t{frames};
 
-  // Monophonic adapters process in.size() channels and write as many out, so
-  // the output must match the input count; sizing it by output_channels<T>()
-  // (e.g. 1 for a sample-port object) underflows out_ptrs -> heap corruption.
-  const int n_out = avnd::monophonic_audio_processor<T>
-                        ? std::max(1, n_in)
-                        : std::max(1, avnd::output_channels<T>(n_in));
+    auto ins = avnd::span<float*>{m_in_ptrs.data(), m_in_ptrs.size()};
+    const auto outs = avnd::span<float*>{m_out_ptrs.data(), m_out_ptrs.size()};
 
-  avnd::effect_container<T> c;
-  c.init_channels(n_in, n_out);
+    // Resynthesized spectrum ports replace their input channels
+    if constexpr(sizeof(m_spectrums) > 1)
+      ins = m_spectrums.analyze(m_container, ins, frames);
 
-  // Default the container's control storage before copying instance values:
-  // nested inputs/outputs-TYPE ports live in the container, not on `T`, so the
-  // copy below can't reach them and they'd otherwise be read uninitialised.
-  avnd::init_controls(c);
+    // The timed values of sample-accurate ports only belong to one block
+    if constexpr(sizeof(m_control_buffers) > 1)
+      m_control_buffers.clear_outputs(m_container);
 
-  for(auto&& st : c.full_state())
-  {
-    if constexpr(std::is_copy_assignable_v<T>)
-      st.effect = self;
-    else if constexpr(requires { st.inputs = avnd::get_inputs(self); })
-      st.inputs = avnd::get_inputs(self);
+    m_processor.process(m_container, ins, outs, t);
+
+    if constexpr(sizeof(m_control_buffers) > 1)
+      m_control_buffers.clear_inputs(m_container);
   }
 
-  // Install no-op/inline handlers so host callables aren't empty when
-  // prepare()/process() runs them.
-  if constexpr(avnd::audio_bus_input_introspection<T>::size > 0)
-    avnd::audio_bus_input_introspection<T>::for_all(
-        avnd::get_inputs(c), [](auto& p) {
-          if constexpr(requires { p.request_channels; })
-            if(!p.request_channels)
-              p.request_channels = [](int) {};
-        });
-  if constexpr(avnd::audio_bus_output_introspection<T>::size > 0)
-    avnd::audio_bus_output_introspection<T>::for_all(
-        avnd::get_outputs(c), [](auto& p) {
-          if constexpr(requires { p.request_channels; })
-            if(!p.request_channels)
-              p.request_channels = [](int) {};
-        });
-  auto wire_buffer = [](auto& p) {
-    if constexpr(requires { p.buffer.upload; })
-      if(!p.buffer.upload)
-        p.buffer.upload = [](const char*, std::int64_t, std::int64_t) {};
-  };
-  if constexpr(avnd::buffer_output_introspection<T>::size > 0)
-    avnd::buffer_output_introspection<T>::for_all(avnd::get_outputs(c), wire_buffer);
-  if constexpr(avnd::buffer_input_introspection<T>::size > 0)
-    avnd::buffer_input_introspection<T>::for_all(avnd::get_inputs(c), wire_buffer);
-  if constexpr(avnd::has_worker<T>)
-    for(auto& impl : c.effects())
+  // Only the parameter values are copied: the rest of the inputs, e.g. the
+  // sample-accurate storage, belongs to the processing instances.
+  void copy_inputs()
+  {
+    if constexpr(avnd::inputs_is_value<T>)
     {
-      using worker_t = std::decay_t<decltype(impl.worker)>;
-      impl.worker.request = [](auto&&... args) {
-        worker_t::work(std::forward<decltype(args)>(args)...);
-      };
+      for(auto&& st : m_container.full_state())
+      {
+        avnd::parameter_input_introspection<T>::for_all(
+            [&]<auto Idx, typename C>(avnd::field_reflection<Idx, C>) {
+          auto& src = avnd::pfr::get<Idx>(avnd::get_inputs(*m_self)).value;
+          auto& dst = avnd::pfr::get<Idx>(st.inputs);
+          if constexpr(requires { bool(src == dst.value); })
+          {
+            if(src == dst.value)
+              return;
+          }
+          dst.value = src;
+          if_possible(dst.update(st.effect));
+        });
+      }
     }
+  }
 
-  avnd::process_setup su{
-      .input_channels = n_in,
-      .output_channels = n_out,
-      .frames_per_buffer = frames,
-      .rate = rate};
-  avnd::process_adapter<T> proc;
-  proc.allocate_buffers(su, float{});
-  proc.allocate_buffers(su, double{});
-  avnd::prepare(c, su);
-
-  // Sample-accurate control ports need their per-buffer storage reserved
-  // before process() (else the object writes into unallocated storage).
-  avnd::control_storage<T> control_buffers;
-  if constexpr(sizeof(control_buffers) > 1)
-    control_buffers.reserve_space(c, frames);
-
-  auto* in_base = static_cast<float*>(info.ptr);
-  std::vector<float*> in_ptrs(n_in);
-  for(int ch = 0; ch < n_in; ch++)
-    in_ptrs[ch] = in_base + static_cast<std::size_t>(ch) * frames;
-
-  py::array_t<float> out(std::vector<py::ssize_t>{n_out, frames});
-  auto out_info = out.request();
-  auto* out_base = static_cast<float*>(out_info.ptr);
-  std::vector<float*> out_ptrs(n_out);
-  for(int ch = 0; ch < n_out; ch++)
-    out_ptrs[ch] = out_base + static_cast<std::size_t>(ch) * frames;
-
-  struct tick
+  // Output controls (e.g. analysis results) are readable on the Python
+  // instance afterwards.
+  void copy_outputs()
   {
-    int frames;
-  } t{frames};
+    if constexpr(avnd::outputs_is_value<T>)
+    {
+      for(auto&& st : m_container.full_state())
+      {
+        avnd::parameter_output_introspection<T>::for_all(
+            [&]<auto Idx, typename C>(avnd::field_reflection<Idx, C>) {
+          avnd::pfr::get<Idx>(avnd::get_outputs(*m_self)).value
+              = avnd::pfr::get<Idx>(st.outputs).value;
+        });
+        break;
+      }
+    }
+  }
+
+  T* m_self{};
+  avnd::effect_container<T> m_container;
+  avnd::process_adapter<T> m_processor;
+  avnd::control_storage<T> m_control_buffers;
+  avnd::stft_storage<T> m_spectrums;
+  std::vector<float*> m_in_ptrs;
+  std::vector<float*> m_out_ptrs;
+  double m_rate{};
+  int m_block_size{};
+  int m_inputs{};
+  int m_outputs{};
+};
+
+// Drive an audio processor over one block. `ins` is (channels, frames) float32
+// (1-D is treated as mono); returns (out_channels, frames). Current control
+// values on `self` are copied into the processing instances first.
+template <typename T>
+py::array run_audio(
+    T& self, py::array_t<float, py::array::c_style | py::array::forcecast> ins,
+    double rate)
+{
+  const auto [n_in, frames] = block_shape(ins.request(), "process_audio");
 
-  proc.process(
-      c, avnd::span<float*>{in_ptrs.data(), static_cast<std::size_t>(n_in)},
-      avnd::span<float*>{out_ptrs.data(), static_cast<std::size_t>(n_out)}, t);
+  audio_stream<T> stream{self, rate, std::max(1, frames), std::max(1, n_in)};
+  auto out = stream.process(std::move(ins), std::nullopt);
 
-  // Copy the processed state back so output controls (e.g. analysis results)
-  // are readable on the Python instance afterwards.
-  for(auto&& st : c.full_state())
+  // Copy the processed state back so that it is readable on the Python
+  // instance afterwards.
+  for(auto&& st : stream.container().full_state())
   {
     if constexpr(std::is_copy_assignable_v<T>)
       self = st.effect;
@@ -904,6 +904,29 @@ struct processor
              py::array_t<float, py::array::c_style | py::array::forcecast> ins,
              double rate) { return run_audio(self, std::move(ins), rate); },
           py::arg("input"), py::arg("rate") = 48000.0);
+
+      // obj.stream(rate, block_size, channels) prepares the processor once, the
+      // returned object then processes successive blocks and keeps its state.
+      static py::class_<audio_stream<T>> stream_cls(
+          m, (std::string{c_str(avnd::get_c_identifier<T>())} + "_stream").c_str());
+      stream_cls.def(
+          "process", &audio_stream<T>::process, py::arg("input"),
+          py::arg("out") = py::none());
+      stream_cls.def_property_readonly("rate", &audio_stream<T>::rate);
+      stream_cls.def_property_readonly("block_size", &audio_stream<T>::block_size);
+      stream_cls.def_property_readonly(
+          "input_channels", &audio_stream<T>::input_channels);
+      stream_cls.def_property_readonly(
+          "output_channels", &audio_stream<T>::output_channels);
+      stream_cls.def_property_readonly("latency", &audio_stream<T>::latency);
+
+      class_def.def(
+          "stream",
+          [](T& self, double rate, int block_size, int channels) {
+        return std::make_unique<audio_stream<T>>(self, rate, block_size, channels);
+          },
+          py::arg("rate") = 48000.0, py::arg("block_size") = 512,
+          py::arg("channels") = 2, py::keep_alive<0, 1>());
     }
 
     if constexpr(avnd::inputs_is_value<T>)
@@ -0,0 +1,239 @@
+#pragma once
+
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+/**
+ * Probes for the realtime-safety harness.
+ *
+ * Must be included in exactly one translation unit of the executable: it
+ * replaces the global allocation functions and, on Linux, interposes the
+ * C allocator (through the glibc __libc_* entry points) as well as the
+ * blocking pthread lock functions.
+ *
+ * On other platforms only operator new / delete are checked.
+ */
+
+#include <avnd/binding/rtcheck/rtcheck.hpp>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#if defined(__linux__) && defined(__GLIBC__)
+#include <dlfcn.h>
+#include <pthread.h>
+#define AVND_RTCHECK_INTERPOSE_LIBC 1
+#else
+#define AVND_RTCHECK_INTERPOSE_LIBC 0
+#endif
+
+#if AVND_RTCHECK_INTERPOSE_LIBC
+extern "C" {
+void* __libc_malloc(std::size_t);
+void* __libc_calloc(std::size_t, std::size_t);
+void* __libc_realloc(void*, std::size_t);
+void* __libc_memalign(std::size_t, std::size_t);
+void __libc_free(void*);
+
+void* malloc(std::size_t sz)
+{
+  rtcheck::record(rtcheck::violation::allocation);
+  return __libc_malloc(sz);
+}
+
+void* calloc(std::size_t n, std::size_t sz)
+{
+  rtcheck::record(rtcheck::violation::allocation);
+  return __libc_calloc(n, sz);
+}
+
+void* realloc(void* ptr, std::size_t sz)
+{
+  rtcheck::record(rtcheck::violation::allocation);
+  return __libc_realloc(ptr, sz);
+}
+
+void* aligned_alloc(std::size_t align, std::size_t sz)
+{
+  rtcheck::record(rtcheck::violation::allocation);
+  return __libc_memalign(align, sz);
+}
+
+void* memalign(std::size_t align, std::size_t sz)
+{
+  rtcheck::record(rtcheck::violation::allocation);
+  return __libc_memalign(align, sz);
+}
+
+int posix_memalign(void** ptr, std::size_t align, std::size_t sz)
+{
+  rtcheck::record(rtcheck::violation::allocation);
+  *ptr = __libc_memalign(align, sz);
+  return *ptr ? 0 : ENOMEM;
+}
+
+void free(void* ptr)
+{
+  if(ptr)
+    rtcheck::record(rtcheck::violation::deallocation);
+  __libc_free(ptr);
+}
+
+// Non-blocking variants (trylock) are fine on the audio thread.
+// dlsym may allocate: the lookup itself is not reported.
+#define AVND_RTCHECK_LOCK_PROBE(func, type)                                   \
+  int func(type* obj)                                                          \
+  {                                                                            \
+    using func_type = int (*)(type*);                                          \
+    static constinit func_type real = nullptr;                                 \
+    if(!real)                                                                  \
+    {                                                                          \
+      const bool armed = rtcheck::g_armed;                                     \
+      rtcheck::g_armed = false;                                                \
+      real = reinterpret_cast<func_type>(dlsym(RTLD_NEXT, #func));             \
+      rtcheck::g_armed = armed;                                                \
+    }                                                                          \
+    rtcheck::record(rtcheck::violation::lock);                                 \
+    return real(obj);                                                          \
+  }
+
+AVND_RTCHECK_LOCK_PROBE(pthread_mutex_lock, pthread_mutex_t)
+AVND_RTCHECK_LOCK_PROBE(pthread_rwlock_rdlock, pthread_rwlock_t)
+AVND_RTCHECK_LOCK_PROBE(pthread_rwlock_wrlock, pthread_rwlock_t)
+#undef AVND_RTCHECK_LOCK_PROBE
+}
+
+namespace rtcheck
+{
+inline void* raw_alloc(std::size_t sz) noexcept
+{
+  return __libc_malloc(sz ? sz : 1);
+}
+inline void* raw_aligned_alloc(std::size_t sz, std::size_t align) noexcept
+{
+  return __libc_memalign(align, sz ? sz : 1);
+}
+inline void raw_free(void* ptr) noexcept
+{
+  __libc_free(ptr);
+}
+inline void raw_aligned_free(void* ptr) noexcept
+{
+  __libc_free(ptr);
+}
+}
+#else
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+namespace rtcheck
+{
+inline void* raw_alloc(std::size_t sz) noexcept
+{
+  return std::malloc(sz ? sz : 1);
+}
+inline void* raw_aligned_alloc(std::size_t sz, std::size_t align) noexcept
+{
+  sz = ((sz ? sz : 1) + align - 1) / align * align;
+#if defined(_WIN32)
+  return _aligned_malloc(sz, align);
+#else
+  return std::aligned_alloc(align, sz);
+#endif
+}
+inline void raw_free(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+inline void raw_aligned_free(void* ptr) noexcept
+{
+#if defined(_WIN32)
+  _aligned_free(ptr);
+#else
+  std::free(ptr);
+#endif
+}
+}
+#endif
+
+void* operator new(std::size_t sz)
+{
+  rtcheck::record(rtcheck::violation::allocation);
+  if(void* p = rtcheck::raw_alloc(sz))
+    return p;
+  throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t sz)
+{
+  return ::operator new(sz);
+}
+
+void* operator new(std::size_t sz, const std::nothrow_t&) noexcept
+{
+  rtcheck::record(rtcheck::violation::allocation);
+  return rtcheck::raw_alloc(sz);
+}
+
+void* operator new[](std::size_t sz, const std::nothrow_t&) noexcept
+{
+  return ::operator new(sz, std::nothrow);
+}
+
+void* operator new(std::size_t sz, std::align_val_t al)
+{
+  rtcheck::record(rtcheck::violation::allocation);
+  if(void* p = rtcheck::raw_aligned_alloc(sz, static_cast<std::size_t>(al)))
+    return p;
+  throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t sz, std::align_val_t al)
+{
+  return ::operator new(sz, al);
+}
+
+void operator delete(void* ptr) noexcept
+{
+  if(ptr)
+    rtcheck::record(rtcheck::violation::deallocation);
+  rtcheck::raw_free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+  ::operator delete(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+  ::operator delete(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+  ::operator delete(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+  if(ptr)
+    rtcheck::record(rtcheck::violation::deallocation);
+  rtcheck::raw_aligned_free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t al) noexcept
+{
+  ::operator delete(ptr, al);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t al) noexcept
+{
+  ::operator delete(ptr, al);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t al) noexcept
+{
+  ::operator delete(ptr, al);
+}
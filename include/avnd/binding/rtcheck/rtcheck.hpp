@@ -0,0 +1,561 @@
+#pragma once
+
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+/**
+ * Realtime-safety harness.
+ *
+ * Runs a processor through its process_adapter, exactly like an audio
+ * binding does on its audio callback, and fails if anything called from
+ * there allocates, frees or takes a lock.
+ *
+ * Each run goes through the channel layouts the processor accepts and the
+ * ways hosts call the adapter (see host_mode). At the start of each block,
+ * controls change and MIDI messages and messages are sent, as a host does
+ * from its audio callback, following the same seeded random sequence on
+ * every run; the other ports are wired as in the fuzz harness.
+ *
+ * Everything up to and including prepare() may allocate: only the process
+ * cycles are checked. The probes themselves (see interpose.hpp) are armed
+ * per-thread, so helper threads started by the processor are not checked.
+ *
+ * Set AVND_RTCHECK_ABORT=1 in the environment to abort() on the first
+ * violation, so that a debugger shows where it comes from.
+ */
+
+#include <avnd/concepts/audio_processor.hpp>
+#include <avnd/concepts/callback.hpp>
+#include <avnd/concepts/generic.hpp>
+#include <avnd/introspection/channels.hpp>
+#include <avnd/introspection/input.hpp>
+#include <avnd/introspection/messages.hpp>
+#include <avnd/introspection/midi.hpp>
+#include <avnd/introspection/output.hpp>
+#include <avnd/wrappers/callbacks_adapter.hpp>
+#include <avnd/wrappers/controls.hpp>
+#include <avnd/wrappers/controls_storage.hpp>
+#include <avnd/wrappers/effect_container.hpp>
+#include <avnd/wrappers/prepare.hpp>
+#include <avnd/wrappers/process_adapter.hpp>
+#include <avnd/wrappers/process_execution.hpp>
+#include <avnd/wrappers/smooth.hpp>
+
+#include <boost/mp11/algorithm.hpp>
+#include <boost/mp11/list.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <random>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace rtcheck
+{
+/** Logging is not what is under test here. */
+struct silent_logger
+{
+  template <typename... Args> constexpr void trace(Args&&...) const noexcept { }
+  template <typename... Args> constexpr void info(Args&&...) const noexcept { }
+  template <typename... Args> constexpr void debug(Args&&...) const noexcept { }
+  template <typename... Args> constexpr void warn(Args&&...) const noexcept { }
+  template <typename... Args> constexpr void error(Args&&...) const noexcept { }
+  template <typename... Args> constexpr void critical(Args&&...) const noexcept { }
+};
+
+struct counters
+{
+  std::atomic_int allocations{};
+  std::atomic_int deallocations{};
+  std::atomic_int locks{};
+};
+
+inline constinit counters g_counters{};
+inline constinit bool g_abort_on_violation = false;
+inline constinit thread_local bool g_armed = false;
+
+enum class violation
+{
+  allocation,
+  deallocation,
+  lock
+};
+
+// Called by the probes: must neither allocate nor lock.
+inline void record(violation v) noexcept
+{
+  if(!g_armed)
+    return;
+
+  switch(v)
+  {
+    case violation::allocation:
+      g_counters.allocations.fetch_add(1, std::memory_order_relaxed);
+      break;
+    case violation::deallocation:
+      g_counters.deallocations.fetch_add(1, std::memory_order_relaxed);
+      break;
+    case violation::lock:
+      g_counters.locks.fetch_add(1, std::memory_order_relaxed);
+      break;
+  }
+
+  if(g_abort_on_violation)
+    std::abort();
+}
+
+/** Arms the probes on the current thread for the lifetime of the object */
+struct scoped_check
+{
+  scoped_check() noexcept { g_armed = true; }
+  ~scoped_check() { g_armed = false; }
+  scoped_check(const scoped_check&) = delete;
+  scoped_check& operator=(const scoped_check&) = delete;
+};
+
+inline constexpr int block_size = 512;
+inline constexpr int blocks_per_precision = 16;
+inline constexpr int default_channels = 2;
+
+// Host events injected in each (sub-)block
+inline constexpr int max_midi_messages = 8;
+inline constexpr int max_splits = 3;
+inline constexpr int texture_size = 16;
+
+// The same seed on every run, so that a violation is reproducible
+using random_engine = std::minstd_rand;
+inline constexpr random_engine::result_type seed = 0x5eed;
+
+/**
+ * How the host drives the process adapter:
+ * - whole_blocks: one call per buffer, like most plug-in APIs;
+ * - split_blocks: buffers cut at control changes, like CLAP and VST3 do with
+ *   tag_split_on_parameter_changes;
+ * - smoothed: one call per buffer with the smoothing storage, like ossia.
+ */
+enum class host_mode
+{
+  whole_blocks,
+  split_blocks,
+  smoothed
+};
+
+// Callback outputs would std::terminate when called empty: install no-op handlers.
+template <typename T>
+void install_callbacks(avnd::effect_container<T>& effect, avnd::callback_storage<T>& storage)
+{
+  using outputs_t = typename avnd::outputs_type<T>::type;
+  if constexpr(avnd::callback_introspection<outputs_t>::size > 0)
+  {
+    storage.wrap_callbacks(
+        effect,
+        []<typename Field, template <typename...> typename L, typename Ret,
+           typename... Args, std::size_t Idx>(
+            Field&, L<Ret, Args...>, avnd::num<Idx>) {
+      if constexpr(std::is_void_v<Ret>)
+        return [](Args...) {};
+      else
+        return [](Args...) -> Ret { return Ret{}; };
+    });
+  }
+}
+
+// The other callables a node may call from process(), as in the fuzz harness:
+// buffer uploads and channel requests of variable-channel busses.
+template <typename T>
+void wire_ports(avnd::effect_container<T>& effect)
+{
+  auto wire_buffer = [](auto& p) {
+    if constexpr(requires { p.buffer.upload; })
+      if(!p.buffer.upload)
+        p.buffer.upload = [](const char*, std::int64_t, std::int64_t) {};
+  };
+  if constexpr(avnd::buffer_output_introspection<T>::size > 0)
+    avnd::buffer_output_introspection<T>::for_all(avnd::get_outputs(effect), wire_buffer);
+  if constexpr(avnd::buffer_input_introspection<T>::size > 0)
+    avnd::buffer_input_introspection<T>::for_all(avnd::get_inputs(effect), wire_buffer);
+
+  auto wire_channels = [](auto& p) {
+    if constexpr(requires { p.request_channels; })
+      if(!p.request_channels)
+        p.request_channels = [](int) {};
+  };
+  if constexpr(avnd::audio_bus_input_introspection<T>::size > 0)
+    avnd::audio_bus_input_introspection<T>::for_all(avnd::get_inputs(effect), wire_channels);
+  if constexpr(avnd::audio_bus_output_introspection<T>::size > 0)
+    avnd::audio_bus_output_introspection<T>::for_all(avnd::get_outputs(effect), wire_channels);
+}
+
+// CPU texture inputs get an image, so that texture filters do not bail out
+// on a null texture. bufs holds one image per port.
+template <typename T>
+void wire_textures(
+    avnd::effect_container<T>& effect, std::vector<std::vector<unsigned char>>& bufs,
+    random_engine& rng)
+{
+  if constexpr(avnd::cpu_texture_input_introspection<T>::size > 0)
+  {
+    bufs.resize(avnd::cpu_texture_input_introspection<T>::size);
+    avnd::cpu_texture_input_introspection<T>::for_all_n(
+        avnd::get_inputs(effect), [&]<auto Idx, typename P>(P& port, avnd::predicate_index<Idx>) {
+      auto& tex = port.texture;
+      using tex_t = std::decay_t<decltype(tex)>;
+      std::size_t bpp;
+      if constexpr(requires { tex.bytes_per_pixel(); })
+        bpp = tex.bytes_per_pixel();
+      else
+        bpp = tex_t::bytes_per_pixel;
+
+      // Sized in bytes by new: aligned enough for float texels too
+      auto& buf = bufs[Idx];
+      buf.resize(std::size_t(texture_size) * texture_size * bpp);
+      for(auto& b : buf)
+        b = static_cast<unsigned char>(rng());
+
+      tex.width = texture_size;
+      tex.height = texture_size;
+      tex.bytes = reinterpret_cast<decltype(tex.bytes)>(buf.data());
+      tex.changed = true;
+    });
+  }
+}
+
+template <typename T>
+void touch_textures(avnd::effect_container<T>& effect) noexcept
+{
+  if constexpr(avnd::cpu_texture_input_introspection<T>::size > 0)
+    avnd::cpu_texture_input_introspection<T>::for_all(
+        avnd::get_inputs(effect), [](auto& port) { port.texture.changed = true; });
+}
+
+/**
+ * Changes some controls, as a host does at the start of a (sub-)block:
+ * values are taken in the range of each control, update() is called on each
+ * instance and sample-accurate ports get the change at a random frame.
+ */
+template <typename T>
+void change_controls(
+    avnd::effect_container<T>& effect, avnd::control_storage<T>& controls,
+    random_engine& rng, int frames)
+{
+  using param_in_info = avnd::parameter_input_introspection<T>;
+  if constexpr(param_in_info::size > 0)
+  {
+    // Every instance of a multi-instance effect sees the same changes
+    const auto block_seed = rng();
+    bool first_instance = true;
+    for(auto state : effect.full_state())
+    {
+      random_engine values{block_seed};
+      std::uniform_real_distribution<double> unit{0., 1.};
+      param_in_info::for_all(state.inputs, [&]<typename C>(C& field) {
+        const bool change = values() % 4 == 0;
+        const double v = unit(values);
+        const int frame = int(values() % std::max(frames, 1));
+        if constexpr(requires { field.value = avnd::map_control_from_01<C>(v); })
+        {
+          if(!change)
+            return;
+          field.value = avnd::map_control_from_01<C>(v);
+          if_possible(field.update(state.effect));
+
+          // Recorded once for all the instances
+          if(first_instance)
+            controls.add_timed_value(effect, field, field.value, frame, frames);
+        }
+      });
+      first_instance = false;
+    }
+  }
+}
+
+/** Sends valid MIDI 1 channel messages to every MIDI input. */
+template <typename T>
+void send_midi(
+    avnd::effect_container<T>& effect, avnd::midi_storage<T>& midi, random_engine& rng,
+    int frames)
+{
+  if constexpr(avnd::midi_input_introspection<T>::size > 0)
+  {
+    avnd::midi_input_introspection<T>::for_all(avnd::get_inputs(effect), [&](auto& port) {
+      const int n = int(rng() % (max_midi_messages + 1));
+      for(int i = 0; i < n; i++)
+      {
+        static constexpr std::uint8_t kinds[]
+            = {0x80, 0x90, 0xA0, 0xB0, 0xC0, 0xD0, 0xE0};
+        const std::uint8_t status = kinds[rng() % std::size(kinds)] | (rng() % 16);
+        const std::uint8_t bytes[3]{
+            status, std::uint8_t(rng() % 128), std::uint8_t(rng() % 128)};
+        const std::size_t size = (status & 0xF0) == 0xC0 || (status & 0xF0) == 0xD0 ? 2 : 3;
+
+        auto msg = midi.push_message(port);
+        if(!msg)
+          break;
+        if_possible(msg->timestamp = int(rng() % std::max(frames, 1)));
+        if(!midi.assign_bytes(*msg, bytes, size))
+          midi.pop_message(port);
+      }
+    });
+  }
+}
+
+template <typename A>
+using message_argument_supported = std::bool_constant<
+    std::is_arithmetic_v<std::decay_t<A>>
+    || std::is_same_v<std::decay_t<A>, std::string>
+    || std::is_same_v<std::decay_t<A>, std::string_view>>;
+
+// The arguments of a message, minus a leading T& ("self") argument
+template <typename T, typename L, bool Empty = boost::mp11::mp_size<L>::value == 0>
+struct message_arguments
+{
+  using type = L;
+};
+template <typename T, typename L>
+struct message_arguments<T, L, false>
+{
+  using type = std::conditional_t<
+      std::is_same_v<std::decay_t<boost::mp11::mp_first<L>>, T>,
+      boost::mp11::mp_pop_front<L>, L>;
+};
+
+// Same call shapes as the pd / max bindings
+template <typename M, typename T>
+void invoke_message(T& impl, auto&... args)
+{
+  if constexpr(requires(M m) { m(impl, args...); })
+    M{}(impl, args...);
+  else if constexpr(requires(M m) { m(args...); })
+    M{}(args...);
+  else
+  {
+    static constexpr auto f = avnd::message_get_func<M>();
+    if constexpr(std::is_member_function_pointer_v<std::decay_t<decltype(f)>>)
+    {
+      if constexpr(requires { (impl.*f)(args...); })
+        (impl.*f)(args...);
+      else if constexpr(requires { (impl.*f)(impl, args...); })
+        (impl.*f)(impl, args...);
+    }
+    else
+    {
+      if constexpr(requires { f(impl, args...); })
+        f(impl, args...);
+      else if constexpr(requires { f(args...); })
+        f(args...);
+    }
+  }
+}
+
+template <typename A>
+void random_argument(A& a, random_engine& rng) noexcept
+{
+  // Strings stay empty: building them would allocate
+  if constexpr(std::is_arithmetic_v<A>)
+    a = A(rng() % 128);
+}
+
+/** Calls one random message, or none, with small numbers and empty strings. */
+template <typename T>
+void send_message(avnd::effect_container<T>& effect, random_engine& rng)
+{
+  if constexpr(avnd::messages_introspection<T>::size > 0)
+  {
+    const int target = int(rng() % (avnd::messages_introspection<T>::size + 1));
+    int index = 0;
+    avnd::messages_introspection<T>::for_all(
+        avnd::get_messages(effect), [&]<typename M>(M&) {
+      if(index++ != target)
+        return;
+      if constexpr(!std::is_void_v<avnd::message_reflection<M>>)
+      {
+        using args_t = typename message_arguments<
+            T, typename avnd::message_reflection<M>::arguments>::type;
+        if constexpr(boost::mp11::mp_all_of<args_t, message_argument_supported>::value)
+        {
+          [&]<typename... Args>(boost::mp11::mp_list<Args...>) {
+            std::tuple<std::decay_t<Args>...> args;
+            std::apply([&](auto&... a) { (random_argument(a, rng), ...); }, args);
+            for(auto& impl : effect.effects())
+              std::apply([&](auto&... a) { invoke_message<M>(impl, a...); }, args);
+          }(args_t{});
+        }
+      }
+    });
+  }
+}
+
+// The host state which lives for one run of the processor
+template <typename T>
+struct session
+{
+  avnd::effect_container<T> effect;
+  avnd::process_adapter<T> processor;
+  avnd::midi_storage<T> midi;
+  avnd::control_storage<T> controls;
+  avnd::callback_storage<T> callbacks;
+  avnd::smooth_storage<T> smooth;
+  std::vector<std::vector<unsigned char>> textures;
+  random_engine rng{seed};
+};
+
+template <typename T, typename FP>
+void process_blocks(session<T>& s, host_mode mode, int in_ch, int out_ch)
+{
+  std::vector<std::vector<FP>> in_storage(in_ch, std::vector<FP>(block_size));
+  std::vector<std::vector<FP>> out_storage(out_ch, std::vector<FP>(block_size));
+  std::vector<FP*> in_ptrs(in_ch), out_ptrs(out_ch);
+
+  auto& effect = s.effect;
+  int phase = 0;
+  for(int b = 0; b < blocks_per_precision; b++)
+  {
+    for(auto& c : in_storage)
+      for(int i = 0; i < block_size; i++)
+        c[i] = FP(0.5) * std::sin(FP(0.01) * FP(phase + i));
+    phase += block_size;
+    touch_textures(effect);
+
+    // Sorted sub-block boundaries
+    int bounds[max_splits + 2]{0};
+    int num_bounds = 1;
+    if(mode == host_mode::split_blocks)
+    {
+      const int splits = 1 + int(s.rng() % max_splits);
+      for(int i = 0; i < splits; i++)
+        bounds[num_bounds++] = 1 + int(s.rng() % (block_size - 1));
+      std::sort(bounds + 1, bounds + num_bounds);
+    }
+    bounds[num_bounds] = block_size;
+
+    for(int sub = 0; sub < num_bounds; sub++)
+    {
+      const int start = bounds[sub];
+      const int frames = bounds[sub + 1] - start;
+      if(frames == 0)
+        continue;
+      for(int c = 0; c < in_ch; c++)
+        in_ptrs[c] = in_storage[c].data() + start;
+      for(int c = 0; c < out_ch; c++)
+        out_ptrs[c] = out_storage[c].data() + start;
+
+      // Hosts apply their events on the audio thread too
+      scoped_check check;
+      change_controls(effect, s.controls, s.rng, frames);
+      send_midi(effect, s.midi, s.rng, frames);
+      send_message(effect, s.rng);
+
+      const avnd::span<FP*> in{in_ptrs.data(), std::size_t(in_ch)};
+      const avnd::span<FP*> out{out_ptrs.data(), std::size_t(out_ch)};
+      if(mode == host_mode::smoothed)
+        s.processor.process(effect, in, out, frames, s.smooth);
+      else
+        s.processor.process(effect, in, out, frames);
+
+      s.midi.clear_inputs(effect);
+      s.midi.clear_outputs(effect);
+      s.controls.clear_inputs(effect);
+      s.controls.clear_outputs(effect);
+    }
+  }
+}
+
+template <typename T>
+void run_session(host_mode mode, int in_ch, int out_ch)
+{
+  session<T> s;
+  auto& effect = s.effect;
+
+  // Before init_controls: update() may already call into the host
+  install_callbacks(effect, s.callbacks);
+  wire_ports(effect);
+  avnd::init_controls(effect);
+
+  constexpr bool is_audio
+      = avnd::monophonic_audio_processor<T> || avnd::polyphonic_audio_processor<T>;
+  if constexpr(is_audio)
+    effect.init_channels(in_ch, out_ch);
+
+  const double rate = 48000.;
+  avnd::process_setup setup{
+      .input_channels = in_ch,
+      .output_channels = out_ch,
+      .frames_per_buffer = block_size,
+      .rate = rate};
+
+  s.processor.allocate_buffers(setup, float{});
+  s.processor.allocate_buffers(setup, double{});
+  s.midi.reserve_space(effect, block_size);
+  s.controls.reserve_space(effect, block_size);
+  if(mode == host_mode::smoothed)
+  {
+    if constexpr(avnd::sample_arg_processor<T> || avnd::sample_port_processor<T>)
+      s.smooth.init(effect, rate);
+    else
+      s.smooth.init(effect, rate / block_size);
+    s.smooth.reserve_ramps(effect, rate, block_size);
+  }
+  avnd::prepare(effect, setup);
+  wire_textures(effect, s.textures, s.rng);
+
+  process_blocks<T, float>(s, mode, in_ch, out_ch);
+  process_blocks<T, double>(s, mode, in_ch, out_ch);
+}
+
+// Channel counts for a requested count, as the bindings resolve them
+template <typename T>
+std::pair<int, int> resolve_channels(int requested)
+{
+  constexpr bool is_audio
+      = avnd::monophonic_audio_processor<T> || avnd::polyphonic_audio_processor<T>;
+  if constexpr(!is_audio)
+    return {0, 0};
+
+  int in_ch = avnd::input_channels<T>(requested);
+  int out_ch = avnd::output_channels<T>(requested);
+  if(in_ch < 0)
+    in_ch = requested;
+  if(out_ch < 0)
+    out_ch = requested;
+  return {in_ch, out_ch};
+}
+
+/** Returns the process exit code: 0 when no violation was recorded. */
+template <typename T>
+int run(std::string_view name)
+{
+  if(const char* e = std::getenv("AVND_RTCHECK_ABORT"))
+    g_abort_on_violation = std::atoi(e) != 0;
+
+  // Mono, then the default layout when it is a different one
+  std::vector<std::pair<int, int>> layouts{resolve_channels<T>(1)};
+  if(resolve_channels<T>(default_channels) != layouts.front())
+    layouts.push_back(resolve_channels<T>(default_channels));
+
+  std::vector<host_mode> modes{host_mode::whole_blocks, host_mode::split_blocks};
+  if constexpr(avnd::smooth_parameter_input_introspection<T>::size > 0)
+    modes.push_back(host_mode::smoothed);
+
+  for(auto [in_ch, out_ch] : layouts)
+    for(auto mode : modes)
+      run_session<T>(mode, in_ch, out_ch);
+
+  const int allocs = g_counters.allocations.load();
+  const int frees = g_counters.deallocations.load();
+  const int locks = g_counters.locks.load();
+  if(allocs + frees + locks == 0)
+    return 0;
+
+  std::fprintf(
+      stderr, "%.*s: %d allocation(s), %d deallocation(s), %d lock(s) in process()\n",
+      int(name.size()), name.data(), allocs, frees, locks);
+  return 1;
+}
+}
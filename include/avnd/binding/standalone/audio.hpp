@@ -2,7 +2,10 @@
 
 /* SPDX-License-Identifier: GPL-3.0-or-later */
 
+#include <avnd/binding/standalone/configure.hpp>
+#include <avnd/binding/standalone/parameter_mailbox.hpp>
 #include <avnd/concepts/all.hpp>
+#include <avnd/concepts/logger.hpp>
 #include <avnd/introspection/input.hpp>
 #include <avnd/introspection/messages.hpp>
 #include <avnd/introspection/output.hpp>
@@ -28,6 +31,9 @@ struct audio_mapper
 
   AVND_NO_UNIQUE_ADDRESS avnd::process_adapter<T> processor;
 
+  // Written by the OSCQuery callbacks, applied at the start of each block
+  parameter_mailboxes<T> parameters;
+
   explicit audio_mapper(
       avnd::effect_container<T>& object, int in_channels, int out_channels, int bs,
       int rate)
@@ -58,11 +64,19 @@ struct audio_mapper
 
   void operator()(const ossia::audio_tick_state& st)
   {
+    // Processors may log from here: register the audio thread with the logger.
+    // The audio API does not tell on which thread it will call us beforehand:
+    // only the first callback on a thread sets it up, the others are a
+    // thread_local read.
+    if constexpr(avnd::audio_thread_logger<config::logger_type>)
+      config::logger_type::attach();
+
     const audio_tick tick = {.frames = (int)st.frames};
     const int n = avnd::get_frames(tick);
     const auto ins
         = avnd::span<float*>{const_cast<float**>(st.inputs), (std::size_t)st.n_in};
     const auto outs = avnd::span<float*>{st.outputs, (std::size_t)st.n_out};
+    parameters.apply(object);
     this->processor.process(object, ins, outs, tick);
   }
 
@@ -1,6 +1,6 @@
 #pragma once
 #include <avnd/wrappers/configure.hpp>
-#include <halp/log.hpp>
+#include <halp/deferred_log.hpp>
 
 #include <utility>
 
@@ -8,7 +8,9 @@ namespace standalone
 {
 struct config
 {
-  using logger_type = halp::basic_logger;
+  // Processors log from the audio callback, which is deferred, and from the
+  // main thread, which is not
+  using logger_type = halp::audio_deferred_logger;
 };
 
 }
@@ -2,6 +2,7 @@
 
 /* SPDX-License-Identifier: GPL-3.0-or-later */
 
+#include <avnd/binding/standalone/parameter_mailbox.hpp>
 #include <avnd/concepts/all.hpp>
 #include <avnd/introspection/input.hpp>
 #include <avnd/introspection/messages.hpp>
@@ -31,12 +32,16 @@ template <typename T>
 struct oscquery_mapper
 {
   avnd::effect_container<T>& object;
+  parameter_mailboxes<T>& parameters;
 
   std::shared_ptr<ossia::net::network_context> m_context;
   ossia::net::generic_device m_dev;
 
-  explicit oscquery_mapper(avnd::effect_container<T>& object, int osc_port, int ws_port)
+  explicit oscquery_mapper(
+      avnd::effect_container<T>& object, parameter_mailboxes<T>& parameters,
+      int osc_port, int ws_port)
       : object{object}
+      , parameters{parameters}
       , m_context{std::make_shared<ossia::net::network_context>()}
       , m_dev{
             std::make_unique<ossia::oscquery_asio::oscquery_server_protocol>(
@@ -46,9 +51,28 @@ struct oscquery_mapper
     create_ports();
   }
 
-  template <avnd::parameter_port Field>
+  // Value types which the OSCQuery parameters can be converted to
+  template <typename Field>
+  static constexpr bool supported_control()
+  {
+    using value_type = std::remove_cvref_t<decltype(Field::value)>;
+    if constexpr(avnd::enum_parameter<Field>)
+      return true;
+    else
+      return std::is_same_v<value_type, float> || std::is_same_v<value_type, double>
+             || std::is_same_v<value_type, int> || std::is_same_v<value_type, bool>
+             || std::is_same_v<value_type, std::string>
+             || std::is_same_v<value_type, std::array<float, 2>>
+             || std::is_same_v<value_type, std::array<float, 3>>
+             || std::is_same_v<value_type, std::array<float, 4>>;
+  }
+
+  // The callbacks run on the network thread: they only post the new value,
+  // which the audio thread applies at the start of its next block.
+  template <avnd::parameter_port Field, typename Mailbox>
     requires(!avnd::enum_parameter<Field>)
-  void setup_control(Field& field, ossia::net::parameter_base& param)
+  void
+  setup_control(Field& field, Mailbox& mailbox, ossia::net::parameter_base& param)
   {
     param.set_value_type(type_for_arg<decltype(Field::value)>());
 
@@ -63,13 +87,14 @@ struct oscquery_mapper
     param.set_access(ossia::access_mode::BI);
 
     // Set-up the external callback
-    param.add_callback([&field](const ossia::value& val) {
-      field.value = convert(val, tag<decltype(field.value)>{});
+    param.add_callback([&mailbox](const ossia::value& val) {
+      mailbox.write(convert(val, tag<std::remove_cvref_t<decltype(Field::value)>>{}));
     });
   }
 
-  template <avnd::enum_parameter Field>
-  void setup_control(Field& field, ossia::net::parameter_base& param)
+  template <avnd::enum_parameter Field, typename Mailbox>
+  void
+  setup_control(Field& field, Mailbox& mailbox, ossia::net::parameter_base& param)
   {
     param.set_value_type(ossia::val_type::STRING);
 
@@ -83,12 +108,13 @@ struct oscquery_mapper
 
     // Set-up the external callback
 
-    param.add_callback([&field](const ossia::value& val) {
+    using value_type = std::remove_cvref_t<decltype(Field::value)>;
+    param.add_callback([&mailbox](const ossia::value& val) {
       if(const int* iindex = val.target<int>())
       {
         if(*iindex >= 0 && *iindex < choices_count)
         {
-          field.value = static_cast<decltype(field.value)>(*iindex);
+          mailbox.write(static_cast<value_type>(*iindex));
         }
       }
       else if(const float* findex = val.target<float>())
@@ -96,7 +122,7 @@ struct oscquery_mapper
         int index = *findex;
         if(index >= 0 && index < choices_count)
         {
-          field.value = static_cast<decltype(field.value)>(index);
+          mailbox.write(static_cast<value_type>(index));
         }
       }
       else if(const std::string* txt = val.target<std::string>())
@@ -105,14 +131,15 @@ struct oscquery_mapper
         if(it != choices.end())
         {
           int index = std::distance(choices.begin(), it);
-          field.value = static_cast<decltype(field.value)>(index);
+          mailbox.write(static_cast<value_type>(index));
         }
       }
     });
   }
 
-  template <avnd::parameter_port Field>
-  void create_control(Field& field)
+  template <avnd::parameter_port Field, typename Mailbox>
+    requires(supported_control<Field>())
+  void create_control(Field& field, Mailbox& mailbox)
   {
     ossia::net::node_base& node = m_dev.get_root_node();
     std::string name = "input";
@@ -122,7 +149,7 @@ struct oscquery_mapper
     if(auto param
        = ossia::net::create_parameter<ossia::net::generic_parameter>(node, name))
     {
-      setup_control(field, *param);
+      setup_control(field, mailbox, *param);
     }
   }
 
@@ -485,8 +512,8 @@ struct oscquery_mapper
     }
   }
 
-  template <typename Field>
-  void create_control(Field& field)
+  template <typename Field, typename Mailbox>
+  void create_control(Field& field, Mailbox& mailbox)
   {
   }
 
@@ -497,14 +524,17 @@ struct oscquery_mapper
 
   void create_ports()
   {
-    /*
-    if constexpr (avnd::float_parameter_input_introspection<T>::size > 0)
+    using inputs = avnd::parameter_input_introspection<T>;
+    if constexpr(inputs::size > 0)
     {
-      avnd::for_each_field_ref(
-          object.inputs(),
-          [this]<typename Field>(Field& f) { create_control(f); });
+      inputs::for_all_n(
+          avnd::get_inputs(object),
+          [this]<typename Field, std::size_t Idx>(Field& f, avnd::predicate_index<Idx>) {
+        create_control(f, tpl::get<Idx>(parameters.mailboxes));
+      });
     }
 
+    /*
     if constexpr (avnd::float_parameter_output_introspection<T>::size > 0)
     {
       avnd::for_each_field_ref(
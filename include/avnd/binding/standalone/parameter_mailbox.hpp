@@ -0,0 +1,50 @@
+#pragma once
+
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+#include <avnd/concepts/generic.hpp>
+#include <avnd/introspection/input.hpp>
+#include <avnd/wrappers/effect_container.hpp>
+#include <avnd/wrappers/value_mailbox.hpp>
+
+#include <type_traits>
+
+namespace standalone
+{
+template <typename Field>
+using parameter_mailbox_type
+    = avnd::value_mailbox<std::remove_cvref_t<decltype(Field::value)>>;
+
+/**
+ * One mailbox per parameter input: the OSCQuery callbacks write the values
+ * they receive in it from the network thread, and the audio callback applies
+ * the latest ones to the inputs at the start of each block.
+ */
+template <typename T>
+struct parameter_mailboxes
+{
+  using inputs = avnd::parameter_input_introspection<T>;
+
+  // std::tuple< value_mailbox<field1 value>, value_mailbox<field3 value>, ... >
+  using tuple
+      = avnd::filter_and_apply<parameter_mailbox_type, avnd::parameter_input_introspection, T>;
+
+  AVND_NO_UNIQUE_ADDRESS tuple mailboxes;
+
+  // Audio thread
+  void apply(avnd::effect_container<T>& object) noexcept
+  {
+    if constexpr(inputs::size > 0)
+    {
+      inputs::for_all_n(
+          avnd::get_inputs(object),
+          [&]<typename Field, std::size_t Idx>(Field& field, avnd::predicate_index<Idx>) {
+        if(tpl::get<Idx>(mailboxes).read(field.value))
+        {
+          if_possible(field.update(object.effect));
+        }
+      });
+    }
+  }
+};
+}
@@ -129,7 +129,7 @@ struct Controls<T>
     // Default to an empty string in case there are no instances (the host
     // buffer is otherwise left uninitialized). Controls are shared across the
     // (internal) per-channel instances; operate on one representative instance.
-    // self.inputs() would be a member_iterator for polyphonic effects, which
+    // self.inputs() would be a member_range for polyphonic effects, which
     // for_nth_mapped can't take.
     if(ptr)
       reinterpret_cast<char*>(ptr)[0] = '\0';
@@ -205,9 +205,9 @@ struct SimpleAudioEffect : vintage::Effect
       using i_info = avnd::midi_input_introspection<T>;
       auto& in_port = avnd::pfr::get<i_info::index_map[0]>(effect.inputs());
 
-      // In case we need to allocate more storage:
+      // Called on the audio thread: messages beyond the space reserved in
+      // prepare are dropped by add_message rather than allocating more.
       const int n = evs->numEvents;
-      midi.reserve_space(this->effect, n);
 
       for(int32_t i = 0; i < n; i++)
       {
@@ -11,44 +11,33 @@ namespace vintage
 template <typename T>
 struct midi_processor : public avnd::midi_storage<T>
 {
-  void
-  init_midi_message(avnd::dynamic_midi_message auto& in, const vintage::MidiEvent& msg)
+  bool init_midi_message(avnd::dynamic_midi_message auto& in, const vintage::MidiEvent& msg)
   {
-    using byte_type = typename decltype(in.bytes)::value_type;
-    using bytes_type = const byte_type*;
     static_assert(sizeof(in.bytes[0]) == sizeof(msg.midiData[0]));
-    // todo: if the size is different, do a copy instead
-
-    auto bytes = reinterpret_cast<bytes_type>(msg.midiData);
-    in.bytes.assign(bytes, bytes + 4); // bytes per midi message fixed in this old api
 
+    // bytes per midi message fixed in this old api
+    auto bytes = reinterpret_cast<const uint8_t*>(msg.midiData);
     if_possible(in.timestamp = msg.deltaFrames);
+    return this->assign_bytes(in, bytes, 4);
   }
 
-  void init_midi_message(avnd::raw_midi_message auto& in, const vintage::MidiEvent& msg)
+  bool init_midi_message(avnd::raw_midi_message auto& in, const vintage::MidiEvent& msg)
   {
-    using bytes_type = decltype(in.bytes);
     static_assert(sizeof(in.bytes[0]) == sizeof(msg.midiData[0]));
 
-    memcpy(std::begin(in.bytes), msg.midiData, 3);
+    auto bytes = reinterpret_cast<const uint8_t*>(msg.midiData);
     if_possible(in.timestamp = msg.deltaFrames);
+    return this->assign_bytes(in, bytes, 3);
   }
 
-  void add_message(
-      avnd::dynamic_container_midi_port auto& port, const vintage::MidiEvent& msg)
+  // Events beyond the reserved capacity are dropped
+  void add_message(avnd::midi_port auto& port, const vintage::MidiEvent& msg)
   {
-    port.midi_messages.push_back({});
-    auto& elt = port.midi_messages.back();
-    init_midi_message(elt, msg);
-  }
-
-  void
-  add_message(avnd::raw_container_midi_port auto& port, const vintage::MidiEvent& msg)
-  {
-    auto& elt = port.midi_messages[port.size];
-    init_midi_message(elt, msg);
-
-    port.size++;
+    auto elt = this->push_message(port);
+    if(!elt)
+      return;
+    if(!init_midi_message(*elt, msg))
+      this->pop_message(port);
   }
 };
 }
@@ -4,6 +4,13 @@
 
 #include <avnd/binding/vintage/helpers.hpp>
 #include <avnd/binding/vintage/vintage.hpp>
+#include <avnd/common/dummy.hpp>
+#include <avnd/common/no_unique_address.hpp>
+#include <avnd/wrappers/batched_voices.hpp>
+#include <avnd/wrappers/voice_pool.hpp>
+
+#include <type_traits>
+#include <vector>
 
 namespace vintage
 {
@@ -17,11 +24,71 @@ concept synth_voice = requires(T t) {
                         t.recycle;
                       };
 
+template <typename T>
+concept synth_voice_system
+    = requires { typename T::voice; } && synth_voice<typename T::voice>;
+
+/**
+ * Voices of the synths which provide voice_lanes (avnd::batched_synth_processor),
+ * rendered in float SIMD lanes. Double-precision hosts get them through a
+ * float scratch buffer, rendered in blocks of scratch_frames.
+ */
+template <typename T, std::size_t MaxVoices>
+struct lane_voices
+{
+};
+
+template <typename T, std::size_t MaxVoices>
+  requires avnd::batched_synth_processor<T, avnd::simd_lane_type<float>>
+struct lane_voices<T, MaxVoices>
+{
+  static constexpr int scratch_frames = 64;
+
+  avnd::batched_voices<T, float, MaxVoices> voices;
+  std::vector<float> scratch;
+  std::vector<float*> scratch_ptrs;
+
+  void reserve(int channels)
+  {
+    voices.reserve(channels, scratch_frames);
+    scratch.assign(std::size_t(channels) * scratch_frames, 0.f);
+    scratch_ptrs.resize(channels);
+    for(int c = 0; c < channels; c++)
+      scratch_ptrs[c] = scratch.data() + std::size_t(c) * scratch_frames;
+  }
+
+  void render(T& synth, float** outputs, int channels, int frames) noexcept
+  {
+    voices.render(synth, outputs, channels, frames);
+  }
+
+  void render(T& synth, double** outputs, int channels, int frames) noexcept
+  {
+    channels = std::min(channels, int(scratch_ptrs.size()));
+    for(int start = 0; start < frames; start += scratch_frames)
+    {
+      const int n = std::min(scratch_frames, frames - start);
+      for(int c = 0; c < channels; c++)
+        std::fill_n(scratch_ptrs[c], n, 0.f);
+
+      voices.render(synth, scratch_ptrs.data(), channels, n);
+
+      for(int c = 0; c < channels; c++)
+        for(int i = 0; i < n; i++)
+          outputs[c][start + i] += scratch_ptrs[c][i];
+    }
+  }
+};
+
 template <typename T>
 struct PolyphonicSynthesizer : vintage::Effect
 {
+  // Synths with voice_lanes are rendered in SIMD lanes, the others voice by voice
+  static constexpr bool batched
+      = avnd::batched_synth_processor<T, avnd::simd_lane_type<float>>;
+
   static_assert(
-      synth_voice<typename T::voice>,
+      batched || synth_voice_system<T>,
       "T does not implement a correct synth voice system");
 
   T implementation;
@@ -75,8 +142,8 @@ struct PolyphonicSynthesizer : vintage::Effect
 
     controls.read(implementation);
 
-    voices.reserve(127);
-    release_voices.reserve(127);
+    if constexpr(batched)
+      lanes.reserve(T::channels);
   }
 
   intptr_t request(HostOpcodes opcode, int a, int b, void* c, float d)
@@ -86,49 +153,50 @@ struct PolyphonicSynthesizer : vintage::Effect
 
   void note_on(int32_t note, int32_t velocity)
   {
-    voices.push_back({.note = float(note), .velocity = float(velocity), .detune = 0.0f});
-    float unison = this->controls.unison_voices * 20.0;
-    float detune = this->controls.unison_detune;
-    float vol = this->controls.unison_volume;
-    for(float i = -unison; i <= unison; i += 2.f)
+    // A voice is a lane: the unison voices are left to the synth itself
+    if constexpr(batched)
     {
-      voices.push_back(
-          {.note = float(note),
-           .velocity = velocity * vol,
-           .detune = i * (1.f + detune),
-           .pan = (int(i / 2) % 2) ? -1.f : 1.f});
+      lanes.voices.note_on(note, float(velocity));
     }
-  }
-
-  void note_off(int32_t note, int32_t velocity)
-  {
-    for(auto it = voices.begin(); it != voices.end();)
+    else
     {
-      if(it->note == note)
-      {
-        it->implementation.release_frame = it->implementation.elapsed;
-        release_voices.push_back(*it);
-        it = voices.erase(it);
-      }
-      else
+      voices.allocate(note)
+          = {.note = float(note), .velocity = float(velocity), .detune = 0.0f};
+      float unison = this->controls.unison_voices * 20.0;
+      float detune = this->controls.unison_detune;
+      float vol = this->controls.unison_volume;
+      for(float i = -unison; i <= unison; i += 2.f)
       {
-        ++it;
+        voices.allocate(note)
+            = {.note = float(note),
+               .velocity = velocity * vol,
+               .detune = i * (1.f + detune),
+               .pan = (int(i / 2) % 2) ? -1.f : 1.f};
       }
     }
   }
 
-  void bend(int32_t bend)
+  void note_off(int32_t note, int32_t velocity)
   {
-    for(auto& voice : voices)
+    if constexpr(batched)
     {
-      voice.bend = bend / 100.;
+      lanes.voices.note_off(note);
     }
-    for(auto& voice : release_voices)
+    else
     {
-      voice.bend = bend / 100.;
+      voices.release(note, [](voice& v) {
+        v.implementation.release_frame = v.implementation.elapsed;
+      });
     }
   }
 
+  // Not part of the voice_lanes interface: batched synths ignore it
+  void bend(int32_t bend)
+  {
+    if constexpr(!batched)
+      voices.for_each([bend](voice& v) { v.bend = bend / 100.; });
+  }
+
   void midi_input(const vintage::MidiEvent& e)
   {
     switch(e.midiData[0] & 0xF0)
@@ -208,21 +276,16 @@ struct PolyphonicSynthesizer : vintage::Effect
       for(int32_t i = 0; i < frames; i++)
         outputs[c][i] = 0.0;
 
-    // Process voices
-    for(auto& voice : voices)
+    // Process voices, including those which were note'off'd in order to
+    // cleanly fade out
+    if constexpr(batched)
     {
-      voice.process(*this, outputs, frames);
+      lanes.render(implementation, outputs, implementation.channels, frames);
     }
-
-    // Process voices that were note'off'd in order to cleanly fade out
-    for(auto it = release_voices.begin(); it != release_voices.end();)
+    else
     {
-      auto& voice = *it;
-      voice.process(*this, outputs, frames);
-      if(voice.implementation.recycle)
-        it = release_voices.erase(it);
-      else
-        ++it;
+      voices.for_each([&](voice& v) { v.process(*this, outputs, frames); });
+      voices.recycle_if([](voice& v) { return bool(v.implementation.recycle); });
     }
 
     // Post-processing
@@ -232,8 +295,15 @@ struct PolyphonicSynthesizer : vintage::Effect
     }
   }
 
-  std::vector<voice> voices;
-  std::vector<voice> release_voices;
+  // 64 notes with the maximum of 21 unison voices each, beyond which
+  // the oldest voices are stolen
+  static constexpr std::size_t max_voices = 64 * 22;
+  AVND_NO_UNIQUE_ADDRESS
+  std::conditional_t<batched, avnd::dummy, avnd::voice_pool<voice, max_voices>> voices;
+
+  // One lane per note
+  static constexpr std::size_t max_lane_voices = 128;
+  AVND_NO_UNIQUE_ADDRESS lane_voices<T, max_lane_voices> lanes;
 };
 }
 
@@ -13,6 +13,10 @@
 #include <avnd/wrappers/controls_storage.hpp>
 #include <avnd/wrappers/prepare.hpp>
 #include <avnd/wrappers/process_adapter.hpp>
+#include <avnd/wrappers/stft.hpp>
+
+#include <algorithm>
+#include <array>
 
 namespace stv3
 {
@@ -81,12 +85,22 @@ struct Component final
   // Per-buffer storage backing sample-accurate control ports
   AVND_NO_UNIQUE_ADDRESS avnd::control_storage<T> control_buffers;
 
+  // Analysis feeding the spectrum input ports
+  AVND_NO_UNIQUE_ADDRESS avnd::stft_storage<T> spectrums;
+
   AVND_NO_UNIQUE_ADDRESS stv3::audio_bus_info<T> audio_busses;
 
   AVND_NO_UNIQUE_ADDRESS stv3::event_bus_info<T> event_busses;
 
   using inputs_info_t = avnd::parameter_input_introspection<T>;
   static const constexpr int32_t parameter_count = inputs_info_t::size;
+  static constexpr bool split_on_parameter_changes
+      = avnd::tag_split_on_parameter_changes<T> && parameter_count > 0;
+
+  // Next point to apply in the queue of each parameter, when splitting blocks.
+  // Indexed by parameter, not by queue: hosts may also send queues for IDs
+  // which are not parameters of this processor.
+  std::array<int32, split_on_parameter_changes ? parameter_count : 0> m_queue_points{};
 
   Component()
   {
@@ -330,6 +344,11 @@ struct Component final
       midi.reserve_space(this->effect, newSetup.maxSamplesPerBlock);
     }
 
+    if constexpr(sizeof(spectrums) > 1)
+      spectrums.reserve_space(
+          effect, audio_busses.runtime_input_channel_count,
+          newSetup.maxSamplesPerBlock);
+
     // Effect-specific preparation
     avnd::prepare(effect, setup_info);
     return kResultOk;
@@ -339,7 +358,7 @@ struct Component final
   // controls, used for READS / serialization (getState) and MIDI dispatch. A
   // VST host sees one parameter set; avendish's polyphony is just internal
   // per-channel replication. For polyphonic effects effect.inputs() is a
-  // per-instance member_iterator, which the field introspection helpers
+  // per-instance member_range, which the field introspection helpers
   // (for_nth_*, for_all_unless, pfr::get) cannot take, so use the first
   // instance. WRITES of host parameter changes (processControl) instead fan out
   // to every instance via full_state().
@@ -358,24 +377,56 @@ struct Component final
     }
   }
 
+  // Applies a normalized value of the control id. Sample-accurate controls
+  // also get the change at frame of the current (sub-)block, if any.
+  void processControlValue(int id, ParamValue value, int32 frame)
+  {
+    // Apply the host parameter change to every (per-channel) instance so all
+    // voices of a polyphonic effect track automation, not just instance 0.
+    for(auto state : this->effect.full_state())
+      inputs_info_t::for_nth_raw(state.inputs, id, [&]<typename C>(C& ctl) {
+        if constexpr(requires { avnd::map_control_from_01<C>(value); })
+          assign_if_assignable(ctl.value, avnd::map_control_from_01<C>(value));
+      });
+
+    // The timed value is recorded once for all the instances
+    inputs_info_t::for_nth_raw(controls_inputs(), id, [&]<typename C>(C& ctl) {
+      if constexpr(requires { avnd::map_control_from_01<C>(value); })
+        control_buffers.add_timed_value(
+            this->effect, ctl, ctl.value, frame, processSetup.maxSamplesPerBlock);
+    });
+  }
+
+  // Whether a change of this control must start a new sub-block
+  static bool splitsBlock(int id) noexcept
+  {
+    bool res = false;
+    inputs_info_t::for_nth_raw(
+        id, [&]<std::size_t Index, typename C>(avnd::field_reflection<Index, C>) {
+          res = !avnd::sample_accurate_parameter_port<C>;
+        });
+    return res;
+  }
+
   void processControl(IParamValueQueue& queue)
   {
     ParamValue value;
     int32 sampleOffset;
-    int32 numPoints = queue.getPointCount();
+    const int32 numPoints = queue.getPointCount();
+    const int id = queue.getParameterId();
 
-    int id = queue.getParameterId();
-    if(queue.getPoint(numPoints - 1, sampleOffset, value) == Steinberg::kResultTrue)
+    if(splitsBlock(id))
     {
-      // Apply the host parameter change to every (per-channel) instance so all
-      // voices of a polyphonic effect track automation, not just instance 0.
-      for(auto state : this->effect.full_state())
-        avnd::parameter_input_introspection<T>::for_nth_raw(
-            state.inputs, id, [&]<typename C>(C& ctl) {
-              if constexpr(requires { avnd::map_control_from_01<C>(value); })
-                assign_if_assignable(ctl.value, avnd::map_control_from_01<C>(value));
-            });
-    };
+      // Plain controls only see the last value of the block
+      if(queue.getPoint(numPoints - 1, sampleOffset, value) == Steinberg::kResultTrue)
+        processControlValue(id, value, -1);
+    }
+    else
+    {
+      for(int32 p = 0; p < numPoints; p++)
+        if(queue.getPoint(p, sampleOffset, value) == Steinberg::kResultTrue)
+          processControlValue(id, value, sampleOffset);
+    }
   }
 
   void processControls(ProcessData& data)
@@ -397,29 +448,109 @@ struct Component final
     }
   }
 
-  template <typename Bus>
-  void add_message(Bus& bus, uint8_t a, uint8_t b, uint8_t c, auto ts)
+  /**
+   * Applies the parameter changes for the sub-block starting at frame start,
+   * and returns where it ends: at the next change of a plain control.
+   * m_queue_points keeps, for each parameter, the first point of its queue
+   * not applied yet.
+   */
+  int32 processControls(ProcessData& data, int32 start)
   {
-    if constexpr(avnd::dynamic_container_midi_port<Bus>)
+    using namespace Steinberg;
+
+    auto paramChanges = data.inputParameterChanges;
+    if(!paramChanges)
+      return data.numSamples;
+
+    const int32 numQueues = paramChanges->getParameterCount();
+
+    ParamValue value;
+    int32 sampleOffset;
+
+    // Plain controls: apply what happened up to now, find the next change
+    int32 end = data.numSamples;
+    for(int32 i = 0; i < numQueues; i++)
     {
-      bus.midi_messages.push_back({.bytes = {a, b, c}, .timestamp = ts});
+      auto q = paramChanges->getParameterData(i);
+      if(!q)
+        continue;
+      const int id = q->getParameterId();
+      const int param = inputs_info_t::field_index_to_index(id);
+      if(param < 0 || !splitsBlock(id))
+        continue;
+
+      auto& point = m_queue_points[param];
+      for(const int32 n = q->getPointCount(); point < n; point++)
+      {
+        if(q->getPoint(point, sampleOffset, value) != kResultTrue)
+          continue;
+        if(sampleOffset > start && sampleOffset < data.numSamples)
+        {
+          end = std::min(end, sampleOffset);
+          break;
+        }
+        processControlValue(id, value, -1);
+      }
     }
-    else
+
+    // Sample-accurate controls: everything which happens before the next split
+    for(int32 i = 0; i < numQueues; i++)
     {
-      //AVND_STATIC_TODO(Bus);
+      auto q = paramChanges->getParameterData(i);
+      if(!q)
+        continue;
+      const int id = q->getParameterId();
+      const int param = inputs_info_t::field_index_to_index(id);
+      if(param < 0 || splitsBlock(id))
+        continue;
+
+      auto& point = m_queue_points[param];
+      for(const int32 n = q->getPointCount(); point < n; point++)
+      {
+        if(q->getPoint(point, sampleOffset, value) != kResultTrue)
+          continue;
+        if(sampleOffset >= end && end < data.numSamples)
+          break;
+        processControlValue(id, value, std::max(sampleOffset - start, int32(0)));
+      }
     }
+    return end;
+  }
+
+  // Does not allocate: events beyond the capacity reserved in
+  // setupProcessing are dropped, sysex payloads go in the midi_storage arena.
+  template <typename Bus>
+  void add_message(Bus& bus, const uint8_t* bytes, std::size_t n, auto ts)
+  {
+    auto msg = midi.push_message(bus);
+    if(!msg)
+      return;
+    if_possible(msg->timestamp = ts);
+    if(!midi.assign_bytes(*msg, bytes, n))
+      midi.pop_message(bus);
   }
 
   void
   processEvent(avnd::midi_port auto& bus, const Steinberg::Vst::NoteOnEvent& ev, auto ts)
   {
-    add_message(bus, ev.channel | 0x90, ev.pitch, ev.velocity * 127, ts);
+    const uint8_t bytes[3]{
+        uint8_t(ev.channel | 0x90), uint8_t(ev.pitch), uint8_t(ev.velocity * 127)};
+    add_message(bus, bytes, 3, ts);
   }
 
   void processEvent(
       avnd::midi_port auto& bus, const Steinberg::Vst::NoteOffEvent& ev, auto ts)
   {
-    add_message(bus, ev.channel | 0x80, ev.pitch, ev.velocity * 127, ts);
+    const uint8_t bytes[3]{
+        uint8_t(ev.channel | 0x80), uint8_t(ev.pitch), uint8_t(ev.velocity * 127)};
+    add_message(bus, bytes, 3, ts);
+  }
+
+  void
+  processEvent(avnd::midi_port auto& bus, const Steinberg::Vst::DataEvent& ev, auto ts)
+  {
+    if(ev.type == Steinberg::Vst::DataEvent::kMidiSysEx && ev.bytes)
+      add_message(bus, ev.bytes, ev.size, ts);
   }
 
   void processEvent(Event& event)
@@ -442,8 +573,9 @@ struct Component final
         break;
       }
       case Event::kDataEvent: {
-        [[maybe_unused]]
-        auto& e = event.data;
+        refl::for_nth_mapped(controls_inputs(), event.busIndex, [&](auto& bus) {
+          this->processEvent(bus, event.data, event.sampleOffset);
+        });
         break;
       }
       case Event::kPolyPressureEvent: {
@@ -480,6 +612,14 @@ struct Component final
   }
 
   void processEvents(ProcessData& data)
+  {
+    int32 index = 0;
+    processEvents(data, index, 0, data.numSamples);
+  }
+
+  // Processes the events from index onwards which happen before end,
+  // with offsets relative to start.
+  void processEvents(ProcessData& data, int32& index, int32 start, int32 end)
   {
     using namespace Steinberg;
     using namespace Steinberg::Vst;
@@ -487,11 +627,14 @@ struct Component final
     if(data.inputEvents)
     {
       const int32 numEvent = data.inputEvents->getEventCount();
-      for(int32 i = 0; i < numEvent; i++)
+      for(; index < numEvent; index++)
       {
         Event event;
-        if(data.inputEvents->getEvent(i, event) == kResultOk)
+        if(data.inputEvents->getEvent(index, event) == kResultOk)
         {
+          if(event.sampleOffset >= end && end < data.numSamples)
+            break;
+          event.sampleOffset = std::max(event.sampleOffset - start, int32(0));
           processEvent(event);
         }
       }
@@ -511,8 +654,7 @@ struct Component final
     data.outputs[0].silenceFlags = 0;
     if(data.symbolicSampleSize == kSample32)
     {
-      processor.process(
-          effect,
+      runProcessor(
           avnd::span<Sample32*>{(Sample32**)in, std::size_t(data.inputs[0].numChannels)},
           avnd::span<Sample32*>{
               (Sample32**)out, std::size_t(data.outputs[0].numChannels)},
@@ -520,8 +662,7 @@ struct Component final
     }
     else
     {
-      processor.process(
-          effect,
+      runProcessor(
           avnd::span<Sample64*>{(Sample64**)in, std::size_t(data.inputs[0].numChannels)},
           avnd::span<Sample64*>{
               (Sample64**)out, std::size_t(data.outputs[0].numChannels)},
@@ -529,6 +670,70 @@ struct Component final
     }
   }
 
+  template <typename Sample>
+  void runProcessor(avnd::span<Sample*> in, avnd::span<Sample*> out, int32 frames)
+  {
+    // Resynthesized spectrum ports replace their input channels
+    if constexpr(sizeof(spectrums) > 1)
+      in = spectrums.analyze(effect, in, frames);
+
+    processor.process(effect, in, out, frames);
+  }
+
+  // Runs the block in sub-blocks delimited by the changes of plain controls
+  template <typename Sample>
+  void processSplit(ProcessData& data)
+  {
+    using namespace Steinberg;
+
+    const bool has_audio = data.numInputs != 0 && data.numOutputs != 0;
+    const int32 in_N = has_audio ? data.inputs[0].numChannels : 0;
+    const int32 out_N = has_audio ? data.outputs[0].numChannels : 0;
+
+    // Copies of the host channel pointers, advanced after each sub-block
+    auto in = (Sample**)alloca(sizeof(Sample*) * std::max(in_N, int32(1)));
+    auto out = (Sample**)alloca(sizeof(Sample*) * std::max(out_N, int32(1)));
+    if(has_audio)
+    {
+      std::copy_n(
+          (Sample**)stv3::getChannelBuffersPointer(processSetup, data.inputs[0]), in_N,
+          in);
+      std::copy_n(
+          (Sample**)stv3::getChannelBuffersPointer(processSetup, data.outputs[0]),
+          out_N, out);
+      data.outputs[0].silenceFlags = 0;
+    }
+
+    m_queue_points.fill(0);
+    int32 event = 0;
+    int32 start = 0;
+    do
+    {
+      const int32 end = processControls(data, start);
+      processEvents(data, event, start, end);
+
+      if(has_audio)
+      {
+        runProcessor(
+            avnd::span<Sample*>{in, std::size_t(in_N)},
+            avnd::span<Sample*>{out, std::size_t(out_N)}, end - start);
+
+        for(int32 i = 0; i < in_N; i++)
+          in[i] += end - start;
+        for(int32 i = 0; i < out_N; i++)
+          out[i] += end - start;
+      }
+      start = end;
+
+      if(start < data.numSamples)
+      {
+        this->midi.clear_inputs(effect);
+        if constexpr(sizeof(control_buffers) > 1)
+          control_buffers.clear_inputs(effect);
+      }
+    } while(start < data.numSamples);
+  }
+
   void processOutputs(ProcessData& data)
   {
     using namespace Steinberg;
@@ -546,13 +751,26 @@ struct Component final
     if constexpr(sizeof(control_buffers) > 1)
       control_buffers.clear_outputs(effect);
 
-    processControls(data);
-    processEvents(data);
+    if constexpr(split_on_parameter_changes)
+    {
+      if(data.symbolicSampleSize == kSample32)
+        processSplit<Sample32>(data);
+      else
+        processSplit<Sample64>(data);
 
-    if(data.numInputs != 0 && data.numOutputs != 0)
+      if(data.numInputs != 0 && data.numOutputs != 0)
+        processOutputs(data);
+    }
+    else
     {
-      processAudio(data);
-      processOutputs(data);
+      processControls(data);
+      processEvents(data);
+
+      if(data.numInputs != 0 && data.numOutputs != 0)
+      {
+        processAudio(data);
+        processOutputs(data);
+      }
     }
 
     // Clear inputs
@@ -635,7 +853,13 @@ struct Component final
     return Steinberg::kResultTrue;
   }
 
-  uint32 getLatencySamples() override { return 0; }
+  uint32 getLatencySamples() override
+  {
+    if constexpr(sizeof(spectrums) > 1)
+      return spectrums.latency();
+    else
+      return 0;
+  }
 
   tresult setProcessing(TBool state) override
   {
@@ -0,0 +1,50 @@
+#pragma once
+
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace avnd
+{
+// One cache line, which is also the width of the largest vector registers (AVX-512)
+inline constexpr std::size_t cache_line_alignment = 64;
+
+template <typename T, std::size_t Align = std::max(cache_line_alignment, alignof(T))>
+struct aligned_allocator
+{
+  using value_type = T;
+
+  template <typename U>
+  struct rebind
+  {
+    using other = aligned_allocator<U, Align>;
+  };
+
+  aligned_allocator() noexcept = default;
+  template <typename U>
+  aligned_allocator(const aligned_allocator<U, Align>&) noexcept
+  {
+  }
+
+  T* allocate(std::size_t n)
+  {
+    return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{Align}));
+  }
+
+  void deallocate(T* p, std::size_t n) noexcept
+  {
+    ::operator delete(p, n * sizeof(T), std::align_val_t{Align});
+  }
+
+  friend bool operator==(const aligned_allocator&, const aligned_allocator&) noexcept
+  {
+    return true;
+  }
+};
+
+template <typename T>
+using aligned_vector = std::vector<T, aligned_allocator<T>>;
+}
@@ -2,7 +2,113 @@
 
 /* SPDX-License-Identifier: GPL-3.0-or-later */
 
+#include <cstddef>
 #include <cstdlib>
+#include <type_traits>
+
+namespace avnd
+{
+/**
+ * Iterates over one member of every instance of a multi-instance processor,
+ * e.g. the outputs of each channel.
+ *
+ * The members are found at a fixed stride from each other, thus unlike
+ * member_iterator this is a plain index iteration, which never allocates
+ * and can be used on the audio thread.
+ */
+template <typename T>
+class member_range
+{
+  using byte_type = std::conditional_t<std::is_const_v<T>, const std::byte, std::byte>;
+
+public:
+  class iterator
+  {
+  public:
+    using difference_type = std::ptrdiff_t;
+    using value_type = std::remove_cv_t<T>;
+
+    iterator() noexcept = default;
+    iterator(byte_type* ptr, std::ptrdiff_t stride) noexcept
+        : m_ptr{ptr}
+        , m_stride{stride}
+    {
+    }
+
+    iterator& operator++() noexcept
+    {
+      m_ptr += m_stride;
+      return *this;
+    }
+
+    iterator operator++(int) noexcept
+    {
+      auto it = *this;
+      m_ptr += m_stride;
+      return it;
+    }
+
+    T& operator*() const noexcept { return *reinterpret_cast<T*>(m_ptr); }
+
+    bool operator==(const iterator& other) const noexcept { return m_ptr == other.m_ptr; }
+
+  private:
+    byte_type* m_ptr{};
+    std::ptrdiff_t m_stride{};
+  };
+
+  member_range() noexcept = default;
+
+  // Contiguous storage
+  member_range(T* first, std::size_t count) noexcept
+      : m_first{reinterpret_cast<byte_type*>(first)}
+      , m_stride{sizeof(T)}
+      , m_count{count}
+  {
+  }
+
+  // The member of each object in an array, e.g. member_range{fx.data(), fx.size(), &T::outputs}
+  template <typename Object>
+  member_range(Object* objects, std::size_t count, T Object::*member) noexcept
+      : m_first{count > 0 ? reinterpret_cast<byte_type*>(&(objects->*member)) : nullptr}
+      , m_stride{sizeof(Object)}
+      , m_count{count}
+  {
+  }
+
+  iterator begin() const noexcept { return iterator{m_first, m_stride}; }
+  iterator end() const noexcept
+  {
+    return iterator{m_first + m_stride * std::ptrdiff_t(m_count), m_stride};
+  }
+
+  T& operator[](std::size_t i) const noexcept
+  {
+    return *reinterpret_cast<T*>(m_first + m_stride * std::ptrdiff_t(i));
+  }
+  std::size_t size() const noexcept { return m_count; }
+  bool empty() const noexcept { return m_count == 0; }
+
+private:
+  byte_type* m_first{};
+  std::ptrdiff_t m_stride{};
+  std::size_t m_count{};
+};
+
+// Ranges over the per-instance inputs / outputs of multi-instance processors
+template <typename T>
+struct is_member_range : std::false_type
+{
+};
+
+template <typename T>
+struct is_member_range<member_range<T>> : std::true_type
+{
+};
+
+template <typename T>
+concept multi_instance_range = is_member_range<std::remove_cvref_t<T>>::value;
+}
 
 #if AVND_DISABLE_COROUTINES == 0
 #if __has_include(<coroutine>)
@@ -37,7 +143,9 @@ inline constexpr default_sentinel_t default_sentinel{};
 namespace avnd
 {
 // modified from https://en.cppreference.com/w/cpp/coroutine/coroutine_handle
-// made for iterating one or multiple members of a structure
+// made for iterating one or multiple members of a structure.
+// Each call allocates a coroutine frame: the effect containers use
+// member_range instead, keep this for code outside of the audio thread.
 template <typename T>
 class member_iterator
 {
@@ -150,6 +258,11 @@ private:
   handle m_coroutine;
 };
 
+template <typename T>
+struct is_member_range<member_iterator<T>> : std::true_type
+{
+};
+
 template <typename T>
 class generator
 {
@@ -7,7 +7,10 @@
 #include <avnd/common/index.hpp>
 #include <avnd/concepts/generic.hpp>
 
+#include <array>
 #include <cassert>
+#include <cstddef>
+#include <type_traits>
 #include <utility>
 
 namespace boost::pfr
@@ -54,14 +57,71 @@ void for_each_field_ref(T&& value, F&& func)
 namespace avnd
 {
 
-template <std::size_t N>
-constexpr void for_nth(int k, auto&& f)
+namespace detail
+{
+template <std::size_t Index, typename F>
+constexpr void invoke_nth(F& f)
+{
+  f.template operator()<Index>();
+}
+
+template <typename F>
+constexpr void invoke_none(F&)
 {
-  [k]<std::size_t... Index>(std::index_sequence<Index...>, auto&& f)
+}
+
+// One entry per index in [0; N[: the indices in Index... call
+// f.template operator()<Index>(), the other ones do nothing.
+template <typename F, std::size_t N, std::size_t... Index>
+struct nth_jump_table
+{
+  using function_type = void (*)(F&);
+  static constexpr std::array<function_type, N> table = [] {
+    std::array<function_type, N> t{};
+    for(auto& fun : t)
+      fun = &invoke_none<F>;
+    ((t[Index] = &invoke_nth<Index, F>), ...);
+    return t;
+  }();
+};
+
+// Below this many candidates a chain of comparisons is cheaper than an indirect call
+inline constexpr std::size_t for_nth_table_threshold = 4;
+}
+
+/**
+ * Calls f.template operator()<k>() if the runtime index k is one of Index...,
+ * N being an upper bound of the indices.
+ *
+ * Dispatch goes through a table of N function pointers, thus the cost does
+ * not depend on the number of indices: this is what is called for every
+ * parameter change / message coming from the host.
+ */
+template <std::size_t N, typename K, K... Index>
+constexpr void for_nth_of(std::integer_sequence<K, Index...>, int k, auto&& f)
+{
+  if constexpr(sizeof...(Index) == 0)
+  {
+    return;
+  }
+  else if constexpr(sizeof...(Index) <= detail::for_nth_table_threshold)
   {
-    ((void)(Index == k && (f.template operator()<Index>(), true)), ...);
+    (void)((Index == k && (f.template operator()<Index>(), true)) || ...);
   }
-  (std::make_index_sequence<N>(), f);
+  else
+  {
+    using func_type = std::remove_reference_t<decltype(f)>;
+    using table_type
+        = detail::nth_jump_table<func_type, N, static_cast<std::size_t>(Index)...>;
+    if(k >= 0 && static_cast<std::size_t>(k) < N)
+      table_type::table[k](f);
+  }
+}
+
+template <std::size_t N>
+constexpr void for_nth(int k, auto&& f)
+{
+  for_nth_of<N>(std::make_index_sequence<N>{}, k, f);
 }
 
 template <class T, class F>
@@ -153,6 +213,14 @@ void for_each_field_ref(const avnd::member_iterator<T>& value, F&& func)
     for_each_field_ref(v, func);
   }
 }
+template <class T, class F>
+void for_each_field_ref(avnd::member_range<T> value, F&& func)
+{
+  for(auto& v : value)
+  {
+    for_each_field_ref(v, func);
+  }
+}
 
 /* FIXME TBD
 template <typename T, typename R>
@@ -47,17 +47,9 @@ struct fields_introspection
 
   static constexpr void for_nth(int n, auto&& func) noexcept
   {
-    // TODO maybe there is some dirty hack to do here with offsetof computations...
-    // technically, we ought to be able to compute the address of member "n" at compile time...
-    // and reinterpret_cast &fields+addr....
-
-    if constexpr(size > 0)
-    {
-      [n, &func]<typename K, K... Index>(std::integer_sequence<K, Index...>) {
-        // TODO compare with || logical-or fold ?
-        (void)((Index == n && (func(field_reflection<Index, pfr::tuple_element_t<Index, type>>{}), true)) || ...);
-          }(indices_n{});
-    }
+    avnd::for_nth_of<size>(indices_n{}, n, [&func]<std::size_t Index>() {
+      func(field_reflection<Index, pfr::tuple_element_t<Index, type>>{});
+    });
   }
 
   template <typename F>
@@ -93,27 +85,9 @@ struct fields_introspection
 
   static constexpr void for_nth(type& fields, int n, auto&& func) noexcept
   {
-    // TODO maybe there is some dirty hack to do here with offsetof computations...
-    // technically, we ought to be able to compute the address of member "n" at compile time...
-    // and reinterpret_cast &fields+addr....
-
-    if constexpr(size > 0)
-    {
-#if AVND_PFR_FLATTEN
-      using namespace std;
-      [n, &func, &fields]<typename K, K... Index>(std::integer_sequence<K, Index...>) {
-        auto&& ppl = pfr::detail::tie_as_tuple(fields);
-        // TODO compare with || logical-or fold ?
-        (void)((Index == n && (func(get<Index>(ppl)), true)) || ...);
-          }(indices_n{});
-#else
-      [n, &func, &fields]<typename K, K... Index>(std::integer_sequence<K, Index...>) {
-        auto&& [... elts] = fields;
-        // TODO compare with || logical-or fold ?
-        (void)((Index == n && (func(elts), true)) || ...);
-          }(indices_n{});
-#endif
-    }
+    avnd::for_nth_of<size>(indices_n{}, n, [&func, &fields]<std::size_t Index>() {
+      func(field<Index>(fields));
+    });
   }
 
   template <std::size_t N>
@@ -263,26 +237,19 @@ struct predicate_introspection
   // n is in [0; total number of ports[ (even those that don't match the predicate)
   static constexpr void for_nth_raw(int n, auto&& func) noexcept
   {
-    if constexpr(size > 0)
-    {
-      [n, &func]<typename K, K... Index>(std::integer_sequence<K, Index...>) {
-        // TODO compare with || logical-or fold ?
-        (void)((Index == n && (func(field_reflection<Index, pfr::tuple_element_t<Index, T>>{}), true)) || ...);
-          }(indices_n{});
-    }
+    avnd::for_nth_of<pfr::tuple_size_v<type>>(
+        indices_n{}, n, [&func]<std::size_t Index>() {
+      func(field_reflection<Index, pfr::tuple_element_t<Index, T>>{});
+    });
   }
 
   // n is in [0; number of ports matching that predicate[
   static constexpr void for_nth_mapped(int n, auto&& func) noexcept
   {
-    if constexpr(size > 0)
-    {
-      [k = index_map[n],
-       &func]<typename K, K... Index>(std::integer_sequence<K, Index...>) {
-        // TODO compare with || logical-or fold ?
-        (void)((Index == k && (func(field_reflection<Index, pfr::tuple_element_t<Index, T>>{}), true)) || ...);
-          }(indices_n{});
-    }
+    avnd::for_nth<size>(n, [&func]<std::size_t LocalIndex>() {
+      constexpr std::size_t Index = index_map[LocalIndex];
+      func(field_reflection<Index, pfr::tuple_element_t<Index, T>>{});
+    });
   }
 
   // Goes from 0, 1, 2 indices to indices in the complete
@@ -368,25 +335,9 @@ struct predicate_introspection
     }
   }
 
-  template <typename U>
-  static constexpr void
-  for_all(member_iterator<U>&& unfiltered_fields, auto&& func) noexcept
-  {
-    if constexpr(size > 0)
-    {
-      [&func,
-       &unfiltered_fields]<typename K, K... Index>(std::integer_sequence<K, Index...>) {
-        for(auto& m : unfiltered_fields)
-        {
-          (func(pfr::get<Index>(m)), ...);
-        }
-          }(indices_n{});
-    }
-  }
-
-  template <typename U>
-  static constexpr void
-  for_all(member_iterator<U>& unfiltered_fields, auto&& func) noexcept
+  // Multiple instances: member_iterator or member_range
+  template <multi_instance_range R>
+  static constexpr void for_all(R&& unfiltered_fields, auto&& func) noexcept
   {
     if constexpr(size > 0)
     {
@@ -437,9 +388,8 @@ struct predicate_introspection
     }
   }
 
-  template <typename U>
-  static constexpr void
-  for_all_n(member_iterator<U> unfiltered_fields, auto&& func) noexcept
+  template <multi_instance_range R>
+  static constexpr void for_all_n(R&& unfiltered_fields, auto&& func) noexcept
   {
     if constexpr(size > 0)
     {
@@ -497,13 +447,12 @@ struct predicate_introspection
     }
   }
 
-  template <typename U>
-  static constexpr bool
-  for_all_unless(member_iterator<U> unfiltered_fields, auto&& func) noexcept
+  template <multi_instance_range R>
+  static constexpr bool for_all_unless(R&& unfiltered_fields, auto&& func) noexcept
   {
     if constexpr(size > 0)
     {
-      AVND_ERROR(U, "Cannot use for_all_unless when there are multiple instances");
+      AVND_ERROR(R, "Cannot use for_all_unless when there are multiple instances");
       return false;
     }
     else
@@ -512,13 +461,12 @@ struct predicate_introspection
     }
   }
 
-  template <typename U>
-  static constexpr bool
-  for_all_until(member_iterator<U> unfiltered_fields, auto&& func) noexcept
+  template <multi_instance_range R>
+  static constexpr bool for_all_until(R&& unfiltered_fields, auto&& func) noexcept
   {
     if constexpr(size > 0)
     {
-      AVND_ERROR(U, "Cannot use for_all_until when there are multiple instances");
+      AVND_ERROR(R, "Cannot use for_all_until when there are multiple instances");
       return false;
     }
     else
@@ -529,55 +477,33 @@ struct predicate_introspection
 
   static constexpr void for_nth_raw(type& fields, int n, auto&& func) noexcept
   {
-    if constexpr(size > 0)
-    {
-      [n, &func, &fields]<typename K, K... Index>(std::integer_sequence<K, Index...>) {
+    avnd::for_nth_of<pfr::tuple_size_v<type>>(
+        indices_n{}, n, [&func, &fields]<std::size_t Index>() {
 #if AVND_PFR_FLATTEN
-        (void)((Index == n && (func(pfr::get<Index>(fields)), true)) || ...);
+      func(pfr::get<Index>(fields));
 #else
-        auto&& [... elts] = fields;
-        (void)((Index == n && (func(elts...[Index]), true)) || ...);
+      auto&& [... elts] = fields;
+      func(elts...[Index]);
 #endif
-          }(indices_n{});
-    }
+    });
   }
 
   static constexpr void for_nth_mapped(type& fields, int n, auto&& func) noexcept
   {
-    if constexpr(size > 0)
-    {
-      [k = index_map[n], &func,
-       &fields]<typename K, K... Index>(std::integer_sequence<K, Index...>) {
-#if AVND_PFR_FLATTEN
-        (void)((Index == k && (func(pfr::get<Index>(fields)), true)) || ...);
-#else
-        auto&& [... elts] = fields;
-        (void)((Index == k && (func(elts...[Index]), true)) || ...);
-#endif
-          }(indices_n{});
-    }
+    avnd::for_nth<size>(n, [&func, &fields]<std::size_t LocalIndex>() {
+      func(field<LocalIndex>(fields));
+    });
   }
+
   static constexpr void
   for_nth_mapped_n2(type& unfiltered_fields, int n, auto&& func) noexcept
   {
-    if constexpr(size > 0)
-    {
-      auto stack_size_helper
-          = [&]<std::size_t Index, std::size_t LocalIndex>() constexpr noexcept {
-        func(
-            pfr::get<Index>(unfiltered_fields), avnd::predicate_index<LocalIndex>{},
-            avnd::field_index<Index>{});
-      };
-
-      [stack_size_helper, k = index_map[n], &func,
-       &unfiltered_fields]<typename K, K... Index, size_t... LocalIndex>(
-          std::integer_sequence<K, Index...>,
-          std::integer_sequence<size_t, LocalIndex...>) {
-        (void)((Index == k
-                && (stack_size_helper.template operator()<Index, LocalIndex>(), true))
-               || ...);
-      }(indices_n{}, std::make_index_sequence<size>{});
-    }
+    avnd::for_nth<size>(n, [&func, &unfiltered_fields]<std::size_t LocalIndex>() {
+      constexpr std::size_t Index = index_map[LocalIndex];
+      func(
+          field<LocalIndex>(unfiltered_fields), avnd::predicate_index<LocalIndex>{},
+          avnd::field_index<Index>{});
+    });
   }
 };
 
@@ -31,4 +31,33 @@ AVND_DEFINE_TAG(cv)
  * on the inputs and nothing else.
  */
 AVND_DEFINE_TAG(stateless)
+
+/**
+ * This tag indicates that a per-sample monophonic processor
+ * can be run channel-major: the whole block of one channel is processed
+ * before moving to the next channel's instance.
+ * Smoothed controls still advance once per sample: their values for the block
+ * are computed once, then given to each channel instance.
+ */
+AVND_DEFINE_TAG(channel_major)
+
+/**
+ * This tag indicates that bindings whose host sends timestamped parameter
+ * changes should split the buffer at each change, and run the processor
+ * on each sub-buffer: automation of plain controls is then sample-accurate.
+ * Sample-accurate controls do not cause splits, their values are filled instead.
+ */
+AVND_DEFINE_TAG(split_on_parameter_changes)
+
+/**
+ * This tag indicates that the instances of a multi-instance processor
+ * (one per channel) and their outputs are each to be stored in their own
+ * cache-line-aligned contiguous array, instead of an array of
+ * {processor, outputs} pairs: reading back the outputs of all the channels
+ * then does not touch the processors.
+ * When the inputs or outputs are values (members of the processor), they are
+ * stored within the instances, which are then stored in one aligned array.
+ * The tag is an error on processors which are not instantiated per channel.
+ */
+AVND_DEFINE_TAG(contiguous_instances)
 }
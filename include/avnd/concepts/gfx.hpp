@@ -4,6 +4,7 @@
 
 #include <avnd/common/aggregates.hpp>
 #include <avnd/common/concepts_polyfill.hpp>
+#include <avnd/common/tag.hpp>
 #include <avnd/concepts/generic.hpp>
 
 namespace avnd
@@ -105,6 +106,14 @@ concept gpu_texture_port = requires(T t) {
   t.texture;
 } && (gpu_texture<std::decay_t<decltype(std::declval<T>().texture)>>);
 
+/**
+ * This tag indicates that a texture filter can write its output over its input:
+ * before each run, bindings which support it set the output texture to the size
+ * of the input and point its bytes to the input texture's.
+ * The filter then must not reallocate its output, e.g. with create().
+ */
+AVND_DEFINE_TAG(texture_in_place)
+
 
 
 template <typename T>
@@ -7,6 +7,8 @@
 #undef error
 #endif
 
+#include <concepts>
+
 namespace avnd
 {
 
@@ -33,4 +35,14 @@ concept logger = requires(T t) {
 #endif
                  };
 
+/**
+ * Loggers which need each thread logging from the audio callback to be
+ * registered first, e.g. halp::deferred_logger: the bindings using one call
+ * attach() from their audio thread before running the processor.
+ */
+template <typename T>
+concept audio_thread_logger = requires {
+  { T::attach() } -> std::convertible_to<bool>;
+};
+
 }
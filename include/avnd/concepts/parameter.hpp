@@ -253,4 +253,13 @@ concept dynamic_sample_accurate_parameter_port
  */
 template <typename T>
 concept smooth_parameter_port = parameter_port<T> && has_range<T> && has_smooth<T>;
+
+/**
+ * Smoothed parameters which also get the smoothed value of every sample
+ * of the current buffer, e.g. with a std::span<float> ramp; member.
+ */
+template <typename T>
+concept smooth_ramp_parameter_port
+    = smooth_parameter_port<T> && std::floating_point<std::decay_t<decltype(T::value)>>
+      && span_value<std::decay_t<decltype(T::ramp)>>;
 }
@@ -139,6 +139,17 @@ concept mono_per_sample_arg_processor
           || std::is_invocable_r_v<FP, T, FP, typename T::outputs&, const typename T::tick&>
           || std::is_invocable_r_v<FP, T, FP, const typename T::inputs&, typename T::outputs&, const typename T::tick&>);
 
+// A per-sample processor can additionally expose a lane-generic version of itself,
+// e.g. template<typename V> using lanes = my_filter<V>;
+// where V is a pack of samples (halp::simd<float, N>): a single lane instance
+// then processes N channels at once. The state of each channel is moved between
+// the lanes and the per-channel instances field by field, so the lane version
+// must have the same fields, with V in place of the floating-point type.
+template <typename T, typename V>
+concept simd_lane_processor = requires { typename T::template lanes<V>; }
+  && (std::is_invocable_r_v<V, typename T::template lanes<V>&, V>
+   || std::is_invocable_r_v<V, typename T::template lanes<V>&, V, const typename T::inputs&>);
+
 template <typename FP, typename T>
 concept per_sample_port_invocations =
     (std::is_invocable_r_v<void, T>
@@ -3,6 +3,7 @@
 /* SPDX-License-Identifier: GPL-3.0-or-later OR BSL-1.0 OR CC0-1.0 OR CC-PDCC OR 0BSD */
 
 #include <cinttypes>
+#include <concepts>
 #include <type_traits>
 #include <utility>
 
@@ -13,4 +14,20 @@ template <typename FP, typename T>
 concept synth_processor = requires(
     T& t) { std::declval<T::voice>().operator()(t, (FP**)nullptr, (int32_t)0); };
 
+// Voices can also be rendered in batches, with
+// template<typename V> using voice_lanes = my_voices<V>;
+// where V is a pack of samples (halp::simd<float, N>): a voice_lanes object
+// holds the state of N voices as structures of arrays, one voice per lane,
+// and writes all of them at once to the V** outputs. The outputs are zeroed
+// beforehand, so voices can either write or add to them.
+template <typename T, typename V>
+concept batched_synth_processor
+    = requires { typename T::template voice_lanes<V>; }
+      && requires(typename T::template voice_lanes<V>& v, T& t, V** out) {
+           v.start(0, 0, 0.f); // lane, note, velocity
+           v.release(0);       // lane
+           { v.finished(0) } -> std::convertible_to<bool>;
+           v(t, out, (int32_t)0);
+         };
+
 }
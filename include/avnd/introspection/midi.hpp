@@ -8,6 +8,11 @@
 #include <avnd/introspection/port.hpp>
 #include <boost/mp11.hpp>
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
 namespace avnd
 {
 
@@ -55,6 +60,50 @@ struct midi_output_storage<T>
   AVND_NO_UNIQUE_ADDRESS midi_out_messages_vectors outputs_storage;
 };
 
+/**
+ * Bytes of the sysex messages received during one block.
+ *
+ * The capacity is set in reserve(), when the buffer size is known;
+ * allocate() then only bumps an offset and returns nullptr once the arena is
+ * full, and reset() makes the whole capacity available again for the next block.
+ */
+class midi_sysex_arena
+{
+public:
+  void reserve(std::size_t bytes)
+  {
+    m_bytes.assign(bytes, 0);
+    m_used = 0;
+  }
+
+  uint8_t* allocate(std::size_t n) noexcept
+  {
+    if(n > m_bytes.size() - m_used)
+      return nullptr;
+    auto ptr = m_bytes.data() + m_used;
+    m_used += n;
+    return ptr;
+  }
+
+  void reset() noexcept { m_used = 0; }
+
+  std::size_t capacity() const noexcept { return m_bytes.size(); }
+  std::size_t used() const noexcept { return m_used; }
+
+private:
+  std::vector<uint8_t> m_bytes;
+  std::size_t m_used{};
+};
+
+/**
+ * MIDI buffers of an effect.
+ *
+ * reserve_space() gives every MIDI port room for one message per sample of
+ * the buffer, and at least min_messages, and reserves the sysex arena; the
+ * bindings then go through push_message() and assign_bytes() on the audio
+ * thread, which never allocate: messages which do not fit are dropped and
+ * counted in dropped_messages, which the binding can report and reset.
+ */
 template <typename T>
 struct midi_storage
     : midi_input_storage<T>
@@ -67,8 +116,27 @@ struct midi_storage
   using dyn_midi_in_info = avnd::dynamic_container_midi_input_introspection<T>;
   using dyn_midi_out_info = avnd::dynamic_container_midi_output_introspection<T>;
 
+  // Sysex bytes reserved per sample of the buffer, and at least
+  static constexpr int sysex_bytes_per_frame = 8;
+  static constexpr int min_sysex_bytes = 4096;
+
+  // Messages reserved per port: one per sample of the buffer, and at least.
+  // Small buffers can receive more events than samples, e.g. dense MPE.
+  static constexpr int min_messages = 512;
+
+  midi_sysex_arena sysex;
+  int max_messages{};
+
+  // Messages which did not fit since the last reset, on the audio thread
+  int dropped_messages{};
+
   void reserve_space(avnd::effect_container<T>& t, int buffer_size)
   {
+    max_messages = std::max(min_messages, buffer_size);
+    dropped_messages = 0;
+    if constexpr(midi_in_info::size > 0)
+      sysex.reserve(std::max(min_sysex_bytes, sysex_bytes_per_frame * buffer_size));
+
     if constexpr(raw_midi_in_info::size > 0)
     {
       auto init_raw_in = [&]<auto Idx, typename M>(M & port, avnd::predicate_index<Idx>)
@@ -76,7 +144,7 @@ struct midi_storage
         // Here we use storage pre-allocated in midi_..._storage
         // We allocate some memory locally and save a pointer in the structure.
         auto& buf = tpl::get<Idx>(this->inputs_storage);
-        buf.resize(buffer_size);
+        buf.resize(max_messages);
 
         port.midi_messages = buf.data();
         port.size = 0;
@@ -91,7 +159,7 @@ struct midi_storage
         // Here we use storage pre-allocated in midi_..._storage
         // We allocate some memory locally and save a pointer in the structure.
         auto& buf = tpl::get<Idx>(this->outputs_storage);
-        buf.resize(buffer_size);
+        buf.resize(max_messages);
 
         port.midi_messages = buf.data();
         port.size = 0;
@@ -102,12 +170,99 @@ struct midi_storage
     auto init_dyn = [&](auto& port) {
       // Here we use the vector in the port directly.
       port.midi_messages.clear();
-      port.midi_messages.reserve(buffer_size);
+      port.midi_messages.reserve(max_messages);
     };
     dyn_midi_in_info::for_all(avnd::get_inputs(t), init_dyn);
     dyn_midi_out_info::for_all(avnd::get_outputs(t), init_dyn);
   }
 
+  /**
+   * Appends a default-constructed message to a port and returns it,
+   * or nullptr if the port already holds as many messages as were reserved.
+   */
+  template <avnd::dynamic_container_midi_port Port>
+  auto* push_message(Port& port) noexcept
+  {
+    using message_type = std::decay_t<decltype(port.midi_messages[0])>;
+    auto& messages = port.midi_messages;
+    if(std::ssize(messages) >= max_messages)
+    {
+      dropped_messages++;
+      return static_cast<message_type*>(nullptr);
+    }
+    messages.push_back({});
+    return &messages.back();
+  }
+
+  template <avnd::raw_container_midi_port Port>
+  auto* push_message(Port& port) noexcept
+  {
+    if(int(port.size) >= max_messages)
+    {
+      dropped_messages++;
+      return static_cast<avnd::midi_message_type<Port>*>(nullptr);
+    }
+    return &port.midi_messages[port.size++];
+  }
+
+  // Removes the message returned by the last push_message
+  void pop_message(avnd::dynamic_container_midi_port auto& port) noexcept
+  {
+    auto& messages = port.midi_messages;
+    if constexpr(requires { messages.pop_back(); })
+      messages.pop_back();
+    else
+      messages.resize(messages.size() - 1);
+  }
+
+  void pop_message(avnd::raw_container_midi_port auto& port) noexcept { port.size--; }
+
+  /**
+   * Copies n bytes in a message. Payloads which do not fit in the message
+   * are stored in the sysex arena when the message can borrow them,
+   * e.g. halp::midi_bytes. Returns false, and counts the message as dropped,
+   * if they could not be stored.
+   */
+  template <avnd::midi_message Message>
+  bool assign_bytes(Message& msg, const uint8_t* bytes, std::size_t n) noexcept
+  {
+    auto& dst = msg.bytes;
+    if constexpr(requires { dst.borrow(sysex.allocate(n), n); })
+    {
+      if(n > std::remove_cvref_t<decltype(dst)>::inline_capacity)
+      {
+        auto ptr = sysex.allocate(n);
+        if(!ptr)
+        {
+          dropped_messages++;
+          return false;
+        }
+        std::memcpy(ptr, bytes, n);
+        dst.borrow(ptr, n);
+        return true;
+      }
+      dst.assign(bytes, bytes + n);
+      return true;
+    }
+    else if constexpr(avnd::dynamic_midi_message<Message>)
+    {
+      dst.assign(bytes, bytes + n);
+      return true;
+    }
+    else
+    {
+      // Fixed arrays only hold channel messages
+      const std::size_t capacity = std::size(dst);
+      if(n > capacity)
+      {
+        dropped_messages++;
+        return false;
+      }
+      std::copy_n(bytes, n, std::begin(dst));
+      return true;
+    }
+  }
+
   void do_clear(avnd::dynamic_container_midi_port auto& port)
   {
     port.midi_messages.clear();
@@ -117,6 +272,7 @@ struct midi_storage
 
   void clear_inputs(avnd::effect_container<T>& t)
   {
+    sysex.reset();
     if constexpr(midi_in_info::size > 0)
     {
       auto clearer = [this](auto&& port) { this->do_clear(port); };
@@ -0,0 +1,238 @@
+#pragma once
+
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+#include <avnd/common/aligned_allocator.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace avnd
+{
+/**
+ * Converts a single sample, e.g. float to double or int16_t to float.
+ *
+ * Integer samples map to [-1, 1) the way GStreamer and most hosts do: they
+ * are divided by 2^(bits - 1). Conversions to integers scale back, clamp and
+ * round to the nearest value.
+ */
+template <typename Dst, typename Src>
+constexpr Dst sample_cast(Src s) noexcept
+{
+  if constexpr(std::is_integral_v<Src> && std::is_floating_point_v<Dst>)
+  {
+    constexpr Dst scale = Dst(1) / (Dst(std::numeric_limits<Src>::max()) + Dst(1));
+    return static_cast<Dst>(s) * scale;
+  }
+  else if constexpr(std::is_floating_point_v<Src> && std::is_integral_v<Dst>)
+  {
+    // float does not have enough mantissa bits for 32-bit integers
+    using calc = std::conditional_t<(sizeof(Dst) > 2), double, Src>;
+    constexpr calc lo = calc(std::numeric_limits<Dst>::min());
+    constexpr calc hi = calc(std::numeric_limits<Dst>::max());
+    const calc v = std::clamp(calc(s) * (hi + calc(1)), lo, hi);
+    return static_cast<Dst>(v < calc(0) ? v - calc(0.5) : v + calc(0.5));
+  }
+  else
+  {
+    return static_cast<Dst>(s);
+  }
+}
+
+/**
+ * Copies n samples from in to out, converting e.g. float to double
+ * with avnd::sample_cast.
+ *
+ * The conversion is done in fixed-size blocks so that compilers emit packed
+ * conversion instructions (cvtps2pd / cvtpd2ps, fcvtl / fcvtn) even with
+ * the cheap vectorization cost model used at -O2.
+ * When both types match this is a plain copy, skipped if in == out.
+ */
+template <typename Src, typename Dst>
+inline void convert_samples(const Src* in, Dst* out, std::size_t n) noexcept
+{
+  if constexpr(std::is_same_v<std::remove_const_t<Src>, Dst>)
+  {
+    if(in != out)
+      std::copy_n(in, n, out);
+  }
+  else
+  {
+    static constexpr std::size_t block = 16;
+
+    std::size_t i = 0;
+    for(; i + block <= n; i += block)
+      for(std::size_t j = 0; j < block; j++)
+        out[i + j] = sample_cast<Dst>(in[i + j]);
+    for(; i < n; i++)
+      out[i] = sample_cast<Dst>(in[i]);
+  }
+}
+
+namespace detail
+{
+// Both kernels go through a small local tile of block frames: the accesses to
+// it have no aliasing and a fixed trip count, so that they are vectorized.
+template <int C, typename Src, typename Dst>
+inline void deinterleave_fixed(const Src* in, Dst* const* out, std::size_t frames) noexcept
+{
+  static constexpr std::size_t block = 16;
+  Dst* o[C];
+  for(int c = 0; c < C; c++)
+    o[c] = out[c];
+
+  std::size_t i = 0;
+  for(; i + block <= frames; i += block)
+  {
+    Src tile[block * C];
+    std::memcpy(tile, in + i * C, sizeof(tile));
+    for(int c = 0; c < C; c++)
+      for(std::size_t j = 0; j < block; j++)
+        o[c][i + j] = sample_cast<Dst>(tile[j * C + c]);
+  }
+  for(; i < frames; i++)
+    for(int c = 0; c < C; c++)
+      o[c][i] = sample_cast<Dst>(in[i * C + c]);
+}
+
+template <int C, typename Src, typename Dst>
+inline void interleave_fixed(const Src* const* in, Dst* out, std::size_t frames) noexcept
+{
+  static constexpr std::size_t block = 16;
+  const Src* s[C];
+  for(int c = 0; c < C; c++)
+    s[c] = in[c];
+
+  std::size_t i = 0;
+  for(; i + block <= frames; i += block)
+  {
+    Dst tile[block * C];
+    for(int c = 0; c < C; c++)
+      for(std::size_t j = 0; j < block; j++)
+        tile[j * C + c] = sample_cast<Dst>(s[c][i + j]);
+    std::memcpy(out + i * C, tile, sizeof(tile));
+  }
+  for(; i < frames; i++)
+    for(int c = 0; c < C; c++)
+      out[i * C + c] = sample_cast<Dst>(s[c][i]);
+}
+}
+
+/**
+ * Splits n frames of interleaved samples into one buffer per channel,
+ * converting e.g. int16_t to float.
+ *
+ * 2, 4 and 8 channels have kernels where the channel count is known at
+ * compile time, which compilers turn into packed shuffles.
+ */
+template <typename Src, typename Dst>
+inline void deinterleave_samples(
+    const Src* in, Dst* const* out, int channels, std::size_t frames) noexcept
+{
+  switch(channels)
+  {
+    case 1:
+      convert_samples(in, out[0], frames);
+      break;
+    case 2:
+      detail::deinterleave_fixed<2>(in, out, frames);
+      break;
+    case 4:
+      detail::deinterleave_fixed<4>(in, out, frames);
+      break;
+    case 8:
+      detail::deinterleave_fixed<8>(in, out, frames);
+      break;
+    default:
+      for(int c = 0; c < channels; c++)
+        for(std::size_t i = 0; i < frames; i++)
+          out[c][i] = sample_cast<Dst>(in[i * channels + c]);
+      break;
+  }
+}
+
+/**
+ * Merges one buffer per channel into n frames of interleaved samples.
+ */
+template <typename Src, typename Dst>
+inline void interleave_samples(
+    const Src* const* in, Dst* out, int channels, std::size_t frames) noexcept
+{
+  switch(channels)
+  {
+    case 1:
+      convert_samples(in[0], out, frames);
+      break;
+    case 2:
+      detail::interleave_fixed<2>(in, out, frames);
+      break;
+    case 4:
+      detail::interleave_fixed<4>(in, out, frames);
+      break;
+    case 8:
+      detail::interleave_fixed<8>(in, out, frames);
+      break;
+    default:
+      for(int c = 0; c < channels; c++)
+        for(std::size_t i = 0; i < frames; i++)
+          out[i * channels + c] = sample_cast<Dst>(in[c][i]);
+      break;
+  }
+}
+
+/**
+ * Contiguous multichannel scratch memory, used when the host and the
+ * processor do not agree on the sample precision.
+ *
+ * All channels live in a single allocation, each one starting on an
+ * cache_line_alignment boundary.
+ */
+template <typename FP>
+class audio_scratch
+{
+public:
+  using value_type = FP;
+
+  void reserve(int channels, int frames)
+  {
+    static constexpr std::size_t per_line = cache_line_alignment / sizeof(FP);
+    m_stride = ((std::max(frames, 0) + per_line - 1) / per_line) * per_line;
+    m_channels = std::max(channels, 0);
+    m_storage.assign(m_stride * m_channels, FP{});
+  }
+
+  [[nodiscard]] FP* channel(int c) noexcept { return m_storage.data() + c * m_stride; }
+  [[nodiscard]] FP* data() noexcept { return m_storage.data(); }
+  [[nodiscard]] std::size_t stride() const noexcept { return m_stride; }
+  [[nodiscard]] int channels() const noexcept { return m_channels; }
+
+  /**
+   * Makes the n samples of in available as FP for channel c.
+   * If in already has the right type it is returned as-is, otherwise
+   * it is converted into the scratch memory of the channel.
+   */
+  template <typename Src>
+  [[nodiscard]] FP* load(int c, const Src* in, std::size_t n) noexcept
+  {
+    if constexpr(std::is_same_v<std::remove_const_t<Src>, FP>)
+    {
+      return const_cast<FP*>(in);
+    }
+    else
+    {
+      FP* ptr = channel(c);
+      convert_samples(in, ptr, n);
+      return ptr;
+    }
+  }
+
+private:
+  aligned_vector<FP> m_storage;
+  std::size_t m_stride{};
+  int m_channels{};
+};
+
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+#include <avnd/concepts/synth.hpp>
+#include <avnd/wrappers/simd_lanes.hpp>
+#include <avnd/wrappers/voice_pool.hpp>
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace avnd
+{
+/**
+ * Renders the voices of a batched_synth_processor in SIMD lanes.
+ *
+ * Voice k is lane k % N of the group k / N, where N is the number of lanes of
+ * a pack (avnd::simd_lane_count). Voices are allocated, released, stolen and
+ * recycled with an avnd::voice_pool.
+ *
+ * render() runs each group which has at least one active voice for the whole
+ * block, accumulates the groups lane-wise, and only then sums the lanes and
+ * mixes the result into the output: the cost grows with the number of groups
+ * rather than with the number of voices.
+ *
+ * Everything is allocated in reserve().
+ */
+template <typename T, std::floating_point FP, std::size_t MaxVoices>
+  requires batched_synth_processor<T, simd_lane_type<FP>>
+class batched_voices
+{
+public:
+  using pack_type = simd_lane_type<FP>;
+  using lanes_type = typename T::template voice_lanes<pack_type>;
+  static constexpr int lanes = simd_lane_count<FP>;
+  static constexpr std::size_t group_count = (MaxVoices + lanes - 1) / lanes;
+
+  batched_voices() noexcept
+  {
+    for(std::size_t k = 0; k < group_count * lanes; k++)
+      m_pool[typename pool_type::index_type(k)]
+          = {uint16_t(k / lanes), uint16_t(k % lanes)};
+  }
+
+  void reserve(int channels, int frames)
+  {
+    m_channels = std::max(channels, 1);
+    m_frames = std::max(frames, 1);
+    m_render.assign(std::size_t(m_channels) * m_frames, pack_type{});
+    m_mix.assign(std::size_t(m_channels) * m_frames, pack_type{});
+    m_render_ptrs.resize(m_channels);
+    for(int c = 0; c < m_channels; c++)
+      m_render_ptrs[c] = m_render.data() + std::size_t(c) * m_frames;
+  }
+
+  std::size_t size() const noexcept { return m_pool.size(); }
+  std::size_t stolen() const noexcept { return m_pool.stolen(); }
+
+  // Voices and their state, e.g. to set per-voice parameters
+  lanes_type& group(std::size_t g) noexcept { return m_groups[g]; }
+
+  void note_on(int note, FP velocity) noexcept
+  {
+    const auto stolen = m_pool.stolen();
+    auto& v = m_pool.allocate(note);
+    if(m_pool.stolen() == stolen)
+      m_active[v.group]++;
+
+    m_mask[v.group][v.lane] = FP(1);
+    m_groups[v.group].start(v.lane, note, velocity);
+  }
+
+  void note_off(int note) noexcept
+  {
+    m_pool.release(
+        note, [this](lane_ref& v) { m_groups[v.group].release(v.lane); });
+  }
+
+  /**
+   * Adds the voices to outputs[0, channels), in blocks of at most the frames
+   * given to reserve(), then recycles the voices which are finished.
+   */
+  void render(T& synth, FP** outputs, int channels, int frames) noexcept
+  {
+    channels = std::min(channels, m_channels);
+    for(int start = 0; start < frames; start += m_frames)
+    {
+      const int n = std::min(m_frames, frames - start);
+      render_block(synth, outputs, channels, start, n);
+    }
+
+    m_pool.recycle_if([this](lane_ref& v) {
+      if(!m_groups[v.group].finished(v.lane))
+        return false;
+      m_mask[v.group][v.lane] = FP(0);
+      m_active[v.group]--;
+      return true;
+    });
+  }
+
+private:
+  struct lane_ref
+  {
+    uint16_t group{};
+    uint16_t lane{};
+  };
+  using pool_type = voice_pool<lane_ref, group_count * lanes>;
+
+  void render_block(T& synth, FP** outputs, int channels, int start, int frames) noexcept
+  {
+    for(int c = 0; c < channels; c++)
+      std::fill_n(m_mix.data() + std::size_t(c) * m_frames, frames, pack_type{});
+
+    bool any = false;
+    for(std::size_t g = 0; g < group_count; g++)
+    {
+      if(m_active[g] == 0)
+        continue;
+      any = true;
+
+      // Voices may add to their outputs rather than overwrite them
+      for(int c = 0; c < m_channels; c++)
+        std::fill_n(m_render_ptrs[c], frames, pack_type{});
+      m_groups[g](synth, m_render_ptrs.data(), frames);
+
+      // Silences the lanes without a voice, e.g. the tail of a recycled one
+      const pack_type mask = m_mask[g];
+      for(int c = 0; c < channels; c++)
+      {
+        const pack_type* in = m_render_ptrs[c];
+        pack_type* mix = m_mix.data() + std::size_t(c) * m_frames;
+        for(int i = 0; i < frames; i++)
+          mix[i] += in[i] * mask;
+      }
+    }
+
+    if(!any)
+      return;
+
+    for(int c = 0; c < channels; c++)
+    {
+      const pack_type* mix = m_mix.data() + std::size_t(c) * m_frames;
+      FP* out = outputs[c] + start;
+      for(int i = 0; i < frames; i++)
+        out[i] += horizontal_sum(mix[i]);
+    }
+  }
+
+  pool_type m_pool;
+  std::array<lanes_type, group_count> m_groups{};
+  std::array<pack_type, group_count> m_mask{};
+  std::array<int, group_count> m_active{};
+
+  std::vector<pack_type> m_render;
+  std::vector<pack_type> m_mix;
+  std::vector<pack_type*> m_render_ptrs;
+  int m_channels{};
+  int m_frames{};
+};
+}
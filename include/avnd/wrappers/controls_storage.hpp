@@ -237,6 +237,7 @@ struct control_storage
       {
         auto& buf = tpl::get<Idx>(this->span_timed_inputs);
         buf.resize(0);
+        port.values = {buf.data(), std::size_t(0)};
       };
       span_timed_in::for_all_n(avnd::get_inputs(t), init_raw_in);
     }
@@ -245,6 +246,65 @@ struct control_storage
     dyn_in::for_all(avnd::get_inputs(t), init_dyn);
   }
 
+  /**
+   * Records that the sample-accurate input port changes to value at the given
+   * frame of the current buffer.
+   * port is the field of any instance: the change is recorded once, and seen
+   * by the matching port of every instance of a multi-instance effect, so this
+   * must be called once per event.
+   * Frames outside of [0, buffer_size) are dropped, and nothing is allocated:
+   * the space reserved by reserve_space is used.
+   * Returns false if port is not a sample-accurate port.
+   */
+  template <typename Field, typename V>
+  bool add_timed_value(
+      avnd::effect_container<T>& t, Field& port, const V& value, int frame,
+      int buffer_size)
+  {
+    if constexpr(avnd::linear_sample_accurate_parameter_port<Field>)
+    {
+      // values points to the storage shared by all the instances
+      if(frame >= 0 && frame < buffer_size)
+        port.values[frame] = value;
+      return true;
+    }
+    else if constexpr(avnd::dynamic_sample_accurate_parameter_port<Field>)
+    {
+      // Each instance owns its values
+      if(frame >= 0 && frame < buffer_size)
+        for_each_instance<dyn_in>(
+            t, port, [&](Field& p) { p.values[frame] = value; });
+      return true;
+    }
+    else if constexpr(avnd::span_sample_accurate_parameter_port<Field>)
+    {
+      if(frame < 0 || frame >= buffer_size)
+        return true;
+
+      // The span does not own its storage: push to the matching buffer once,
+      // then point the port of every instance to it.
+      bool pushed = false;
+      for_each_instance<span_timed_in>(
+          t, port, [&]<auto Idx>(Field& p, avnd::predicate_index<Idx>) {
+        auto& buf = tpl::get<Idx>(this->span_timed_inputs);
+        if(!pushed && buf.size() < buf.capacity())
+        {
+          typename std::decay_t<decltype(buf)>::value_type v{};
+          v.frame = frame;
+          v.value = value;
+          buf.push_back(v);
+        }
+        pushed = true;
+        p.values = {buf.data(), buf.size()};
+      });
+      return true;
+    }
+    else
+    {
+      return false;
+    }
+  }
+
   void clear_outputs(avnd::effect_container<T>& t)
   {
     if constexpr(lin_out::size > 0)
@@ -272,6 +332,33 @@ struct control_storage
     auto init_dyn = [&](auto& port) { port.values.clear(); };
     dyn_out::for_all(avnd::get_outputs(t), init_dyn);
   }
+
+private:
+  // Calls f with the port at the same place as port, in every instance
+  template <typename Info, typename Field, typename F>
+  static void for_each_instance(avnd::effect_container<T>& t, Field& port, F&& f)
+  {
+    int index = -1;
+    Info::for_all_n(
+        avnd::get_inputs(t), [&]<auto Idx, typename M>(M& p, avnd::predicate_index<Idx>) {
+      if constexpr(std::is_same_v<M, Field>)
+        if(&p == &port)
+          index = Idx;
+    });
+
+    Info::for_all_n(
+        avnd::get_inputs(t), [&]<auto Idx, typename M>(M& p, avnd::predicate_index<Idx>) {
+      if constexpr(std::is_same_v<M, Field>)
+      {
+        if(Idx != index)
+          return;
+        if constexpr(requires { f(p, avnd::predicate_index<Idx>{}); })
+          f(p, avnd::predicate_index<Idx>{});
+        else
+          f(p);
+      }
+    });
+  }
 };
 
 /**
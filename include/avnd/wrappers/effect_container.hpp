@@ -2,10 +2,12 @@
 
 /* SPDX-License-Identifier: GPL-3.0-or-later */
 
+#include <avnd/common/aligned_allocator.hpp>
 #include <avnd/common/coroutines.hpp>
 #include <avnd/common/no_unique_address.hpp>
 #include <avnd/concepts/all.hpp>
 
+#include <type_traits>
 #include <vector>
 
 namespace avnd
@@ -48,7 +50,8 @@ struct member_iterator_poly_effect
   void operator++() noexcept { i++; }
   auto& operator*() const noexcept
   {
-    if constexpr(std::is_same_v<decltype(self.effect), typename T::type>)
+    if constexpr(std::is_same_v<
+                     std::remove_cvref_t<decltype(self.effect[i])>, typename T::type>)
       return self.effect[i];
     else
       return self.effect[i].effect;
@@ -107,6 +110,14 @@ struct outputs_storage<T>
   typename T::outputs outputs_storage;
 };
 
+/**
+ * Storage of the instances of a multi-instance processor: with the
+ * contiguous_instances tag, a cache-line-aligned contiguous array.
+ */
+template <typename T>
+using instances_storage = std::conditional_t<
+    tag_contiguous_instances<T>, aligned_vector<T>, std::vector<T>>;
+
 /**
  * @brief used to adapt monophonic effects to polyphonic hosts
  */
@@ -121,6 +132,11 @@ struct effect_container
     single_instance
   };
 
+  static_assert(
+      !tag_contiguous_instances<T>,
+      "contiguous_instances only applies to monophonic processors, which are "
+      "instantiated once per channel");
+
   T effect;
 
   inline constexpr void init_channels(int input, int output)
@@ -209,6 +225,11 @@ struct effect_container<T>
     single_instance
   };
 
+  static_assert(
+      !tag_contiguous_instances<T>,
+      "contiguous_instances only applies to monophonic processors, which are "
+      "instantiated once per channel");
+
   T effect;
 
   void init_channels(int input, int output)
@@ -246,7 +267,7 @@ struct effect_container<T>
     multi_instance
   };
 
-  std::vector<T> effect;
+  instances_storage<T> effect;
   void init_channels(int input, int output)
   {
     // FIXME do that everywhere
@@ -279,13 +300,11 @@ struct effect_container<T>
     AVND_NO_UNIQUE_ADDRESS dummy outputs;
   };
 
-  member_iterator<ref> full_state()
+  ref full_state(int i) { return {effect[i], {}, {}}; }
+
+  full_state_iterator<effect_container> full_state()
   {
-    for(auto& e : effect)
-    {
-      ref r{e, {}, {}};
-      co_yield r;
-    }
+    return full_state_iterator<effect_container>{*this};
   }
 };
 
@@ -301,7 +320,7 @@ struct effect_container<T>
 
   typename T::inputs inputs_storage;
 
-  std::vector<T> effect;
+  instances_storage<T> effect;
 
   void init_channels(int input, int output) { effect.resize(std::max(input, output)); }
 
@@ -331,7 +350,9 @@ struct effect_container<T>
 };
 
 template <avnd::monophonic_audio_processor T>
-  requires(avnd::inputs_is_type<T> && avnd::outputs_is_type<T> && !tag_cv<T>)
+  requires(
+      avnd::inputs_is_type<T> && avnd::outputs_is_type<T> && !tag_cv<T>
+      && !tag_contiguous_instances<T>)
 struct effect_container<T>
 {
   using type = T;
@@ -377,10 +398,64 @@ struct effect_container<T>
     return member_iterator_poly_effect<effect_container>{*this};
   }
 
-  member_iterator<typename T::outputs> outputs()
+  member_range<typename T::outputs> outputs() noexcept
+  {
+    return {effect.data(), effect.size(), &state::outputs_storage};
+  }
+};
+
+template <avnd::monophonic_audio_processor T>
+  requires(
+      avnd::inputs_is_type<T> && avnd::outputs_is_type<T> && !tag_cv<T>
+      && tag_contiguous_instances<T>)
+struct effect_container<T>
+{
+  using type = T;
+  enum
+  {
+    multi_instance
+  };
+
+  typename T::inputs inputs_storage;
+
+  // Struct-of-arrays: the instances and their outputs each live in their own
+  // cache-line-aligned contiguous storage, so that walking all the outputs
+  // (e.g. to read back output controls) does not touch the processors.
+  aligned_vector<T> effect;
+  aligned_vector<typename T::outputs> outputs_storage;
+
+  void init_channels(int input, int output)
+  {
+    const auto sz = std::max(input, output);
+    effect.resize(sz);
+    outputs_storage.resize(sz);
+  }
+
+  auto& inputs() noexcept { return inputs_storage; }
+  auto& inputs() const noexcept { return inputs_storage; }
+
+  struct ref
+  {
+    T& effect;
+    typename T::inputs& inputs;
+    typename T::outputs& outputs;
+  };
+
+  ref full_state(int i) { return {effect[i], this->inputs_storage, outputs_storage[i]}; }
+
+  full_state_iterator<effect_container> full_state()
+  {
+    return full_state_iterator<effect_container>{*this};
+  }
+
+  auto effects()
+  {
+    return member_iterator_poly_effect<effect_container>{*this};
+  }
+
+  member_range<typename T::outputs> outputs() noexcept
   {
-    for(auto& e : effect)
-      co_yield e.outputs_storage;
+    return {outputs_storage.data(), outputs_storage.size()};
   }
 };
 
@@ -396,7 +471,7 @@ struct effect_container<T>
 
   typename T::inputs inputs_storage;
 
-  std::vector<T> effect;
+  instances_storage<T> effect;
 
   void init_channels(int input, int output)
   {
@@ -414,10 +489,7 @@ struct effect_container<T>
     decltype(T::outputs)& outputs;
   };
 
-  ref full_state(int i)
-  {
-    return {effect[i].effect, this->inputs_storage, effect[i].effect.outputs};
-  }
+  ref full_state(int i) { return {effect[i], this->inputs_storage, effect[i].outputs}; }
 
   full_state_iterator<effect_container> full_state()
   {
@@ -429,10 +501,9 @@ struct effect_container<T>
     return member_iterator_poly_effect<effect_container>{*this};
   }
 
-  member_iterator<typename T::outputs> outputs()
+  member_range<decltype(T::outputs)> outputs() noexcept
   {
-    for(auto& e : effect)
-      co_yield e.output;
+    return {effect.data(), effect.size(), &T::outputs};
   }
 };
 
@@ -446,7 +517,7 @@ struct effect_container<T>
     multi_instance
   };
 
-  std::vector<T> effect;
+  instances_storage<T> effect;
 
   void init_channels(int input, int output)
   {
@@ -479,15 +550,13 @@ struct effect_container<T>
 
   auto effects() { return member_iterator_poly_effect<effect_container>{*this}; }
 
-  member_iterator<decltype(T::inputs)> inputs()
+  member_range<decltype(T::inputs)> inputs() noexcept
   {
-    for(auto& e : effect)
-      co_yield e.inputs;
+    return {effect.data(), effect.size(), &T::inputs};
   }
-  member_iterator<decltype(T::outputs)> outputs()
+  member_range<decltype(T::outputs)> outputs() noexcept
   {
-    for(auto& e : effect)
-      co_yield e.outputs;
+    return {effect.data(), effect.size(), &T::outputs};
   }
 };
 template <avnd::monophonic_audio_processor T>
@@ -500,7 +569,7 @@ struct effect_container<T>
     multi_instance
   };
 
-  std::vector<T> effect;
+  instances_storage<T> effect;
 
   void init_channels(int input, int output)
   {
@@ -540,10 +609,9 @@ struct effect_container<T>
     return member_iterator_poly_effect<effect_container>{*this};
   }
 
-  member_iterator<decltype(T::inputs)> inputs()
+  member_range<decltype(T::inputs)> inputs() noexcept
   {
-    for(auto& e : effect)
-      co_yield e.inputs;
+    return {effect.data(), effect.size(), &T::inputs};
   }
 
   auto& outputs() noexcept { return dummy_instance; }
@@ -11,6 +11,7 @@
 #include <avnd/wrappers/process_execution.hpp>
 #include <avnd/wrappers/smooth.hpp>
 
+#include <algorithm>
 #include <concepts>
 #include <cstdint>
 #include <cstdlib>
@@ -59,6 +60,120 @@ void process_smooth(avnd::effect_container<T>& implementation, auto& p, auto&&..
   process_smooth(implementation, params...);
 }
 
+// The smoothing storage among the parameters of process(), or nullptr
+template <typename T>
+std::nullptr_t get_smooth_storage(avnd::effect_container<T>& implementation)
+{
+  return nullptr;
+}
+
+template <typename T>
+smooth_storage<T>* get_smooth_storage(
+    avnd::effect_container<T>& implementation, smooth_storage<T>& smooth,
+    auto&&... params)
+{
+  return &smooth;
+}
+
+template <typename T>
+auto get_smooth_storage(
+    avnd::effect_container<T>& implementation, auto& p, auto&&... params)
+{
+  return get_smooth_storage(implementation, params...);
+}
+
+/**
+ * Smoothing for adapters which process a whole buffer at once: the smoothers
+ * advance by `frames` samples, and ports with a ramp get the value of each
+ * sample of the buffer.
+ */
+template <typename T>
+void process_smooth(
+    avnd::effect_container<T>& implementation, int frames, auto&&... params)
+{
+  if constexpr(!std::is_same_v<
+                   decltype(get_smooth_storage(implementation, params...)),
+                   std::nullptr_t>)
+    get_smooth_storage(implementation, params...)->smooth_all(implementation, frames);
+}
+
+/**
+ * Smoothing for processors run one channel at a time.
+ *
+ * In sample-major order the smoothers advance by one step per sample, shared
+ * by all the channels. Here the steps of the whole block are computed once by
+ * start(), then set() gives a channel instance the values of sample i.
+ * Blocks larger than reserved do not fit(): they must be run sample-major.
+ * Without smoothed inputs, all of this compiles to nothing.
+ */
+template <typename T>
+struct channel_major_smoothing
+{
+  void reserve(int frames) { }
+  bool fits(int frames) const noexcept { return true; }
+  void start(auto smooth, int frames) noexcept { }
+  void set(auto& inputs, int i) const noexcept { }
+};
+
+template <typename T>
+  requires(smooth_parameter_input_introspection<T>::size > 0)
+struct channel_major_smoothing<T>
+{
+  using smooth_in = smooth_parameter_input_introspection<T>;
+
+  // One buffer per smoothed input, with the value of each sample of the block
+  filter_and_apply<smooth_param_values, smooth_parameter_input_introspection, T> values;
+  int capacity{};
+  bool active{};
+
+  void reserve(int frames)
+  {
+    [&]<std::size_t... I>(std::index_sequence<I...>) {
+      (tpl::get<I>(values).resize(frames), ...);
+    }(std::make_index_sequence<smooth_in::size>{});
+    capacity = frames;
+  }
+
+  bool fits(int frames) const noexcept { return frames <= capacity; }
+
+  void start(std::nullptr_t, int frames) noexcept { active = false; }
+  void start(smooth_storage<T>* smooth, int frames) noexcept
+  {
+    smooth->smooth_steps(values, frames);
+    active = true;
+  }
+
+  void set(auto& inputs, int i) const noexcept
+  {
+    if(!active)
+      return;
+
+    smooth_in::for_all_n(
+        inputs, [this, i]<auto Idx, typename M>(M& field, avnd::predicate_index<Idx>) {
+      field.value = tpl::get<Idx>(values)[i];
+      if constexpr(smooth_ramp_parameter_port<M>)
+        field.ramp = {};
+    });
+  }
+};
+
+/**
+ * Per-sample monophonic processors can be run channel-major (a whole block
+ * for one channel, then the next) only if writing an output channel cannot
+ * clobber an input channel that has not been read yet.
+ * Some hosts like puredata reuse input buffers as output buffers.
+ */
+template <typename FP>
+bool channels_are_independent(avnd::span<FP*> in, avnd::span<FP*> out) noexcept
+{
+  const std::size_t channels = std::min(in.size(), out.size());
+  for(std::size_t c = 0; c < channels; c++)
+    for(std::size_t d = c + 1; d < channels; d++)
+      if(out[c] == in[d])
+        return false;
+  return true;
+}
+
 template <typename Fp>
 struct zero_storage
 {
@@ -87,7 +202,7 @@ struct process_adapter
       const auto& tick, auto&&... params)
   {
     // Process the various parameters
-    process_smooth(implementation, params...);
+    process_smooth(implementation, int(get_frames(tick)), params...);
 
     // Audio buffers aren't used at all
     invoke_effect(implementation, tick);
@@ -127,9 +242,9 @@ struct audio_buffer_storage
     {
       using needed_type = typename needs_storage<SrcFP, T>::needed_storage_t;
       input_buffer_for(needed_type{})
-          .resize(setup.frames_per_buffer * setup.input_channels);
+          .reserve(setup.input_channels, setup.frames_per_buffer);
       output_buffer_for(needed_type{})
-          .resize(setup.frames_per_buffer * setup.output_channels);
+          .reserve(setup.output_channels, setup.frames_per_buffer);
     }
 
 #if AVND_ENABLE_SAFE_BUFFER_STORAGE
@@ -0,0 +1,177 @@
+#pragma once
+
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+#include <avnd/wrappers/process/base.hpp>
+#include <avnd/wrappers/simd_lanes.hpp>
+
+namespace avnd
+{
+
+/**
+ * Lane packs of a lane-generic processor: channels [N*k, N*k + N) are
+ * processed by packs[k]. The packs keep nothing between blocks: the state
+ * stays in the per-channel instances of the effect_container, and is loaded
+ * into the packs before each block and stored back after it.
+ */
+template <typename T, typename FP>
+struct simd_lane_storage
+{
+};
+
+template <typename T, typename FP>
+  requires simd_lane_processor<T, simd_lane_type<FP>>
+struct simd_lane_storage<T, FP>
+{
+  using lanes_type = typename T::template lanes<simd_lane_type<FP>>;
+  using transfer = simd_lane_transfer<FP, simd_lane_count<FP>>;
+  std::vector<lanes_type> packs;
+
+  // Samples of the current frame, transposed: frame[k][c] is channel N*k + c
+  std::vector<simd_lane_type<FP>> frame;
+};
+
+/**
+ * Lane-packed execution of the per-sample monophonic processors, whether they
+ * take their sample as an argument or through ports: the lane instance is
+ * always called with the sample pack, and the inputs if it wants them.
+ *
+ * process() returns false when the block cannot be run in lanes: the adapter
+ * then processes the instances one by one. Without a lane-generic version of
+ * the processor, all of this compiles to nothing.
+ */
+template <typename T>
+struct simd_lane_execution
+{
+  template <std::floating_point FP>
+  void reserve(process_setup setup, FP)
+  {
+  }
+
+  template <std::floating_point FP>
+  bool process(
+      avnd::effect_container<T>& implementation, avnd::span<FP*> in,
+      avnd::span<FP*> out, int32_t n, auto&&... params) noexcept
+  {
+    return false;
+  }
+};
+
+template <typename T>
+  requires(
+      simd_lane_processor<T, simd_lane_type<float>>
+      || simd_lane_processor<T, simd_lane_type<double>>)
+struct simd_lane_execution<T>
+{
+  AVND_NO_UNIQUE_ADDRESS simd_lane_storage<T, float> m_lanes_f;
+  AVND_NO_UNIQUE_ADDRESS simd_lane_storage<T, double> m_lanes_d;
+
+  auto& lanes_for(float) { return m_lanes_f; }
+  auto& lanes_for(double) { return m_lanes_d; }
+
+  template <std::floating_point FP>
+  void reserve(process_setup setup, FP)
+  {
+    if constexpr(simd_lane_processor<T, simd_lane_type<FP>>)
+    {
+      constexpr int N = simd_lane_count<FP>;
+      const int channels = std::max(setup.input_channels, setup.output_channels);
+      auto& lanes = lanes_for(FP{});
+
+      lanes.packs.clear();
+      lanes.packs.resize((channels + N - 1) / N);
+      lanes.frame.resize(lanes.packs.size());
+    }
+  }
+
+  template <std::floating_point FP>
+  bool process(
+      avnd::effect_container<T>& implementation, avnd::span<FP*> in,
+      avnd::span<FP*> out, int32_t n, auto&&... params)
+  {
+    if constexpr(simd_lane_processor<T, simd_lane_type<FP>>)
+    {
+      // Only the channels which have an instance are processed.
+      // With more channels than packs were allocated for (or buffers allocated
+      // at the other precision), the adapter processes the instances one by
+      // one: the state is the same in both paths, only slower.
+      auto& lanes = lanes_for(FP{});
+      const int processed
+          = std::min(int(in.size()), int(std::ssize(implementation.effect)));
+      if(std::ssize(lanes.packs) * simd_lane_count<FP> < processed)
+        return false;
+
+      process_lanes(implementation, lanes, processed, in, out, n, params...);
+      return true;
+    }
+    else
+    {
+      return false;
+    }
+  }
+
+private:
+  template <typename L, typename V>
+  static V process_lane(L& fx, V in, auto& ins)
+  {
+    if constexpr(requires { fx(in, ins); })
+      return fx(in, ins);
+    else
+      return fx(in);
+  }
+
+  template <std::floating_point FP>
+  void process_lanes(
+      avnd::effect_container<T>& implementation, simd_lane_storage<T, FP>& lanes,
+      int channels, avnd::span<FP*> in, avnd::span<FP*> out, int32_t n,
+      auto&&... params)
+  {
+    constexpr int N = simd_lane_count<FP>;
+    using transfer = typename simd_lane_storage<T, FP>::transfer;
+    const int packs = (channels + N - 1) / N;
+    auto& ins = [&]() -> auto& {
+      if constexpr(avnd::inputs_is_type<T>)
+        return implementation.inputs();
+      else
+        return avnd::dummy_instance;
+    }();
+
+    // Controls stored in the instances are loaded as the rest of their state
+    for(int k = 0; k < packs; k++)
+      for(int c = 0; c < N && k * N + c < channels; c++)
+        transfer::load(lanes.packs[k], implementation.full_state(k * N + c).effect, c);
+
+    for(int32_t i = 0; i < n; i++)
+    {
+      // All the inputs are fetched before any output is written,
+      // as hosts may reuse input buffers as output buffers
+      for(int k = 0; k < packs; k++)
+      {
+        auto& frame = lanes.frame[k];
+        for(int c = 0; c < N; c++)
+        {
+          const int channel = k * N + c;
+          frame[c] = channel < channels ? in[channel][i] : FP{};
+        }
+      }
+
+      // Process the various parameters
+      process_smooth(implementation, params...);
+
+      for(int k = 0; k < packs; k++)
+        lanes.frame[k] = process_lane(lanes.packs[k], lanes.frame[k], ins);
+
+      for(int k = 0; k < packs; k++)
+      {
+        const auto& frame = lanes.frame[k];
+        for(int c = 0; c < N && k * N + c < channels; c++)
+          out[k * N + c][i] = frame[c];
+      }
+    }
+
+    for(int k = 0; k < packs; k++)
+      for(int c = 0; c < N && k * N + c < channels; c++)
+        transfer::store(lanes.packs[k], implementation.full_state(k * N + c).effect, c);
+  }
+};
+}
@@ -57,7 +57,7 @@ struct process_adapter<T> : audio_buffer_storage<T>
     o_info::for_all(ports, [&](auto& bus) {
       if(k + 1 <= buffers.size())
       {
-        std::copy_n(bus.channel, n, buffers[k]);
+        avnd::convert_samples(bus.channel, buffers[k], n);
       }
       k++;
     });
@@ -90,8 +90,7 @@ struct process_adapter<T> : audio_buffer_storage<T>
         auto i_conv = (DstFP**)alloca(sizeof(DstFP*) * (1 + input_channels));
         for(int c = 0; c < input_channels; ++c)
         {
-          i_conv[c] = dsp_buffer_input.data() + c * n;
-          std::copy_n(in[c], n, i_conv[c]);
+          i_conv[c] = dsp_buffer_input.load(c, in[c], n);
         }
 
         initialize_busses<i_info, true>(ins, avnd::span<DstFP*>(i_conv, input_channels));
@@ -106,7 +105,7 @@ struct process_adapter<T> : audio_buffer_storage<T>
         auto o_conv = (DstFP**)alloca(sizeof(DstFP*) * (1 + output_channels));
         for(int c = 0; c < output_channels; ++c)
         {
-          o_conv[c] = dsp_buffer_output.data() + c * n;
+          o_conv[c] = dsp_buffer_output.channel(c);
         }
 
         initialize_busses<o_info, false>(
@@ -137,7 +136,7 @@ struct process_adapter<T> : audio_buffer_storage<T>
       const auto& tick, auto&&... params)
   {
     // Process the various parameters
-    process_smooth(implementation, params...);
+    process_smooth(implementation, int(get_frames(tick)), params...);
 
     // Note: here we have a redundant check. This is to make sure that we always check the case
     // where we won't have to do a conversion first.
@@ -3,6 +3,7 @@
 /* SPDX-License-Identifier: GPL-3.0-or-later */
 
 #include <avnd/wrappers/process/base.hpp>
+#include <avnd/wrappers/process/lane_packed.hpp>
 
 namespace avnd
 {
@@ -16,9 +17,18 @@ template <typename T>
       || avnd::mono_per_sample_arg_processor<float, T>)
 struct process_adapter<T>
 {
-  void allocate_buffers(process_setup setup, auto&& f)
+  AVND_NO_UNIQUE_ADDRESS simd_lane_execution<T> m_lanes;
+  AVND_NO_UNIQUE_ADDRESS channel_major_smoothing<T> m_smoothing;
+
+  template <std::floating_point SrcFP>
+  void allocate_buffers(process_setup setup, SrcFP f)
   {
-    // No buffer to allocates here
+    // Only the smoothing of channel-major processors needs storage
+    if constexpr(avnd::tag_channel_major<T>)
+      m_smoothing.reserve(setup.frames_per_buffer);
+
+    // Only lane-generic processors need storage, for their packs
+    m_lanes.reserve(setup, f);
   }
 
   template <typename FP>
@@ -55,6 +65,47 @@ struct process_adapter<T>
       static_assert(std::is_void_v<FP>, "Canno call processor");
   }
 
+  template <std::floating_point FP>
+  void process_channel_major(
+      avnd::effect_container<T>& implementation, avnd::span<FP*> in, avnd::span<FP*> out,
+      const auto& tick, auto&&... params)
+  {
+    const int channels = in.size();
+    const auto n = get_frames(tick);
+
+    // The controls are shared by all the channel instances:
+    // the smoothing steps of the block are computed once for all of them.
+    m_smoothing.start(get_smooth_storage(implementation, params...), n);
+
+    auto effects_range = implementation.full_state();
+    auto effects_it = effects_range.begin();
+    for(int c = 0; c < channels && effects_it != effects_range.end(); ++c, ++effects_it)
+    {
+      auto [impl, ins, outs] = *effects_it;
+      static_assert(std::is_reference_v<decltype(impl)>);
+      const FP* const in_c = in[c];
+      FP* const out_c = out[c];
+
+      if constexpr(avnd::has_tick<T>)
+      {
+        const auto t = get_tick_or_frames(implementation, tick);
+        for(int32_t i = 0; i < n; i++)
+        {
+          m_smoothing.set(ins, i);
+          out_c[i] = process_sample(in_c[i], impl, ins, outs, t);
+        }
+      }
+      else
+      {
+        for(int32_t i = 0; i < n; i++)
+        {
+          m_smoothing.set(ins, i);
+          out_c[i] = process_sample(in_c[i], impl, ins, outs);
+        }
+      }
+    }
+  }
+
   template <std::floating_point FP>
   void process(
       avnd::effect_container<T>& implementation, avnd::span<FP*> in, avnd::span<FP*> out,
@@ -66,6 +117,18 @@ struct process_adapter<T>
     const int channels = input_channels;
     const auto n = get_frames(tick);
 
+    if(m_lanes.process(implementation, in, out, n, params...))
+      return;
+
+    if constexpr(avnd::tag_channel_major<T>)
+    {
+      if(channels_are_independent(in, out) && m_smoothing.fits(n))
+      {
+        process_channel_major(implementation, in, out, tick, params...);
+        return;
+      }
+    }
+
     auto input_buf = (FP*)alloca((1 + channels) * sizeof(FP));
 
     for(int32_t i = 0; i < n; i++)
@@ -3,6 +3,7 @@
 /* SPDX-License-Identifier: GPL-3.0-or-later */
 
 #include <avnd/wrappers/process/base.hpp>
+#include <avnd/wrappers/process/lane_packed.hpp>
 
 namespace avnd
 {
@@ -16,9 +17,18 @@ template <typename T>
       || avnd::mono_per_sample_port_processor<float, T>)
 struct process_adapter<T>
 {
-  void allocate_buffers(process_setup setup, auto&& f)
+  AVND_NO_UNIQUE_ADDRESS simd_lane_execution<T> m_lanes;
+  AVND_NO_UNIQUE_ADDRESS channel_major_smoothing<T> m_smoothing;
+
+  template <std::floating_point SrcFP>
+  void allocate_buffers(process_setup setup, SrcFP f)
   {
-    // No buffer to allocates here
+    // Only the smoothing of channel-major processors needs storage
+    if constexpr(avnd::tag_channel_major<T>)
+      m_smoothing.reserve(setup.frames_per_buffer);
+
+    // Only lane-generic processors need storage, for their packs
+    m_lanes.reserve(setup, f);
   }
 
   // Here we know that we at least have one in and one out
@@ -61,6 +71,46 @@ struct process_adapter<T>
     return out;
   }
 
+  template <std::floating_point FP>
+  void process_channel_major(
+      avnd::effect_container<T>& implementation, avnd::span<FP*> in, avnd::span<FP*> out,
+      const auto& tick, auto&&... params)
+  {
+    const int channels = in.size();
+    const auto n = get_frames(tick);
+
+    // The controls are shared by all the channel instances:
+    // the smoothing steps of the block are computed once for all of them.
+    m_smoothing.start(get_smooth_storage(implementation, params...), n);
+
+    auto effects_range = implementation.full_state();
+    auto effects_it = effects_range.begin();
+    for(int c = 0; c < channels && effects_it != effects_range.end(); ++c, ++effects_it)
+    {
+      auto&& ref = *effects_it;
+      const FP* const in_c = in[c];
+      FP* const out_c = out[c];
+
+      if constexpr(avnd::has_tick<T>)
+      {
+        const auto t = get_tick_or_frames(implementation, tick);
+        for(int32_t i = 0; i < n; i++)
+        {
+          m_smoothing.set(ref.inputs, i);
+          out_c[i] = process_0(implementation, in_c[i], ref, t);
+        }
+      }
+      else
+      {
+        for(int32_t i = 0; i < n; i++)
+        {
+          m_smoothing.set(ref.inputs, i);
+          out_c[i] = process_0(implementation, in_c[i], ref);
+        }
+      }
+    }
+  }
+
   template <std::floating_point FP>
   void process(
       avnd::effect_container<T>& implementation, avnd::span<FP*> in, avnd::span<FP*> out,
@@ -70,10 +120,23 @@ struct process_adapter<T>
     const int output_channels = out.size();
     assert(input_channels == output_channels);
     const int channels = input_channels;
+    const auto n = get_frames(tick);
+
+    // The lane version takes the sample pack directly instead of the ports
+    if(m_lanes.process(implementation, in, out, n, params...))
+      return;
+
+    if constexpr(avnd::tag_channel_major<T>)
+    {
+      if(channels_are_independent(in, out) && m_smoothing.fits(n))
+      {
+        process_channel_major(implementation, in, out, tick, params...);
+        return;
+      }
+    }
 
     auto input_buf = (FP*)alloca((1 + channels) * sizeof(FP));
 
-    const auto n = get_frames(tick);
     for(int32_t i = 0; i < n; i++)
     {
       // Some hosts like puredata uses the same buffers for input and output.
@@ -103,7 +166,8 @@ struct process_adapter<T>
         if constexpr(avnd::has_tick<T>)
         {
           out[c][i] = process_0(
-              implementation, input_buf[c], *effects_it, current_tick(implementation));
+              implementation, input_buf[c], *effects_it,
+              get_tick_or_frames(implementation, tick));
         }
         else
         {
@@ -39,13 +39,12 @@ struct process_adapter<T> : audio_buffer_storage<T>
       // Copy & convert input channels
       for(int c = 0; c < input_channels; ++c)
       {
-        in_samples[c] = dsp_buffer_input.data() + c * n;
-        std::copy_n(in[c], n, in_samples[c]);
+        in_samples[c] = dsp_buffer_input.load(c, in[c], n);
       }
 
       for(int c = 0; c < output_channels; ++c)
       {
-        out_samples[c] = dsp_buffer_output.data() + c * n;
+        out_samples[c] = dsp_buffer_output.channel(c);
       }
 
       implementation.effect(
@@ -54,7 +53,7 @@ struct process_adapter<T> : audio_buffer_storage<T>
       // Copy & convert output channels
       for(int c = 0; c < output_channels; ++c)
       {
-        std::copy_n(out_samples[c], n, out[c]);
+        avnd::convert_samples(out_samples[c], out[c], n);
       }
     }
     else
@@ -71,7 +70,7 @@ struct process_adapter<T> : audio_buffer_storage<T>
       const auto& tick, auto&&... params)
   {
     // Process the various parameters
-    process_smooth(implementation, params...);
+    process_smooth(implementation, int(get_frames(tick)), params...);
 
     // Note: here we have a redundant check. This is to make sure that we always check the case
     // where we won't have to do a conversion first.
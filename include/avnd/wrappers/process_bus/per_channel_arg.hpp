@@ -36,7 +36,7 @@ struct process_bus_adapter<T>
       const auto& tick, auto&&... params)
   {
     // Process the various parameters
-    process_smooth(implementation, params...);
+    process_smooth(implementation, int(get_frames(tick)), params...);
 
     const int input_channels = in.size();
     const int output_channels = out.size();
@@ -51,14 +51,13 @@ struct process_bus_adapter<T> : audio_buffer_storage<T>
       // Copy & convert input channels
       for(int c = 0; c < input_channels; ++c)
       {
-        auto in_ptr = dsp_buffer_input.data() + c * n;
-        std::copy_n(in[c], n, in_ptr);
+        auto in_ptr = dsp_buffer_input.load(c, in[c], n);
         in_port.samples[c] = const_cast<input_fp_type*>(in_ptr);
       }
 
       for(int c = 0; c < output_channels; ++c)
       {
-        out_port.samples[c] = dsp_buffer_output.data() + c * n;
+        out_port.samples[c] = dsp_buffer_output.channel(c);
       }
 
       invoke_effect(implementation, get_tick_or_frames(implementation, tick));
@@ -66,7 +65,7 @@ struct process_bus_adapter<T> : audio_buffer_storage<T>
       // Copy & convert output channels
       for(int c = 0; c < output_channels; ++c)
       {
-        std::copy_n(out_port.samples[c], n, out[c]);
+        avnd::convert_samples(out_port.samples[c], out[c], n);
       }
     }
     else
@@ -92,7 +91,7 @@ struct process_bus_adapter<T> : audio_buffer_storage<T>
       const auto& tick, auto&&... params)
   {
     // Process the various parameters
-    process_smooth(implementation, params...);
+    process_smooth(implementation, int(get_frames(tick)), params...);
 
     // Note: here we have a redundant check. This is to make sure that we always check the case
     // where we won't have to do a conversion first.
@@ -145,8 +144,7 @@ struct process_bus_adapter<T> : audio_buffer_storage<T>
       // Copy & convert input channels
       for(int c = 0; c < input_channels; ++c)
       {
-        auto in_ptr = dsp_buffer_input.data() + c * n;
-        std::copy_n(in[c], n, in_ptr);
+        auto in_ptr = dsp_buffer_input.load(c, in[c], n);
         in_port.samples[c] = const_cast<input_fp_type*>(in_ptr);
       }
 
@@ -281,7 +279,7 @@ struct process_bus_adapter<T> : audio_buffer_storage<T>
       if(k + channels <= buffers.size() && bus.samples)
       {
         for(int c = 0; c < channels; c++)
-          std::copy_n(bus.samples[c], n, buffers[k + c]);
+          avnd::convert_samples(bus.samples[c], buffers[k + c], n);
       }
       k += channels;
     });
@@ -315,8 +313,7 @@ struct process_bus_adapter<T> : audio_buffer_storage<T>
         auto i_conv = (DstFP**)alloca(sizeof(DstFP*) * input_channels);
         for(int c = 0; c < input_channels; ++c)
         {
-          i_conv[c] = dsp_buffer_input.data() + c * n;
-          std::copy_n(in[c], n, i_conv[c]);
+          i_conv[c] = dsp_buffer_input.load(c, in[c], n);
         }
 
         initialize_busses<i_info, true>(
@@ -332,7 +329,7 @@ struct process_bus_adapter<T> : audio_buffer_storage<T>
         auto o_conv = (DstFP**)alloca(sizeof(DstFP*) * output_channels);
         for(int c = 0; c < output_channels; ++c)
         {
-          o_conv[c] = dsp_buffer_output.data() + c * n;
+          o_conv[c] = dsp_buffer_output.channel(c);
         }
 
         initialize_busses<o_info, false>(
@@ -365,7 +362,7 @@ struct process_bus_adapter<T> : audio_buffer_storage<T>
       const auto& tick, const auto&... params)
   {
     // Process the various parameters
-    process_smooth(implementation, params...);
+    process_smooth(implementation, int(get_frames(tick)), params...);
 
     // Note: here we have a redundant check. This is to make sure that we always check the case
     // where we won't have to do a conversion first.
@@ -7,6 +7,7 @@
 #include <avnd/introspection/channels.hpp>
 #include <avnd/introspection/input.hpp>
 #include <avnd/introspection/output.hpp>
+#include <avnd/wrappers/audio_buffer.hpp>
 
 #include <concepts>
 #include <cstdint>
@@ -64,9 +65,7 @@ struct needs_storage<double, T> : std::true_type
 template <typename FP, typename T>
 using buffer_type = std::conditional_t<
     needs_storage<FP, T>::value,
-    std::vector<typename needs_storage<FP, T>::needed_storage_t> // TODO aligned alloc
-    ,
-    dummy>;
+    audio_scratch<typename needs_storage<FP, T>::needed_storage_t>, dummy>;
 
 template <typename T, typename Tick>
   requires requires(Tick t) { t.frames(); }
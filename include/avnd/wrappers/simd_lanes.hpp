@@ -0,0 +1,89 @@
+#pragma once
+
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+#include <avnd/common/aggregates.hpp>
+#include <halp/simd.hpp>
+
+#include <type_traits>
+#include <utility>
+
+namespace avnd
+{
+// 256-bit packs: 8 float channels or 4 double channels per lane instance
+template <typename FP>
+inline constexpr int simd_lane_count = 32 / sizeof(FP);
+
+template <typename FP>
+using simd_lane_type = halp::simd<FP, simd_lane_count<FP>>;
+
+// Sum of the lanes of a pack
+template <typename FP, int N>
+constexpr FP horizontal_sum(const halp::simd<FP, N>& x) noexcept
+{
+  FP res{};
+  for(int i = 0; i < N; i++)
+    res += x.v[i];
+  return res;
+}
+
+/**
+ * Moves state between the lanes of a lane-generic processor and its scalar
+ * instances: T::lanes<V> must have the same fields as T, with V in place of FP.
+ *
+ * load() puts scalar in lane c. store() writes lane c back to scalar.
+ * Fields of any other type are shared by the lanes: they are taken from the
+ * scalar instance of lane 0 and are not written back.
+ */
+template <std::floating_point FP, int N>
+struct simd_lane_transfer
+{
+  using pack_type = halp::simd<FP, N>;
+
+  template <typename L, typename S>
+  static void load(L& lane, const S& scalar, int c) noexcept
+  {
+    if constexpr(std::is_same_v<L, pack_type> && std::is_same_v<S, FP>)
+      lane[c] = scalar;
+    else if constexpr(std::is_array_v<L>)
+      for(std::size_t i = 0; i < std::extent_v<L>; i++)
+        load(lane[i], scalar[i], c);
+    else if constexpr(std::is_assignable_v<L&, const S&>)
+    {
+      if(c == 0)
+        lane = scalar;
+    }
+    else
+      for_each_field(lane, scalar, [c](auto& l, const auto& s) { load(l, s, c); });
+  }
+
+  template <typename L, typename S>
+  static void store(const L& lane, S& scalar, int c) noexcept
+  {
+    if constexpr(std::is_same_v<L, pack_type> && std::is_same_v<S, FP>)
+      scalar = lane[c];
+    else if constexpr(std::is_array_v<L>)
+      for(std::size_t i = 0; i < std::extent_v<L>; i++)
+        store(lane[i], scalar[i], c);
+    else if constexpr(!std::is_assignable_v<L&, const S&>)
+      for_each_field(lane, scalar, [c](const auto& l, auto& s) { store(l, s, c); });
+  }
+
+private:
+  template <typename L, typename S, typename F>
+  static void for_each_field(L& lane, S& scalar, F f) noexcept
+  {
+    using lane_type = std::remove_const_t<L>;
+    using scalar_type = std::remove_const_t<S>;
+    static_assert(
+        std::is_aggregate_v<lane_type> && std::is_aggregate_v<scalar_type>
+            && avnd::pfr::tuple_size_v<lane_type>
+                   == avnd::pfr::tuple_size_v<scalar_type>,
+        "The lanes of a processor must have the same fields as the processor, "
+        "with the sample pack type in place of its floating-point type");
+    [&]<std::size_t... I>(std::index_sequence<I...>) {
+      (f(avnd::pfr::get<I>(lane), avnd::pfr::get<I>(scalar)), ...);
+    }(std::make_index_sequence<avnd::pfr::tuple_size_v<lane_type>>{});
+  }
+};
+}
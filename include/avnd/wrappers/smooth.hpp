@@ -10,7 +10,9 @@
 #include <avnd/wrappers/avnd.hpp>
 #include <cmath>
 
+#include <algorithm>
 #include <chrono>
+#include <vector>
 namespace avnd
 {
 // Field: struct { float smoothing_ratio(); T value; }
@@ -26,6 +28,71 @@ struct smooth_param_storage_type
   double smooth_rate{}; // exp(-2pi / (0.0001 * smooth * fs))
 };
 
+// Field: struct { float smoothing_ratio(); float value; std::span<float> ramp; }
+// This gives us in addition a buffer for the per-sample values of the ramp.
+template <smooth_ramp_parameter_port Field>
+struct smooth_param_storage_type<Field>
+{
+  smooth_param_value_type<Field> current_value;
+  smooth_param_value_type<Field> target_value;
+  double smooth_rate{}; // per-sample once reserve_ramps has been called
+
+  // Linear smoothing: number of samples to reach the target, 0 if exponential
+  int linear_samples{};
+  int linear_remaining{};
+  double linear_increment{};
+
+  std::vector<smooth_param_value_type<Field>> ramp;
+};
+
+// The values of a smoother after each step of a buffer
+template <typename Field>
+using smooth_param_values = std::vector<smooth_param_value_type<Field>>;
+
+/**
+ * Fills out[i] with the i+1-th step of the one-pole smoother
+ * current = target - rate * (target - current).
+ *
+ * Uses the closed form target - rate^(i+1) * (target - current) so that
+ * the inner loop has no dependency between samples.
+ */
+template <std::floating_point FP>
+void fill_exponential_ramp(FP* out, int frames, FP current, FP target, double rate)
+{
+  static constexpr int W = 8;
+  double powers[W];
+  powers[0] = rate;
+  for(int k = 1; k < W; k++)
+    powers[k] = powers[k - 1] * rate;
+  const double stride = powers[W - 1];
+  const double delta = double(target) - double(current);
+
+  int i = 0;
+  for(; i + W <= frames; i += W)
+  {
+    for(int k = 0; k < W; k++)
+      out[i + k] = FP(target - powers[k] * delta);
+    for(int k = 0; k < W; k++)
+      powers[k] *= stride;
+  }
+  for(int k = 0; i < frames; i++, k++)
+    out[i] = FP(target - powers[k] * delta);
+}
+
+/**
+ * Fills out[i] with current + (i+1) * increment, for the first `remaining`
+ * samples, and with target afterwards.
+ */
+template <std::floating_point FP>
+void fill_linear_ramp(
+    FP* out, int frames, FP current, FP target, double increment, int remaining)
+{
+  const int n = std::min(frames, remaining);
+  for(int i = 0; i < n; i++)
+    out[i] = FP(current + (i + 1) * increment);
+  std::fill(out + n, out + frames, target);
+}
+
 template <typename T>
 struct smooth_param_storage
 {
@@ -51,37 +118,77 @@ struct smooth_storage : smooth_param_storage<T>
 {
   using smooth_in = smooth_parameter_input_introspection<T>;
 
+  // rate: how many times per second smooth_all is called
+  template <typename M>
+  static double compute_smooth_rate(double rate)
+  {
+    const auto ratio = -2. * avnd::pi / (1e-3f * rate);
+    static constexpr auto smooth = avnd::get_smooth<M>();
+
+    if constexpr(requires { smooth.ratio(0.); })
+    {
+      return smooth.ratio(rate);
+    }
+    else if constexpr(requires { smooth.duration; })
+    {
+      static_assert(smooth.duration > std::chrono::milliseconds(0));
+      return std::exp(
+          ratio
+          / std::chrono::duration_cast<std::chrono::milliseconds>(smooth.duration)
+                .count());
+    }
+    else
+    {
+      static_assert(smooth.milliseconds > 0.);
+      return std::exp(ratio / smooth.milliseconds);
+    }
+  }
+
   void init(avnd::effect_container<T>& t, double sample_rate)
   {
     if constexpr(smooth_in::size > 0)
     {
-      const auto ratio = -2. * avnd::pi / (1e-3f * sample_rate);
-
       auto init_smooth = [&]<auto Idx, typename M>(M & port, avnd::predicate_index<Idx>)
       {
         auto& buf = tpl::get<Idx>(this->smoothed_inputs);
+        buf.smooth_rate = compute_smooth_rate<M>(sample_rate);
+      };
+      smooth_in::for_all_n(avnd::get_inputs(t), init_smooth);
+    }
+  }
 
-        static constexpr auto smooth = avnd::get_smooth<M>();
-
-        if constexpr(requires { smooth.ratio(0.); })
-        {
-          buf.smooth_rate = smooth.ratio(sample_rate);
-        }
-        else if constexpr(requires { smooth.duration; })
-        {
-          static_assert(smooth.duration > std::chrono::milliseconds(0));
-          buf.smooth_rate = std::exp(
-              ratio
-              / std::chrono::duration_cast<std::chrono::milliseconds>(smooth.duration)
-                    .count());
-        }
-        else
+  /**
+   * Ports with a ramp get the smoothed value of every sample of the buffer,
+   * whatever the rate at which smooth_all is called: they need the actual
+   * sample rate, and room for a whole buffer. Must be called before processing,
+   * outside of the audio thread.
+   */
+  void reserve_ramps(avnd::effect_container<T>& t, double sample_rate, int buffer_size)
+  {
+    if constexpr(smooth_in::size > 0)
+    {
+      auto init_ramp = [&]<auto Idx, typename M>(M & port, avnd::predicate_index<Idx>)
+      {
+        if constexpr(smooth_ramp_parameter_port<M>)
         {
-          static_assert(smooth.milliseconds > 0.);
-          buf.smooth_rate = std::exp(ratio / smooth.milliseconds);
+          auto& buf = tpl::get<Idx>(this->smoothed_inputs);
+          static constexpr auto smooth = avnd::get_smooth<M>();
+          if constexpr(requires { smooth.linear; })
+          {
+            static_assert(smooth.milliseconds > 0.);
+            buf.linear_samples
+                = std::max(1, int(std::round(1e-3 * smooth.milliseconds * sample_rate)));
+          }
+          else
+          {
+            buf.smooth_rate = compute_smooth_rate<M>(sample_rate);
+          }
+
+          buf.ramp.resize(buffer_size);
+          port.ramp = {};
         }
       };
-      smooth_in::for_all_n(avnd::get_inputs(t), init_smooth);
+      smooth_in::for_all_n(avnd::get_inputs(t), init_ramp);
     }
   }
 
@@ -92,8 +199,23 @@ struct smooth_storage : smooth_param_storage<T>
     smooth_param_storage_type<Field>& storage = get<npredicate>(this->smoothed_inputs);
 
     storage.target_value = next;
+
+    if constexpr(smooth_ramp_parameter_port<Field>)
+    {
+      if(storage.linear_samples > 0)
+      {
+        storage.linear_remaining = storage.linear_samples;
+        storage.linear_increment
+            = (double(storage.target_value) - double(storage.current_value))
+              / storage.linear_samples;
+      }
+    }
   }
 
+  /**
+   * Advances the smoothing by one step.
+   * Ports with a ramp are advanced by one sample and get no ramp.
+   */
   void smooth_all(avnd::effect_container<T>& t)
   {
     if constexpr(smooth_in::size > 0)
@@ -103,13 +225,146 @@ struct smooth_storage : smooth_param_storage<T>
       {
         smooth_param_storage_type<M>& storage = get<Idx>(this->smoothed_inputs);
 
-        storage.current_value
-            = storage.target_value
-              - storage.smooth_rate * (storage.target_value - storage.current_value);
+        step(storage);
+        if constexpr(smooth_ramp_parameter_port<M>)
+          field.ramp = {};
         field.value = storage.current_value;
       };
       smooth_in::for_all_n(avnd::get_inputs(t), process_smooth);
     }
   }
+
+  /**
+   * Advances the smoothing by `frames` steps, as that many calls to the
+   * one-step smooth_all() would, without writing to the processor.
+   * values: one buffer of at least `frames` elements per smoothed input,
+   * which gets the value after each step.
+   */
+  void smooth_steps(auto& values, int frames) noexcept
+  {
+    [&]<std::size_t... I>(std::index_sequence<I...>) {
+      (step_values(tpl::get<I>(this->smoothed_inputs), tpl::get<I>(values), frames),
+       ...);
+    }(std::make_index_sequence<smooth_in::size>{});
+  }
+
+  /**
+   * Advances the smoothing for a buffer of `frames` samples.
+   * Ports with a ramp get the per-sample values in their ramp, or an empty ramp
+   * if the value has converged or the buffer is larger than reserved in
+   * reserve_ramps(), and the last value of the buffer in their value.
+   */
+  void smooth_all(avnd::effect_container<T>& t, int frames)
+  {
+    if constexpr(smooth_in::size > 0)
+    {
+      auto process_smooth
+          = [this, frames]<auto Idx, typename M>(M & field, avnd::predicate_index<Idx> idx)
+      {
+        smooth_param_storage_type<M>& storage = get<Idx>(this->smoothed_inputs);
+
+        if constexpr(smooth_ramp_parameter_port<M>)
+        {
+          // The smoother always advances by the whole buffer. If it is larger
+          // than reserved, the port gets no ramp and only the final value.
+          const int n = smooth_ramp(storage, frames);
+          field.ramp = {storage.ramp.data(), std::size_t(n)};
+        }
+        else
+        {
+          storage.current_value
+              = storage.target_value
+                - storage.smooth_rate * (storage.target_value - storage.current_value);
+        }
+        field.value = storage.current_value;
+      };
+      smooth_in::for_all_n(avnd::get_inputs(t), process_smooth);
+    }
+  }
+
+private:
+  // One step: one sample for ports with a ramp
+  template <typename Storage>
+  static void step(Storage& storage) noexcept
+  {
+    if constexpr(requires { storage.ramp; })
+    {
+      smooth_ramp(storage, 1);
+    }
+    else
+    {
+      storage.current_value
+          = storage.target_value
+            - storage.smooth_rate * (storage.target_value - storage.current_value);
+    }
+  }
+
+  template <typename Storage>
+  static void step_values(Storage& storage, auto& values, int frames) noexcept
+  {
+    for(int i = 0; i < frames; i++)
+    {
+      step(storage);
+      values[i] = storage.current_value;
+    }
+  }
+
+  // Returns the number of ramp samples written: 0 when the value has converged
+  template <typename Storage>
+  static int smooth_ramp(Storage& storage, int frames)
+  {
+    using value_type = decltype(storage.current_value);
+    const value_type current = storage.current_value;
+    const value_type target = storage.target_value;
+    if(frames <= 0)
+      return 0;
+
+    if(storage.linear_samples > 0)
+    {
+      if(storage.linear_remaining <= 0)
+      {
+        storage.current_value = target;
+        return 0;
+      }
+
+      const int remaining = storage.linear_remaining;
+      const bool fill = storage.ramp.size() >= std::size_t(frames);
+      if(fill)
+        fill_linear_ramp(
+            storage.ramp.data(), frames, current, target, storage.linear_increment,
+            remaining);
+
+      storage.linear_remaining = std::max(0, remaining - frames);
+      storage.current_value
+          = storage.linear_remaining > 0
+                ? value_type(current + frames * storage.linear_increment)
+                : target;
+      return fill ? frames : 0;
+    }
+    else
+    {
+      // Close enough: snap to the target and stop computing ramps
+      const value_type epsilon = value_type(1e-6) * (value_type(1) + std::abs(target));
+      if(std::abs(target - current) <= epsilon)
+      {
+        storage.current_value = target;
+        return 0;
+      }
+
+      if(storage.ramp.size() >= std::size_t(frames))
+      {
+        fill_exponential_ramp(
+            storage.ramp.data(), frames, current, target, storage.smooth_rate);
+        storage.current_value = storage.ramp[frames - 1];
+        return frames;
+      }
+      else
+      {
+        storage.current_value = value_type(
+            target - std::pow(storage.smooth_rate, frames) * (target - current));
+        return 0;
+      }
+    }
+  }
 };
 }
@@ -0,0 +1,594 @@
+#pragma once
+
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+#include <avnd/common/span_polyfill.hpp>
+#include <avnd/concepts/audio_port.hpp>
+#include <avnd/concepts/fft.hpp>
+#include <avnd/introspection/input.hpp>
+#include <avnd/introspection/port.hpp>
+#include <avnd/wrappers/effect_container.hpp>
+#include <avnd/wrappers/window.hpp>
+#include <halp/fft.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <complex>
+#include <vector>
+
+namespace avnd
+{
+/**
+ * Streaming short-time Fourier transform.
+ *
+ * Samples are pushed in blocks of any size; every `hop` samples the last
+ * `fft_size` samples are windowed and transformed, and the spectrum is passed
+ * to a callback. The analysis window is normalized by its sum, so that a
+ * full-scale sine gives bins of magnitude 0.5 whatever the window.
+ *
+ * When an output buffer is given, the spectra (possibly modified by the
+ * callback, bins 0 to fft_size / 2) are transformed back and overlap-added:
+ * with a window whose overlapped copies sum to a constant at this hop
+ * (rectangular, or Hann / Hamming with hop = fft_size / 2 or fft_size / 4)
+ * the output is the input, delayed by latency() samples.
+ *
+ * Everything is allocated in reset().
+ */
+template <std::floating_point FP, typename FFT = halp::fft<FP>>
+class stft
+{
+public:
+  using complex_type = std::complex<FP>;
+
+  void reset(int fft_size, int hop, window_kind window)
+  {
+    m_size = std::max(fft_size, 2);
+    m_hop = std::clamp(hop, 1, m_size);
+    m_fill = 0;
+
+    m_window.resize(m_size);
+    fill_window(window, m_window.data(), m_size);
+    FP sum{};
+    for(FP w : m_window)
+      sum += w;
+    for(FP& w : m_window)
+      w /= sum;
+
+    m_input.assign(m_size, FP{});
+    m_frame.assign(m_size, FP{});
+    m_overlap.assign(m_size, FP{});
+    m_ready.assign(m_hop, FP{});
+    m_fft.reset(m_size);
+
+    // Each output sample is the sum of fft_size / hop frames, each
+    // weighted by the window normalized by its sum
+    m_resynthesis_gain = FP(m_hop * m_fft.normalization(m_size));
+  }
+
+  int fft_size() const noexcept { return m_size; }
+  int hop() const noexcept { return m_hop; }
+  int bins() const noexcept { return m_size / 2 + 1; }
+
+  // Delay between an input sample and the matching resynthesized sample
+  int latency() const noexcept { return m_size; }
+
+  /**
+   * in: frames input samples, or nullptr for silence.
+   * out: frames resynthesized samples, or nullptr for analysis only.
+   * on_frame: called with the complex_type* spectrum of each new frame.
+   */
+  template <typename In, typename Out, typename F>
+  void process(const In* in, Out* out, int frames, F&& on_frame) noexcept
+  {
+    FP* const incoming = m_input.data() + (m_size - m_hop);
+    int i = 0;
+    while(i < frames)
+    {
+      const int n = std::min(frames - i, m_hop - m_fill);
+      if(in)
+        for(int j = 0; j < n; j++)
+          incoming[m_fill + j] = FP(in[i + j]);
+      else
+        std::fill_n(incoming + m_fill, n, FP{});
+
+      // After reading the input: out may be the same buffer as in
+      if(out)
+        for(int j = 0; j < n; j++)
+          out[i + j] = Out(m_ready[m_fill + j]);
+
+      m_fill += n;
+      i += n;
+      if(m_fill == m_hop)
+      {
+        m_fill = 0;
+        run_frame(out != nullptr, on_frame);
+      }
+    }
+  }
+
+  template <typename In, typename F>
+  void process(const In* in, int frames, F&& on_frame) noexcept
+  {
+    process(in, static_cast<FP*>(nullptr), frames, on_frame);
+  }
+
+private:
+  template <typename F>
+  void run_frame(bool resynthesize, F& on_frame) noexcept
+  {
+    const int N = m_size;
+    const int H = m_hop;
+    for(int n = 0; n < N; n++)
+      m_frame[n] = m_input[n] * m_window[n];
+    std::copy(m_input.begin() + H, m_input.end(), m_input.begin());
+
+    complex_type* spectrum = m_fft.execute(m_frame.data(), N);
+    on_frame(spectrum);
+
+    if(resynthesize)
+    {
+      const FP* y = m_fft.execute(spectrum, N);
+      for(int n = 0; n < N; n++)
+        m_overlap[n] += m_resynthesis_gain * y[n];
+
+      // The first hop samples have received the contribution of every frame
+      std::copy_n(m_overlap.begin(), H, m_ready.begin());
+      std::copy(m_overlap.begin() + H, m_overlap.end(), m_overlap.begin());
+      std::fill(m_overlap.end() - H, m_overlap.end(), FP{});
+    }
+  }
+
+  FFT m_fft;
+  std::vector<FP> m_window;
+  std::vector<FP> m_input;
+  std::vector<FP> m_frame;
+  std::vector<FP> m_overlap;
+  std::vector<FP> m_ready;
+  FP m_resynthesis_gain{};
+  int m_size{};
+  int m_hop{};
+  int m_fill{};
+};
+
+template <typename Field>
+concept stft_analysis_port
+    = spectrum_split_channel_port<Field> || spectrum_complex_channel_port<Field>
+      || spectrum_split_bus_port<Field> || spectrum_complex_bus_port<Field>;
+
+/**
+ * FFT size and hop used for a spectrum port. Ports can set them with e.g.
+ * static constexpr int fft_size() { return 2048; }
+ * static constexpr int hop() { return 512; }
+ *
+ * Otherwise the FFT covers the host buffer size, rounded up to a power of
+ * two, with a hop of half the FFT size.
+ */
+template <typename Field>
+int stft_size_for(int buffer_size) noexcept
+{
+  if constexpr(requires { Field::fft_size(); })
+    return Field::fft_size();
+  else
+    return int(std::bit_ceil(unsigned(std::max(buffer_size, 2))));
+}
+
+template <typename Field>
+int stft_hop_for(int fft_size) noexcept
+{
+  if constexpr(requires { Field::hop(); })
+    return Field::hop();
+  else
+    return fft_size / 2;
+}
+
+/**
+ * Spectrum ports whose frames are transformed back to audio, with
+ * static constexpr bool resynthesize() { return true; }
+ *
+ * The samples of such a port are then the overlap-add of its frames instead
+ * of the host input, delayed by the FFT size. A port can modify each frame
+ * before it is resynthesized with e.g. void on_frame(MyProcessor& self);
+ * it is called with the bins of the frame in the spectrum arrays.
+ */
+template <typename Field>
+consteval bool stft_resynthesizes() noexcept
+{
+  if constexpr(requires { Field::resynthesize(); })
+    return Field::resynthesize();
+  else
+    return false;
+}
+
+// Type of the bins of complex spectrum ports
+template <typename Field>
+struct stft_bin_type
+{
+  using type = std::complex<double>;
+};
+
+template <typename Field>
+  requires spectrum_complex_channel_port<Field>
+struct stft_bin_type<Field>
+{
+  using type = std::remove_cvref_t<decltype(std::declval<Field&>().spectrum.bin[0])>;
+};
+
+template <typename Field>
+  requires spectrum_complex_bus_port<Field>
+struct stft_bin_type<Field>
+{
+  using type = std::remove_cvref_t<decltype(std::declval<Field&>().spectrum.bin[0][0])>;
+};
+
+/**
+ * State for one audio input: nothing unless it is a spectrum port.
+ */
+template <typename Field>
+struct stft_port_storage
+{
+};
+
+template <stft_analysis_port Field>
+struct stft_port_storage<Field>
+{
+  using bin_type = typename stft_bin_type<Field>::type;
+
+  struct channel
+  {
+    stft<double> analysis;
+
+    // Latest frame, as the port expects it
+    std::vector<bin_type> bins;
+    std::vector<double> real;
+    std::vector<double> imag;
+
+    // Resynthesized samples of the current block, at the host precision
+    std::vector<float> output_f;
+    std::vector<double> output_d;
+
+    auto& output_for(float) noexcept { return output_f; }
+    auto& output_for(double) noexcept { return output_d; }
+  };
+
+  std::vector<channel> channels;
+
+  // Per-channel pointer arrays for bus ports
+  std::vector<double*> amplitudes;
+  std::vector<double*> phases;
+  std::vector<bin_type*> complex_bins;
+};
+
+/**
+ * Computes the spectrum of spectrum input ports, for the bindings which do not
+ * provide them natively (ossia does, with its own FFT).
+ *
+ * The binding calls reserve_space() when the buffer size is known and the
+ * channels are initialized, then analyze() with the host inputs just before
+ * processing: the host channels are matched to the audio input ports in the
+ * same way as the process adapters do. Each port then sees the spectrum of the
+ * latest frame complete at the end of the current buffer, in the same layout as
+ * with ossia:
+ *
+ * - split ports: amplitude[k] and phase[k] are the real and imaginary parts of bin k;
+ * - complex ports: bin[k], a std::complex<double> or std::complex<float>.
+ *
+ * Split ports use double amplitudes and phases. The analysis itself is always
+ * done in double precision.
+ *
+ * Frames come every hop samples whatever the host buffer size; the arrays hold
+ * at least buffer_size / 2 + 1 bins.
+ *
+ * For resynthesized ports (see stft_resynthesizes), analyze() returns the
+ * input channels to process, in which the channels of these ports point to
+ * the resynthesized audio; the binding reports latency() to the host.
+ * Blocks larger than the buffer size given to reserve_space() are only
+ * analyzed. Other channels are the host inputs, unchanged.
+ *
+ * Processors instantiated once per channel get their own analyzers:
+ * instance i sees the spectrum of host channel i.
+ */
+template <typename T>
+struct stft_storage
+{
+  static constexpr bool resynthesis = false;
+
+  void reserve_space(avnd::effect_container<T>&, int input_channels, int buffer_size)
+  {
+  }
+
+  template <typename FP>
+  avnd::span<FP*>
+  analyze(avnd::effect_container<T>&, avnd::span<FP*> in, int frames) noexcept
+  {
+    return in;
+  }
+
+  int latency() const noexcept { return 0; }
+};
+
+template <typename T>
+  requires(
+      spectrum_split_channel_input_introspection<T>::size
+          + spectrum_complex_channel_input_introspection<T>::size
+          + spectrum_split_bus_input_introspection<T>::size
+          + spectrum_complex_bus_input_introspection<T>::size
+      > 0)
+struct stft_storage<T>
+{
+  using audio_in = avnd::audio_input_introspection<T>;
+  using port_tuple = avnd::filter_and_apply<
+      stft_port_storage, avnd::audio_input_introspection, T>;
+
+  static constexpr bool multi_instance
+      = requires { avnd::effect_container<T>::multi_instance; };
+  static_assert(
+      !(multi_instance && avnd::inputs_is_type<T>),
+      "Spectrum ports of a processor instantiated per channel need per-instance "
+      "inputs: declare them as a value (struct { ... } inputs;)");
+
+  static constexpr bool resynthesis = [] {
+    bool any = false;
+    audio_in::for_all([&]<auto Idx, typename Field>(avnd::field_reflection<Idx, Field>) {
+      any = any || stft_resynthesizes<Field>();
+    });
+    return any;
+  }();
+
+  // One set of analyzers for each instance of the processor
+  std::vector<port_tuple> instances;
+
+  // Host input channels, with the resynthesized ones replaced
+  std::vector<float*> inputs_f;
+  std::vector<double*> inputs_d;
+  int capacity{};
+  int delay{};
+
+  auto& inputs_for(float) noexcept { return inputs_f; }
+  auto& inputs_for(double) noexcept { return inputs_d; }
+
+  // Delay of the resynthesized audio, to report to the host
+  int latency() const noexcept { return delay; }
+
+  void reserve_space(avnd::effect_container<T>& t, int input_channels, int buffer_size)
+  {
+    std::size_t count = 0;
+    for(auto state : t.full_state())
+    {
+      (void)state;
+      count++;
+    }
+    instances.clear();
+    instances.resize(count);
+
+    capacity = buffer_size;
+    delay = 0;
+    std::size_t i = 0;
+    for(auto state : t.full_state())
+    {
+      delay = std::max(
+          delay, reserve_instance(
+                     instances[i++], state.inputs,
+                     multi_instance ? 1 : input_channels, buffer_size));
+    }
+
+    if constexpr(resynthesis)
+    {
+      inputs_f.assign(input_channels, nullptr);
+      inputs_d.assign(input_channels, nullptr);
+    }
+  }
+
+  template <typename FP>
+  avnd::span<FP*>
+  analyze(avnd::effect_container<T>& t, avnd::span<FP*> in, int frames) noexcept
+  {
+    // Where the channels of resynthesized ports go, if they can be replaced
+    FP** replaced = nullptr;
+    if constexpr(resynthesis)
+    {
+      auto& ptrs = inputs_for(FP{});
+      if(frames <= capacity && in.size() <= ptrs.size())
+      {
+        std::copy(in.begin(), in.end(), ptrs.begin());
+        replaced = ptrs.data();
+      }
+    }
+
+    std::size_t i = 0;
+    for(auto state : t.full_state())
+    {
+      if(i >= instances.size())
+        break;
+
+      if constexpr(multi_instance)
+      {
+        // Same attribution as the per-channel process adapters
+        const std::size_t n = i < in.size() ? 1 : 0;
+        analyze_instance(
+            instances[i], state.effect, state.inputs,
+            avnd::span<FP*>{in.data() + i, n}, (replaced && n) ? replaced + i : nullptr,
+            frames);
+      }
+      else
+      {
+        analyze_instance(instances[i], state.effect, state.inputs, in, replaced, frames);
+      }
+      i++;
+    }
+
+    if(replaced)
+      return avnd::span<FP*>{replaced, in.size()};
+    return in;
+  }
+
+private:
+  // Returns the latency of the resynthesized ports of the instance
+  template <typename Inputs>
+  static int reserve_instance(
+      port_tuple& ports, Inputs& inputs, int input_channels, int buffer_size)
+  {
+    int latency = 0;
+    audio_in::for_all_n(
+        inputs, [&]<auto Idx, typename Field>(Field& port, avnd::predicate_index<Idx>) {
+      if constexpr(stft_analysis_port<Field>)
+      {
+        auto& storage = tpl::get<Idx>(ports);
+        const int N = stft_size_for<Field>(buffer_size);
+        const int hop = stft_hop_for<Field>(N);
+        const int bins = std::max(N, buffer_size) / 2 + 1;
+
+        int channels = 1;
+        if constexpr(avnd::fixed_poly_audio_port<Field>)
+          channels = port.channels();
+        else if constexpr(avnd::dynamic_poly_audio_port<Field>)
+          channels = input_channels;
+
+        storage.channels.resize(channels);
+        for(auto& c : storage.channels)
+        {
+          c.analysis.reset(N, hop, window_kind_for<Field>());
+          c.bins.assign(bins, {});
+          c.real.assign(bins, 0.);
+          c.imag.assign(bins, 0.);
+          if constexpr(stft_resynthesizes<Field>())
+          {
+            c.output_f.assign(buffer_size, 0.f);
+            c.output_d.assign(buffer_size, 0.);
+            latency = std::max(latency, c.analysis.latency());
+          }
+        }
+
+        storage.amplitudes.resize(channels);
+        storage.phases.resize(channels);
+        storage.complex_bins.resize(channels);
+        for(int c = 0; c < channels; c++)
+        {
+          storage.amplitudes[c] = storage.channels[c].real.data();
+          storage.phases[c] = storage.channels[c].imag.data();
+          storage.complex_bins[c] = storage.channels[c].bins.data();
+        }
+
+        assign_spectrum(port, storage);
+      }
+    });
+    return latency;
+  }
+
+  template <typename Inputs, typename FP>
+  static void analyze_instance(
+      port_tuple& ports, T& self, Inputs& inputs, avnd::span<FP*> in, FP** replaced,
+      int frames) noexcept
+  {
+    // Same attribution of the host channels as in process_bus_adapter
+    int k = 0;
+    const int n_in = in.size();
+    audio_in::for_all_n(
+        inputs, [&]<auto Idx, typename Field>(Field& port, avnd::predicate_index<Idx>) {
+      int channels = 1;
+      if constexpr(avnd::fixed_poly_audio_port<Field>)
+        channels = port.channels();
+      else if constexpr(avnd::dynamic_poly_audio_port<Field>)
+        channels = (Idx == audio_in::size - 1) ? std::max(n_in - k, 0) : port.channels;
+
+      if constexpr(stft_analysis_port<Field>)
+      {
+        auto& storage = tpl::get<Idx>(ports);
+        const int analyzed = std::min(channels, int(storage.channels.size()));
+        for(int c = 0; c < analyzed; c++)
+        {
+          const FP* samples = (k + c < n_in) ? in[k + c] : nullptr;
+          auto& chan = storage.channels[c];
+
+          // Resynthesized channels are only given to the processor if they
+          // replace a host channel
+          FP* out = nullptr;
+          if constexpr(stft_resynthesizes<Field>())
+            if(replaced && k + c < n_in)
+              out = replaced[k + c] = chan.output_for(FP{}).data();
+
+          chan.analysis.process(
+              samples, out, frames, [&](std::complex<double>* spectrum) {
+            const int bins = chan.analysis.bins();
+            if constexpr(
+                spectrum_complex_channel_port<Field> || spectrum_complex_bus_port<Field>)
+            {
+              for(int b = 0; b < bins; b++)
+                chan.bins[b] = typename stft_port_storage<Field>::bin_type(spectrum[b]);
+            }
+            else
+            {
+              for(int b = 0; b < bins; b++)
+              {
+                chan.real[b] = spectrum[b].real();
+                chan.imag[b] = spectrum[b].imag();
+              }
+            }
+
+            // The port may change the frame before it is transformed back
+            if constexpr(
+                stft_resynthesizes<Field>() && requires { port.on_frame(self); })
+            {
+              assign_spectrum(port, storage, c);
+              port.on_frame(self);
+              if constexpr(
+                  spectrum_complex_channel_port<Field> || spectrum_complex_bus_port<Field>)
+              {
+                for(int b = 0; b < bins; b++)
+                  spectrum[b] = std::complex<double>(chan.bins[b]);
+              }
+              else
+              {
+                for(int b = 0; b < bins; b++)
+                  spectrum[b] = {chan.real[b], chan.imag[b]};
+              }
+            }
+          });
+        }
+        assign_spectrum(port, storage);
+      }
+      k += channels;
+    });
+  }
+
+  // Channel ports show the spectrum of channel c: for on_frame, it is the
+  // channel of the frame. Bus ports always show all of their channels.
+  template <typename Field>
+  static void
+  assign_spectrum(Field& port, stft_port_storage<Field>& storage, int c = 0) noexcept
+  {
+    using bin_type = typename stft_port_storage<Field>::bin_type;
+    static_assert(
+        std::is_same_v<bin_type, std::complex<double>>
+            || std::is_same_v<bin_type, std::complex<float>>,
+        "Complex spectrum ports must use std::complex<double> or std::complex<float> "
+        "bins");
+
+    if constexpr(spectrum_split_channel_port<Field>)
+    {
+      static_assert(
+          std::is_same_v<
+              std::remove_cvref_t<decltype(port.spectrum.amplitude[0])>, double>,
+          "Split spectrum ports must use double amplitudes and phases");
+      port.spectrum.amplitude = storage.amplitudes[c];
+      port.spectrum.phase = storage.phases[c];
+    }
+    else if constexpr(spectrum_complex_channel_port<Field>)
+    {
+      port.spectrum.bin = storage.complex_bins[c];
+    }
+    else if constexpr(spectrum_split_bus_port<Field>)
+    {
+      static_assert(
+          std::is_same_v<
+              std::remove_cvref_t<decltype(port.spectrum.amplitude[0][0])>, double>,
+          "Split spectrum ports must use double amplitudes and phases");
+      port.spectrum.amplitude = storage.amplitudes.data();
+      port.spectrum.phase = storage.phases.data();
+    }
+    else if constexpr(spectrum_complex_bus_port<Field>)
+    {
+      port.spectrum.bin = storage.complex_bins.data();
+    }
+  }
+};
+}
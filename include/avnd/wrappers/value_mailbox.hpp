@@ -0,0 +1,66 @@
+#pragma once
+
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace avnd
+{
+/**
+ * Passes the latest value of a parameter from one thread, e.g. the network
+ * or UI thread, to another, e.g. the audio thread, without locks.
+ *
+ * This is a triple buffer: the writer fills its own slot and publishes it,
+ * the reader takes the last published slot. Updates which are published
+ * before the reader comes are coalesced: only the last one is read.
+ *
+ * read() never allocates: values which are not trivially copyable (strings,
+ * vectors...) are swapped with the destination, and the writer reassigns the
+ * slot it gets back on its own thread.
+ */
+template <typename V>
+class value_mailbox
+{
+public:
+  // Writer thread
+  template <typename U>
+  void write(U&& value) noexcept(std::is_nothrow_assignable_v<V&, U&&>)
+  {
+    m_slots[m_back] = std::forward<U>(value);
+    m_back = m_ready.exchange(m_back | fresh, std::memory_order_acq_rel) & index;
+  }
+
+  // Reader thread: if a new value was written since the last read, moves it
+  // into out and returns true
+  bool read(V& out) noexcept
+  {
+    if(!(m_ready.load(std::memory_order_relaxed) & fresh))
+      return false;
+
+    m_front = m_ready.exchange(m_front, std::memory_order_acq_rel) & index;
+    if constexpr(std::is_trivially_copyable_v<V>)
+    {
+      out = m_slots[m_front];
+    }
+    else
+    {
+      using std::swap;
+      swap(out, m_slots[m_front]);
+    }
+    return true;
+  }
+
+private:
+  static constexpr uint8_t index = 0x3;
+  static constexpr uint8_t fresh = 0x4;
+
+  std::array<V, 3> m_slots{};
+  std::atomic<uint8_t> m_ready{1};
+  uint8_t m_back{0};
+  uint8_t m_front{2};
+};
+}
@@ -0,0 +1,211 @@
+#pragma once
+
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace avnd
+{
+/**
+ * Fixed-capacity storage for the voices of a polyphonic synthesizer.
+ *
+ * Voices live in slots which never move: pointers to them stay valid while
+ * they are active. Free slots are kept in a free-list, and the indices of the
+ * active voices in a contiguous array, so that rendering only walks the voices
+ * which are actually playing.
+ *
+ * Nothing is allocated: when every slot is used, allocate() steals a voice,
+ * picking in order:
+ * - the voices in their release phase, the oldest release first;
+ * - then the oldest voice, or the quietest one if a level function is given.
+ *
+ * Voices are keyed by an integer, usually the MIDI note, so that all the
+ * voices of a note (e.g. with unison) can be released at once.
+ */
+template <typename Voice, std::size_t Capacity>
+class voice_pool
+{
+  static_assert(Capacity > 0 && Capacity <= std::numeric_limits<uint16_t>::max());
+
+public:
+  using index_type = uint16_t;
+
+  voice_pool() noexcept { clear(); }
+
+  static constexpr std::size_t capacity() noexcept { return Capacity; }
+  std::size_t size() const noexcept { return m_count; }
+  bool empty() const noexcept { return m_count == 0; }
+
+  // Number of voices which had to be stolen since the last clear()
+  std::size_t stolen() const noexcept { return m_stolen; }
+
+  void clear() noexcept
+  {
+    m_count = 0;
+    m_free_count = Capacity;
+    m_stolen = 0;
+    for(std::size_t i = 0; i < Capacity; i++)
+      m_free[i] = index_type(Capacity - 1 - i);
+  }
+
+  /**
+   * Returns a voice for key, stealing the oldest one if needed.
+   * The voice keeps its previous state: the caller assigns it.
+   */
+  Voice& allocate(int key) noexcept
+  {
+    return allocate(key, [](const Voice&) { return 0.f; });
+  }
+
+  /**
+   * Same, but the steal goes to the voice with the lowest level(voice)
+   * amongst those which are not releasing, the oldest first for equal levels.
+   */
+  template <typename Level>
+  Voice& allocate(int key, Level&& level) noexcept
+  {
+    index_type slot;
+    if(m_free_count > 0)
+    {
+      slot = m_free[--m_free_count];
+      m_active[m_count++] = slot;
+    }
+    else
+    {
+      slot = m_active[steal_position(level)];
+      m_stolen++;
+    }
+
+    auto& s = m_slots[slot];
+    s.key = key;
+    s.age = m_clock++;
+    s.releasing = false;
+    return s.voice;
+  }
+
+  /**
+   * Moves all the voices of key which are not releasing yet to their release
+   * phase, calling on_release(voice) on each.
+   */
+  template <typename F>
+  void release(int key, F&& on_release) noexcept
+  {
+    for(std::size_t i = 0; i < m_count; i++)
+    {
+      auto& s = m_slots[m_active[i]];
+      if(s.key == key && !s.releasing)
+      {
+        s.releasing = true;
+        s.age = m_clock++;
+        on_release(s.voice);
+      }
+    }
+  }
+
+  /**
+   * Returns the releasing voices for which done(voice) is true to the
+   * free-list.
+   */
+  template <typename F>
+  void recycle_if(F&& done) noexcept
+  {
+    for(std::size_t i = 0; i < m_count;)
+    {
+      const index_type slot = m_active[i];
+      auto& s = m_slots[slot];
+      if(s.releasing && done(s.voice))
+        remove_at(i);
+      else
+        i++;
+    }
+  }
+
+  // f(voice) for every active voice
+  template <typename F>
+  void for_each(F&& f) noexcept
+  {
+    for(std::size_t i = 0; i < m_count; i++)
+      f(m_slots[m_active[i]].voice);
+  }
+
+  // f(voice, bool releasing) for every active voice
+  template <typename F>
+  void for_each_state(F&& f) noexcept
+  {
+    for(std::size_t i = 0; i < m_count; i++)
+    {
+      auto& s = m_slots[m_active[i]];
+      f(s.voice, s.releasing);
+    }
+  }
+
+  // Contiguous slot indices of the active voices
+  const index_type* active_begin() const noexcept { return m_active.data(); }
+  const index_type* active_end() const noexcept { return m_active.data() + m_count; }
+
+  Voice& operator[](index_type slot) noexcept { return m_slots[slot].voice; }
+  const Voice& operator[](index_type slot) const noexcept { return m_slots[slot].voice; }
+
+  bool releasing(index_type slot) const noexcept { return m_slots[slot].releasing; }
+  int key(index_type slot) const noexcept { return m_slots[slot].key; }
+
+private:
+  struct slot_type
+  {
+    Voice voice{};
+    uint64_t age{};
+    int key{};
+    bool releasing{};
+  };
+
+  template <typename Level>
+  std::size_t steal_position(Level& level) noexcept
+  {
+    // Oldest release
+    std::size_t best = m_count;
+    for(std::size_t i = 0; i < m_count; i++)
+    {
+      const auto& s = m_slots[m_active[i]];
+      if(s.releasing && (best == m_count || s.age < m_slots[m_active[best]].age))
+        best = i;
+    }
+    if(best != m_count)
+      return best;
+
+    // Quietest, then oldest
+    best = 0;
+    auto best_level = level(m_slots[m_active[0]].voice);
+    for(std::size_t i = 1; i < m_count; i++)
+    {
+      const auto& s = m_slots[m_active[i]];
+      const auto l = level(s.voice);
+      if(l < best_level || (l == best_level && s.age < m_slots[m_active[best]].age))
+      {
+        best = i;
+        best_level = l;
+      }
+    }
+    return best;
+  }
+
+  void remove_at(std::size_t i) noexcept
+  {
+    const index_type slot = m_active[i];
+    const index_type last = m_active[--m_count];
+    m_active[i] = last;
+    m_free[m_free_count++] = slot;
+  }
+
+  std::array<slot_type, Capacity> m_slots{};
+  std::array<index_type, Capacity> m_active{};
+  std::array<index_type, Capacity> m_free{};
+  std::size_t m_count{};
+  std::size_t m_free_count{};
+  std::size_t m_stolen{};
+  uint64_t m_clock{};
+};
+}
@@ -0,0 +1,227 @@
+#pragma once
+
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+#include <cmath>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace avnd
+{
+enum class window_kind
+{
+  rectangular,
+  hanning,
+  hamming,
+  blackman_harris,
+  kaiser,
+  flat_top
+};
+
+// Shape parameter of the Kaiser window: side lobes around -90 dB
+inline constexpr double kaiser_beta = 8.6;
+
+namespace detail
+{
+template <typename S>
+consteval window_kind window_tag() noexcept
+{
+  if constexpr(requires { S::window::hanning; })
+    return window_kind::hanning;
+  else if constexpr(requires { S::window::hamming; })
+    return window_kind::hamming;
+  else if constexpr(requires { S::window::blackman_harris; })
+    return window_kind::blackman_harris;
+  else if constexpr(requires { S::window::kaiser; })
+    return window_kind::kaiser;
+  else if constexpr(requires { S::window::flat_top; })
+    return window_kind::flat_top;
+  else
+    return window_kind::rectangular;
+}
+}
+
+/**
+ * Window requested by a spectrum port, either in the spectrum struct like
+ * the halp spectrum ports:
+ *
+ *   struct { enum window { hanning }; double* amplitude; ... } spectrum;
+ *
+ * or directly in the port. The supported tags are hanning, hamming,
+ * blackman_harris, kaiser and flat_top.
+ * Ports which do not ask for anything get a rectangular window.
+ */
+template <typename Field>
+consteval window_kind window_kind_for() noexcept
+{
+  using spectrum_type = std::decay_t<decltype(std::declval<Field&>().spectrum)>;
+  if constexpr(detail::window_tag<spectrum_type>() != window_kind::rectangular)
+    return detail::window_tag<spectrum_type>();
+  else
+    return detail::window_tag<Field>();
+}
+
+namespace detail
+{
+// Zeroth-order modified Bessel function of the first kind
+inline double bessel_i0(double x) noexcept
+{
+  double sum = 1.;
+  double term = 1.;
+  const double q = x * x / 4.;
+  for(int k = 1; k < 64 && term > 1e-17 * sum; k++)
+  {
+    term *= q / (double(k) * double(k));
+    sum += term;
+  }
+  return sum;
+}
+
+inline double cosine_sum(const double* a, int terms, double phase) noexcept
+{
+  double res = a[0];
+  double sign = -1.;
+  for(int k = 1; k < terms; k++, sign = -sign)
+    res += sign * a[k] * std::cos(k * phase);
+  return res;
+}
+}
+
+/**
+ * Writes the N coefficients of a window in out.
+ *
+ * Periodic windows are the default as they sum to a constant when overlapped
+ * with the usual hops (N / 2, N / 4 for Hann), which is what overlap-add
+ * resynthesis requires. Symmetric windows are the ones used by the ossia
+ * binding for single-block analysis.
+ */
+template <typename FP>
+void fill_window(window_kind kind, FP* out, int N, bool symmetric = false) noexcept
+{
+  constexpr double two_pi = 6.283185307179586476925286766559;
+  const int period = (symmetric && N > 1) ? N - 1 : N;
+  const double factor = two_pi / period;
+
+  static constexpr double hanning[] = {0.5, 0.5};
+  static constexpr double hamming[] = {25. / 46., 21. / 46.};
+  static constexpr double blackman_harris[] = {0.35875, 0.48829, 0.14128, 0.01168};
+  static constexpr double flat_top[]
+      = {0.21557895, 0.41663158, 0.277263158, 0.083578947, 0.006947368};
+
+  switch(kind)
+  {
+    case window_kind::rectangular:
+      for(int i = 0; i < N; i++)
+        out[i] = FP(1);
+      break;
+    case window_kind::hanning:
+      for(int i = 0; i < N; i++)
+        out[i] = FP(detail::cosine_sum(hanning, 2, factor * i));
+      break;
+    case window_kind::hamming:
+      for(int i = 0; i < N; i++)
+        out[i] = FP(detail::cosine_sum(hamming, 2, factor * i));
+      break;
+    case window_kind::blackman_harris:
+      for(int i = 0; i < N; i++)
+        out[i] = FP(detail::cosine_sum(blackman_harris, 4, factor * i));
+      break;
+    case window_kind::flat_top:
+      for(int i = 0; i < N; i++)
+        out[i] = FP(detail::cosine_sum(flat_top, 5, factor * i));
+      break;
+    case window_kind::kaiser: {
+      const double norm = 1. / detail::bessel_i0(kaiser_beta);
+      for(int i = 0; i < N; i++)
+      {
+        const double r = 2. * i / period - 1.;
+        const double arg = r * r < 1. ? std::sqrt(1. - r * r) : 0.;
+        out[i] = FP(norm * detail::bessel_i0(kaiser_beta * arg));
+      }
+      break;
+    }
+  }
+}
+
+/**
+ * out[i] = in[i] * window[i] * gain.
+ *
+ * Kept as a plain loop without any dependency between iterations so that
+ * compilers vectorize it.
+ */
+template <typename FP>
+void multiply_window(const FP* in, const FP* window, FP* out, int N, FP gain) noexcept
+{
+  for(int i = 0; i < N; i++)
+    out[i] = in[i] * (window[i] * gain);
+}
+
+/**
+ * Window tables, keyed by window kind, size, symmetry and precision.
+ *
+ * prepare() computes a table if it is not there yet and may allocate: it is
+ * meant to be called when the buffer size is known. find() never allocates
+ * and returns nullptr for tables which were not prepared.
+ */
+class window_cache
+{
+public:
+  template <typename FP>
+  const FP* prepare(window_kind kind, int N, bool symmetric = false)
+  {
+    if(auto w = find<FP>(kind, N, symmetric))
+      return w;
+
+    auto& e = tables<FP>().emplace_back(entry<FP>{kind, N, symmetric, {}});
+    e.table.resize(N);
+    fill_window(kind, e.table.data(), N, symmetric);
+    return e.table.data();
+  }
+
+  template <typename FP>
+  const FP* find(window_kind kind, int N, bool symmetric = false) const noexcept
+  {
+    for(auto& e : tables<FP>())
+      if(e.kind == kind && e.size == N && e.symmetric == symmetric)
+        return e.table.data();
+    return nullptr;
+  }
+
+  void clear() noexcept
+  {
+    m_float.clear();
+    m_double.clear();
+  }
+
+private:
+  template <typename FP>
+  struct entry
+  {
+    window_kind kind{};
+    int size{};
+    bool symmetric{};
+    std::vector<FP> table;
+  };
+
+  template <typename FP>
+  auto& tables() noexcept
+  {
+    if constexpr(std::is_same_v<FP, float>)
+      return m_float;
+    else
+      return m_double;
+  }
+  template <typename FP>
+  const auto& tables() const noexcept
+  {
+    if constexpr(std::is_same_v<FP, float>)
+      return m_float;
+    else
+      return m_double;
+  }
+
+  std::vector<entry<float>> m_float;
+  std::vector<entry<double>> m_double;
+};
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <halp/polyfill.hpp>
 #include <halp/static_string.hpp>
 
 #if __has_include(<smallfun_trivial.hpp>)
@@ -11,6 +12,8 @@
 #include <halp/modules.hpp>
 
 #include <algorithm>
+#include <limits>
+#include <string_view>
 #include <vector>
 HALP_MODULE_EXPORT
 namespace halp
@@ -142,6 +145,196 @@ struct custom_curve : std::vector<custom_curve_segment>
   }
 };
 
+/**
+ * Evaluates a curve at many positions, e.g. once per sample, with the same
+ * results as Curve::value_at.
+ *
+ * The index of the last segment used is kept: when positions increase
+ * (playback) or stay in the same segment, the next one is found without a
+ * binary search.
+ *
+ * bake() additionally tabulates the mapping of the power segments with
+ * gamma >= 1, which then costs a linear interpolation instead of a std::pow.
+ * The tables are associated with the gamma of each segment when baking:
+ * segments whose gamma changed afterwards are computed directly until the
+ * next bake().
+ */
+template <typename Curve>
+class curve_evaluator
+{
+public:
+  using segment_type = typename Curve::value_type;
+
+  // Allocates: to be called when the curve changes, outside of the audio thread.
+  void bake(const Curve& curve, int resolution = 256)
+  {
+    m_cursor = 0;
+    if constexpr(requires(segment_type s) { s.gamma; })
+    {
+      m_resolution = std::max(resolution, 1);
+      m_gammas.resize(curve.size());
+      m_tables.resize(curve.size() * (m_resolution + 1));
+      for(std::size_t i = 0; i < curve.size(); i++)
+      {
+        // x^gamma has an infinite slope at 0 for gamma < 1: interpolating a
+        // table would be very inaccurate there.
+        const auto& segment = curve[i];
+        if(!(segment.gamma >= 1.f))
+        {
+          m_gammas[i] = std::numeric_limits<float>::quiet_NaN();
+          continue;
+        }
+
+        m_gammas[i] = segment.gamma;
+        float* table = m_tables.data() + i * (m_resolution + 1);
+        for(int k = 0; k <= m_resolution; k++)
+          table[k] = segment(float(k) / m_resolution);
+      }
+    }
+  }
+
+  void reset() noexcept { m_cursor = 0; }
+
+  float value_at(const Curve& curve, float position) noexcept
+  {
+    if(curve.empty())
+      return 0.;
+
+    if(position > 1.0f)
+      return end_value(curve.back());
+
+    const std::size_t index = find_segment(curve, position);
+    return evaluate(curve[index], index, position);
+  }
+
+  // out[i] = value_at(curve, positions[i])
+  void value_at(const Curve& curve, const float* positions, float* out, int n) noexcept
+  {
+    if(curve.empty())
+    {
+      std::fill_n(out, n, 0.f);
+      return;
+    }
+
+    for(int i = 0; i < n; i++)
+    {
+      const float position = positions[i];
+      if(position > 1.0f)
+      {
+        out[i] = end_value(curve.back());
+        continue;
+      }
+
+      const std::size_t index = find_segment(curve, position);
+      const auto& segment = curve[index];
+
+      // Evaluate all the following positions which are in the same segment
+      const float next = index + 1 < curve.size() ? start_x(curve[index + 1]) : 1.0f;
+      out[i] = evaluate(segment, index, position);
+      while(i + 1 < n && positions[i + 1] >= start_x(segment) && positions[i + 1] < next)
+      {
+        ++i;
+        out[i] = evaluate(segment, index, positions[i]);
+      }
+    }
+  }
+
+private:
+  static float start_x(const segment_type& segment) noexcept
+  {
+    if constexpr(requires { segment.start.x; })
+      return segment.start.x;
+    else
+      return segment.start;
+  }
+
+  static float end_x(const segment_type& segment) noexcept
+  {
+    if constexpr(requires { segment.end.x; })
+      return segment.end.x;
+    else
+      return segment.end;
+  }
+
+  static float end_value(const segment_type& segment) noexcept
+  {
+    if constexpr(requires { segment.end.y; })
+      return segment.end.y;
+    else
+      return segment.function(segment.end);
+  }
+
+  // Index of the last segment starting before position, or the first one.
+  std::size_t find_segment(const Curve& curve, float position) noexcept
+  {
+    const std::size_t N = curve.size();
+    std::size_t i = m_cursor < N ? m_cursor : 0;
+
+    const auto contains = [&](std::size_t k) {
+      return (k == 0 || start_x(curve[k]) <= position)
+             && (k + 1 == N || position < start_x(curve[k + 1]));
+    };
+
+    // Playback moves forward: look at the current and next segments first
+    for(int step = 0; step < 2 && i < N; step++, i++)
+    {
+      if(contains(i))
+        return m_cursor = i;
+    }
+
+    auto it = std::upper_bound(
+        curve.begin(), curve.end(), position,
+        [](float v, const segment_type& segt) noexcept { return v < start_x(segt); });
+    if(it != curve.begin())
+      --it;
+    return m_cursor = std::size_t(it - curve.begin());
+  }
+
+  float evaluate(const segment_type& segment, std::size_t index, float position) noexcept
+  {
+    const float sx = start_x(segment);
+    const float ex = end_x(segment);
+    if constexpr(requires { segment.start.y; })
+    {
+      if(ex - sx < 1e-8f)
+        return segment.start.y;
+
+      const float spos = (position - sx) / (ex - sx);
+      const float smap = map(segment, index, spos);
+      return segment.start.y + smap * (segment.end.y - segment.start.y);
+    }
+    else
+    {
+      if(ex - sx < 1e-8f)
+        return segment.function(sx);
+
+      return segment.function((position - sx) / (ex - sx));
+    }
+  }
+
+  float map(const segment_type& segment, std::size_t index, float spos) noexcept
+  {
+    if constexpr(requires { segment.gamma; })
+    {
+      if(index < m_gammas.size() && m_gammas[index] == segment.gamma && spos >= 0.f
+         && spos <= 1.f)
+      {
+        const float* table = m_tables.data() + index * (m_resolution + 1);
+        const float x = spos * m_resolution;
+        const int k = std::min(int(x), m_resolution - 1);
+        const float frac = x - k;
+        return table[k] + frac * (table[k + 1] - table[k]);
+      }
+    }
+    return segment(spos);
+  }
+
+  std::vector<float> m_gammas;
+  std::vector<float> m_tables;
+  std::size_t m_cursor{};
+  int m_resolution{};
+};
+
 template <static_string lit, typename Curve = halp::custom_curve>
 struct curve_port
 {
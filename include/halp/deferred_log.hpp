@@ -0,0 +1,743 @@
+#pragma once
+
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+#include <halp/log.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+
+#if defined(FMT_PRINTF_H_)
+#include <fmt/args.h>
+#endif
+
+#include <halp/modules.hpp>
+
+HALP_MODULE_EXPORT
+namespace halp
+{
+enum class log_level : uint8_t
+{
+  trace,
+  debug,
+  info,
+  warn,
+  error,
+  critical
+};
+
+namespace detail
+{
+/**
+ * One log call: the format string is kept as a pointer, as it is expected to be
+ * a literal, and the arguments are copied by value. Strings are copied in the
+ * record's text storage and truncated to what fits.
+ */
+struct deferred_log_record
+{
+  static constexpr int max_args = 8;
+  static constexpr int text_capacity = 64;
+
+  enum arg_type : uint8_t
+  {
+    signed_int,
+    unsigned_int,
+    floating,
+    boolean,
+    character,
+    string,
+    pointer
+  };
+
+  struct text_ref
+  {
+    uint8_t offset, size;
+  };
+
+  union arg_value
+  {
+    int64_t i;
+    uint64_t u;
+    double d;
+    text_ref t;
+    const void* p;
+  };
+
+  const char* format{};
+  uint32_t format_size{};
+  log_level level{};
+  uint8_t count{};
+  uint8_t text_size{};
+  arg_type types[max_args]{};
+  arg_value values[max_args]{};
+  char text[text_capacity]{};
+
+  void add_text(std::string_view str) noexcept
+  {
+    const auto n = std::min<std::size_t>(str.size(), text_capacity - text_size);
+    std::memcpy(text + text_size, str.data(), n);
+    types[count] = arg_type::string;
+    values[count++].t = {text_size, uint8_t(n)};
+    text_size += n;
+  }
+
+  template <typename T>
+  void add(const T& arg) noexcept
+  {
+    using type = std::remove_cvref_t<T>;
+    if(count == max_args)
+      return;
+
+    if constexpr(std::is_same_v<type, bool>)
+    {
+      types[count] = arg_type::boolean;
+      values[count++].u = arg;
+    }
+    else if constexpr(std::is_same_v<type, char>)
+    {
+      types[count] = arg_type::character;
+      values[count++].u = uint8_t(arg);
+    }
+    else if constexpr(std::is_integral_v<type> && std::is_signed_v<type>)
+    {
+      types[count] = arg_type::signed_int;
+      values[count++].i = arg;
+    }
+    else if constexpr(std::is_integral_v<type>)
+    {
+      types[count] = arg_type::unsigned_int;
+      values[count++].u = arg;
+    }
+    else if constexpr(std::is_floating_point_v<type>)
+    {
+      types[count] = arg_type::floating;
+      values[count++].d = arg;
+    }
+    else if constexpr(std::is_convertible_v<const T&, std::string_view>)
+    {
+      add_text(std::string_view(arg));
+    }
+    else if constexpr(std::is_pointer_v<std::decay_t<type>>)
+    {
+      types[count] = arg_type::pointer;
+      values[count++].p = static_cast<const void*>(arg);
+    }
+    else
+    {
+      static_assert(
+          std::is_void_v<T>, "deferred_logger only captures arithmetic, "
+                             "string and pointer arguments");
+    }
+  }
+
+  std::string_view text_arg(int i) const noexcept
+  {
+    return {text + values[i].t.offset, values[i].t.size};
+  }
+};
+
+/**
+ * Single-producer, single-consumer queue of records. Each thread which logs
+ * gets one; state tells whether it is free, owned by a thread, or owned by a
+ * thread which has exited and left the records to be printed.
+ */
+struct deferred_log_ring
+{
+  static constexpr std::size_t capacity = 256;
+  static_assert((capacity & (capacity - 1)) == 0);
+
+  enum : int
+  {
+    free,
+    owned,
+    retiring
+  };
+
+  bool push(const deferred_log_record& r) noexcept
+  {
+    const auto w = write.load(std::memory_order_relaxed);
+    if(w - read.load(std::memory_order_acquire) == capacity)
+    {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    records[w & (capacity - 1)] = r;
+    write.store(w + 1, std::memory_order_release);
+    return true;
+  }
+
+  template <typename F>
+  std::size_t pop_all(F&& f)
+  {
+    const auto w = write.load(std::memory_order_acquire);
+    auto r = read.load(std::memory_order_relaxed);
+    const auto n = w - r;
+    for(; r != w; ++r)
+    {
+      f(records[r & (capacity - 1)]);
+      read.store(r + 1, std::memory_order_release);
+    }
+    return n;
+  }
+
+  alignas(64) std::atomic<std::size_t> write{};
+  alignas(64) std::atomic<std::size_t> read{};
+  alignas(64) std::atomic<int> state{free};
+  std::atomic<uint64_t> dropped{};
+  std::array<deferred_log_record, capacity> records{};
+};
+
+/**
+ * Owns the rings and the thread which formats and prints their records.
+ * There is one per process, created by the first deferred_logger.
+ */
+class deferred_log_backend
+{
+public:
+  static constexpr std::size_t max_threads = 8;
+  using sink_type = std::function<void(log_level, std::string_view)>;
+
+  static deferred_log_backend& instance()
+  {
+    static deferred_log_backend backend;
+    return backend;
+  }
+
+  deferred_log_backend()
+  {
+    for(auto& r : m_rings)
+      r = std::make_unique<deferred_log_ring>();
+    m_window = std::chrono::steady_clock::now();
+    m_thread = std::thread{[this] {
+      while(!m_stop.load(std::memory_order_acquire))
+      {
+        if(drain() == 0)
+          std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+    }};
+  }
+
+  ~deferred_log_backend()
+  {
+    m_stop.store(true, std::memory_order_release);
+    m_thread.join();
+    flush();
+  }
+
+  deferred_log_backend(const deferred_log_backend&) = delete;
+  deferred_log_backend& operator=(const deferred_log_backend&) = delete;
+
+  // Gives a ring to the calling thread, false if there is none left
+  bool attach() noexcept { return thread_ring() != nullptr; }
+
+  // Whether the calling thread has a ring, without giving it one
+  static bool attached() noexcept { return this_thread_slot().ring != nullptr; }
+
+  // Called from the thread which logs: no lock, no allocation once attached
+  void push(const deferred_log_record& r) noexcept
+  {
+    if(auto* ring = thread_ring())
+      ring->push(r);
+    else
+      m_unattached_drops.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Prints all the pending records and the pending drop and suppression counts
+  void flush()
+  {
+    drain();
+    std::lock_guard _{m_mutex};
+    report_counts();
+  }
+
+  void set_sink(sink_type sink)
+  {
+    std::lock_guard _{m_mutex};
+    m_sink = std::move(sink);
+  }
+
+  void set_rate_limit(int lines_per_second)
+  {
+    std::lock_guard _{m_mutex};
+    m_rate_limit = lines_per_second;
+    m_window = std::chrono::steady_clock::now();
+    m_window_lines = 0;
+  }
+
+  uint64_t dropped() const noexcept { return m_dropped.load(); }
+  uint64_t suppressed() const noexcept { return m_suppressed.load(); }
+
+private:
+  struct thread_slot
+  {
+    deferred_log_ring* ring{};
+    ~thread_slot()
+    {
+      if(ring)
+        ring->state.store(deferred_log_ring::retiring, std::memory_order_release);
+    }
+  };
+
+  static thread_slot& this_thread_slot() noexcept
+  {
+    static thread_local thread_slot slot;
+    return slot;
+  }
+
+  deferred_log_ring* thread_ring() noexcept
+  {
+    auto& slot = this_thread_slot();
+    if(!slot.ring)
+    {
+      for(auto& r : m_rings)
+      {
+        int expected = deferred_log_ring::free;
+        if(r->state.compare_exchange_strong(expected, deferred_log_ring::owned))
+        {
+          slot.ring = r.get();
+          break;
+        }
+      }
+    }
+    return slot.ring;
+  }
+
+  std::size_t drain()
+  {
+    std::lock_guard _{m_mutex};
+    std::size_t n = 0;
+    for(auto& r : m_rings)
+    {
+      const int state = r->state.load(std::memory_order_acquire);
+      if(state == deferred_log_ring::free)
+        continue;
+
+      n += r->pop_all([this](const deferred_log_record& rec) { print(rec); });
+      if(auto d = r->dropped.exchange(0, std::memory_order_relaxed))
+        m_pending_drops += d;
+
+      if(state == deferred_log_ring::retiring)
+        r->state.store(deferred_log_ring::free, std::memory_order_release);
+    }
+    m_pending_drops += m_unattached_drops.exchange(0, std::memory_order_relaxed);
+
+    const auto now = std::chrono::steady_clock::now();
+    if(now - m_window >= std::chrono::seconds(1))
+    {
+      report_counts();
+      m_window = now;
+      m_window_lines = 0;
+    }
+    return n;
+  }
+
+  void report_counts()
+  {
+    if(m_pending_drops > 0)
+    {
+      format_notice("{} log messages dropped: queue full", m_pending_drops);
+      m_dropped += m_pending_drops;
+      m_pending_drops = 0;
+    }
+    if(m_pending_suppressed > 0)
+    {
+      format_notice("{} log messages suppressed: rate limit", m_pending_suppressed);
+      m_suppressed += m_pending_suppressed;
+      m_pending_suppressed = 0;
+    }
+  }
+
+  void format_notice(const char* format, uint64_t count)
+  {
+    deferred_log_record r{};
+    r.format = format;
+    r.format_size = std::strlen(format);
+    r.level = log_level::warn;
+    r.add(count);
+    format_record(r);
+    emit(r.level);
+  }
+
+  void print(const deferred_log_record& r)
+  {
+    if(m_rate_limit > 0 && m_window_lines >= m_rate_limit)
+    {
+      m_pending_suppressed++;
+      return;
+    }
+    m_window_lines++;
+    format_record(r);
+    emit(r.level);
+  }
+
+  void emit(log_level level)
+  {
+    if(m_sink)
+    {
+      m_sink(level, m_line);
+    }
+    else
+    {
+      auto* out = level >= log_level::warn ? stderr : stdout;
+      std::fwrite(m_line.data(), 1, m_line.size(), out);
+      std::fputc('\n', out);
+      std::fflush(out);
+    }
+  }
+
+#if defined(FMT_PRINTF_H_)
+  void format_record(const deferred_log_record& r)
+  {
+    using R = deferred_log_record;
+    fmt::dynamic_format_arg_store<fmt::format_context> args;
+    for(int i = 0; i < r.count; i++)
+    {
+      switch(r.types[i])
+      {
+        case R::signed_int:
+          args.push_back(r.values[i].i);
+          break;
+        case R::unsigned_int:
+          args.push_back(r.values[i].u);
+          break;
+        case R::floating:
+          args.push_back(r.values[i].d);
+          break;
+        case R::boolean:
+          args.push_back(r.values[i].u != 0);
+          break;
+        case R::character:
+          args.push_back(char(r.values[i].u));
+          break;
+        case R::string:
+          args.push_back(fmt::string_view(r.text_arg(i).data(), r.text_arg(i).size()));
+          break;
+        case R::pointer:
+          args.push_back(r.values[i].p);
+          break;
+      }
+    }
+
+    m_line.clear();
+    try
+    {
+      fmt::vformat_to(
+          std::back_inserter(m_line), fmt::string_view(r.format, r.format_size), args);
+    }
+    catch(const std::exception& e)
+    {
+      m_line.assign(r.format, r.format_size);
+      m_line += " [format error: ";
+      m_line += e.what();
+      m_line += "]";
+    }
+  }
+#else
+  // Replaces each {...} by the next argument, format specifications are ignored
+  void format_record(const deferred_log_record& r)
+  {
+    using R = deferred_log_record;
+    m_line.clear();
+    const std::string_view format{r.format, r.format_size};
+    int arg = 0;
+    for(std::size_t i = 0; i < format.size(); i++)
+    {
+      const char c = format[i];
+      if((c == '{' || c == '}') && i + 1 < format.size() && format[i + 1] == c)
+      {
+        m_line += c;
+        i++;
+      }
+      else if(c == '{')
+      {
+        const auto end = format.find('}', i);
+        if(end == std::string_view::npos)
+        {
+          m_line += format.substr(i);
+          break;
+        }
+        i = end;
+        if(arg >= r.count)
+          continue;
+
+        char buf[64];
+        int n = 0;
+        const auto& v = r.values[arg];
+        switch(r.types[arg])
+        {
+          case R::signed_int:
+            n = snprintf(buf, sizeof(buf), "%lld", (long long)v.i);
+            break;
+          case R::unsigned_int:
+            n = snprintf(buf, sizeof(buf), "%llu", (unsigned long long)v.u);
+            break;
+          case R::floating:
+            n = snprintf(buf, sizeof(buf), "%g", v.d);
+            break;
+          case R::boolean:
+            n = snprintf(buf, sizeof(buf), "%s", v.u ? "true" : "false");
+            break;
+          case R::character:
+            n = snprintf(buf, sizeof(buf), "%c", char(v.u));
+            break;
+          case R::string:
+            m_line += r.text_arg(arg);
+            break;
+          case R::pointer:
+            n = snprintf(buf, sizeof(buf), "%p", v.p);
+            break;
+        }
+        if(n > 0)
+          m_line.append(buf, std::min<std::size_t>(n, sizeof(buf) - 1));
+        arg++;
+      }
+      else
+      {
+        m_line += c;
+      }
+    }
+  }
+#endif
+
+  std::array<std::unique_ptr<deferred_log_ring>, max_threads> m_rings;
+  std::atomic<uint64_t> m_unattached_drops{};
+
+  std::mutex m_mutex;
+  sink_type m_sink;
+  std::string m_line;
+  std::chrono::steady_clock::time_point m_window;
+  int m_rate_limit{200};
+  int m_window_lines{};
+  uint64_t m_pending_drops{};
+  uint64_t m_pending_suppressed{};
+  std::atomic<uint64_t> m_dropped{};
+  std::atomic<uint64_t> m_suppressed{};
+
+  std::atomic_bool m_stop{};
+  std::thread m_thread;
+};
+
+#if defined(FMT_PRINTF_H_)
+template <typename... T>
+using deferred_format_string = fmt::format_string<T...>;
+inline std::string_view to_string_view(fmt::string_view s) noexcept
+{
+  return {s.data(), s.size()};
+}
+template <typename... T>
+std::string_view to_string_view(fmt::format_string<T...> s) noexcept
+{
+  return to_string_view(fmt::string_view(s));
+}
+#else
+template <typename... T>
+using deferred_format_string = std::string_view;
+inline std::string_view to_string_view(std::string_view s) noexcept
+{
+  return s;
+}
+#endif
+}
+
+/**
+ * A logger which can be called from the audio thread.
+ *
+ * A log call only copies the format string pointer and the arguments in a
+ * lock-free queue owned by the calling thread; formatting and printing happen
+ * later, on a background thread. Thus:
+ * - format strings must outlive the call, e.g. be string literals;
+ * - arguments are limited to arithmetic types, pointers and strings,
+ *   which are copied and truncated to a few dozen bytes;
+ * - when a queue is full, messages are dropped and counted;
+ * - the background thread prints at most set_rate_limit() lines per second
+ *   and counts the others.
+ *
+ * The background thread starts with the first deferred_logger: processors
+ * which hold one as their logger member start it when they are created.
+ *
+ * Each thread gets its queue on its first log call, which sets up a
+ * thread_local and may allocate. Threads which log in real time, such as the
+ * audio thread, must call attach() before they log. The audio APIs wrapped by
+ * the bindings do not tell on which thread the audio will run before calling
+ * it, so the bindings call attach() at the start of each audio callback:
+ * the first callback on a given thread pays for the thread_local set-up,
+ * the later ones only read it.
+ */
+struct deferred_logger
+{
+  using logger_type = deferred_logger;
+  using backend_type = detail::deferred_log_backend;
+
+  deferred_logger() { backend_type::instance(); }
+
+  template <typename... T>
+  static void log(detail::deferred_format_string<T...> fmt, T&&... args) noexcept
+  {
+    push(log_level::info, detail::to_string_view(fmt), args...);
+  }
+  template <typename... T>
+  static void trace(detail::deferred_format_string<T...> fmt, T&&... args) noexcept
+  {
+    push(log_level::trace, detail::to_string_view(fmt), args...);
+  }
+  template <typename... T>
+  static void debug(detail::deferred_format_string<T...> fmt, T&&... args) noexcept
+  {
+    push(log_level::debug, detail::to_string_view(fmt), args...);
+  }
+  template <typename... T>
+  static void info(detail::deferred_format_string<T...> fmt, T&&... args) noexcept
+  {
+    push(log_level::info, detail::to_string_view(fmt), args...);
+  }
+  template <typename... T>
+  static void warn(detail::deferred_format_string<T...> fmt, T&&... args) noexcept
+  {
+    push(log_level::warn, detail::to_string_view(fmt), args...);
+  }
+  template <typename... T>
+  static void error(detail::deferred_format_string<T...> fmt, T&&... args) noexcept
+  {
+    push(log_level::error, detail::to_string_view(fmt), args...);
+  }
+  template <typename... T>
+  static void critical(detail::deferred_format_string<T...> fmt, T&&... args) noexcept
+  {
+    push(log_level::critical, detail::to_string_view(fmt), args...);
+  }
+
+  /**
+   * Gives a queue to the calling thread, so that its log calls never allocate.
+   * Returns false when all the queues are taken: the log calls of this thread
+   * are then dropped and counted.
+   */
+  static bool attach() noexcept { return backend_type::instance().attach(); }
+
+  // Whether the calling thread has a queue
+  static bool attached() noexcept { return backend_type::attached(); }
+
+  // Blocks until everything logged so far is printed
+  static void flush() { backend_type::instance().flush(); }
+
+  // Replaces printing to stdout / stderr, called from the background thread
+  static void set_sink(backend_type::sink_type sink)
+  {
+    backend_type::instance().set_sink(std::move(sink));
+  }
+
+  // 0 for no limit
+  static void set_rate_limit(int lines_per_second)
+  {
+    backend_type::instance().set_rate_limit(lines_per_second);
+  }
+
+  // Messages lost since the start, as reported so far
+  static uint64_t dropped() noexcept { return backend_type::instance().dropped(); }
+  static uint64_t suppressed() noexcept { return backend_type::instance().suppressed(); }
+
+private:
+  template <typename... T>
+  static void push(log_level level, std::string_view fmt, const T&... args) noexcept
+  {
+    static_assert(
+        sizeof...(T) <= detail::deferred_log_record::max_args,
+        "deferred_logger: too many arguments");
+
+    detail::deferred_log_record r;
+    r.format = fmt.data();
+    r.format_size = fmt.size();
+    r.level = level;
+    (r.add(args), ...);
+    backend_type::instance().push(r);
+  }
+};
+
+static_assert(avnd::logger<halp::deferred_logger>);
+
+/**
+ * Defers the logs of the threads attached to deferred_logger, i.e. the audio
+ * threads of the bindings, and prints the logs of the other threads
+ * synchronously with basic_logger: those are neither truncated nor
+ * rate-limited.
+ */
+struct audio_deferred_logger
+{
+  using logger_type = audio_deferred_logger;
+
+  audio_deferred_logger() { deferred_logger::backend_type::instance(); }
+
+  template <typename... T>
+  static void log(detail::deferred_format_string<T...> fmt, T&&... args) noexcept
+  {
+    if(deferred_logger::attached())
+      deferred_logger::log(fmt, std::forward<T>(args)...);
+    else
+      basic_logger::log(fmt, std::forward<T>(args)...);
+  }
+  template <typename... T>
+  static void trace(detail::deferred_format_string<T...> fmt, T&&... args) noexcept
+  {
+    if(deferred_logger::attached())
+      deferred_logger::trace(fmt, std::forward<T>(args)...);
+    else
+      basic_logger::trace(fmt, std::forward<T>(args)...);
+  }
+  template <typename... T>
+  static void debug(detail::deferred_format_string<T...> fmt, T&&... args) noexcept
+  {
+    if(deferred_logger::attached())
+      deferred_logger::debug(fmt, std::forward<T>(args)...);
+    else
+      basic_logger::debug(fmt, std::forward<T>(args)...);
+  }
+  template <typename... T>
+  static void info(detail::deferred_format_string<T...> fmt, T&&... args) noexcept
+  {
+    if(deferred_logger::attached())
+      deferred_logger::info(fmt, std::forward<T>(args)...);
+    else
+      basic_logger::info(fmt, std::forward<T>(args)...);
+  }
+  template <typename... T>
+  static void warn(detail::deferred_format_string<T...> fmt, T&&... args) noexcept
+  {
+    if(deferred_logger::attached())
+      deferred_logger::warn(fmt, std::forward<T>(args)...);
+    else
+      basic_logger::warn(fmt, std::forward<T>(args)...);
+  }
+  template <typename... T>
+  static void error(detail::deferred_format_string<T...> fmt, T&&... args) noexcept
+  {
+    if(deferred_logger::attached())
+      deferred_logger::error(fmt, std::forward<T>(args)...);
+    else
+      basic_logger::error(fmt, std::forward<T>(args)...);
+  }
+  template <typename... T>
+  static void critical(detail::deferred_format_string<T...> fmt, T&&... args) noexcept
+  {
+    if(deferred_logger::attached())
+      deferred_logger::critical(fmt, std::forward<T>(args)...);
+    else
+      basic_logger::critical(fmt, std::forward<T>(args)...);
+  }
+
+  static bool attach() noexcept { return deferred_logger::attach(); }
+  static void flush() { deferred_logger::flush(); }
+};
+
+static_assert(avnd::logger<halp::audio_deferred_logger>);
+}
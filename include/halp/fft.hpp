@@ -4,50 +4,135 @@
 #include <halp/modules.hpp>
 
 #include <complex>
+#include <cstddef>
 #include <vector>
 namespace halp::detail
 {
-// Minimal implementation taken from https://gist.github.com/lukicdarkoo/3f0d056e9244784f8b4a
-// Instead go use fftw, MKL, KFR or whatever !
+static constexpr double fft_pi = 3.141592653589793238462643383279502884;
+
+constexpr bool is_power_of_two(std::size_t N) noexcept
+{
+  return N > 0 && (N & (N - 1)) == 0;
+}
+
+/**
+ * Iterative in-place radix-2 complex FFT of a power-of-two size M.
+ *
+ * All the twiddles are computed once in plan(): those of each stage are
+ * stored contiguously, so that the inner butterfly loops only do
+ * unit-stride loads and compilers can vectorize them.
+ * Complex products are written out by hand: std::complex's operator*
+ * handles infinities through a library call unless -ffast-math is on.
+ */
 template <typename FP>
-static void fft_rec(std::complex<FP>* x, int N)
+class complex_fft_plan
 {
-  using namespace std;
-  using cplx = std::complex<FP>;
-  static constexpr double pi = 3.141592653589793238462643383279502884;
+public:
+  using complex_type = std::complex<FP>;
 
-  // Check if it is splitted enough
-  if(N <= 1)
+  void plan(std::size_t M)
   {
-    return;
-  }
+    m_size = M;
+    m_bitrev.assign(M, 0);
+    m_twiddles.clear();
+    if(M < 2)
+      return;
 
-  // Split even and odd
-  auto* odd = (cplx*)alloca(sizeof(cplx) * (1 + N / 2));
-  auto* even = (cplx*)alloca(sizeof(cplx) * (1 + N / 2));
-  for(int i = 0; i < N / 2; i++)
-  {
-    even[i] = x[i * 2];
-    odd[i] = x[i * 2 + 1];
+    int bits = 0;
+    while((std::size_t(1) << bits) < M)
+      bits++;
+    for(std::size_t i = 0; i < M; i++)
+    {
+      std::size_t r = 0;
+      for(int b = 0; b < bits; b++)
+        r |= ((i >> b) & 1) << (bits - 1 - b);
+      m_bitrev[i] = r;
+    }
+
+    // Stage with butterflies of size 2h uses exp(-i pi j / h), j < h
+    m_twiddles.reserve(M);
+    for(std::size_t h = 1; h < M; h *= 2)
+      for(std::size_t j = 0; j < h; j++)
+        m_twiddles.push_back(std::polar(FP(1), FP(-fft_pi * double(j) / double(h))));
   }
 
-  // Split on tasks
-  fft_rec(even, N / 2);
-  fft_rec(odd, N / 2);
+  std::size_t size() const noexcept { return m_size; }
 
-  // Calculate DFT
-  for(int k = 0; k < N / 2; k++)
+  // Unnormalized forward (or inverse) transform of x, in-place.
+  template <bool Inverse>
+  void execute(complex_type* x) const noexcept
   {
-    cplx t = std::exp(cplx(0, -2 * pi * k / N)) * odd[k];
-    x[k] = even[k] + t;
-    x[N / 2 + k] = even[k] - t;
+    const std::size_t M = m_size;
+    if(M < 2)
+      return;
+
+    for(std::size_t i = 0; i < M; i++)
+    {
+      const std::size_t r = m_bitrev[i];
+      if(i < r)
+        std::swap(x[i], x[r]);
+    }
+
+    auto* data = reinterpret_cast<FP*>(x);
+
+    // First stage: twiddle is 1
+    for(std::size_t i = 0; i < M; i += 2)
+    {
+      const complex_type a = x[i], b = x[i + 1];
+      x[i] = a + b;
+      x[i + 1] = a - b;
+    }
+
+    const complex_type* tw = m_twiddles.data() + 1;
+    for(std::size_t h = 2; h < M; h *= 2)
+    {
+      for(std::size_t base = 0; base < M; base += 2 * h)
+      {
+        FP* lo = data + 2 * base;
+        FP* hi = data + 2 * (base + h);
+        for(std::size_t j = 0; j < h; j++)
+        {
+          const FP wr = tw[j].real();
+          const FP wi = Inverse ? -tw[j].imag() : tw[j].imag();
+          const FP br = hi[2 * j], bi = hi[2 * j + 1];
+          const FP tr = br * wr - bi * wi;
+          const FP ti = br * wi + bi * wr;
+          const FP ar = lo[2 * j], ai = lo[2 * j + 1];
+          lo[2 * j] = ar + tr;
+          lo[2 * j + 1] = ai + ti;
+          hi[2 * j] = ar - tr;
+          hi[2 * j + 1] = ai - ti;
+        }
+      }
+      tw += h;
+    }
   }
-}
+
+private:
+  std::vector<complex_type> m_twiddles;
+  std::vector<std::size_t> m_bitrev;
+  std::size_t m_size{};
+};
 }
 
 HALP_MODULE_EXPORT
 namespace halp
 {
+/**
+ * Real FFT.
+ *
+ * reset(N) plans the transforms of size N: a real transform of size N
+ * is computed as a complex transform of size N / 2 on the even / odd samples
+ * packed as real / imaginary parts, followed by a post-processing pass.
+ * Nothing is allocated afterwards as long as execute() is called with the
+ * planned size.
+ *
+ * The forward transform yields the N bins of the spectrum (the upper half being
+ * the complex conjugate of the lower half), the inverse transform reads bins
+ * 0 to N / 2 and is unnormalized: see normalization().
+ *
+ * Sizes which are not a power of two fall back to a direct DFT.
+ */
 template <typename FP>
 class fft
 {
@@ -62,61 +147,172 @@ public:
 
   void reset(std::size_t N)
   {
-    m_cplx.resize(N + 1);
-    m_real.resize(N + 1);
+    m_size = N;
+    m_cplx.assign(N + 1, {});
+    m_real.assign(N + 1, {});
+
+    if(detail::is_power_of_two(N) && N >= 2)
+    {
+      const std::size_t M = N / 2;
+      m_plan.plan(M);
+      m_work.assign(M, {});
+
+      // Post-processing twiddles: exp(-2 i pi k / N), k <= N / 2
+      m_real_twiddles.resize(M + 1);
+      for(std::size_t k = 0; k <= M; k++)
+        m_real_twiddles[k]
+            = std::polar(FP(1), FP(-2. * detail::fft_pi * double(k) / double(N)));
+    }
+    else
+    {
+      m_plan.plan(0);
+      m_work.clear();
+
+      // exp(-2 i pi k / N) for the direct DFT
+      m_real_twiddles.resize(N);
+      for(std::size_t k = 0; k < N; k++)
+        m_real_twiddles[k]
+            = std::polar(FP(1), FP(-2. * detail::fft_pi * double(k) / double(N)));
+    }
   }
 
   // Real to complex
   complex_type* execute(real_type* x_in, std::size_t N)
   {
-    if(m_cplx.size() != N + 1)
+    if(N != m_size)
+      reset(N);
+
+    auto x_out = m_cplx.data();
+    if(N == 0)
+      return x_out;
+
+    if(m_work.empty())
     {
-      m_cplx.resize(N + 1);
+      dft(x_in, x_out, N);
+      return x_out;
     }
 
-    auto x_out = m_cplx.data();
-    for(int i = 0; i < N; i++)
+    const std::size_t M = N / 2;
+
+    // Pack the even and odd samples in a complex signal of size N / 2
+    auto* z = m_work.data();
+    for(std::size_t n = 0; n < M; n++)
+      z[n] = {x_in[2 * n], x_in[2 * n + 1]};
+
+    m_plan.template execute<false>(z);
+
+    // Unpack: X[k] = E[k] + W^k O[k], with
+    // E[k] = (Z[k] + conj(Z[M - k])) / 2 and O[k] = (Z[k] - conj(Z[M - k])) / 2i
+    const auto* w = m_real_twiddles.data();
+    x_out[0] = {z[0].real() + z[0].imag(), 0};
+    x_out[M] = {z[0].real() - z[0].imag(), 0};
+    for(std::size_t k = 1; k < M; k++)
     {
-      x_out[i] = {x_in[i], 0};
+      const FP zr = z[k].real(), zi = z[k].imag();
+      const FP cr = z[M - k].real(), ci = -z[M - k].imag();
+
+      const FP er = FP(0.5) * (zr + cr), ei = FP(0.5) * (zi + ci);
+      // (a + ib) / 2i = (b - ia) / 2
+      const FP or_ = FP(0.5) * (zi - ci), oi = FP(-0.5) * (zr - cr);
+
+      const FP wr = w[k].real(), wi = w[k].imag();
+      x_out[k] = {er + (or_ * wr - oi * wi), ei + (or_ * wi + oi * wr)};
     }
 
-    detail::fft_rec(x_out, N);
+    // Upper half of the spectrum of a real signal
+    for(std::size_t k = M + 1; k < N; k++)
+      x_out[k] = std::conj(x_out[N - k]);
 
     return x_out;
   }
 
-  // Complex to real
+  // Complex to real.
+  // For power-of-two sizes, only bins 0 to N/2 are read: the spectrum is
+  // assumed to be that of a real signal, whose upper bins are the conjugates
+  // of the lower ones, so changes made to the bins above N/2 are ignored.
+  // Other sizes read all the N bins.
   real_type* execute(complex_type* x_in, std::size_t N)
   {
-    if(m_cplx.size() != N + 1)
-    {
-      m_cplx.resize(N + 1);
-    }
-    if(m_real.size() != N + 1)
+    if(N != m_size)
+      reset(N);
+
+    auto x_out = m_real.data();
+    if(N == 0)
+      return x_out;
+
+    if(m_work.empty())
     {
-      m_real.resize(N + 1);
+      idft(x_in, x_out, N);
+      return x_out;
     }
 
-    auto cplx = m_cplx.data();
-    for(int i = 0; i < N; i++)
+    const std::size_t M = N / 2;
+
+    // Pack: Z[k] = (X[k] + conj(X[M - k])) + i conj(W^k) (X[k] - conj(X[M - k]))
+    const auto* w = m_real_twiddles.data();
+    auto* z = m_work.data();
+    for(std::size_t k = 0; k < M; k++)
     {
-      cplx[i] = {x_in[i].imag(), x_in[i].real()};
+      const FP xr = x_in[k].real(), xi = x_in[k].imag();
+      const FP cr = x_in[M - k].real(), ci = -x_in[M - k].imag();
+
+      const FP er = xr + cr, ei = xi + ci;
+      const FP dr = xr - cr, di = xi - ci;
+
+      // conj(W^k) * d
+      const FP wr = w[k].real(), wi = -w[k].imag();
+      const FP or_ = dr * wr - di * wi, oi = dr * wi + di * wr;
+
+      // e + i o
+      z[k] = {er - oi, ei + or_};
     }
 
-    detail::fft_rec(cplx, N);
+    m_plan.template execute<true>(z);
 
-    auto x_out = m_real.data();
-    for(int i = 0; i < N; i++)
+    for(std::size_t n = 0; n < M; n++)
     {
-      x_out[i] = cplx[i].imag();
+      x_out[2 * n] = z[n].real();
+      x_out[2 * n + 1] = z[n].imag();
     }
 
     return x_out;
   }
 
 private:
+  void dft(const real_type* x_in, complex_type* x_out, std::size_t N) const noexcept
+  {
+    const auto* w = m_real_twiddles.data();
+    for(std::size_t k = 0; k < N; k++)
+    {
+      FP re{}, im{};
+      for(std::size_t n = 0, idx = 0; n < N; n++, idx = (idx + k) % N)
+      {
+        re += x_in[n] * w[idx].real();
+        im += x_in[n] * w[idx].imag();
+      }
+      x_out[k] = {re, im};
+    }
+  }
+
+  void idft(const complex_type* x_in, real_type* x_out, std::size_t N) const noexcept
+  {
+    // Real part of the sum of X[k] conj(W^kn)
+    const auto* w = m_real_twiddles.data();
+    for(std::size_t n = 0; n < N; n++)
+    {
+      FP re{};
+      for(std::size_t k = 0, idx = 0; k < N; k++, idx = (idx + n) % N)
+        re += x_in[k].real() * w[idx].real() + x_in[k].imag() * w[idx].imag();
+      x_out[n] = re;
+    }
+  }
+
+  detail::complex_fft_plan<FP> m_plan;
+  std::vector<std::complex<FP>> m_real_twiddles;
+  std::vector<std::complex<FP>> m_work;
   std::vector<std::complex<FP>> m_cplx;
   std::vector<FP> m_real;
+  std::size_t m_size{};
 };
 
 template <typename C, typename FP>
@@ -124,5 +320,7 @@ concept has_fft_1d = avnd::fft_1d<FP, typename C::template fft_type<FP>>;
 }
 static_assert(avnd::fft_1d<float, halp::fft<float>>);
 static_assert(avnd::fft_1d<double, halp::fft<double>>);
+static_assert(avnd::rfft_1d<float, halp::fft<float>>);
+static_assert(avnd::rfft_1d<double, halp::fft<double>>);
 static_assert(halp::has_fft_1d<halp::fft<float>, float>);
 static_assert(halp::has_fft_1d<halp::fft<double>, double>);
@@ -9,16 +9,175 @@
 #include <algorithm>
 #include <cstdint>
 #include <initializer_list>
+#include <iterator>
 #include <string_view>
 #include <type_traits>
+#include <utility>
 
 HALP_MODULE_EXPORT
 namespace halp
 {
 
+/**
+ * Bytes of a MIDI message.
+ *
+ * Up to 15 bytes are stored inline, which covers every channel message without
+ * allocating. Longer payloads (sysex) can be borrowed from memory owned by the
+ * binding with borrow(): avnd::midi_storage does this with a byte arena reserved
+ * along with the buffers, so that the message does not allocate either. A
+ * borrowed payload is only valid for the current block: copying or moving the
+ * message copies the payload, so that the new message can be kept longer.
+ *
+ * Modifying the bytes first copies a borrowed payload in the message.
+ */
+class midi_bytes
+{
+public:
+  using value_type = uint8_t;
+  using size_type = std::size_t;
+  using iterator = uint8_t*;
+  using const_iterator = const uint8_t*;
+
+  static constexpr std::size_t inline_capacity = 15;
+
+  midi_bytes() noexcept = default;
+  midi_bytes(const midi_bytes& other)
+      : m_owned(other.begin(), other.end())
+  {
+  }
+  midi_bytes(midi_bytes&& other)
+  {
+    take(other);
+  }
+  midi_bytes& operator=(const midi_bytes& other)
+  {
+    if(this != &other)
+      assign(other.begin(), other.end());
+    return *this;
+  }
+  midi_bytes& operator=(midi_bytes&& other)
+  {
+    if(this != &other)
+      take(other);
+    return *this;
+  }
+  midi_bytes(std::initializer_list<uint8_t> bytes)
+      : m_owned(bytes)
+  {
+  }
+  template <std::input_iterator It>
+  midi_bytes(It first, It last)
+      : m_owned(first, last)
+  {
+  }
+
+  midi_bytes& operator=(std::initializer_list<uint8_t> bytes)
+  {
+    assign(bytes);
+    return *this;
+  }
+
+  // Points to size bytes owned by someone else, without copying them
+  void borrow(uint8_t* bytes, std::size_t size) noexcept
+  {
+    m_owned.clear();
+    m_borrowed = bytes;
+    m_borrowed_size = size;
+  }
+  bool borrowed() const noexcept { return m_borrowed != nullptr; }
+
+  uint8_t* data() noexcept { return m_borrowed ? m_borrowed : m_owned.data(); }
+  const uint8_t* data() const noexcept
+  {
+    return m_borrowed ? m_borrowed : m_owned.data();
+  }
+  std::size_t size() const noexcept
+  {
+    return m_borrowed ? m_borrowed_size : m_owned.size();
+  }
+  bool empty() const noexcept { return size() == 0; }
+
+  uint8_t* begin() noexcept { return data(); }
+  uint8_t* end() noexcept { return data() + size(); }
+  const uint8_t* begin() const noexcept { return data(); }
+  const uint8_t* end() const noexcept { return data() + size(); }
+  const uint8_t* cbegin() const noexcept { return data(); }
+  const uint8_t* cend() const noexcept { return data() + size(); }
+
+  uint8_t& operator[](std::size_t i) noexcept { return data()[i]; }
+  const uint8_t& operator[](std::size_t i) const noexcept { return data()[i]; }
+  uint8_t& front() noexcept { return data()[0]; }
+  const uint8_t& front() const noexcept { return data()[0]; }
+  uint8_t& back() noexcept { return data()[size() - 1]; }
+  const uint8_t& back() const noexcept { return data()[size() - 1]; }
+
+  void clear() noexcept
+  {
+    m_owned.clear();
+    m_borrowed = nullptr;
+    m_borrowed_size = 0;
+  }
+  void reserve(std::size_t n)
+  {
+    own();
+    m_owned.reserve(n);
+  }
+  void resize(std::size_t n)
+  {
+    own();
+    m_owned.resize(n);
+  }
+  void push_back(uint8_t b)
+  {
+    own();
+    m_owned.push_back(b);
+  }
+  void assign(std::initializer_list<uint8_t> bytes)
+  {
+    clear();
+    m_owned.assign(bytes);
+  }
+  template <std::input_iterator It>
+  void assign(It first, It last)
+  {
+    clear();
+    m_owned.assign(first, last);
+  }
+
+private:
+  // Moves the bytes of other, but copies a borrowed payload: it is not ours
+  void take(midi_bytes& other)
+  {
+    if(other.m_borrowed)
+      assign(other.begin(), other.end());
+    else
+    {
+      clear();
+      m_owned = std::move(other.m_owned);
+    }
+    other.clear();
+  }
+
+  void own()
+  {
+    if(m_borrowed)
+    {
+      const auto* b = m_borrowed;
+      const auto n = m_borrowed_size;
+      m_borrowed = nullptr;
+      m_borrowed_size = 0;
+      m_owned.assign(b, b + n);
+    }
+  }
+
+  boost::container::small_vector<uint8_t, inline_capacity> m_owned;
+  uint8_t* m_borrowed{};
+  std::size_t m_borrowed_size{};
+};
+
 struct midi_msg
 {
-  boost::container::small_vector<uint8_t, 15> bytes;
+  midi_bytes bytes;
   int64_t timestamp{};
 };
 struct midi_note_msg
@@ -32,6 +191,8 @@ struct midi_bus
 {
   static consteval auto name() { return std::string_view{lit.value}; }
 
+  // The bindings reserve room for one message per frame of the buffer, and at
+  // least avnd::midi_storage::min_messages, and do not go past it.
   boost::container::small_vector<MessageType, 2> midi_messages;
 
   operator auto &() noexcept { return midi_messages; }
@@ -155,7 +316,7 @@ private:
   }
 
   // Assign bytes whether MessageType::bytes is a resizable container
-  // (e.g. small_vector, the default midi_msg) or a fixed C array (midi_note_msg,
+  // (e.g. midi_bytes, the default midi_msg) or a fixed C array (midi_note_msg,
   // which is not list-assignable).
   template <typename Bytes>
   static void assign_bytes(Bytes& bytes, std::initializer_list<uint8_t> vals) noexcept
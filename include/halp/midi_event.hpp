@@ -0,0 +1,406 @@
+#pragma once
+
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+#include <halp/modules.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+HALP_MODULE_EXPORT
+namespace halp
+{
+
+/**
+ * A MIDI event which can be copied around with memcpy: one Universal MIDI
+ * Packet of up to 64 bits, the frame at which it happens in the current
+ * block and the index of the source it comes from.
+ *
+ * MIDI 1.0 messages are stored as UMP MIDI 1.0 channel voice (message type 2)
+ * or system (type 1) packets, sysex as a sequence of 7-bit sysex packets
+ * (type 3), with 6 bytes of payload each. 64-bit MIDI 2.0 channel voice
+ * packets (type 4) fit as well.
+ */
+struct midi_event
+{
+  uint32_t ump[2]{};
+  int32_t timestamp{};
+  uint32_t source{};
+
+  static constexpr midi_event
+  midi1(uint8_t status, uint8_t data1, uint8_t data2, int32_t timestamp) noexcept
+  {
+    const uint32_t type = status >= 0xF0 ? 0x1 : 0x2;
+    return midi_event{
+        .ump
+        = {(type << 28) | (uint32_t(status) << 16) | (uint32_t(data1 & 0x7F) << 8)
+               | uint32_t(data2 & 0x7F),
+           0},
+        .timestamp = timestamp};
+  }
+
+  constexpr uint8_t message_type() const noexcept { return ump[0] >> 28; }
+  constexpr uint8_t group() const noexcept { return (ump[0] >> 24) & 0xF; }
+
+  // Status byte of system and channel voice messages
+  constexpr uint8_t status() const noexcept { return (ump[0] >> 16) & 0xFF; }
+  constexpr uint8_t channel() const noexcept { return status() & 0xF; }
+  constexpr uint8_t data1() const noexcept { return (ump[0] >> 8) & 0x7F; }
+  constexpr uint8_t data2() const noexcept { return ump[0] & 0x7F; }
+
+  constexpr bool is_midi1_channel_voice() const noexcept { return message_type() == 0x2; }
+  constexpr bool is_note_on() const noexcept
+  {
+    return is_midi1_channel_voice() && (status() & 0xF0) == 0x90 && data2() > 0;
+  }
+  constexpr bool is_note_off() const noexcept
+  {
+    return is_midi1_channel_voice()
+           && ((status() & 0xF0) == 0x80 || ((status() & 0xF0) == 0x90 && data2() == 0));
+  }
+};
+
+static_assert(sizeof(midi_event) == 16);
+static_assert(std::is_trivially_copyable_v<midi_event>);
+
+/**
+ * Number of bytes of a MIDI 1.0 message, given its status byte.
+ */
+constexpr int midi1_message_size(uint8_t status) noexcept
+{
+  switch(status & 0xF0)
+  {
+    case 0xC0:
+    case 0xD0:
+      return 2;
+    case 0xF0:
+      switch(status)
+      {
+        case 0xF1:
+        case 0xF3:
+          return 2;
+        case 0xF2:
+          return 3;
+        default:
+          return 1;
+      }
+    default:
+      return 3;
+  }
+}
+
+/**
+ * Number of events needed for n bytes of MIDI 1.0 data.
+ */
+constexpr int midi1_event_count(const uint8_t* bytes, std::size_t n) noexcept
+{
+  if(n == 0)
+    return 0;
+  if(bytes[0] != 0xF0)
+    return 1;
+
+  // F0 and F7 are not part of the sysex packets
+  std::size_t payload = n - 1;
+  if(payload > 0 && bytes[n - 1] == 0xF7)
+    payload--;
+  return std::max(1, int((payload + 5) / 6));
+}
+
+/**
+ * Converts n bytes of MIDI 1.0 data to events, which are passed to emit.
+ * Returns the number of events.
+ */
+template <typename F>
+constexpr int
+midi1_to_events(const uint8_t* bytes, std::size_t n, int32_t timestamp, F&& emit) noexcept
+{
+  if(n == 0)
+    return 0;
+
+  if(bytes[0] != 0xF0)
+  {
+    emit(midi_event::midi1(
+        bytes[0], n > 1 ? bytes[1] : uint8_t{}, n > 2 ? bytes[2] : uint8_t{},
+        timestamp));
+    return 1;
+  }
+
+  const uint8_t* payload = bytes + 1;
+  std::size_t size = n - 1;
+  if(size > 0 && payload[size - 1] == 0xF7)
+    size--;
+
+  const int packets = std::max(1, int((size + 5) / 6));
+  for(int p = 0; p < packets; p++)
+  {
+    // 0: complete sysex in one packet, 1: start, 2: continue, 3: end
+    const uint32_t status = packets == 1 ? 0 : p == 0 ? 1 : p == packets - 1 ? 3 : 2;
+    const std::size_t offset = p * 6;
+    const std::size_t count = std::min<std::size_t>(6, size - offset);
+
+    uint8_t data[6]{};
+    for(std::size_t i = 0; i < count; i++)
+      data[i] = payload[offset + i] & 0x7F;
+
+    emit(midi_event{
+        .ump
+        = {(0x3u << 28) | (status << 20) | (uint32_t(count) << 16)
+               | (uint32_t(data[0]) << 8) | data[1],
+           (uint32_t(data[2]) << 24) | (uint32_t(data[3]) << 16)
+               | (uint32_t(data[4]) << 8) | data[5]},
+        .timestamp = timestamp});
+  }
+  return packets;
+}
+
+/**
+ * Writes the MIDI 1.0 bytes of an event in out, which must hold at least 8
+ * bytes, and returns their number. Sysex packets give their part of the
+ * message: F0 is written before the first one and F7 after the last one.
+ * Other kinds of packets give 0 bytes.
+ */
+constexpr int midi1_from_event(const midi_event& e, uint8_t* out) noexcept
+{
+  switch(e.message_type())
+  {
+    case 0x1:
+    case 0x2: {
+      const int n = midi1_message_size(e.status());
+      out[0] = e.status();
+      if(n > 1)
+        out[1] = e.data1();
+      if(n > 2)
+        out[2] = e.data2();
+      return n;
+    }
+    case 0x3: {
+      const int status = (e.ump[0] >> 20) & 0xF;
+      const int count = std::min(6, int((e.ump[0] >> 16) & 0xF));
+      const uint8_t data[6]{
+          uint8_t(e.ump[0] >> 8), uint8_t(e.ump[0]),       uint8_t(e.ump[1] >> 24),
+          uint8_t(e.ump[1] >> 16), uint8_t(e.ump[1] >> 8), uint8_t(e.ump[1])};
+
+      int k = 0;
+      if(status == 0 || status == 1)
+        out[k++] = 0xF0;
+      for(int i = 0; i < count; i++)
+        out[k++] = data[i] & 0x7F;
+      if(status == 0 || status == 3)
+        out[k++] = 0xF7;
+      return k;
+    }
+    default:
+      return 0;
+  }
+}
+
+/**
+ * Combines the events of several sources (host MIDI input, MIDI file playback,
+ * notes generated by the processor...) in a single timestamp-ordered sequence.
+ *
+ * Usage, once per block:
+ *
+ *   merger.clear();
+ *   merger.add(inputs.midi, 0);
+ *   merger.begin_source(1);
+ *   for(...) merger.push(midi_event::midi1(0x90, note, 100, frame));
+ *   for(const halp::midi_event& e : merger.merge()) ...
+ *
+ * The events of each source are expected to be mostly sorted already; a source
+ * which is not gets an insertion sort. The sources are then merged two by two.
+ * Events with the same timestamp keep the order of their sources, and their
+ * order within a source: e.g. the packets of a sysex stay together.
+ *
+ * Nothing is allocated outside of reserve(): events past the capacity are
+ * dropped and counted in dropped().
+ */
+class midi_event_merger
+{
+public:
+  static constexpr int max_runs = 32;
+
+  void reserve(std::size_t capacity)
+  {
+    m_events.resize(capacity);
+    m_scratch.resize(capacity);
+    clear();
+  }
+
+  std::size_t capacity() const noexcept { return m_events.size(); }
+  std::size_t size() const noexcept { return m_size; }
+  std::size_t dropped() const noexcept { return m_dropped; }
+
+  void clear() noexcept
+  {
+    m_size = 0;
+    m_dropped = 0;
+    m_run_count = 0;
+    m_run_begin = 0;
+    m_run_sorted = true;
+    m_source = 0;
+  }
+
+  // Events pushed from now on come from the given source
+  void begin_source(uint32_t source) noexcept
+  {
+    end_run();
+    m_source = source;
+  }
+
+  bool push(midi_event e) noexcept
+  {
+    if(m_size == m_events.size())
+    {
+      m_dropped++;
+      return false;
+    }
+
+    e.source = m_source;
+    if(m_size > m_run_begin && e.timestamp < m_events[m_size - 1].timestamp)
+      m_run_sorted = false;
+    m_events[m_size++] = e;
+    return true;
+  }
+
+  // Adds a MIDI 1.0 message, or nothing if all its packets do not fit
+  bool push_midi1(const uint8_t* bytes, std::size_t n, int32_t timestamp) noexcept
+  {
+    if(std::size_t(midi1_event_count(bytes, n)) > m_events.size() - m_size)
+    {
+      m_dropped++;
+      return false;
+    }
+    midi1_to_events(bytes, n, timestamp, [this](const midi_event& e) { push(e); });
+    return true;
+  }
+
+  /**
+   * Adds a whole source of MIDI messages with bytes and timestamp members,
+   * such as a halp::midi_bus.
+   */
+  template <typename Messages>
+  void add(const Messages& messages, uint32_t source) noexcept
+  {
+    begin_source(source);
+    for(const auto& m : messages)
+    {
+      const auto* bytes = reinterpret_cast<const uint8_t*>(std::data(m.bytes));
+      push_midi1(bytes, std::size(m.bytes), int32_t(m.timestamp));
+    }
+  }
+
+  /**
+   * Adds a whole source of anything, e.g. the events of a midifile_port
+   * track: to_event(element, emit) calls emit(midi_event) for each event
+   * the element gives in the current block.
+   */
+  template <typename Range, typename F>
+  void add(const Range& elements, uint32_t source, F&& to_event) noexcept
+  {
+    begin_source(source);
+    auto emit = [this](const midi_event& e) { push(e); };
+    for(const auto& element : elements)
+      to_event(element, emit);
+  }
+
+  /**
+   * Merges the sources added since clear() and returns the result,
+   * valid until the next call to clear() or reserve().
+   */
+  std::span<const midi_event> merge() noexcept
+  {
+    end_run();
+    merge_runs();
+    return {m_events.data(), m_size};
+  }
+
+private:
+  struct run
+  {
+    std::size_t begin{}, end{};
+  };
+
+  void end_run() noexcept
+  {
+    if(m_size == m_run_begin)
+      return;
+
+    if(!m_run_sorted)
+    {
+      // Stable insertion sort, for the sources which push out of order
+      auto* first = m_events.data() + m_run_begin;
+      auto* last = m_events.data() + m_size;
+      for(auto* it = first + 1; it < last; ++it)
+      {
+        const midi_event e = *it;
+        auto* pos = it;
+        for(; pos > first && e.timestamp < (pos - 1)->timestamp; --pos)
+          *pos = *(pos - 1);
+        *pos = e;
+      }
+    }
+
+    // Out of run slots: fold what we have in a single run
+    if(m_run_count == max_runs)
+      merge_runs();
+
+    m_runs[m_run_count++] = {m_run_begin, m_size};
+    m_run_begin = m_size;
+    m_run_sorted = true;
+  }
+
+  void merge_runs() noexcept
+  {
+    if(m_run_count < 2)
+      return;
+
+    const std::size_t n = m_runs[m_run_count - 1].end;
+    midi_event* src = m_events.data();
+    midi_event* dst = m_scratch.data();
+    while(m_run_count > 1)
+    {
+      int out = 0;
+      for(int r = 0; r < m_run_count; r += 2, out++)
+      {
+        const std::size_t begin = m_runs[r].begin;
+        const std::size_t end = m_runs[r].end;
+        if(r + 1 < m_run_count)
+        {
+          const std::size_t end2 = m_runs[r + 1].end;
+          std::merge(
+              src + begin, src + end, src + end, src + end2, dst + begin,
+              [](const midi_event& a, const midi_event& b) {
+            return a.timestamp < b.timestamp;
+          });
+          m_runs[out] = {begin, end2};
+        }
+        else
+        {
+          std::copy(src + begin, src + end, dst + begin);
+          m_runs[out] = {begin, end};
+        }
+      }
+      m_run_count = out;
+      std::swap(src, dst);
+    }
+
+    if(src != m_events.data())
+      std::copy_n(src, n, m_events.data());
+  }
+
+  std::vector<midi_event> m_events;
+  std::vector<midi_event> m_scratch;
+  std::array<run, max_runs> m_runs{};
+  std::size_t m_size{};
+  std::size_t m_dropped{};
+  std::size_t m_run_begin{};
+  int m_run_count{};
+  bool m_run_sorted{true};
+  uint32_t m_source{};
+};
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+#include <halp/modules.hpp>
+
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <type_traits>
+
+HALP_MODULE_EXPORT
+namespace halp
+{
+
+/**
+ * A pack of N samples processed in lock-step.
+ *
+ * Lane-generic processors are written against a sample type V, which is
+ * either a plain floating-point type or a halp::simd: the adapters then run
+ * a single instance for N channels at once, one channel per lane.
+ *
+ * All operations are lane-wise loops over a fixed-size array, which compilers
+ * turn into vector instructions.
+ * Math functions are found through ADL: write e.g.
+ *
+ *   using std::tanh;
+ *   return tanh(x);
+ *
+ * so that the same code works for float, double and halp::simd.
+ */
+template <std::floating_point FP, int N>
+struct simd
+{
+  using value_type = FP;
+  static constexpr int lanes = N;
+
+  alignas(N * sizeof(FP)) FP v[N]{};
+
+  constexpr simd() noexcept = default;
+
+  template <typename U>
+    requires std::is_arithmetic_v<U>
+  constexpr simd(U x) noexcept
+  {
+    for(int i = 0; i < N; i++)
+      v[i] = FP(x);
+  }
+
+  constexpr FP& operator[](int i) noexcept { return v[i]; }
+  constexpr const FP& operator[](int i) const noexcept { return v[i]; }
+
+#define HALP_SIMD_BINARY_OPERATOR(op)                                            \
+  friend constexpr simd operator op(const simd& a, const simd& b) noexcept       \
+  {                                                                              \
+    simd r;                                                                      \
+    for(int i = 0; i < N; i++)                                                   \
+      r.v[i] = a.v[i] op b.v[i];                                                 \
+    return r;                                                                    \
+  }                                                                              \
+  constexpr simd& operator op##=(const simd& b) noexcept                         \
+  {                                                                              \
+    for(int i = 0; i < N; i++)                                                   \
+      v[i] op##= b.v[i];                                                         \
+    return *this;                                                                \
+  }
+
+  HALP_SIMD_BINARY_OPERATOR(+)
+  HALP_SIMD_BINARY_OPERATOR(-)
+  HALP_SIMD_BINARY_OPERATOR(*)
+  HALP_SIMD_BINARY_OPERATOR(/)
+#undef HALP_SIMD_BINARY_OPERATOR
+
+  friend constexpr simd operator-(const simd& a) noexcept
+  {
+    simd r;
+    for(int i = 0; i < N; i++)
+      r.v[i] = -a.v[i];
+    return r;
+  }
+
+#define HALP_SIMD_UNARY_FUNCTION(fun)              \
+  friend simd fun(const simd& a) noexcept          \
+  {                                                \
+    simd r;                                        \
+    for(int i = 0; i < N; i++)                     \
+      r.v[i] = std::fun(a.v[i]);                   \
+    return r;                                      \
+  }
+
+  HALP_SIMD_UNARY_FUNCTION(abs)
+  HALP_SIMD_UNARY_FUNCTION(sqrt)
+  HALP_SIMD_UNARY_FUNCTION(exp)
+  HALP_SIMD_UNARY_FUNCTION(log)
+  HALP_SIMD_UNARY_FUNCTION(sin)
+  HALP_SIMD_UNARY_FUNCTION(cos)
+  HALP_SIMD_UNARY_FUNCTION(tan)
+  HALP_SIMD_UNARY_FUNCTION(tanh)
+  HALP_SIMD_UNARY_FUNCTION(floor)
+#undef HALP_SIMD_UNARY_FUNCTION
+
+#define HALP_SIMD_BINARY_FUNCTION(fun, expr)                   \
+  friend simd fun(const simd& a, const simd& b) noexcept       \
+  {                                                            \
+    simd r;                                                    \
+    for(int i = 0; i < N; i++)                                 \
+    {                                                          \
+      const FP x = a.v[i], y = b.v[i];                         \
+      r.v[i] = expr;                                           \
+    }                                                          \
+    return r;                                                  \
+  }
+
+  HALP_SIMD_BINARY_FUNCTION(min, y < x ? y : x)
+  HALP_SIMD_BINARY_FUNCTION(max, x < y ? y : x)
+  HALP_SIMD_BINARY_FUNCTION(pow, std::pow(x, y))
+#undef HALP_SIMD_BINARY_FUNCTION
+};
+
+}
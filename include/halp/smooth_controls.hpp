@@ -3,6 +3,8 @@
 #include <halp/modules.hpp>
 #include <halp/smoothers.hpp>
 
+#include <span>
+
 HALP_MODULE_EXPORT
 namespace halp
 {
@@ -12,6 +14,23 @@ struct smooth_control : T
   using smooth = halp::milliseconds_smooth<15>;
 };
 
+// The smoothed value of every sample of the current buffer.
+// Empty when the value has converged: then the value member is exact
+// for the whole buffer.
+template <typename T>
+struct smooth_ramp_values
+{
+  std::span<T> ramp;
+};
+
+template <typename T>
+struct smooth_ramp_control
+    : T
+    , smooth_ramp_values<std::decay_t<decltype(T::value)>>
+{
+  using smooth = halp::milliseconds_smooth<15>;
+};
+
 template <static_string lit, auto setup = default_range<float>>
 struct smooth_knob : halp::knob_t<float, lit, setup>
 {
@@ -24,4 +43,20 @@ struct smooth_slider : halp::slider_t<float, lit, setup>
   using smooth = halp::milliseconds_smooth<15>;
 };
 
+template <static_string lit, auto setup = default_range<float>>
+struct smooth_ramp_knob
+    : halp::knob_t<float, lit, setup>
+    , smooth_ramp_values<float>
+{
+  using smooth = halp::milliseconds_smooth<15>;
+};
+
+template <static_string lit, auto setup = default_range<float>>
+struct smooth_ramp_slider
+    : halp::slider_t<float, lit, setup>
+    , smooth_ramp_values<float>
+{
+  using smooth = halp::milliseconds_smooth<15>;
+};
+
 }
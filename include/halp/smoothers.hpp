@@ -17,6 +17,16 @@ struct milliseconds_smooth
   // static constexpr std::chrono::milliseconds duration{T};
 };
 
+// Linear ramp to the target in T milliseconds.
+// Only controls with a per-sample ramp (halp::smooth_ramp_control) use it,
+// others are smoothed exponentially with the same duration.
+template <int T>
+struct linear_smooth
+{
+  static constexpr float milliseconds{T};
+  static constexpr bool linear{true};
+};
+
 // Same thing but explicit control over the smoothing
 // ratio
 template <int T>
@@ -0,0 +1,436 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+// The audio thread must not allocate.
+//
+// Every operator new in this test binary goes through a counter, which is
+// only armed around what a binding does on its audio callback: running one
+// block through the process adapter, then reading the output controls back
+// from every per-channel instance.
+// The latter used to go through a member_iterator coroutine, whose frame is
+// heap-allocated on each call.
+
+#include <catch2/catch_all.hpp>
+
+#include <avnd/introspection/midi.hpp>
+#include <avnd/introspection/port.hpp>
+#include <avnd/wrappers/effect_container.hpp>
+#include <avnd/wrappers/prepare.hpp>
+#include <avnd/wrappers/process_adapter.hpp>
+
+#include <halp/audio.hpp>
+#include <halp/controls.hpp>
+#include <halp/meta.hpp>
+#include <halp/midi.hpp>
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+namespace
+{
+std::atomic_bool g_counting{false};
+std::atomic_int g_allocations{0};
+
+void count_allocation() noexcept
+{
+  if(g_counting.load(std::memory_order_relaxed))
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+void* counted_alloc(std::size_t sz)
+{
+  count_allocation();
+  if(void* p = std::malloc(sz ? sz : 1))
+    return p;
+  throw std::bad_alloc{};
+}
+
+void* counted_aligned_alloc(std::size_t sz, std::align_val_t al)
+{
+  count_allocation();
+  const auto align = static_cast<std::size_t>(al);
+  sz = ((sz ? sz : 1) + align - 1) / align * align;
+#if defined(_WIN32)
+  if(void* p = _aligned_malloc(sz, align))
+    return p;
+#else
+  if(void* p = std::aligned_alloc(align, sz))
+    return p;
+#endif
+  throw std::bad_alloc{};
+}
+
+void aligned_free(void* p) noexcept
+{
+#if defined(_WIN32)
+  _aligned_free(p);
+#else
+  std::free(p);
+#endif
+}
+
+// Counts the allocations done while it is alive
+struct allocation_counter
+{
+  allocation_counter()
+  {
+    g_allocations = 0;
+    g_counting = true;
+  }
+  ~allocation_counter() { g_counting = false; }
+  int count() const noexcept { return g_allocations.load(); }
+};
+}
+
+void* operator new(std::size_t sz)
+{
+  return counted_alloc(sz);
+}
+void* operator new[](std::size_t sz)
+{
+  return counted_alloc(sz);
+}
+void* operator new(std::size_t sz, std::align_val_t al)
+{
+  return counted_aligned_alloc(sz, al);
+}
+void* operator new[](std::size_t sz, std::align_val_t al)
+{
+  return counted_aligned_alloc(sz, al);
+}
+void operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+void operator delete[](void* p) noexcept
+{
+  std::free(p);
+}
+void operator delete(void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
+void operator delete[](void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
+void operator delete(void* p, std::align_val_t) noexcept
+{
+  aligned_free(p);
+}
+void operator delete[](void* p, std::align_val_t) noexcept
+{
+  aligned_free(p);
+}
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept
+{
+  aligned_free(p);
+}
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept
+{
+  aligned_free(p);
+}
+
+namespace
+{
+// inputs / outputs as types: one output struct per channel, stored along
+// with each processor.
+struct ArgMeter
+{
+  halp_meta(name, "Arg meter")
+  halp_meta(c_name, "test_arg_meter")
+  halp_meta(uuid, "0d3b7c36-4f3e-4a55-a0d4-7f4c2e8b1a01")
+
+  struct inputs
+  {
+    halp::hslider_f32<"Gain", halp::range{.min = 0., .max = 2., .init = 1.}> gain;
+  };
+
+  struct outputs
+  {
+    halp::hbargraph_f32<"Level", halp::range{.min = 0., .max = 1., .init = 0.}> level;
+  };
+
+  float operator()(float in, const inputs& ins, outputs& outs)
+  {
+    outs.level.value = std::abs(in);
+    return in * ins.gain;
+  }
+};
+
+// Same, with the processors and their outputs in two contiguous arrays.
+struct ContiguousArgMeter
+{
+  halp_meta(name, "Contiguous arg meter")
+  halp_meta(c_name, "test_contiguous_arg_meter")
+  halp_meta(uuid, "0d3b7c36-4f3e-4a55-a0d4-7f4c2e8b1a04")
+  halp_flag(contiguous_instances);
+
+  using inputs = ArgMeter::inputs;
+  using outputs = ArgMeter::outputs;
+
+  float operator()(float in, const inputs& ins, outputs& outs)
+  {
+    outs.level.value = std::abs(in);
+    return in * ins.gain;
+  }
+};
+
+// inputs / outputs as members of each instance.
+struct PortMeter
+{
+  halp_meta(name, "Port meter")
+  halp_meta(c_name, "test_port_meter")
+  halp_meta(uuid, "0d3b7c36-4f3e-4a55-a0d4-7f4c2e8b1a02")
+
+  struct
+  {
+    halp::audio_sample<"In", float> audio;
+    halp::hslider_f32<"Gain", halp::range{.min = 0., .max = 2., .init = 1.}> gain;
+  } inputs;
+
+  struct
+  {
+    halp::audio_sample<"Out", float> audio;
+    halp::hbargraph_f32<"Level", halp::range{.min = 0., .max = 1., .init = 0.}> level;
+  } outputs;
+
+  void operator()()
+  {
+    outputs.level.value = std::abs(inputs.audio.sample);
+    outputs.audio = inputs.audio * inputs.gain;
+  }
+};
+
+// Same, with the instances in one aligned array.
+struct ContiguousPortMeter
+{
+  halp_meta(name, "Contiguous port meter")
+  halp_meta(c_name, "test_contiguous_port_meter")
+  halp_meta(uuid, "0d3b7c36-4f3e-4a55-a0d4-7f4c2e8b1a05")
+  halp_flag(contiguous_instances);
+
+  decltype(PortMeter::inputs) inputs;
+  decltype(PortMeter::outputs) outputs;
+
+  void operator()()
+  {
+    outputs.level.value = std::abs(inputs.audio.sample);
+    outputs.audio = inputs.audio * inputs.gain;
+  }
+};
+
+struct MidiSink
+{
+  halp_meta(name, "Midi sink")
+  halp_meta(c_name, "test_midi_sink")
+  halp_meta(uuid, "0d3b7c36-4f3e-4a55-a0d4-7f4c2e8b1a03")
+
+  struct
+  {
+    halp::midi_bus<"In"> midi;
+  } inputs;
+
+  void operator()(int frames) { }
+};
+
+// Prepares T outside of the counted region, then returns the number of
+// allocations done by one audio callback.
+template <typename T, typename FP>
+int allocations_in_one_cycle(int channels, int frames)
+{
+  avnd::effect_container<T> effect;
+  avnd::process_adapter<T> processor;
+
+  avnd::process_setup setup{
+      .input_channels = channels,
+      .output_channels = channels,
+      .frames_per_buffer = frames,
+      .rate = 44100.};
+
+  processor.allocate_buffers(setup, FP{});
+  effect.init_channels(channels, channels);
+  avnd::prepare(effect, setup);
+
+  std::vector<std::vector<FP>> ins(channels, std::vector<FP>(frames, FP(0.5)));
+  std::vector<std::vector<FP>> outs(channels, std::vector<FP>(frames));
+  std::vector<FP*> in_ptrs, out_ptrs;
+  for(auto& c : ins)
+    in_ptrs.push_back(c.data());
+  for(auto& c : outs)
+    out_ptrs.push_back(c.data());
+
+  float levels = 0.f;
+  allocation_counter counter;
+  processor.process(
+      effect, avnd::span<FP*>{in_ptrs.data(), std::size_t(channels)},
+      avnd::span<FP*>{out_ptrs.data(), std::size_t(channels)}, frames);
+
+  avnd::parameter_output_introspection<T>::for_all(
+      effect.outputs(), [&](auto& port) { levels += port.value; });
+
+  const int count = counter.count();
+  REQUIRE(levels == Catch::Approx(0.5f * channels));
+  return count;
+}
+}
+
+TEST_CASE("the allocation counter sees allocations", "[realtime]")
+{
+  static int* volatile sink{};
+  allocation_counter counter;
+  sink = new int{1};
+  delete sink;
+  REQUIRE(counter.count() == 1);
+}
+
+TEST_CASE("a process cycle does not allocate", "[realtime]")
+{
+  constexpr int channels = 4, frames = 64;
+
+  SECTION("inputs and outputs types")
+  {
+    REQUIRE(allocations_in_one_cycle<ArgMeter, float>(channels, frames) == 0);
+    REQUIRE(allocations_in_one_cycle<ArgMeter, double>(channels, frames) == 0);
+  }
+
+  SECTION("inputs and outputs types, contiguous instances")
+  {
+    REQUIRE(allocations_in_one_cycle<ContiguousArgMeter, float>(channels, frames) == 0);
+    REQUIRE(allocations_in_one_cycle<ContiguousArgMeter, double>(channels, frames) == 0);
+  }
+
+  SECTION("inputs and outputs members")
+  {
+    REQUIRE(allocations_in_one_cycle<PortMeter, float>(channels, frames) == 0);
+    REQUIRE(allocations_in_one_cycle<PortMeter, double>(channels, frames) == 0);
+  }
+
+  SECTION("inputs and outputs members, contiguous instances")
+  {
+    using T = ContiguousPortMeter;
+    static_assert(std::is_same_v<
+                  decltype(avnd::effect_container<T>::effect), avnd::aligned_vector<T>>);
+    REQUIRE(allocations_in_one_cycle<T, float>(channels, frames) == 0);
+    REQUIRE(allocations_in_one_cycle<T, double>(channels, frames) == 0);
+  }
+}
+
+TEST_CASE("MIDI input does not allocate", "[realtime][midi]")
+{
+  constexpr int frames = 64;
+  avnd::effect_container<MidiSink> effect;
+  avnd::midi_storage<MidiSink> midi;
+  midi.reserve_space(effect, frames);
+
+  auto& port = effect.inputs().midi;
+  std::vector<uint8_t> sysex(200);
+  for(std::size_t i = 0; i < sysex.size(); i++)
+    sysex[i] = uint8_t(i & 0x7F);
+  sysex.front() = 0xF0;
+  sysex.back() = 0xF7;
+
+  // Small buffers still get room for more events than samples
+  REQUIRE(midi.max_messages == midi.min_messages);
+  const int capacity = midi.max_messages;
+
+  for(int cycle = 0; cycle < 3; cycle++)
+  {
+    int pushed = 0;
+    {
+      allocation_counter counter;
+      // More events than the reserved capacity: the extra ones are dropped
+      for(int i = 0; i < 2 * capacity; i++)
+      {
+        auto msg = midi.push_message(port);
+        if(!msg)
+          continue;
+        pushed++;
+        if(i < 16 && i % 4 == 0)
+        {
+          REQUIRE(midi.assign_bytes(*msg, sysex.data(), sysex.size()));
+        }
+        else
+        {
+          const uint8_t note[3]{0x90, uint8_t(i & 0x7F), 100};
+          REQUIRE(midi.assign_bytes(*msg, note, 3));
+        }
+        msg->timestamp = i;
+      }
+      REQUIRE(counter.count() == 0);
+    }
+
+    REQUIRE(pushed == capacity);
+    REQUIRE(midi.dropped_messages == capacity);
+    REQUIRE(port.size() == std::size_t(capacity));
+    REQUIRE(port[0].bytes.size() == sysex.size());
+    REQUIRE(port[0].bytes.borrowed());
+    REQUIRE(std::equal(port[0].bytes.begin(), port[0].bytes.end(), sysex.begin()));
+    REQUIRE(port[1].bytes.size() == 3);
+    REQUIRE(port[1].bytes[1] == 1);
+
+    midi.clear_inputs(effect);
+    midi.dropped_messages = 0;
+    REQUIRE(port.empty());
+    REQUIRE(midi.sysex.used() == 0);
+  }
+
+  // Sysex which do not fit in the arena anymore are refused
+  auto msg = midi.push_message(port);
+  REQUIRE(msg);
+  std::vector<uint8_t> huge(midi.sysex.capacity() + 1, 0xF0);
+  REQUIRE(!midi.assign_bytes(*msg, huge.data(), huge.size()));
+  REQUIRE(midi.dropped_messages == 1);
+}
+
+TEST_CASE("copied MIDI messages own their bytes", "[midi]")
+{
+  uint8_t arena[20]{0xF0, 1, 2, 3};
+  halp::midi_msg msg;
+  msg.bytes.borrow(arena, 20);
+
+  // The copy outlives the block: it must not point in the arena anymore
+  halp::midi_msg copy = msg;
+  halp::midi_msg assigned;
+  assigned = msg;
+  std::fill(std::begin(arena), std::end(arena), 0);
+  for(const halp::midi_msg* m : {&copy, &assigned})
+  {
+    REQUIRE(!m->bytes.borrowed());
+    REQUIRE(m->bytes.size() == 20);
+    REQUIRE(m->bytes[0] == 0xF0);
+    REQUIRE(m->bytes[3] == 3);
+  }
+
+  // Moving keeps borrowing, without copying
+  halp::midi_msg moved = std::move(msg);
+  REQUIRE(moved.bytes.borrowed());
+  REQUIRE(moved.bytes.data() == arena);
+  REQUIRE(!msg.bytes.borrowed());
+}
+
+TEST_CASE("borrowed MIDI bytes are copied on write", "[midi]")
+{
+  uint8_t arena[20]{0xF0, 1, 2, 3};
+  halp::midi_bytes bytes;
+  bytes.borrow(arena, 20);
+  REQUIRE(bytes.data() == arena);
+
+  bytes.push_back(0xF7);
+  REQUIRE(!bytes.borrowed());
+  REQUIRE(bytes.size() == 21);
+  REQUIRE(bytes[3] == 3);
+  REQUIRE(bytes.back() == 0xF7);
+
+  bytes = {0x80, 60, 0};
+  REQUIRE(bytes.size() == 3);
+  REQUIRE(bytes[1] == 60);
+}
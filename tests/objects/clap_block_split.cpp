@@ -0,0 +1,276 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later OR BSL-1.0 OR CC0-1.0 OR CC-PDCC OR 0BSD */
+
+// Timestamped CLAP parameter events: processors tagged
+// split_on_parameter_changes are run on sub-blocks starting at each change,
+// sample-accurate controls get the changes in their values map, and the
+// others only see the last value of the block.
+
+#include <avnd/binding/clap/audio_effect.hpp>
+#include <halp/audio.hpp>
+#include <halp/controls.hpp>
+#include <halp/meta.hpp>
+#include <halp/sample_accurate_controls.hpp>
+
+#include <catch2/catch_all.hpp>
+
+#include <array>
+#include <map>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace
+{
+using gain_slider = halp::hslider_f32<"Gain", halp::range{.min = 0., .max = 1., .init = 0.}>;
+
+// Write the current gain to every output sample
+struct SplitWriter
+{
+  halp_meta(name, "Split writer")
+  halp_meta(c_name, "split_writer")
+  halp_meta(uuid, "5f0c3e1a-9d2b-4c7e-8a61-3b9e0d4f2a10")
+  halp_flag(split_on_parameter_changes);
+
+  struct
+  {
+    halp::fixed_audio_bus<"In", double, 1> audio;
+    gain_slider gain;
+  } inputs;
+  struct
+  {
+    halp::fixed_audio_bus<"Out", double, 1> audio;
+  } outputs;
+
+  int calls = 0;
+  void operator()(int frames)
+  {
+    calls++;
+    for(int i = 0; i < frames; i++)
+      outputs.audio[0][i] = inputs.gain.value;
+  }
+};
+
+struct PlainWriter
+{
+  halp_meta(name, "Plain writer")
+  halp_meta(c_name, "plain_writer")
+  halp_meta(uuid, "5f0c3e1a-9d2b-4c7e-8a61-3b9e0d4f2a12")
+
+  struct
+  {
+    halp::fixed_audio_bus<"In", double, 1> audio;
+    gain_slider gain;
+  } inputs;
+  struct
+  {
+    halp::fixed_audio_bus<"Out", double, 1> audio;
+  } outputs;
+
+  int calls = 0;
+  void operator()(int frames)
+  {
+    calls++;
+    for(int i = 0; i < frames; i++)
+      outputs.audio[0][i] = inputs.gain.value;
+  }
+};
+
+struct AccurateReader
+{
+  halp_meta(name, "Accurate reader")
+  halp_meta(c_name, "accurate_reader")
+  halp_meta(uuid, "5f0c3e1a-9d2b-4c7e-8a61-3b9e0d4f2a11")
+  halp_flag(split_on_parameter_changes);
+
+  struct
+  {
+    halp::fixed_audio_bus<"In", double, 1> audio;
+    halp::accurate<gain_slider> gain;
+  } inputs;
+  struct
+  {
+    halp::fixed_audio_bus<"Out", double, 1> audio;
+  } outputs;
+
+  int calls = 0;
+  std::map<int, float> seen;
+  void operator()(int frames)
+  {
+    calls++;
+    for(auto& [frame, value] : inputs.gain.values)
+      seen[frame] = value;
+  }
+};
+
+// Timed values in a span: the binding owns their storage
+struct span_gain : gain_slider
+{
+  struct timed_value
+  {
+    int frame;
+    float value;
+  };
+  std::span<timed_value> values;
+};
+
+// Instantiated once per channel
+struct MultiAccurateReader
+{
+  halp_meta(name, "Multi accurate reader")
+  halp_meta(c_name, "multi_accurate_reader")
+  halp_meta(uuid, "5f0c3e1a-9d2b-4c7e-8a61-3b9e0d4f2a13")
+
+  struct
+  {
+    span_gain gain;
+  } inputs;
+
+  std::vector<std::pair<int, float>> seen;
+  void operator()(double* in, double* out, int frames)
+  {
+    for(auto& v : inputs.gain.values)
+      seen.emplace_back(v.frame, v.value);
+  }
+};
+
+const clap_host fake_host{
+    .clap_version = CLAP_VERSION,
+    .host_data = nullptr,
+    .name = "test-host",
+    .vendor = "avnd",
+    .url = "",
+    .version = "1.0",
+    .get_extension = [](const clap_host*, const char*) -> const void* {
+      return nullptr;
+    },
+    .request_restart = [](const clap_host*) {},
+    .request_process = [](const clap_host*) {},
+    .request_callback = [](const clap_host*) {},
+};
+
+struct param_events
+{
+  std::vector<clap_event_param_value_t> events;
+  clap_input_events_t in{
+      .ctx = this,
+      .size = [](const clap_input_events_t* list) -> uint32_t {
+        return static_cast<param_events*>(list->ctx)->events.size();
+      },
+      .get = [](const clap_input_events_t* list,
+                uint32_t i) -> const clap_event_header_t* {
+        return &static_cast<param_events*>(list->ctx)->events[i].header;
+      }};
+  clap_output_events_t out{
+      .ctx = nullptr,
+      .try_push = [](const clap_output_events_t*,
+                     const clap_event_header_t*) -> bool { return true; }};
+
+  void add(uint32_t time, clap_id id, double value)
+  {
+    clap_event_param_value_t ev{};
+    ev.header.size = sizeof(ev);
+    ev.header.time = time;
+    ev.header.space_id = CLAP_CORE_EVENT_SPACE_ID;
+    ev.header.type = CLAP_EVENT_PARAM_VALUE;
+    ev.param_id = id;
+    ev.note_id = -1;
+    ev.port_index = -1;
+    ev.channel = -1;
+    ev.key = -1;
+    ev.value = value;
+    events.push_back(ev);
+  }
+};
+
+constexpr uint32_t frames = 64;
+
+template <typename T, int Channels = 1>
+std::array<double, frames>
+run_one_block(avnd_clap::SimpleAudioEffect<T>& fx, clap_id param = 1)
+{
+  REQUIRE(fx.activate(&fx, 48000., 1, frames));
+
+  param_events events;
+  events.add(16, param, 0.5);
+  events.add(40, param, 1.0);
+
+  std::array<std::array<double, frames>, Channels> in{}, out{};
+  double* in_ptrs[Channels];
+  double* out_ptrs[Channels];
+  for(int c = 0; c < Channels; c++)
+  {
+    in_ptrs[c] = in[c].data();
+    out_ptrs[c] = out[c].data();
+  }
+  clap_audio_buffer_t in_bus{.data64 = in_ptrs, .channel_count = Channels};
+  clap_audio_buffer_t out_bus{.data64 = out_ptrs, .channel_count = Channels};
+
+  clap_process_t process{};
+  process.frames_count = frames;
+  process.audio_inputs = &in_bus;
+  process.audio_outputs = &out_bus;
+  process.audio_inputs_count = 1;
+  process.audio_outputs_count = 1;
+  process.in_events = &events.in;
+  process.out_events = &events.out;
+  REQUIRE(fx.process(&fx, &process) == CLAP_PROCESS_CONTINUE);
+  return out[0];
+}
+}
+
+TEST_CASE("clap: blocks are split at parameter changes", "[clap][sample-accurate]")
+{
+  auto fx = std::make_unique<avnd_clap::SimpleAudioEffect<SplitWriter>>(&fake_host);
+  const auto out = run_one_block(*fx);
+
+  REQUIRE(fx->effect.effect.calls == 3);
+  for(uint32_t i = 0; i < 16; i++)
+    REQUIRE(out[i] == Catch::Approx(0.));
+  for(uint32_t i = 16; i < 40; i++)
+    REQUIRE(out[i] == Catch::Approx(0.5));
+  for(uint32_t i = 40; i < frames; i++)
+    REQUIRE(out[i] == Catch::Approx(1.));
+}
+
+TEST_CASE("clap: untagged processors see the last value", "[clap][sample-accurate]")
+{
+  auto fx = std::make_unique<avnd_clap::SimpleAudioEffect<PlainWriter>>(&fake_host);
+  const auto out = run_one_block(*fx);
+
+  REQUIRE(fx->effect.effect.calls == 1);
+  for(uint32_t i = 0; i < frames; i++)
+    REQUIRE(out[i] == Catch::Approx(1.));
+}
+
+TEST_CASE("clap: sample-accurate controls get timed values", "[clap][sample-accurate]")
+{
+  auto fx = std::make_unique<avnd_clap::SimpleAudioEffect<AccurateReader>>(&fake_host);
+  run_one_block(*fx);
+
+  // Changes of sample-accurate controls never split the block
+  REQUIRE(fx->effect.effect.calls == 1);
+  REQUIRE(fx->effect.effect.seen.size() == 2);
+  REQUIRE(fx->effect.effect.seen[16] == Catch::Approx(0.5f));
+  REQUIRE(fx->effect.effect.seen[40] == Catch::Approx(1.f));
+  REQUIRE(fx->effect.effect.inputs.gain.value == Catch::Approx(1.f));
+}
+
+TEST_CASE("clap: each instance gets the timed values once", "[clap][sample-accurate]")
+{
+  using T = MultiAccurateReader;
+  static_assert(avnd::monophonic_audio_processor<T>);
+
+  auto fx = std::make_unique<avnd_clap::SimpleAudioEffect<T>>(&fake_host);
+  run_one_block<T, 2>(*fx, 0);
+
+  REQUIRE(fx->effect.effect.size() == 2);
+  for(auto& instance : fx->effect.effect)
+  {
+    REQUIRE(instance.seen.size() == 2);
+    REQUIRE(instance.seen[0].first == 16);
+    REQUIRE(instance.seen[0].second == Catch::Approx(0.5f));
+    REQUIRE(instance.seen[1].first == 40);
+    REQUIRE(instance.seen[1].second == Catch::Approx(1.f));
+    REQUIRE(instance.inputs.gain.value == Catch::Approx(1.f));
+  }
+}
@@ -23,6 +23,7 @@
 
 #include <halp/controls.hpp>
 #include <halp/meta.hpp>
+#include <halp/smooth_controls.hpp>
 
 #include <vector>
 
@@ -63,6 +64,130 @@ struct MonoAccumulator
   }
 };
 
+// Same, opted into channel-major execution: each instance runs over the whole
+// block before the next one starts.
+struct MonoAccumulatorChannelMajor
+{
+  halp_meta(name, "Mono accumulator (channel-major)")
+  halp_meta(c_name, "test_mono_accum_cm")
+  halp_meta(uuid, "6f0a7a0e-2b1d-4e0a-9a3e-1a4a4f9d2f03")
+  halp_flag(channel_major);
+
+  struct
+  {
+  } inputs;
+
+  float running_sum{};
+  float operator()(float in)
+  {
+    running_sum += in;
+    return running_sum;
+  }
+};
+
+// A smoothed gain, run channel-major when the buffers allow it.
+struct SmoothGainInputs
+{
+  halp::smooth_knob<"Gain", halp::range{.min = 0., .max = 1., .init = 0.}> gain;
+};
+
+struct SmoothGainChannelMajor
+{
+  halp_meta(name, "Smooth gain (channel-major)")
+  halp_meta(c_name, "test_smooth_gain_cm")
+  halp_meta(uuid, "6f0a7a0e-2b1d-4e0a-9a3e-1a4a4f9d2f05")
+  halp_flag(channel_major);
+
+  using inputs = SmoothGainInputs;
+
+  // Order of the calls, to tell channel-major from sample-major execution
+  static inline int calls = 0;
+  int first_call = -1, last_call = -1;
+
+  float operator()(float in, const inputs& ins)
+  {
+    if(first_call < 0)
+      first_call = calls;
+    last_call = calls++;
+    return in * ins.gain.value;
+  }
+};
+
+// Same, written once for any sample type: the adapter runs one lane instance
+// for several channels at once.
+struct LaneAccumulatorInputs
+{
+};
+
+template <typename V>
+struct BasicLaneAccumulator
+{
+  halp_meta(name, "Lane accumulator")
+  halp_meta(c_name, "test_lane_accum")
+  halp_meta(uuid, "6f0a7a0e-2b1d-4e0a-9a3e-1a4a4f9d2f04")
+
+  template <typename U>
+  using lanes = BasicLaneAccumulator<U>;
+  using inputs = LaneAccumulatorInputs;
+
+  V running_sum{};
+  V operator()(V in, const inputs&)
+  {
+    running_sum += in;
+    return running_sum;
+  }
+};
+using LaneAccumulator = BasicLaneAccumulator<float>;
+
+// Same with sample ports: the lane version takes the sample pack as argument.
+struct PortLaneAccumulatorInputs
+{
+  struct
+  {
+    float sample;
+  } audio;
+};
+
+struct PortLaneAccumulatorOutputs
+{
+  struct
+  {
+    float sample;
+  } audio;
+};
+
+struct PortLaneAccumulator
+{
+  halp_meta(name, "Port lane accumulator")
+  halp_meta(c_name, "test_port_lane_accum")
+  halp_meta(uuid, "6f0a7a0e-2b1d-4e0a-9a3e-1a4a4f9d2f06")
+
+  using inputs = PortLaneAccumulatorInputs;
+  using outputs = PortLaneAccumulatorOutputs;
+
+  template <typename V>
+  struct lanes
+  {
+    V running_sum{};
+    V operator()(V in, const inputs&)
+    {
+      running_sum += in;
+      return running_sum;
+    }
+  };
+
+  // Calls of the scalar version, which the lane-packed path must not make
+  static inline int scalar_calls = 0;
+
+  float running_sum{};
+  void operator()(const inputs& in, outputs& out)
+  {
+    scalar_calls++;
+    running_sum += in.audio.sample;
+    out.audio.sample = running_sum;
+  }
+};
+
 // Drive `T` through the same adapter every audio binding uses, with `channels`
 // distinct input channels, and return the produced output channels.
 template <typename T>
@@ -159,3 +284,194 @@ TEST_CASE("per-channel state is not shared between channels", "[polyphony]")
     }
   }
 }
+
+TEST_CASE("channel-major execution matches sample-major execution", "[polyphony]")
+{
+  constexpr int channels = 4, frames = 16;
+  const auto in = distinct_inputs(channels, frames);
+  const auto sample_major = run<MonoAccumulator>(channels, frames, in);
+  const auto channel_major = run<MonoAccumulatorChannelMajor>(channels, frames, in);
+
+  REQUIRE(channel_major.size() == sample_major.size());
+  for(int c = 0; c < channels; c++)
+    for(int i = 0; i < frames; i++)
+      REQUIRE(channel_major[c][i] == Catch::Approx(sample_major[c][i]));
+}
+
+TEST_CASE("channel-major execution is refused when outputs alias later inputs", "[polyphony]")
+{
+  float a[4]{}, b[4]{}, c[4]{};
+
+  // In-place, channel by channel: fine.
+  float* in_place[2]{a, b};
+  REQUIRE(avnd::channels_are_independent(
+      avnd::span<float*>{in_place, 2}, avnd::span<float*>{in_place, 2}));
+
+  // Output 0 is input 1: processing channel 0 first would clobber it.
+  float* ins[2]{a, b};
+  float* outs[2]{b, c};
+  REQUIRE(!avnd::channels_are_independent(
+      avnd::span<float*>{ins, 2}, avnd::span<float*>{outs, 2}));
+}
+
+TEST_CASE("channel-major execution smooths controls as sample-major execution", "[polyphony]")
+{
+  // Channel-major is only used when no output aliases a later input:
+  // both orders must give the same gain trajectory.
+  using T = SmoothGainChannelMajor;
+  constexpr int channels = 2, frames = 32;
+  const auto in = distinct_inputs(channels, frames);
+
+  // reserved: the block size given to allocate_buffers
+  bool channel_major_used = false;
+  auto run_smoothed = [&](bool aliased, int reserved) {
+    avnd::effect_container<T> effect;
+    avnd::process_adapter<T> processor;
+    avnd::smooth_storage<T> smooth;
+    processor.allocate_buffers(
+        avnd::process_setup{
+            .input_channels = channels,
+            .output_channels = channels,
+            .frames_per_buffer = reserved,
+            .rate = 48000.},
+        float{});
+    effect.init_channels(channels, channels);
+    smooth.init(effect, 48000.);
+    smooth.update_target(effect.inputs().gain, 1.f, avnd::field_index<0>{});
+
+    // Aliased: buffers {x0, x1, x2}, inputs {x0, x1} and outputs {x1, x2}
+    std::vector<std::vector<float>> bufs(channels + 1, std::vector<float>(frames));
+    std::vector<std::vector<float>> outs(channels, std::vector<float>(frames));
+    std::vector<float*> in_ptrs, out_ptrs;
+    for(int c = 0; c < channels; c++)
+    {
+      bufs[c] = in[c];
+      in_ptrs.push_back(bufs[c].data());
+      out_ptrs.push_back(aliased ? bufs[c + 1].data() : outs[c].data());
+    }
+    REQUIRE(
+        avnd::channels_are_independent(
+            avnd::span<float*>{in_ptrs.data(), in_ptrs.size()},
+            avnd::span<float*>{out_ptrs.data(), out_ptrs.size()})
+        == !aliased);
+
+    // Two blocks, so that the second one starts mid-glide
+    std::vector<std::vector<float>> result(channels);
+    for(int block = 0; block < 2; block++)
+    {
+      if(block == 1)
+        for(int c = 0; c < channels; c++)
+          std::copy_n(in[c].data(), frames, in_ptrs[c]);
+
+      for(auto& instance : effect.effects())
+        instance.first_call = instance.last_call = -1;
+
+      processor.process(
+          effect, avnd::span<float*>{in_ptrs.data(), std::size_t(channels)},
+          avnd::span<float*>{out_ptrs.data(), std::size_t(channels)}, frames, smooth);
+      for(int c = 0; c < channels; c++)
+        result[c].insert(result[c].end(), out_ptrs[c], out_ptrs[c] + frames);
+    }
+
+    std::vector<const T*> instances;
+    for(auto& instance : effect.effects())
+      instances.push_back(&instance);
+    channel_major_used = instances.front()->last_call < instances.back()->first_call;
+    return result;
+  };
+
+  const auto sample_major = run_smoothed(true, frames);
+  REQUIRE(!channel_major_used);
+
+  // Larger blocks than reserved: the values of the block do not fit
+  const auto too_large = run_smoothed(false, frames / 2);
+  REQUIRE(!channel_major_used);
+
+  const auto channel_major = run_smoothed(false, frames);
+  REQUIRE(channel_major_used);
+
+  for(int c = 0; c < channels; c++)
+  {
+    // The gain moves during the block
+    REQUIRE(channel_major[c][0] < channel_major[c][frames - 1]);
+    for(int i = 0; i < 2 * frames; i++)
+    {
+      REQUIRE(channel_major[c][i] == Catch::Approx(sample_major[c][i]));
+      REQUIRE(too_large[c][i] == Catch::Approx(sample_major[c][i]));
+    }
+  }
+}
+
+TEST_CASE("lane-packed execution keeps channels independent", "[polyphony]")
+{
+  // Not a multiple of the lane count, so the last pack is partially filled.
+  constexpr int channels = 11, frames = 16;
+  const auto in = distinct_inputs(channels, frames);
+  const auto lanes = run<LaneAccumulator>(channels, frames, in);
+  const auto scalar = run<MonoAccumulator>(channels, frames, in);
+
+  REQUIRE(lanes.size() == scalar.size());
+  for(int c = 0; c < channels; c++)
+    for(int i = 0; i < frames; i++)
+      REQUIRE(lanes[c][i] == Catch::Approx(scalar[c][i]));
+}
+
+TEST_CASE("lane-packed execution of per-sample ports", "[polyphony]")
+{
+  constexpr int channels = 11, frames = 16;
+  const auto in = distinct_inputs(channels, frames);
+  PortLaneAccumulator::scalar_calls = 0;
+  const auto lanes = run<PortLaneAccumulator>(channels, frames, in);
+  const auto scalar = run<MonoAccumulator>(channels, frames, in);
+
+  REQUIRE(PortLaneAccumulator::scalar_calls == 0);
+  REQUIRE(lanes.size() == scalar.size());
+  for(int c = 0; c < channels; c++)
+    for(int i = 0; i < frames; i++)
+      REQUIRE(lanes[c][i] == Catch::Approx(scalar[c][i]));
+}
+
+TEST_CASE("lane-packed execution keeps its state in the channel instances", "[polyphony]")
+{
+  // Three blocks: packs for every channel, then packs allocated for fewer
+  // channels than processed, then packs for every channel again.
+  constexpr int channels = 11, frames = 16;
+  const auto in = distinct_inputs(channels, frames);
+
+  avnd::effect_container<LaneAccumulator> effect;
+  avnd::process_adapter<LaneAccumulator> processor;
+  effect.init_channels(channels, channels);
+
+  std::vector<std::vector<float>> ins = in;
+  std::vector<std::vector<float>> outs(channels, std::vector<float>(frames));
+  std::vector<float*> in_ptrs, out_ptrs;
+  for(auto& c : ins)
+    in_ptrs.push_back(c.data());
+  for(auto& c : outs)
+    out_ptrs.push_back(c.data());
+
+  float expected_sum[channels]{};
+  for(int allocated : {channels, 4, channels})
+  {
+    avnd::process_setup setup{
+        .input_channels = allocated,
+        .output_channels = allocated,
+        .frames_per_buffer = frames,
+        .rate = 44100.};
+    processor.allocate_buffers(setup, float{});
+
+    processor.process(
+        effect, avnd::span<float*>{in_ptrs.data(), std::size_t(channels)},
+        avnd::span<float*>{out_ptrs.data(), std::size_t(channels)}, frames);
+
+    for(int c = 0; c < channels; c++)
+    {
+      for(int i = 0; i < frames; i++)
+      {
+        expected_sum[c] += in[c][i];
+        REQUIRE(outs[c][i] == Catch::Approx(expected_sum[c]));
+      }
+      REQUIRE(effect.effect[c].running_sum == Catch::Approx(expected_sum[c]));
+    }
+  }
+}
@@ -0,0 +1,330 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later OR BSL-1.0 OR CC0-1.0 OR CC-PDCC OR 0BSD */
+
+// VST3 parameter queues: processors tagged split_on_parameter_changes are run
+// on sub-blocks starting at each change, sample-accurate controls get the
+// changes in their values, and the others only see the last value of the block.
+
+#include <avnd/binding/vst3/audio_effect.hpp>
+#include <avnd/binding/vst3/interface_ids.hpp>
+#include <halp/audio.hpp>
+#include <halp/controls.hpp>
+#include <halp/meta.hpp>
+#include <halp/sample_accurate_controls.hpp>
+
+#include <catch2/catch_all.hpp>
+
+#include <array>
+#include <map>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace
+{
+using namespace Steinberg;
+using namespace Steinberg::Vst;
+
+using gain_slider = halp::hslider_f32<"Gain", halp::range{.min = 0., .max = 1., .init = 0.}>;
+
+// Write the current gain to every output sample
+struct SplitWriter
+{
+  halp_meta(name, "Split writer")
+  halp_meta(c_name, "split_writer")
+  halp_meta(uuid, "7a2e4d10-3c5b-4f8e-9b16-2d0c8e5f1a20")
+  halp_flag(split_on_parameter_changes);
+
+  struct
+  {
+    halp::fixed_audio_bus<"In", double, 1> audio;
+    gain_slider gain;
+  } inputs;
+  struct
+  {
+    halp::fixed_audio_bus<"Out", double, 1> audio;
+  } outputs;
+
+  int calls = 0;
+  void operator()(int frames)
+  {
+    calls++;
+    for(int i = 0; i < frames; i++)
+      outputs.audio[0][i] = inputs.gain.value;
+  }
+};
+
+struct PlainWriter
+{
+  halp_meta(name, "Plain writer")
+  halp_meta(c_name, "plain_writer")
+  halp_meta(uuid, "7a2e4d10-3c5b-4f8e-9b16-2d0c8e5f1a21")
+
+  struct
+  {
+    halp::fixed_audio_bus<"In", double, 1> audio;
+    gain_slider gain;
+  } inputs;
+  struct
+  {
+    halp::fixed_audio_bus<"Out", double, 1> audio;
+  } outputs;
+
+  int calls = 0;
+  void operator()(int frames)
+  {
+    calls++;
+    for(int i = 0; i < frames; i++)
+      outputs.audio[0][i] = inputs.gain.value;
+  }
+};
+
+struct AccurateReader
+{
+  halp_meta(name, "Accurate reader")
+  halp_meta(c_name, "accurate_reader")
+  halp_meta(uuid, "7a2e4d10-3c5b-4f8e-9b16-2d0c8e5f1a22")
+  halp_flag(split_on_parameter_changes);
+
+  struct
+  {
+    halp::fixed_audio_bus<"In", double, 1> audio;
+    halp::accurate<gain_slider> gain;
+  } inputs;
+  struct
+  {
+    halp::fixed_audio_bus<"Out", double, 1> audio;
+  } outputs;
+
+  int calls = 0;
+  std::map<int, float> seen;
+  void operator()(int frames)
+  {
+    calls++;
+    for(auto& [frame, value] : inputs.gain.values)
+      seen[frame] = value;
+  }
+};
+
+// Timed values in a span: the binding owns their storage
+struct span_gain : gain_slider
+{
+  struct timed_value
+  {
+    int frame;
+    float value;
+  };
+  std::span<timed_value> values;
+};
+
+// Instantiated once per channel
+struct MultiAccurateReader
+{
+  halp_meta(name, "Multi accurate reader")
+  halp_meta(c_name, "multi_accurate_reader")
+  halp_meta(uuid, "7a2e4d10-3c5b-4f8e-9b16-2d0c8e5f1a23")
+
+  struct
+  {
+    span_gain gain;
+  } inputs;
+
+  std::vector<std::pair<int, float>> seen;
+  void operator()(double* in, double* out, int frames)
+  {
+    for(auto& v : inputs.gain.values)
+      seen.emplace_back(v.frame, v.value);
+  }
+};
+
+// The points of a single parameter, as a host sends them
+struct param_queue final : IParamValueQueue
+{
+  ParamID id{};
+  std::vector<std::pair<int32, ParamValue>> points;
+
+  tresult PLUGIN_API queryInterface(const TUID, void** obj) override
+  {
+    *obj = nullptr;
+    return kNoInterface;
+  }
+  uint32 PLUGIN_API addRef() override { return 1; }
+  uint32 PLUGIN_API release() override { return 1; }
+
+  ParamID PLUGIN_API getParameterId() override { return id; }
+  int32 PLUGIN_API getPointCount() override { return int32(points.size()); }
+  tresult PLUGIN_API
+  getPoint(int32 index, int32& sampleOffset, ParamValue& value) override
+  {
+    if(index < 0 || index >= getPointCount())
+      return kResultFalse;
+    sampleOffset = points[index].first;
+    value = points[index].second;
+    return kResultTrue;
+  }
+  tresult PLUGIN_API addPoint(int32 sampleOffset, ParamValue value, int32& index) override
+  {
+    index = int32(points.size());
+    points.emplace_back(sampleOffset, value);
+    return kResultTrue;
+  }
+};
+
+struct param_changes final : IParameterChanges
+{
+  std::vector<param_queue> queues;
+
+  tresult PLUGIN_API queryInterface(const TUID, void** obj) override
+  {
+    *obj = nullptr;
+    return kNoInterface;
+  }
+  uint32 PLUGIN_API addRef() override { return 1; }
+  uint32 PLUGIN_API release() override { return 1; }
+
+  int32 PLUGIN_API getParameterCount() override { return int32(queues.size()); }
+  IParamValueQueue* PLUGIN_API getParameterData(int32 index) override
+  {
+    return index >= 0 && index < getParameterCount() ? &queues[index] : nullptr;
+  }
+  IParamValueQueue* PLUGIN_API addParameterData(const ParamID& id, int32& index) override
+  {
+    index = getParameterCount();
+    auto& queue = queues.emplace_back();
+    queue.id = id;
+    return &queue;
+  }
+
+  void add(ParamID id, std::vector<std::pair<int32, ParamValue>> points)
+  {
+    int32 index{};
+    static_cast<param_queue*>(addParameterData(id, index))->points = std::move(points);
+  }
+};
+
+constexpr int32 frames = 64;
+
+template <typename T, int Channels = 1>
+std::array<double, frames> run_one_block(stv3::Component<T>& fx, param_changes& changes)
+{
+  ProcessSetup setup{};
+  setup.processMode = kRealtime;
+  setup.symbolicSampleSize = kSample64;
+  setup.maxSamplesPerBlock = frames;
+  setup.sampleRate = 48000.;
+  REQUIRE(fx.setupProcessing(setup) == kResultOk);
+
+  std::array<std::array<double, frames>, Channels> in{}, out{};
+  double* in_ptrs[Channels];
+  double* out_ptrs[Channels];
+  for(int c = 0; c < Channels; c++)
+  {
+    in_ptrs[c] = in[c].data();
+    out_ptrs[c] = out[c].data();
+  }
+  AudioBusBuffers in_bus;
+  in_bus.numChannels = Channels;
+  in_bus.channelBuffers64 = in_ptrs;
+  AudioBusBuffers out_bus;
+  out_bus.numChannels = Channels;
+  out_bus.channelBuffers64 = out_ptrs;
+
+  ProcessData data;
+  data.processMode = kRealtime;
+  data.symbolicSampleSize = kSample64;
+  data.numSamples = frames;
+  data.numInputs = 1;
+  data.numOutputs = 1;
+  data.inputs = &in_bus;
+  data.outputs = &out_bus;
+  data.inputParameterChanges = &changes;
+  REQUIRE(fx.process(data) == kResultOk);
+  return out[0];
+}
+
+template <typename T, int Channels = 1>
+std::array<double, frames> run_one_block(stv3::Component<T>& fx, ParamID param = 1)
+{
+  // The gain goes from 0 to 1: normalized and plain values are the same
+  param_changes changes;
+  changes.add(param, {{16, 0.5}, {40, 1.0}});
+  return run_one_block<T, Channels>(fx, changes);
+}
+}
+
+TEST_CASE("vst3: blocks are split at parameter changes", "[vst3][sample-accurate]")
+{
+  auto fx = std::make_unique<stv3::Component<SplitWriter>>();
+  const auto out = run_one_block(*fx);
+
+  REQUIRE(fx->effect.effect.calls == 3);
+  for(int32 i = 0; i < 16; i++)
+    REQUIRE(out[i] == Catch::Approx(0.));
+  for(int32 i = 16; i < 40; i++)
+    REQUIRE(out[i] == Catch::Approx(0.5));
+  for(int32 i = 40; i < frames; i++)
+    REQUIRE(out[i] == Catch::Approx(1.));
+}
+
+TEST_CASE("vst3: queues of unknown parameters are skipped", "[vst3][sample-accurate]")
+{
+  // More queues than parameters, the gain one last: 0 is the audio bus
+  param_changes changes;
+  changes.add(7, {{8, 0.25}});
+  changes.add(0, {{24, 0.75}});
+  changes.add(1, {{16, 0.5}, {40, 1.0}});
+
+  auto fx = std::make_unique<stv3::Component<SplitWriter>>();
+  const auto out = run_one_block(*fx, changes);
+
+  REQUIRE(fx->effect.effect.calls == 3);
+  for(int32 i = 0; i < 16; i++)
+    REQUIRE(out[i] == Catch::Approx(0.));
+  for(int32 i = 16; i < 40; i++)
+    REQUIRE(out[i] == Catch::Approx(0.5));
+  for(int32 i = 40; i < frames; i++)
+    REQUIRE(out[i] == Catch::Approx(1.));
+}
+
+TEST_CASE("vst3: untagged processors see the last value", "[vst3][sample-accurate]")
+{
+  auto fx = std::make_unique<stv3::Component<PlainWriter>>();
+  const auto out = run_one_block(*fx);
+
+  REQUIRE(fx->effect.effect.calls == 1);
+  for(int32 i = 0; i < frames; i++)
+    REQUIRE(out[i] == Catch::Approx(1.));
+}
+
+TEST_CASE("vst3: sample-accurate controls get timed values", "[vst3][sample-accurate]")
+{
+  auto fx = std::make_unique<stv3::Component<AccurateReader>>();
+  run_one_block(*fx);
+
+  // Changes of sample-accurate controls never split the block
+  REQUIRE(fx->effect.effect.calls == 1);
+  REQUIRE(fx->effect.effect.seen.size() == 2);
+  REQUIRE(fx->effect.effect.seen[16] == Catch::Approx(0.5f));
+  REQUIRE(fx->effect.effect.seen[40] == Catch::Approx(1.f));
+  REQUIRE(fx->effect.effect.inputs.gain.value == Catch::Approx(1.f));
+}
+
+TEST_CASE("vst3: each instance gets the timed values once", "[vst3][sample-accurate]")
+{
+  using T = MultiAccurateReader;
+  static_assert(avnd::monophonic_audio_processor<T>);
+
+  auto fx = std::make_unique<stv3::Component<T>>();
+  run_one_block<T, 2>(*fx, 0);
+
+  REQUIRE(fx->effect.effect.size() == 2);
+  for(auto& instance : fx->effect.effect)
+  {
+    REQUIRE(instance.seen.size() == 2);
+    REQUIRE(instance.seen[0].first == 16);
+    REQUIRE(instance.seen[0].second == Catch::Approx(0.5f));
+    REQUIRE(instance.seen[1].first == 40);
+    REQUIRE(instance.seen[1].second == Catch::Approx(1.f));
+    REQUIRE(instance.inputs.gain.value == Catch::Approx(1.f));
+  }
+}
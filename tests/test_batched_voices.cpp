@@ -0,0 +1,169 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+// avnd::batched_voices: voices rendered in SIMD lanes give the same mix as
+// rendering each voice on its own, and finished voices are recycled.
+
+#include <catch2/catch_all.hpp>
+
+#include <avnd/wrappers/batched_voices.hpp>
+
+#include <cmath>
+#include <vector>
+
+namespace
+{
+// Decaying sine voices, with all their state as structures of arrays.
+// Accumulate: the voices add to their outputs, as the per-voice synths do.
+template <bool Accumulate>
+struct LaneSynthT
+{
+  template <typename V>
+  struct voice_lanes
+  {
+    static constexpr int N = V::lanes;
+    using FP = typename V::value_type;
+
+    V phase{};
+    V increment{};
+    V gain{};
+    V decay{};
+
+    void start(int lane, int note, float velocity)
+    {
+      phase[lane] = 0;
+      increment[lane] = FP(note) / 1000.;
+      gain[lane] = velocity / 127.;
+      decay[lane] = 1.;
+    }
+    void release(int lane) { decay[lane] = 0.5; }
+    bool finished(int lane) const { return gain[lane] < 1e-6; }
+
+    void operator()(LaneSynthT& synth, V** out, int frames)
+    {
+      using std::sin;
+      for(int i = 0; i < frames; i++)
+      {
+        const V s = sin(phase) * gain * V(synth.volume);
+        if constexpr(Accumulate)
+        {
+          out[0][i] += s;
+          out[1][i] += s * V(0.5);
+        }
+        else
+        {
+          out[0][i] = s;
+          out[1][i] = s * V(0.5);
+        }
+        phase += increment;
+        gain *= decay;
+      }
+    }
+  };
+
+  double volume = 0.5;
+};
+using LaneSynth = LaneSynthT<false>;
+using AccumulatingLaneSynth = LaneSynthT<true>;
+
+// The same voice, rendered alone
+struct reference_voice
+{
+  int note;
+  float velocity;
+  int released_at = -1;
+
+  double sample(int t) const
+  {
+    double gain = velocity / 127.;
+    if(released_at >= 0 && t > released_at)
+      gain *= std::pow(0.5, t - released_at);
+    return std::sin(t * (note / 1000.)) * gain * 0.5;
+  }
+};
+
+static_assert(avnd::batched_synth_processor<LaneSynth, avnd::simd_lane_type<float>>);
+static_assert(avnd::batched_synth_processor<LaneSynth, avnd::simd_lane_type<double>>);
+
+template <typename Synth>
+void check_mix()
+{
+  Synth synth;
+  avnd::batched_voices<Synth, double, 64> voices;
+  constexpr int frames = 48;
+  voices.reserve(2, frames);
+
+  // More voices than lanes in a pack, spread over several groups
+  std::vector<reference_voice> refs;
+  for(int k = 0; k < 11; k++)
+  {
+    refs.push_back({30 + 3 * k, float(40 + 5 * k)});
+    voices.note_on(refs.back().note, refs.back().velocity);
+  }
+  REQUIRE(voices.size() == 11);
+
+  std::vector<double> left(2 * frames), right(2 * frames);
+  double* outs[2] = {left.data(), right.data()};
+
+  // Blocks larger than the reserved size are rendered in several passes
+  voices.render(synth, outs, 2, 2 * frames);
+
+  for(int i = 0; i < 2 * frames; i++)
+  {
+    double expected = 0.;
+    for(auto& r : refs)
+      expected += r.sample(i);
+    REQUIRE(left[i] == Catch::Approx(expected).margin(1e-12));
+    REQUIRE(right[i] == Catch::Approx(0.5 * expected).margin(1e-12));
+  }
+}
+}
+
+TEST_CASE("batched_voices: same mix as one voice at a time", "[voices][simd]")
+{
+  check_mix<LaneSynth>();
+}
+
+TEST_CASE("batched_voices: voices adding to their outputs", "[voices][simd]")
+{
+  // Each group and each pass gets a cleared buffer
+  check_mix<AccumulatingLaneSynth>();
+}
+
+TEST_CASE("batched_voices: release and recycling", "[voices][simd]")
+{
+  LaneSynth synth;
+  avnd::batched_voices<LaneSynth, float, 16> voices;
+  constexpr int frames = 64;
+  voices.reserve(2, frames);
+
+  std::vector<float> left(frames), right(frames);
+  float* outs[2] = {left.data(), right.data()};
+
+  for(int note = 40; note < 50; note++)
+    voices.note_on(note, 100);
+  voices.note_off(42);
+  voices.note_off(43);
+
+  // The released voices decay to silence within the block and are recycled
+  voices.render(synth, outs, 2, frames);
+  REQUIRE(voices.size() == 8);
+
+  // Past the capacity, voices are stolen and the count stays the same
+  for(int note = 60; note < 80; note++)
+    voices.note_on(note, 100);
+  REQUIRE(voices.size() == 16);
+  REQUIRE(voices.stolen() == 12);
+
+  for(int note = 60; note < 80; note++)
+    voices.note_off(note);
+  for(int note = 40; note < 50; note++)
+    voices.note_off(note);
+  voices.render(synth, outs, 2, frames);
+  REQUIRE(voices.size() == 0);
+
+  // Nothing is left to mix
+  std::fill(left.begin(), left.end(), 0.f);
+  voices.render(synth, outs, 2, frames);
+  for(float s : left)
+    REQUIRE(s == 0.f);
+}
@@ -0,0 +1,81 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+// halp::curve_evaluator gives the same values as Curve::value_at, for
+// monotonic and random positions, with and without the baked tables.
+
+#include <catch2/catch_all.hpp>
+
+#include <halp/curve.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace
+{
+halp::power_curve make_power_curve()
+{
+  halp::power_curve curve;
+  const float xs[] = {0.f, 0.1f, 0.35f, 0.5f, 0.8f, 1.f};
+  const float gammas[] = {2.5f, 0.5f, 1.f, 4.f, 0.2f};
+  for(int i = 0; i < 5; i++)
+  {
+    halp::power_curve_segment s;
+    s.start = {xs[i], float(i % 2)};
+    s.end = {xs[i + 1], float((i + 1) % 2)};
+    s.gamma = gammas[i];
+    curve.push_back(s);
+  }
+  return curve;
+}
+
+std::vector<float> positions(int n)
+{
+  // Playback, then random jumps
+  std::vector<float> pos(n);
+  for(int i = 0; i < n; i++)
+    pos[i] = 1.1f * i / n;
+  std::mt19937 gen(n);
+  std::shuffle(pos.begin() + n / 2, pos.end(), gen);
+  return pos;
+}
+}
+
+TEST_CASE("curve evaluator: power curve", "[curve]")
+{
+  auto curve = make_power_curve();
+  const auto pos = positions(4096);
+  std::vector<float> out(pos.size());
+
+  halp::curve_evaluator<halp::power_curve> direct;
+  direct.value_at(curve, pos.data(), out.data(), pos.size());
+  for(std::size_t i = 0; i < pos.size(); i++)
+  {
+    REQUIRE(out[i] == curve.value_at(pos[i]));
+    REQUIRE(direct.value_at(curve, pos[i]) == curve.value_at(pos[i]));
+  }
+
+  halp::curve_evaluator<halp::power_curve> baked;
+  baked.bake(curve, 1024);
+  baked.value_at(curve, pos.data(), out.data(), pos.size());
+  for(std::size_t i = 0; i < pos.size(); i++)
+    REQUIRE(out[i] == Catch::Approx(curve.value_at(pos[i])).margin(1e-4));
+
+  // Tables are not used anymore for segments modified after baking
+  curve[3].gamma = 3.f;
+  baked.value_at(curve, pos.data(), out.data(), pos.size());
+  for(std::size_t i = 0; i < pos.size(); i++)
+    REQUIRE(out[i] == Catch::Approx(curve.value_at(pos[i])).margin(1e-4));
+}
+
+TEST_CASE("curve evaluator: custom curve", "[curve]")
+{
+  halp::custom_curve curve;
+  curve.push_back({0.f, 0.5f, [](float x) { return 2.f * x; }});
+  curve.push_back({0.5f, 1.f, [](float x) { return 1.f - x; }});
+
+  const auto pos = positions(1024);
+  halp::curve_evaluator<halp::custom_curve> eval;
+  for(float p : pos)
+    REQUIRE(eval.value_at(curve, p) == curve.value_at(p));
+}
@@ -0,0 +1,200 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+// halp::deferred_logger: formatting on the background thread, what happens
+// when the queue of a thread is full, rate limiting, and logging from a block
+// processed on an audio thread, as the bindings using it run them.
+// halp::audio_deferred_logger: only the attached threads are deferred.
+
+#include <catch2/catch_all.hpp>
+
+#include <avnd/concepts/logger.hpp>
+#include <avnd/wrappers/configure.hpp>
+#include <avnd/wrappers/effect_container.hpp>
+#include <avnd/wrappers/process_adapter.hpp>
+#include <halp/deferred_log.hpp>
+#include <halp/log.hpp>
+#include <halp/meta.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+struct captured_lines
+{
+  std::mutex mutex;
+  std::vector<std::pair<halp::log_level, std::string>> lines;
+
+  // While set, the background thread waits on the first line it prints
+  std::atomic_bool paused{};
+
+  captured_lines()
+  {
+    halp::deferred_logger::set_sink([this](halp::log_level l, std::string_view s) {
+      while(paused.load())
+        std::this_thread::yield();
+      std::lock_guard _{mutex};
+      lines.emplace_back(l, std::string(s));
+    });
+  }
+  ~captured_lines() { halp::deferred_logger::set_sink({}); }
+};
+
+struct deferred_config
+{
+  using logger_type = halp::deferred_logger;
+};
+
+template <typename C>
+struct BlockLogger
+{
+  halp_meta(name, "Block logger")
+  halp_meta(c_name, "test_block_logger")
+  halp_meta(uuid, "5b8e2f47-1c3a-4d6e-9f02-7a4b3c5d6e81")
+
+  [[no_unique_address]] typename C::logger_type logger;
+
+  int blocks = 0;
+  void operator()(int frames) { logger.info("block {}: {} frames", blocks++, frames); }
+};
+}
+
+static_assert(avnd::audio_thread_logger<halp::deferred_logger>);
+static_assert(avnd::audio_thread_logger<halp::audio_deferred_logger>);
+static_assert(!avnd::audio_thread_logger<halp::basic_logger>);
+static_assert(!avnd::audio_thread_logger<halp::no_logger>);
+
+TEST_CASE("deferred_logger: formatting", "[log]")
+{
+  halp::deferred_logger logger;
+  captured_lines captured;
+  halp::deferred_logger::set_rate_limit(0);
+
+  std::string temporary = "temporary";
+  bool attached = false;
+  std::thread{[&] {
+    attached = halp::deferred_logger::attach();
+    logger.info("int {} float {} bool {}", -12, 0.5f, true);
+    logger.error("{} {} {}", "literal", temporary, std::string_view{"view"});
+    logger.trace("no argument");
+  }}.join();
+  temporary = "changed";
+
+  REQUIRE(attached);
+  halp::deferred_logger::flush();
+  REQUIRE(captured.lines.size() == 3);
+  REQUIRE(captured.lines[0].first == halp::log_level::info);
+  REQUIRE(captured.lines[0].second == "int -12 float 0.5 bool true");
+  REQUIRE(captured.lines[1].first == halp::log_level::error);
+  REQUIRE(captured.lines[1].second == "literal temporary view");
+  REQUIRE(captured.lines[2].second == "no argument");
+}
+
+TEST_CASE("deferred_logger: full queue", "[log]")
+{
+  halp::deferred_logger logger;
+  captured_lines captured;
+  halp::deferred_logger::set_rate_limit(0);
+
+  // Nothing is printed while the thread logs: the queue must overflow
+  constexpr int capacity = halp::detail::deferred_log_ring::capacity;
+  const auto dropped = halp::deferred_logger::dropped();
+  constexpr int count = 4 * capacity;
+  captured.paused = true;
+  std::thread{[&] {
+    for(int i = 0; i < count; i++)
+      logger.debug("{}", i);
+  }}.join();
+  captured.paused = false;
+  halp::deferred_logger::flush();
+
+  // Everything is either printed, in order, or counted
+  std::size_t printed = 0;
+  int last = -1;
+  for(auto& [level, line] : captured.lines)
+  {
+    if(level != halp::log_level::debug)
+      continue;
+    const int i = std::stoi(line);
+    REQUIRE(i > last);
+    last = i;
+    printed++;
+  }
+  REQUIRE(printed <= capacity);
+  REQUIRE(printed + (halp::deferred_logger::dropped() - dropped) == count);
+}
+
+TEST_CASE("deferred_logger: rate limit", "[log]")
+{
+  halp::deferred_logger logger;
+  halp::deferred_logger::flush();
+  captured_lines captured;
+  halp::deferred_logger::set_rate_limit(10);
+
+  const auto suppressed = halp::deferred_logger::suppressed();
+  for(int i = 0; i < 50; i++)
+    logger.warn("line {}", i);
+  halp::deferred_logger::flush();
+  halp::deferred_logger::set_rate_limit(200);
+
+  // At most 10 lines for the current second, and a summary
+  REQUIRE(captured.lines.size() >= 2);
+  REQUIRE(captured.lines.size() <= 11);
+  REQUIRE(
+      captured.lines.size() - 1 + halp::deferred_logger::suppressed() - suppressed == 50);
+  REQUIRE(captured.lines.back().second.find("suppressed") != std::string::npos);
+}
+
+TEST_CASE("deferred_logger: logging from a processed block", "[log]")
+{
+  using config = deferred_config;
+  using T = decltype(avnd::configure<config, BlockLogger>())::type;
+  captured_lines captured;
+  halp::deferred_logger::set_rate_limit(0);
+
+  avnd::effect_container<T> effect;
+  avnd::process_adapter<T> processor;
+  const auto dropped = halp::deferred_logger::dropped();
+
+  // The audio thread of a binding: attach, then process
+  std::thread{[&] {
+    for(int block = 0; block < 3; block++)
+    {
+      if constexpr(avnd::audio_thread_logger<config::logger_type>)
+        config::logger_type::attach();
+      processor.process(effect, avnd::span<float*>{}, avnd::span<float*>{}, 64);
+    }
+  }}.join();
+
+  // Drained on the main thread
+  halp::deferred_logger::flush();
+  REQUIRE(captured.lines.size() == 3);
+  REQUIRE(captured.lines[0].second == "block 0: 64 frames");
+  REQUIRE(captured.lines[2].second == "block 2: 64 frames");
+  REQUIRE(halp::deferred_logger::dropped() == dropped);
+}
+
+TEST_CASE("audio_deferred_logger: only attached threads are deferred", "[log]")
+{
+  halp::audio_deferred_logger logger;
+  halp::deferred_logger::flush();
+  captured_lines captured;
+  halp::deferred_logger::set_rate_limit(0);
+
+  // Printed right away by basic_logger, not through the sink
+  REQUIRE(!halp::deferred_logger::attached());
+  logger.info("main thread {}", 1);
+  REQUIRE(!halp::deferred_logger::attached());
+
+  std::thread{[&] {
+    REQUIRE(halp::audio_deferred_logger::attach());
+    logger.info("audio thread {}", 2);
+  }}.join();
+
+  halp::deferred_logger::flush();
+  REQUIRE(captured.lines.size() == 1);
+  REQUIRE(captured.lines[0].second == "audio thread 2");
+}
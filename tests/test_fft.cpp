@@ -0,0 +1,62 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+// halp::fft against a direct DFT, for power-of-two sizes (planned transform)
+// and other sizes (direct fallback), forward and inverse.
+
+#include <catch2/catch_all.hpp>
+
+#include <halp/fft.hpp>
+
+#include <cmath>
+#include <complex>
+#include <random>
+#include <vector>
+
+namespace
+{
+template <typename FP>
+void check_roundtrip(std::size_t N, double tolerance)
+{
+  halp::fft<FP> fft;
+  fft.reset(N);
+
+  std::vector<FP> x(N);
+  std::mt19937 gen(N);
+  std::uniform_real_distribution<double> dist(-1., 1.);
+  for(auto& v : x)
+    v = dist(gen);
+
+  const auto* X = fft.execute(x.data(), N);
+  for(std::size_t k = 0; k < N; k++)
+  {
+    std::complex<double> expected{};
+    for(std::size_t n = 0; n < N; n++)
+      expected += double(x[n])
+                  * std::polar(1., -2. * M_PI * double(k * n % N) / double(N));
+    REQUIRE(std::abs(expected - std::complex<double>(X[k])) < tolerance);
+  }
+
+  std::vector<std::complex<FP>> spectrum(X, X + N);
+  const auto* y = fft.execute(spectrum.data(), N);
+  for(std::size_t n = 0; n < N; n++)
+    REQUIRE(std::abs(double(y[n]) * fft.normalization(N) - double(x[n])) < tolerance);
+}
+}
+
+TEST_CASE("fft matches the DFT", "[fft]")
+{
+  for(std::size_t N : {1, 2, 4, 8, 64, 1024})
+  {
+    check_roundtrip<double>(N, 1e-9);
+    check_roundtrip<float>(N, 1e-4);
+  }
+}
+
+TEST_CASE("fft of sizes which are not a power of two", "[fft]")
+{
+  for(std::size_t N : {3, 6, 100})
+  {
+    check_roundtrip<double>(N, 1e-9);
+    check_roundtrip<float>(N, 1e-4);
+  }
+}
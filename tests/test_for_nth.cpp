@@ -0,0 +1,154 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+// avnd::for_nth_of / for_nth: runtime index to compile-time index dispatch,
+// through the chain of comparisons (few indices) and the jump table (more
+// indices), and predicate_introspection::for_nth_raw / for_nth_mapped on top.
+
+#include <catch2/catch_all.hpp>
+
+#include <avnd/common/for_nth.hpp>
+#include <avnd/common/struct_reflection.hpp>
+
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+// Runs for_nth_of<N>(Indices{}, k) for every k around [0; N[ and returns,
+// for each k, the compile-time index which was called (or -1).
+template <std::size_t N, typename Indices>
+std::vector<int> dispatch_all(Indices seq, int lo, int hi)
+{
+  std::vector<int> res;
+  for(int k = lo; k < hi; k++)
+  {
+    int called = -1;
+    int count = 0;
+    avnd::for_nth_of<N>(seq, k, [&]<auto Index>() {
+      called = static_cast<int>(Index);
+      count++;
+    });
+    REQUIRE(count <= 1);
+    res.push_back(called);
+  }
+  return res;
+}
+
+struct mixed
+{
+  int a;
+  float b;
+  int c;
+  int d;
+  float e;
+  int f;
+  float g;
+  int h;
+};
+
+template <typename T>
+using is_int = std::is_same<T, int>;
+template <typename T>
+using is_float = std::is_same<T, float>;
+
+using ints = avnd::predicate_introspection<mixed, is_int>;
+using floats = avnd::predicate_introspection<mixed, is_float>;
+}
+
+TEST_CASE("for_nth: dense indices, fold and table", "[for_nth]")
+{
+  static_assert(avnd::detail::for_nth_table_threshold == 4);
+
+  // Fold path
+  REQUIRE(
+      dispatch_all<3>(std::make_index_sequence<3>{}, -3, 6)
+      == std::vector<int>{-1, -1, -1, 0, 1, 2, -1, -1, -1});
+  REQUIRE(
+      dispatch_all<4>(std::make_index_sequence<4>{}, -1, 5)
+      == std::vector<int>{-1, 0, 1, 2, 3, -1});
+
+  // Table path
+  REQUIRE(
+      dispatch_all<5>(std::make_index_sequence<5>{}, -1, 6)
+      == std::vector<int>{-1, 0, 1, 2, 3, 4, -1});
+
+  std::vector<int> expected;
+  expected.push_back(-1);
+  for(int i = 0; i < 32; i++)
+    expected.push_back(i);
+  expected.push_back(-1);
+  REQUIRE(dispatch_all<32>(std::make_index_sequence<32>{}, -1, 33) == expected);
+
+  // for_nth is for_nth_of over [0; N[
+  for(int k : {-100, -1, 0, 7, 8, 1000})
+  {
+    int called = -1;
+    avnd::for_nth<8>(k, [&]<std::size_t Index>() { called = Index; });
+    REQUIRE(called == (k >= 0 && k < 8 ? k : -1));
+  }
+
+  // No index at all
+  int count = 0;
+  avnd::for_nth<0>(0, [&]<std::size_t>() { count++; });
+  REQUIRE(count == 0);
+}
+
+TEST_CASE("for_nth: sparse indices, fold and table", "[for_nth]")
+{
+  // Fold path: only the listed indices fire
+  REQUIRE(
+      dispatch_all<10>(std::integer_sequence<int, 2, 5, 9>{}, -2, 12)
+      == std::vector<int>{-1, -1, -1, -1, 2, -1, -1, 5, -1, -1, -1, 9, -1, -1});
+
+  // Table path: the table has N entries, the holes do nothing
+  REQUIRE(
+      dispatch_all<10>(std::integer_sequence<int, 1, 3, 4, 6, 7, 9>{}, -2, 12)
+      == std::vector<int>{-1, -1, -1, 1, -1, 3, 4, -1, 6, 7, -1, 9, -1, -1});
+}
+
+TEST_CASE("for_nth: predicate_introspection on a struct of 8 fields", "[for_nth]")
+{
+  static_assert(ints::size == 5);
+  static_assert(floats::size == 3);
+  REQUIRE(
+      std::vector<int>(ints::index_map.begin(), ints::index_map.end())
+      == std::vector<int>{0, 2, 3, 5, 7});
+  REQUIRE(
+      std::vector<int>(floats::index_map.begin(), floats::index_map.end())
+      == std::vector<int>{1, 4, 6});
+
+  auto raw = []<typename Introspection>(Introspection, int n) {
+    int called = -1;
+    Introspection::for_nth_raw(
+        n, [&]<std::size_t Idx, typename F>(avnd::field_reflection<Idx, F>) {
+      called = Idx;
+    });
+    return called;
+  };
+  auto mapped = []<typename Introspection>(Introspection, int n) {
+    int called = -1;
+    Introspection::for_nth_mapped(
+        n, [&]<std::size_t Idx, typename F>(avnd::field_reflection<Idx, F>) {
+      called = Idx;
+    });
+    return called;
+  };
+
+  // for_nth_raw takes the index in the struct: only matching fields fire.
+  // 5 ints go through the table, 3 floats through the fold.
+  const std::vector<int> raw_ints{-1, -1, 0, -1, 2, 3, -1, 5, -1, 7, -1, -1};
+  const std::vector<int> raw_floats{-1, -1, -1, 1, -1, -1, 4, -1, 6, -1, -1, -1};
+  for(int n = -2; n < 10; n++)
+  {
+    REQUIRE(raw(ints{}, n) == raw_ints[n + 2]);
+    REQUIRE(raw(floats{}, n) == raw_floats[n + 2]);
+  }
+
+  // for_nth_mapped takes the index among the matching fields and goes
+  // through the (non-identity) index_map
+  for(int n = -2; n < 7; n++)
+  {
+    REQUIRE(mapped(ints{}, n) == (n >= 0 && n < 5 ? int(ints::index_map[n]) : -1));
+    REQUIRE(mapped(floats{}, n) == (n >= 0 && n < 3 ? int(floats::index_map[n]) : -1));
+  }
+}
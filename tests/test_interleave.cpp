@@ -0,0 +1,81 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+// avnd::deinterleave_samples / interleave_samples: every channel count, with
+// and without the fixed-channel kernels, and frame counts around their block,
+// and the conversions from and to integer samples.
+
+#include <catch2/catch_all.hpp>
+
+#include <avnd/wrappers/audio_buffer.hpp>
+
+#include <cstdint>
+#include <vector>
+
+TEST_CASE("interleave round trip", "[audio]")
+{
+  for(int channels = 1; channels <= 9; channels++)
+  {
+    for(std::size_t frames : {0, 1, 15, 16, 17, 33, 256})
+    {
+      std::vector<float> interleaved(channels * frames);
+      for(std::size_t i = 0; i < interleaved.size(); i++)
+        interleaved[i] = float(i);
+
+      std::vector<std::vector<double>> planar(channels, std::vector<double>(frames));
+      std::vector<double*> ptrs;
+      for(auto& p : planar)
+        ptrs.push_back(p.data());
+
+      avnd::deinterleave_samples(interleaved.data(), ptrs.data(), channels, frames);
+      for(int c = 0; c < channels; c++)
+        for(std::size_t i = 0; i < frames; i++)
+          REQUIRE(planar[c][i] == double(i * channels + c));
+
+      std::vector<float> back(channels * frames, -1.f);
+      avnd::interleave_samples(ptrs.data(), back.data(), channels, frames);
+      REQUIRE(back == interleaved);
+    }
+  }
+}
+
+TEST_CASE("integer sample conversion", "[audio]")
+{
+  REQUIRE(avnd::sample_cast<float>(int16_t(-32768)) == -1.f);
+  REQUIRE(avnd::sample_cast<float>(int16_t(16384)) == 0.5f);
+  REQUIRE(avnd::sample_cast<int16_t>(0.5f) == 16384);
+  REQUIRE(avnd::sample_cast<int16_t>(2.f) == 32767);
+  REQUIRE(avnd::sample_cast<int16_t>(-2.f) == -32768);
+  REQUIRE(avnd::sample_cast<int32_t>(1.0) == 2147483647);
+  REQUIRE(avnd::sample_cast<int32_t>(-1.0) == -2147483647 - 1);
+
+  const int channels = 3;
+  const std::size_t frames = 40;
+  std::vector<int16_t> in16(channels * frames);
+  std::vector<int32_t> in32(channels * frames);
+  for(std::size_t i = 0; i < in16.size(); i++)
+  {
+    in16[i] = int16_t(i * 1637 - 32768);
+    in32[i] = int32_t(i * 107374183 - 2147483647);
+  }
+
+  std::vector<std::vector<float>> planar_f(channels, std::vector<float>(frames));
+  std::vector<std::vector<double>> planar_d(channels, std::vector<double>(frames));
+  std::vector<float*> ptrs_f;
+  std::vector<double*> ptrs_d;
+  for(int c = 0; c < channels; c++)
+  {
+    ptrs_f.push_back(planar_f[c].data());
+    ptrs_d.push_back(planar_d[c].data());
+  }
+
+  // int16_t is exact in float, int32_t in double
+  avnd::deinterleave_samples(in16.data(), ptrs_f.data(), channels, frames);
+  std::vector<int16_t> out16(in16.size());
+  avnd::interleave_samples(ptrs_f.data(), out16.data(), channels, frames);
+  REQUIRE(out16 == in16);
+
+  avnd::deinterleave_samples(in32.data(), ptrs_d.data(), channels, frames);
+  std::vector<int32_t> out32(in32.size());
+  avnd::interleave_samples(ptrs_d.data(), out32.data(), channels, frames);
+  REQUIRE(out32 == in32);
+}
@@ -0,0 +1,195 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+// halp::midi_event: MIDI 1.0 <-> UMP conversions, and merging of several
+// sources in a single timestamp-ordered sequence.
+// halp::midi_bytes: messages moved out of a block own their payload.
+
+#include <catch2/catch_all.hpp>
+
+#include <halp/midi.hpp>
+#include <halp/midi_event.hpp>
+#include <halp/midifile_port.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+std::vector<uint8_t> to_bytes(std::span<const halp::midi_event> events)
+{
+  std::vector<uint8_t> res;
+  for(auto& e : events)
+  {
+    uint8_t buf[8];
+    const int n = halp::midi1_from_event(e, buf);
+    res.insert(res.end(), buf, buf + n);
+  }
+  return res;
+}
+
+std::vector<halp::midi_event> to_events(const std::vector<uint8_t>& bytes)
+{
+  std::vector<halp::midi_event> res;
+  halp::midi1_to_events(
+      bytes.data(), bytes.size(), 0, [&](const halp::midi_event& e) { res.push_back(e); });
+  return res;
+}
+}
+
+TEST_CASE("midi_event: MIDI 1.0 round trip", "[midi]")
+{
+  for(std::vector<uint8_t> msg :
+      {std::vector<uint8_t>{0x93, 60, 100}, {0x80, 61, 0}, {0xB2, 7, 127}, {0xC1, 12},
+       {0xE0, 0, 64}, {0xF8}, {0xF2, 1, 2}})
+  {
+    const auto events = to_events(msg);
+    REQUIRE(events.size() == 1);
+    REQUIRE(to_bytes(events) == msg);
+  }
+
+  auto on = halp::midi_event::midi1(0x93, 60, 100, 12);
+  REQUIRE(on.message_type() == 0x2);
+  REQUIRE(on.channel() == 3);
+  REQUIRE(on.is_note_on());
+  REQUIRE(!on.is_note_off());
+  REQUIRE(halp::midi_event::midi1(0x90, 60, 0, 0).is_note_off());
+}
+
+TEST_CASE("midi_event: sysex packets", "[midi]")
+{
+  for(int payload : {0, 1, 6, 7, 12, 13, 100})
+  {
+    std::vector<uint8_t> sysex{0xF0};
+    for(int i = 0; i < payload; i++)
+      sysex.push_back(uint8_t(i & 0x7F));
+    sysex.push_back(0xF7);
+
+    const auto events = to_events(sysex);
+    REQUIRE(
+        int(events.size()) == halp::midi1_event_count(sysex.data(), sysex.size()));
+    REQUIRE(int(events.size()) == std::max(1, (payload + 5) / 6));
+    for(auto& e : events)
+      REQUIRE(e.message_type() == 0x3);
+    REQUIRE(to_bytes(events) == sysex);
+  }
+}
+
+TEST_CASE("midi_event_merger", "[midi]")
+{
+  halp::midi_event_merger merger;
+  merger.reserve(64);
+
+  halp::midi_bus<"In"> host;
+  host.push_back({.bytes = {0x90, 60, 100}, .timestamp = 0});
+  host.push_back({.bytes = {0x90, 64, 100}, .timestamp = 10});
+  host.push_back({.bytes = {0xF0, 1, 2, 3, 4, 5, 6, 7, 0xF7}, .timestamp = 20});
+  host.push_back({.bytes = {0x80, 60, 0}, .timestamp = 30});
+
+  // e.g. a midifile_port track, with its ticks converted to frames
+  std::vector<halp::simple_midi_track_event> track{
+      {{0x91, 40, 90}, 5}, {{0x91, 41, 90}, 20}, {{0x81, 40, 0}, 25}};
+
+  for(int block = 0; block < 2; block++)
+  {
+    merger.clear();
+    merger.add(host, 0);
+    merger.add(track, 1, [](const auto& ev, auto emit) {
+      emit(halp::midi_event::midi1(
+          ev.bytes[0], ev.bytes[1], ev.bytes[2], int32_t(ev.tick_absolute)));
+    });
+
+    // Generated notes, pushed out of order
+    merger.begin_source(2);
+    merger.push(halp::midi_event::midi1(0x82, 70, 0, 20));
+    merger.push(halp::midi_event::midi1(0x92, 70, 100, 3));
+
+    const auto events = merger.merge();
+    REQUIRE(events.size() == 10);
+    REQUIRE(merger.dropped() == 0);
+
+    for(std::size_t i = 1; i < events.size(); i++)
+      REQUIRE(events[i - 1].timestamp <= events[i].timestamp);
+
+    // Same timestamp: the order of the sources, and the sysex stays together
+    REQUIRE(events[4].timestamp == 20);
+    REQUIRE(events[4].source == 0);
+    REQUIRE(events[4].message_type() == 0x3);
+    REQUIRE(events[5].source == 0);
+    REQUIRE(events[5].message_type() == 0x3);
+    REQUIRE(events[6].source == 1);
+    REQUIRE(events[7].source == 2);
+    REQUIRE(events[7].status() == 0x82);
+  }
+}
+
+TEST_CASE("midi_event_merger: capacity and many sources", "[midi]")
+{
+  halp::midi_event_merger merger;
+  merger.reserve(256);
+
+  // More sources than run slots
+  constexpr int sources = 3 * halp::midi_event_merger::max_runs + 1;
+  for(int s = 0; s < sources; s++)
+  {
+    merger.begin_source(s);
+    merger.push(halp::midi_event::midi1(0x90, 60, 100, (s * 37) % 64));
+    merger.push(halp::midi_event::midi1(0x80, 60, 0, 64 + (s * 11) % 64));
+  }
+
+  const auto events = merger.merge();
+  REQUIRE(events.size() == 2 * sources);
+  for(std::size_t i = 1; i < events.size(); i++)
+  {
+    REQUIRE(events[i - 1].timestamp <= events[i].timestamp);
+    if(events[i - 1].timestamp == events[i].timestamp)
+      REQUIRE(events[i - 1].source < events[i].source);
+  }
+
+  // Full: further events are dropped, sysex as a whole
+  merger.clear();
+  for(int i = 0; i < 255; i++)
+    REQUIRE(merger.push(halp::midi_event::midi1(0xF8, 0, 0, i)));
+
+  const uint8_t sysex[]{0xF0, 1, 2, 3, 4, 5, 6, 7, 0xF7};
+  REQUIRE(!merger.push_midi1(sysex, sizeof(sysex), 0));
+  REQUIRE(merger.push(halp::midi_event::midi1(0xF8, 0, 0, 0)));
+  REQUIRE(!merger.push(halp::midi_event::midi1(0xF8, 0, 0, 0)));
+  REQUIRE(merger.dropped() == 2);
+  REQUIRE(merger.merge().size() == 256);
+}
+
+TEST_CASE("midi_bytes: moving a borrowed payload copies it", "[midi]")
+{
+  // A sysex longer than the inline capacity, in memory owned by the "binding"
+  std::vector<uint8_t> arena(32, 0x42);
+  arena.front() = 0xF0;
+  arena.back() = 0xF7;
+
+  halp::midi_msg msg;
+  msg.bytes.borrow(arena.data(), arena.size());
+  REQUIRE(msg.bytes.borrowed());
+
+  halp::midi_msg constructed{std::move(msg)};
+  halp::midi_msg assigned;
+  assigned.bytes.borrow(arena.data(), arena.size());
+  halp::midi_msg target;
+  target = std::move(assigned);
+
+  // The arena is reset at the end of the block
+  const std::vector<uint8_t> expected = arena;
+  std::fill(arena.begin(), arena.end(), 0);
+
+  for(auto* m : {&constructed, &target})
+  {
+    REQUIRE(!m->bytes.borrowed());
+    REQUIRE(std::vector<uint8_t>(m->bytes.begin(), m->bytes.end()) == expected);
+  }
+  REQUIRE(msg.bytes.empty());
+  REQUIRE(assigned.bytes.empty());
+
+  // Owned bytes are still moved
+  halp::midi_msg note{.bytes = {0x90, 60, 100}};
+  halp::midi_msg moved{std::move(note)};
+  REQUIRE(moved.bytes.size() == 3);
+  REQUIRE(moved.bytes[1] == 60);
+}
@@ -0,0 +1,178 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+// Smoothing ramps: the closed forms match the step-by-step smoothers, the
+// smoothing does not depend on the size of the buffers it is computed for, and
+// the block adapters advance it by the whole buffer.
+
+#include <catch2/catch_all.hpp>
+
+#include <avnd/wrappers/prepare.hpp>
+#include <avnd/wrappers/process_adapter.hpp>
+#include <avnd/wrappers/smooth.hpp>
+#include <examples/Helpers/SmoothGain.hpp>
+#include <halp/controls.hpp>
+#include <halp/meta.hpp>
+#include <halp/smooth_controls.hpp>
+
+#include <cmath>
+#include <vector>
+
+namespace
+{
+struct SmoothRamp
+{
+  halp_meta(name, "Smooth ramp")
+  halp_meta(c_name, "smooth_ramp")
+  halp_meta(uuid, "8c3f1e52-94d7-4a0b-b6e1-2f7d5a9c3e18")
+
+  struct
+  {
+    halp::smooth_ramp_knob<"Gain"> gain;
+  } inputs;
+
+  void operator()(int frames) { }
+};
+}
+
+TEST_CASE("smooth: exponential ramp", "[smooth]")
+{
+  const double rate = 0.9;
+  for(int frames : {1, 7, 8, 9, 64, 100})
+  {
+    std::vector<double> ramp(frames);
+    avnd::fill_exponential_ramp(ramp.data(), frames, 0., 1., rate);
+
+    // Same values as the one-pole smoother, step by step
+    double current = 0.;
+    for(int i = 0; i < frames; i++)
+    {
+      current = 1. - rate * (1. - current);
+      REQUIRE(ramp[i] == Catch::Approx(current).margin(1e-12));
+    }
+  }
+
+  // Starting on the target stays on the target
+  std::vector<float> flat(16);
+  avnd::fill_exponential_ramp(flat.data(), 16, 0.5f, 0.5f, rate);
+  for(float v : flat)
+    REQUIRE(v == 0.5f);
+}
+
+TEST_CASE("smooth: linear ramp", "[smooth]")
+{
+  // 4 steps of 0.25 from 0 to 1, then the target
+  std::vector<double> ramp(10);
+  avnd::fill_linear_ramp(ramp.data(), 10, 0., 1., 0.25, 4);
+  REQUIRE(ramp[0] == Catch::Approx(0.25));
+  REQUIRE(ramp[3] == Catch::Approx(1.));
+  for(int i = 4; i < 10; i++)
+    REQUIRE(ramp[i] == 1.);
+
+  // Fewer frames than remaining steps: no sample reaches the target
+  avnd::fill_linear_ramp(ramp.data(), 3, 0., 1., 0.25, 4);
+  REQUIRE(ramp[0] == Catch::Approx(0.25));
+  REQUIRE(ramp[2] == Catch::Approx(0.75));
+}
+
+TEST_CASE("smooth: buffers larger than reserved", "[smooth]")
+{
+  constexpr double sample_rate = 48000.;
+  constexpr int reserved = 64;
+
+  // Same target, processed with small and too large buffers
+  avnd::effect_container<SmoothRamp> small, large;
+  avnd::smooth_storage<SmoothRamp> small_smooth, large_smooth;
+  small_smooth.reserve_ramps(small, sample_rate, reserved);
+  large_smooth.reserve_ramps(large, sample_rate, reserved);
+
+  small_smooth.update_target(small.inputs().gain, 1.f, avnd::field_index<0>{});
+  large_smooth.update_target(large.inputs().gain, 1.f, avnd::field_index<0>{});
+
+  // 4 buffers of 64 samples: a full ramp each time
+  std::vector<float> expected;
+  for(int i = 0; i < 4; i++)
+  {
+    small_smooth.smooth_all(small, reserved);
+    const auto& ramp = small.inputs().gain.ramp;
+    REQUIRE(ramp.size() == std::size_t(reserved));
+    expected.insert(expected.end(), ramp.begin(), ramp.end());
+  }
+
+  // 1 buffer of 256 samples: no ramp, but the smoothing advanced as much
+  large_smooth.smooth_all(large, 4 * reserved);
+  REQUIRE(large.inputs().gain.ramp.empty());
+  REQUIRE(large.inputs().gain.value == Catch::Approx(expected.back()).epsilon(1e-5));
+  REQUIRE(large.inputs().gain.value == Catch::Approx(small.inputs().gain.value));
+
+  // Back to a reserved size: the ramp continues from there
+  small_smooth.smooth_all(small, reserved);
+  large_smooth.smooth_all(large, reserved);
+  REQUIRE(large.inputs().gain.ramp.size() == std::size_t(reserved));
+  for(int i = 0; i < reserved; i++)
+    REQUIRE(
+        large.inputs().gain.ramp[i]
+        == Catch::Approx(small.inputs().gain.ramp[i]).epsilon(1e-5));
+}
+
+TEST_CASE("smooth: block processors get a ramp for the whole buffer", "[smooth]")
+{
+  using T = examples::helpers::SmoothGainRamp;
+  constexpr double sample_rate = 48000.;
+  constexpr int frames = 64;
+  constexpr int channels = 2;
+
+  avnd::effect_container<T> effect;
+  avnd::process_adapter<T> processor;
+  avnd::smooth_storage<T> smooth;
+
+  avnd::process_setup setup{
+      .input_channels = channels,
+      .output_channels = channels,
+      .frames_per_buffer = frames,
+      .rate = sample_rate};
+  processor.allocate_buffers(setup, double{});
+  effect.init_channels(channels, channels);
+  avnd::prepare(effect, setup);
+  smooth.init(effect, sample_rate);
+  smooth.reserve_ramps(effect, sample_rate, frames);
+
+  // The same smoother, advanced directly by whole buffers
+  avnd::effect_container<T> reference;
+  avnd::smooth_storage<T> reference_smooth;
+  reference_smooth.init(reference, sample_rate);
+  reference_smooth.reserve_ramps(reference, sample_rate, frames);
+
+  smooth.update_target(effect.inputs().gain, 1.f, avnd::field_index<1>{});
+  reference_smooth.update_target(reference.inputs().gain, 1.f, avnd::field_index<1>{});
+
+  std::vector<std::vector<double>> ins(channels, std::vector<double>(frames, 1.));
+  std::vector<std::vector<double>> outs(channels, std::vector<double>(frames));
+  std::vector<double*> in_ptrs, out_ptrs;
+  for(auto& c : ins)
+    in_ptrs.push_back(c.data());
+  for(auto& c : outs)
+    out_ptrs.push_back(c.data());
+
+  for(int block = 0; block < 3; block++)
+  {
+    processor.process(
+        effect, avnd::span<double*>{in_ptrs.data(), std::size_t(channels)},
+        avnd::span<double*>{out_ptrs.data(), std::size_t(channels)}, frames, smooth);
+    reference_smooth.smooth_all(reference, frames);
+
+    const auto& ramp = effect.inputs().gain.ramp;
+    const auto& expected = reference.inputs().gain.ramp;
+    REQUIRE(ramp.size() == std::size_t(frames));
+    REQUIRE(expected.size() == std::size_t(frames));
+    for(int i = 0; i < frames; i++)
+    {
+      REQUIRE(ramp[i] == Catch::Approx(expected[i]));
+      for(int c = 0; c < channels; c++)
+        REQUIRE(outs[c][i] == Catch::Approx(expected[i]));
+    }
+    REQUIRE(effect.inputs().gain.value == Catch::Approx(reference.inputs().gain.value));
+  }
+
+  // Advancing by one sample per buffer would have left it close to 0.5
+  REQUIRE(effect.inputs().gain.value > 0.75f);
+}
@@ -0,0 +1,363 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+// avnd::stft: frames come every hop and overlap-add resynthesis gives back the
+// delayed input whatever the host block size, and spectrum ports get the
+// analysis of the latest frame.
+
+#include <catch2/catch_all.hpp>
+
+#include <avnd/wrappers/stft.hpp>
+#include <halp/audio.hpp>
+#include <halp/meta.hpp>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+std::vector<double> noise(int n)
+{
+  std::vector<double> x(n);
+  std::mt19937 gen(n);
+  std::uniform_real_distribution<double> dist(-1., 1.);
+  for(auto& v : x)
+    v = dist(gen);
+  return x;
+}
+
+// The spectra are the same whatever the block size the samples come in
+void check_framing(int N, int hop, int block)
+{
+  const int total = 8 * N;
+  const auto in = noise(total);
+
+  avnd::stft<double> whole;
+  whole.reset(N, hop, avnd::window_kind::hanning);
+  std::vector<std::complex<double>> expected;
+  whole.process(in.data(), total, [&](std::complex<double>* spectrum) {
+    expected.insert(expected.end(), spectrum, spectrum + whole.bins());
+  });
+  REQUIRE(expected.size() == std::size_t(total / hop * whole.bins()));
+
+  avnd::stft<double> stft;
+  stft.reset(N, hop, avnd::window_kind::hanning);
+  std::size_t k = 0;
+  for(int i = 0; i < total; i += block)
+    stft.process(
+        in.data() + i, std::min(block, total - i), [&](std::complex<double>* spectrum) {
+      for(int b = 0; b < stft.bins(); b++, k++)
+        REQUIRE(spectrum[b] == expected[k]);
+    });
+  REQUIRE(k == expected.size());
+}
+
+void check_reconstruction(int N, int hop, avnd::window_kind window, int block)
+{
+  avnd::stft<double> stft;
+  stft.reset(N, hop, window);
+  REQUIRE(stft.latency() == N);
+
+  const int total = 8 * N;
+  const auto in = noise(total);
+  std::vector<double> out(total);
+  int frames = 0;
+  for(int i = 0; i < total; i += block)
+    stft.process(
+        in.data() + i, out.data() + i, std::min(block, total - i),
+        [&](std::complex<double>*) { frames++; });
+
+  REQUIRE(frames == total / hop);
+  for(int i = N; i < total; i++)
+    REQUIRE(out[i] == Catch::Approx(in[i - N]).margin(1e-9));
+}
+
+constexpr double pi = 3.141592653589793;
+
+struct Analyzer
+{
+  halp_meta(name, "Analyzer")
+  halp_meta(c_name, "analyzer")
+  halp_meta(uuid, "0b7e6f5c-2a43-4e59-8d1b-7c3a9e6f1d24")
+
+  struct
+  {
+    halp::audio_spectrum_channel<"In", double> in;
+    halp::fixed_audio_spectrum_bus<"Bus", double, 2> bus;
+  } inputs;
+
+  void operator()(int frames) { }
+};
+
+// Instantiated once per channel
+struct MonoAnalyzer
+{
+  halp_meta(name, "Mono analyzer")
+  halp_meta(c_name, "mono_analyzer")
+  halp_meta(uuid, "5d2c8a1e-7f34-4b6d-9e05-3a8f1c7b2e96")
+
+  struct
+  {
+    halp::audio_spectrum_channel<"In", double> in;
+  } inputs;
+
+  struct
+  {
+    halp::audio_channel<"Out", double> out;
+  } outputs;
+
+  void operator()(int frames) { }
+};
+
+// Spectrum port transformed back to audio, scaled by the processor gain
+struct Resynthesizer
+{
+  halp_meta(name, "Resynthesizer")
+  halp_meta(c_name, "resynthesizer")
+  halp_meta(uuid, "8a4f2d6b-1c93-4e7a-b5d0-6e2f9c3a7b18")
+
+  struct in_port : halp::audio_spectrum_channel<"In", double>
+  {
+    static constexpr bool resynthesize() { return true; }
+    static constexpr int fft_size() { return 256; }
+    static constexpr int hop() { return 64; }
+
+    void on_frame(auto& self)
+    {
+      self.frames++;
+      for(int k = 0; k < 129; k++)
+      {
+        spectrum.amplitude[k] *= self.gain;
+        spectrum.phase[k] *= self.gain;
+      }
+    }
+  };
+
+  struct
+  {
+    in_port in;
+  } inputs;
+
+  struct
+  {
+    halp::audio_channel<"Out", double> out;
+  } outputs;
+
+  double gain = 1.;
+  int frames = 0;
+
+  void operator()(int n) { }
+};
+
+int peak_bin(const double* re, const double* im, int bins)
+{
+  int peak = 0;
+  double max = 0.;
+  for(int k = 0; k < bins; k++)
+  {
+    const double mag = std::hypot(re[k], im[k]);
+    if(mag > max)
+    {
+      max = mag;
+      peak = k;
+    }
+  }
+  return peak;
+}
+}
+
+TEST_CASE("stft: framing does not depend on the block size", "[stft]")
+{
+  for(int block : {1, 7, 64, 500, 1024})
+  {
+    check_framing(256, 128, block);
+    check_framing(256, 64, block);
+    check_framing(256, 256, block);
+  }
+}
+
+TEST_CASE("stft: overlap-add reconstruction", "[stft]")
+{
+  for(int block : {1, 7, 64, 500, 1024})
+  {
+    check_reconstruction(256, 128, avnd::window_kind::hanning, block);
+    check_reconstruction(256, 64, avnd::window_kind::hanning, block);
+    check_reconstruction(256, 128, avnd::window_kind::hamming, block);
+    check_reconstruction(256, 256, avnd::window_kind::rectangular, block);
+  }
+}
+
+TEST_CASE("stft: normalized analysis", "[stft]")
+{
+  constexpr int N = 512;
+  constexpr int bin = 32;
+  avnd::stft<double> stft;
+  stft.reset(N, N / 2, avnd::window_kind::hanning);
+
+  std::vector<double> in(2 * N);
+  for(int i = 0; i < 2 * N; i++)
+    in[i] = std::cos(2. * pi * bin * i / N);
+
+  double magnitude = 0.;
+  stft.process(in.data(), 2 * N, [&](std::complex<double>* spectrum) {
+    magnitude = std::abs(spectrum[bin]);
+  });
+  REQUIRE(magnitude == Catch::Approx(0.5));
+}
+
+TEST_CASE("stft: spectrum ports", "[stft]")
+{
+  avnd::effect_container<Analyzer> effect;
+  avnd::stft_storage<Analyzer> storage;
+
+  constexpr int buffer_size = 256;
+  storage.reserve_space(effect, 3, buffer_size);
+
+  auto& ins = effect.inputs();
+  REQUIRE(ins.in.spectrum.amplitude);
+  REQUIRE(ins.bus.spectrum.amplitude[1]);
+
+  // One sine per host channel, at a different bin each
+  const int bins[3] = {8, 20, 40};
+  std::vector<std::vector<float>> channels(3, std::vector<float>(4 * buffer_size));
+  for(int c = 0; c < 3; c++)
+    for(int i = 0; i < 4 * buffer_size; i++)
+      channels[c][i] = std::sin(2. * pi * bins[c] * i / buffer_size);
+
+  // Blocks smaller than the host buffer size: frames still come every hop
+  constexpr int block = 100;
+  for(int i = 0; i + block <= 4 * buffer_size; i += block)
+  {
+    float* ptrs[3] = {channels[0].data() + i, channels[1].data() + i, channels[2].data() + i};
+    storage.analyze(effect, avnd::span<float*>{ptrs, 3}, block);
+  }
+
+  constexpr int n_bins = buffer_size / 2 + 1;
+  REQUIRE(peak_bin(ins.in.spectrum.amplitude, ins.in.spectrum.phase, n_bins) == bins[0]);
+  REQUIRE(
+      peak_bin(ins.bus.spectrum.amplitude[0], ins.bus.spectrum.phase[0], n_bins)
+      == bins[1]);
+  REQUIRE(
+      peak_bin(ins.bus.spectrum.amplitude[1], ins.bus.spectrum.phase[1], n_bins)
+      == bins[2]);
+}
+
+TEST_CASE("window tables", "[stft][window]")
+{
+  struct kaiser_port
+  {
+    struct
+    {
+      enum window
+      {
+        kaiser
+      };
+      double* amplitude{};
+      double* phase{};
+    } spectrum;
+  };
+  static_assert(avnd::window_kind_for<kaiser_port>() == avnd::window_kind::kaiser);
+  static_assert(
+      avnd::window_kind_for<halp::audio_spectrum_channel<"In", double>>()
+      == avnd::window_kind::hanning);
+
+  avnd::window_cache cache;
+  REQUIRE(!cache.find<float>(avnd::window_kind::blackman_harris, 64));
+
+  const float* w = cache.prepare<float>(avnd::window_kind::blackman_harris, 64, true);
+  REQUIRE(cache.find<float>(avnd::window_kind::blackman_harris, 64, true) == w);
+  REQUIRE(!cache.find<double>(avnd::window_kind::blackman_harris, 64, true));
+  REQUIRE(!cache.find<float>(avnd::window_kind::blackman_harris, 64, false));
+
+  // Symmetric windows
+  for(int i = 0; i < 32; i++)
+    REQUIRE(w[i] == Catch::Approx(w[63 - i]));
+
+  // Periodic windows peak at N / 2
+  for(auto kind :
+      {avnd::window_kind::hanning, avnd::window_kind::hamming,
+       avnd::window_kind::blackman_harris, avnd::window_kind::kaiser,
+       avnd::window_kind::flat_top})
+  {
+    std::vector<double> window(64);
+    avnd::fill_window(kind, window.data(), 64);
+    REQUIRE(window[32] == Catch::Approx(1.).margin(1e-6));
+  }
+}
+
+TEST_CASE("stft: spectrum ports of per-channel processors", "[stft]")
+{
+  static_assert(avnd::monophonic_audio_processor<MonoAnalyzer>);
+
+  avnd::effect_container<MonoAnalyzer> effect;
+  avnd::stft_storage<MonoAnalyzer> storage;
+  effect.init_channels(2, 2);
+
+  constexpr int buffer_size = 256;
+  storage.reserve_space(effect, 2, buffer_size);
+
+  const int bins[2] = {12, 30};
+  std::vector<std::vector<float>> channels(2, std::vector<float>(4 * buffer_size));
+  for(int c = 0; c < 2; c++)
+    for(int i = 0; i < 4 * buffer_size; i++)
+      channels[c][i] = std::sin(2. * pi * bins[c] * i / buffer_size);
+
+  for(int i = 0; i < 4 * buffer_size; i += buffer_size)
+  {
+    float* ptrs[2] = {channels[0].data() + i, channels[1].data() + i};
+    storage.analyze(effect, avnd::span<float*>{ptrs, 2}, buffer_size);
+  }
+
+  // Each instance sees the spectrum of its own channel
+  constexpr int n_bins = buffer_size / 2 + 1;
+  for(int c = 0; c < 2; c++)
+  {
+    auto& in = effect.effect[c].inputs.in;
+    REQUIRE(peak_bin(in.spectrum.amplitude, in.spectrum.phase, n_bins) == bins[c]);
+  }
+  REQUIRE(
+      effect.effect[0].inputs.in.spectrum.amplitude
+      != effect.effect[1].inputs.in.spectrum.amplitude);
+}
+
+TEST_CASE("stft: resynthesized spectrum ports", "[stft]")
+{
+  static_assert(avnd::stft_storage<Resynthesizer>::resynthesis);
+  static_assert(!avnd::stft_storage<Analyzer>::resynthesis);
+
+  avnd::effect_container<Resynthesizer> effect;
+  avnd::stft_storage<Resynthesizer> storage;
+  effect.init_channels(1, 1);
+
+  constexpr int buffer_size = 64;
+  storage.reserve_space(effect, 1, buffer_size);
+  REQUIRE(storage.latency() == 256);
+
+  auto& fx = effect.effect[0];
+  fx.gain = 0.5;
+
+  constexpr int total = 16 * buffer_size;
+  const auto x = noise(total);
+  std::vector<float> in(x.begin(), x.end());
+  for(int i = 0; i < total; i += buffer_size)
+  {
+    float* ptrs[1] = {in.data() + i};
+    auto out = storage.analyze(effect, avnd::span<float*>{ptrs, 1}, buffer_size);
+
+    // The processor gets the modified frames back, delayed by the FFT size
+    REQUIRE(out.size() == 1);
+    REQUIRE(out[0] != in.data() + i);
+    for(int j = 0; j < buffer_size; j++)
+    {
+      const int t = i + j - storage.latency();
+      REQUIRE(out[0][j] == Catch::Approx(t < 0 ? 0. : 0.5 * in[t]).margin(1e-5));
+    }
+  }
+  REQUIRE(fx.frames == total / 64);
+
+  // Larger blocks than reserved are only analyzed
+  std::vector<float> large(2 * buffer_size);
+  float* ptrs[1] = {large.data()};
+  auto out = storage.analyze(effect, avnd::span<float*>{ptrs, 1}, 2 * buffer_size);
+  REQUIRE(out[0] == large.data());
+}
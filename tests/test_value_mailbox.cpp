@@ -0,0 +1,64 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+// avnd::value_mailbox: latest-value handoff between a writer thread and a
+// reader thread.
+
+#include <catch2/catch_all.hpp>
+
+#include <avnd/wrappers/value_mailbox.hpp>
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+TEST_CASE("value_mailbox: coalescing", "[mailbox]")
+{
+  avnd::value_mailbox<float> mailbox;
+  float value = -1.f;
+  REQUIRE(!mailbox.read(value));
+  REQUIRE(value == -1.f);
+
+  mailbox.write(1.f);
+  mailbox.write(2.f);
+  mailbox.write(3.f);
+  REQUIRE(mailbox.read(value));
+  REQUIRE(value == 3.f);
+  REQUIRE(!mailbox.read(value));
+
+  mailbox.write(4.f);
+  REQUIRE(mailbox.read(value));
+  REQUIRE(value == 4.f);
+}
+
+TEST_CASE("value_mailbox: concurrent strings", "[mailbox]")
+{
+  avnd::value_mailbox<std::string> mailbox;
+  constexpr int count = 100000;
+  std::atomic_bool done{};
+
+  // Every value is a run of the same digit, long enough to be on the heap:
+  // a torn value would mix two of them.
+  std::thread writer{[&] {
+    for(int i = 1; i <= count; i++)
+      mailbox.write(std::string(40 + i % 10, char('0' + i % 10)));
+    done = true;
+  }};
+
+  std::string value;
+  int reads = 0;
+  for(bool last = false; !last;)
+  {
+    last = done.load();
+    if(mailbox.read(value))
+    {
+      reads++;
+      REQUIRE(int(value.size()) == 40 + (value[0] - '0'));
+      REQUIRE(value.find_first_not_of(value[0]) == std::string::npos);
+    }
+  }
+  writer.join();
+
+  REQUIRE(reads > 0);
+  REQUIRE(reads <= count);
+  REQUIRE(value == std::string(40, '0'));
+}
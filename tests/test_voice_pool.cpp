@@ -0,0 +1,102 @@
+/* SPDX-License-Identifier: GPL-3.0-or-later */
+
+// avnd::voice_pool: free-list allocation, release and recycling, and which
+// voice gets stolen once every slot is in use.
+
+#include <catch2/catch_all.hpp>
+
+#include <avnd/wrappers/voice_pool.hpp>
+
+#include <set>
+
+namespace
+{
+struct test_voice
+{
+  int note{};
+  float level{};
+  bool done{};
+};
+
+template <typename Pool>
+std::multiset<int> active_notes(Pool& pool)
+{
+  std::multiset<int> res;
+  pool.for_each([&](test_voice& v) { res.insert(v.note); });
+  return res;
+}
+}
+
+TEST_CASE("voice_pool: allocate, release, recycle", "[voices]")
+{
+  avnd::voice_pool<test_voice, 8> pool;
+  REQUIRE(pool.empty());
+
+  // A note with two unison voices
+  pool.allocate(60) = {.note = 60};
+  pool.allocate(60) = {.note = 60};
+  pool.allocate(64) = {.note = 64};
+  REQUIRE(pool.size() == 3);
+
+  int released = 0;
+  pool.release(60, [&](test_voice& v) {
+    REQUIRE(v.note == 60);
+    released++;
+  });
+  REQUIRE(released == 2);
+
+  // Releasing voices keep playing until they are done
+  REQUIRE(pool.size() == 3);
+  pool.recycle_if([](test_voice& v) { return v.done; });
+  REQUIRE(pool.size() == 3);
+
+  pool.for_each([](test_voice& v) { v.done = true; });
+  pool.recycle_if([](test_voice& v) { return v.done; });
+
+  // Voices which are not releasing are never recycled
+  REQUIRE(pool.size() == 1);
+  REQUIRE(active_notes(pool) == std::multiset<int>{64});
+
+  // The active indices stay contiguous
+  REQUIRE(pool.active_end() - pool.active_begin() == 1);
+  REQUIRE(pool[*pool.active_begin()].note == 64);
+  REQUIRE(pool.stolen() == 0);
+}
+
+TEST_CASE("voice_pool: stealing", "[voices]")
+{
+  avnd::voice_pool<test_voice, 4> pool;
+  for(int note : {60, 61, 62, 63})
+    pool.allocate(note) = {.note = note, .level = float(note)};
+
+  SECTION("oldest voice")
+  {
+    pool.allocate(70) = {.note = 70};
+    REQUIRE(pool.stolen() == 1);
+    REQUIRE(pool.size() == 4);
+    REQUIRE(active_notes(pool) == std::multiset<int>{61, 62, 63, 70});
+  }
+
+  SECTION("releasing voices first")
+  {
+    pool.release(62, [](test_voice&) { });
+    pool.release(61, [](test_voice&) { });
+    pool.allocate(70) = {.note = 70};
+    REQUIRE(active_notes(pool) == std::multiset<int>{60, 61, 63, 70});
+    pool.allocate(71) = {.note = 71};
+    REQUIRE(active_notes(pool) == std::multiset<int>{60, 63, 70, 71});
+  }
+
+  SECTION("quietest voice")
+  {
+    pool.for_each([](test_voice& v) { v.level = v.note == 62 ? 0.1f : 1.f; });
+    pool.allocate(70, [](const test_voice& v) { return v.level; }) = {.note = 70};
+    REQUIRE(active_notes(pool) == std::multiset<int>{60, 61, 63, 70});
+  }
+
+  // Chord spam: nothing grows, the most recent notes win
+  for(int note = 0; note < 100; note++)
+    pool.allocate(note) = {.note = note};
+  REQUIRE(pool.size() == 4);
+  REQUIRE(active_notes(pool) == std::multiset<int>{96, 97, 98, 99});
+}
@@ -7,11 +7,22 @@ Covers every port category the Python backend exposes. Objects that are not
 built are skipped, so a partial build still reports what it can.
 """
 
+import gc
 import sys
-import numpy as np
+
+try:
+    import numpy as np
+except ModuleNotFoundError:
+    print("numpy is not available: skipping")
+    sys.exit(77)
 
 import py_test_harness as h
 
+# The cases run when they are defined, below: the module directory has to be
+# on the path first.
+if len(sys.argv) > 1:
+    sys.path.insert(0, sys.argv[1])
+
 OK, SKIP, FAIL = [], [], []
 
 
@@ -85,6 +96,66 @@ def _():
     assert y.shape == (2, 64) and np.all(np.isfinite(y))
 
 
+@case("audio: persistent stream with out=")
+def _():
+    o = h.load("avnd_test_audio_mono")()
+    o.Gain = 2.0
+    s = o.stream(rate=48000.0, block_size=16, channels=1)
+    out = np.zeros((1, 40), dtype=np.float32)
+    y = s.process(np.ones((1, 40), dtype=np.float32), out=out)
+    assert y is out and np.allclose(out, 2.0)
+    o.Gain = 3.0
+    s.process(np.ones((1, 40), dtype=np.float32), out=out)
+    assert np.allclose(out, 3.0)
+
+
+@case("audio: stream outlives its object")
+def _():
+    o = h.load("avnd_test_audio_mono")()
+    o.Gain = 2.0
+    s = o.stream(rate=48000.0, block_size=16, channels=1)
+    # keep_alive: the stream holds the object, whose controls it reads
+    del o
+    gc.collect()
+    y = s.process(np.ones((1, 40), dtype=np.float32))
+    assert y.shape == (1, 40) and np.allclose(y, 2.0)
+
+
+@case("audio: stream input buffers")
+def _():
+    o = h.load("avnd_test_audio_mono")()
+    o.Gain = 2.0
+    s = o.stream(rate=48000.0, block_size=16, channels=2)
+    x = np.arange(80, dtype=np.float64).reshape(40, 2)
+    # float64, and not C-contiguous: converted
+    y = s.process(x.T)
+    assert y.dtype == np.float32 and np.allclose(y, 2.0 * x.T)
+    # 1-D is mono
+    m = o.stream(rate=48000.0, block_size=16, channels=1)
+    y = m.process(np.ones(40, dtype=np.float32))
+    assert y.shape == (1, 40) and np.allclose(y, 2.0)
+
+
+@case("audio: stream rejects unusable out= buffers")
+def _():
+    o = h.load("avnd_test_audio_mono")()
+    s = o.stream(rate=48000.0, block_size=16, channels=1)
+    x = np.ones((1, 40), dtype=np.float32)
+    read_only = np.zeros((1, 40), dtype=np.float32)
+    read_only.flags.writeable = False
+    for out in (
+        np.zeros((1, 40), dtype=np.float64),
+        np.zeros((1, 41), dtype=np.float32),
+        np.zeros((40, 1), dtype=np.float32).T,
+        read_only,
+    ):
+        try:
+            s.process(x, out=out)
+        except RuntimeError:
+            continue
+        raise AssertionError(f"accepted out with {out.dtype} {out.shape} {out.flags}")
+
+
 @case("texture: rgba8 roundtrip")
 def _():
     o = h.load("avnd_test_tex_rgba8")()
@@ -162,8 +233,6 @@ def _():
 
 
 def main():
-    if len(sys.argv) > 1:
-        sys.path.insert(0, sys.argv[1])
     print("=== avendish Python backend harness ===")
     # (cases run at import via @case)
     print(f"\n{len(OK)} passed, {len(SKIP)} skipped, {len(FAIL)} failed")